@@ -0,0 +1,67 @@
+#ifndef ADBBridge_h
+#define ADBBridge_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Native client for the adb server's host and sync protocols.
+// Talks to the local adb server socket directly instead of spawning
+// `adb shell ls` / `adb pull` / `adb push` for every operation, and keeps
+// one sync connection open across calls.
+
+// Structs to pass data to Swift
+typedef struct {
+    char name[256];
+    uint64_t size;
+    uint32_t mode;              // st_mode as reported by the device
+    bool is_directory;
+    bool exists;                // false when STAT found nothing at the path
+    uint64_t modification_date; // Unix timestamp
+} ADBFileInfo;
+
+typedef struct {
+    char serial[128];
+    char state[32];             // "device", "unauthorized", "offline", ...
+} ADBDeviceInfo;
+
+// Callback for progress: transferred bytes, total bytes, context
+typedef void (*ADBProgressCallback)(uint64_t sent, uint64_t total, const void* context);
+
+// Server
+// Defaults to 127.0.0.1:5037. Tests point this at a stand-in server.
+void adb_set_server(const char* host, uint16_t port);
+// Fills up to max_devices entries, returns the number of devices or -1 if the server is unreachable
+int adb_list_devices(ADBDeviceInfo* devices, int max_devices);
+
+// Device Management
+// serial may be NULL to use the only connected device
+bool adb_connect(const char* serial);
+void adb_disconnect(void);
+bool adb_is_connected(void);
+
+// File Operations
+// Returns an array of ADBFileInfo, caller must free it with adb_free_files.
+// count receives the number of entries, or a negative error code on failure.
+// An empty folder returns NULL with a count of 0.
+ADBFileInfo* adb_list_files(const char* path, int* count);
+void adb_free_files(ADBFileInfo* files);
+// Returns 0 on success, non-zero on error
+int adb_stat(const char* path, ADBFileInfo* info);
+// Pipelines count STAT requests on the sync connection; infos must hold count entries
+int adb_stat_many(const char* const* paths, int count, ADBFileInfo* infos);
+
+// Transfer Operations
+int adb_download_file(const char* device_path, const char* dest_path, ADBProgressCallback callback, const void* context);
+int adb_upload_file(const char* source_path, const char* device_path, ADBProgressCallback callback, const void* context);
+int adb_delete_file(const char* device_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADBBridge_h */
@@ -0,0 +1,743 @@
+#include "ADBBridge.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+// Sync protocol limits (see adb's file_sync_protocol.h)
+static const size_t SYNC_DATA_MAX = 64 * 1024;
+static const size_t SYNC_PATH_MAX = 1024;
+
+// Directory bit of st_mode; Android reports Linux values regardless of host
+static const uint32_t MODE_TYPE_MASK = 0170000;
+static const uint32_t MODE_DIRECTORY = 0040000;
+static const uint32_t MODE_REGULAR = 0100000;
+
+// Global connection state (single device, like the MTP and iOS bridges)
+static std::mutex bridge_lock;
+static std::string server_host = "127.0.0.1";
+static uint16_t server_port = 5037;
+static std::string device_serial;   // Empty means "the only device"
+static bool has_stat_v2 = false;
+static bool has_ls_v2 = false;
+
+// Progress callback wrapper structure
+struct ADBBridgeCallbackData {
+    ADBProgressCallback callback;
+    const void* context;
+    uint64_t lastReportedBytes;
+    std::chrono::steady_clock::time_point lastReportTime;
+};
+
+static void adb_bridge_progress_wrapper(uint64_t sent, uint64_t total, ADBBridgeCallbackData* cbData) {
+    if (cbData && cbData->callback) {
+        // Throttle callbacks to reduce overhead
+        // Only report every 1MB or every 100ms, whichever comes first
+        auto now = std::chrono::steady_clock::now();
+        uint64_t bytesSinceLastReport = sent - cbData->lastReportedBytes;
+        auto timeSinceLastReport = std::chrono::duration_cast<std::chrono::milliseconds>(now - cbData->lastReportTime).count();
+
+        const uint64_t MIN_BYTES_DELTA = 1024 * 1024; // 1 MB
+        const int64_t MIN_TIME_DELTA_MS = 100; // 100 ms
+
+        bool shouldReport = (sent == 0) ||
+                           (sent == total) ||
+                           (bytesSinceLastReport >= MIN_BYTES_DELTA) ||
+                           (timeSinceLastReport >= MIN_TIME_DELTA_MS);
+
+        if (shouldReport) {
+            cbData->callback(sent, total, cbData->context);
+            cbData->lastReportedBytes = sent;
+            cbData->lastReportTime = now;
+        }
+    }
+}
+
+// Maps a FAIL message from the device to the same codes the iOS bridge uses
+static int fail_message_to_int(const std::string& message) {
+    if (message.find("No such file") != std::string::npos) return -4;
+    if (message.find("Permission denied") != std::string::npos) return -3;
+    if (message.find("Read-only") != std::string::npos) return -3;
+    return -5;
+}
+
+// MARK: - Buffered socket
+
+// Sync traffic is many tiny fields; buffering both directions keeps it to a
+// handful of syscalls per batch and lets requests be pipelined in one write.
+class SyncSocket {
+public:
+    int fd = -1;
+
+    bool valid() const { return fd >= 0; }
+
+    void close_socket() {
+        if (fd >= 0) close(fd);
+        fd = -1;
+        inPos = inLen = 0;
+        out.clear();
+    }
+
+    void write(const void* data, size_t length) {
+        const char* p = (const char*)data;
+        out.insert(out.end(), p, p + length);
+    }
+
+    void write_u32(uint32_t v) {
+        unsigned char b[4] = { (unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+        write(b, 4);
+    }
+
+    // id + length + payload, the framing of every sync request
+    void write_request(const char* id, const void* payload, size_t length) {
+        write(id, 4);
+        write_u32((uint32_t)length);
+        if (length > 0) write(payload, length);
+    }
+
+    bool flush() {
+        size_t sent = 0;
+        while (sent < out.size()) {
+#ifdef MSG_NOSIGNAL
+            ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+#else
+            ssize_t n = send(fd, out.data() + sent, out.size() - sent, 0);
+#endif
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += (size_t)n;
+        }
+        out.clear();
+        return true;
+    }
+
+    bool read(void* data, size_t length) {
+        char* p = (char*)data;
+        while (length > 0) {
+            if (inPos == inLen) {
+                // Never block on a reply while our own requests are still queued
+                if (!out.empty() && !flush()) return false;
+                ssize_t n = recv(fd, in, sizeof(in), 0);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                inPos = 0;
+                inLen = (size_t)n;
+            }
+            size_t take = (inLen - inPos) < length ? (inLen - inPos) : length;
+            memcpy(p, in + inPos, take);
+            inPos += take;
+            p += take;
+            length -= take;
+        }
+        return true;
+    }
+
+    bool read_u32(uint32_t& v) {
+        unsigned char b[4];
+        if (!read(b, 4)) return false;
+        v = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+        return true;
+    }
+
+    bool read_u64(uint64_t& v) {
+        uint32_t lo, hi;
+        if (!read_u32(lo) || !read_u32(hi)) return false;
+        v = (uint64_t)lo | ((uint64_t)hi << 32);
+        return true;
+    }
+
+    bool read_string(std::string& s, size_t length) {
+        s.resize(length);
+        return length == 0 || read(&s[0], length);
+    }
+
+private:
+    char in[64 * 1024];
+    size_t inPos = 0;
+    size_t inLen = 0;
+    std::vector<char> out;
+};
+
+static SyncSocket sync_socket;
+
+// MARK: - Host protocol
+
+static int open_server() {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* res = NULL;
+    std::string service = std::to_string(server_port);
+    if (getaddrinfo(server_host.c_str(), service.c_str(), &hints, &res) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+// Host requests are a 4 digit hex length followed by the payload
+static void write_host_request(SyncSocket& s, const std::string& request) {
+    char length[5];
+    snprintf(length, sizeof(length), "%04x", (unsigned)request.size());
+    s.write(length, 4);
+    s.write(request.data(), request.size());
+}
+
+static bool read_hex_string(SyncSocket& s, std::string& out) {
+    char length[5] = {0};
+    if (!s.read(length, 4)) return false;
+    size_t n = strtoul(length, NULL, 16);
+    return s.read_string(out, n);
+}
+
+// Reads OKAY, or FAIL followed by its message
+static bool read_host_status(SyncSocket& s, std::string* error) {
+    char status[4];
+    if (!s.read(status, 4)) return false;
+    if (memcmp(status, "OKAY", 4) == 0) return true;
+    if (memcmp(status, "FAIL", 4) == 0 && error) {
+        read_hex_string(s, *error);
+    }
+    return false;
+}
+
+// One-shot host query such as host:devices or host:features
+static bool host_query(const std::string& request, std::string& response) {
+    SyncSocket s;
+    s.fd = open_server();
+    if (!s.valid()) return false;
+    write_host_request(s, request);
+    bool ok = read_host_status(s, NULL) && read_hex_string(s, response);
+    s.close_socket();
+    return ok;
+}
+
+// Opens a connection already switched to the selected device
+static bool open_transport(SyncSocket& s) {
+    s.fd = open_server();
+    if (!s.valid()) return false;
+    write_host_request(s, device_serial.empty() ? "host:transport-any" : "host:transport:" + device_serial);
+    if (!read_host_status(s, NULL)) {
+        s.close_socket();
+        return false;
+    }
+    return true;
+}
+
+static bool open_sync() {
+    if (sync_socket.valid()) return true;
+    if (!open_transport(sync_socket)) return false;
+    write_host_request(sync_socket, "sync:");
+    if (!read_host_status(sync_socket, NULL)) {
+        sync_socket.close_socket();
+        return false;
+    }
+    return true;
+}
+
+// Any framing error leaves the stream in an unknown state; start over next time
+static int drop_sync(int code) {
+    sync_socket.close_socket();
+    return code;
+}
+
+// MARK: - Server & device management
+
+void adb_set_server(const char* host, uint16_t port) {
+    std::lock_guard<std::mutex> guard(bridge_lock);
+    sync_socket.close_socket();
+    server_host = host ? host : "127.0.0.1";
+    server_port = port ? port : 5037;
+}
+
+int adb_list_devices(ADBDeviceInfo* devices, int max_devices) {
+    std::string response;
+    {
+        std::lock_guard<std::mutex> guard(bridge_lock);
+        if (!host_query("host:devices", response)) {
+            return -1;
+        }
+    }
+
+    // "serial\tstate\n" per device
+    int count = 0;
+    size_t start = 0;
+    while (start < response.size()) {
+        size_t end = response.find('\n', start);
+        if (end == std::string::npos) end = response.size();
+        std::string line = response.substr(start, end - start);
+        start = end + 1;
+
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        if (devices && count < max_devices) {
+            ADBDeviceInfo& info = devices[count];
+            memset(&info, 0, sizeof(info));
+            strncpy(info.serial, line.substr(0, tab).c_str(), sizeof(info.serial) - 1);
+            strncpy(info.state, line.substr(tab + 1).c_str(), sizeof(info.state) - 1);
+        }
+        count++;
+    }
+    return count;
+}
+
+bool adb_connect(const char* serial) {
+    std::lock_guard<std::mutex> guard(bridge_lock);
+
+    std::string wanted = serial ? serial : "";
+    if (sync_socket.valid() && wanted == device_serial) {
+        return true; // Already connected
+    }
+    sync_socket.close_socket();
+    device_serial = wanted;
+
+    // Feature list decides between 32-bit (v1) and 64-bit (v2) stat/list replies
+    std::string features;
+    std::string request = device_serial.empty() ? "host:features" : "host-serial:" + device_serial + ":features";
+    has_stat_v2 = false;
+    has_ls_v2 = false;
+    if (host_query(request, features)) {
+        std::string list = "," + features + ",";
+        has_stat_v2 = list.find(",stat_v2,") != std::string::npos;
+        has_ls_v2 = list.find(",ls_v2,") != std::string::npos;
+    }
+
+    return open_sync();
+}
+
+void adb_disconnect() {
+    std::lock_guard<std::mutex> guard(bridge_lock);
+    if (sync_socket.valid()) {
+        sync_socket.write_request("QUIT", NULL, 0);
+        sync_socket.flush();
+    }
+    sync_socket.close_socket();
+}
+
+bool adb_is_connected() {
+    std::lock_guard<std::mutex> guard(bridge_lock);
+    return sync_socket.valid();
+}
+
+// MARK: - Listing & stat
+
+static void fill_info(ADBFileInfo& info, const std::string& name, uint32_t mode, uint64_t size, uint64_t mtime) {
+    memset(&info, 0, sizeof(info));
+    strncpy(info.name, name.c_str(), sizeof(info.name) - 1);
+    info.size = size;
+    info.mode = mode;
+    info.is_directory = (mode & MODE_TYPE_MASK) == MODE_DIRECTORY;
+    info.exists = mode != 0;
+    info.modification_date = mtime;
+}
+
+// Reads the FAIL message that replaces a normal reply
+static int read_fail(std::string& message) {
+    uint32_t length = 0;
+    if (!sync_socket.read_u32(length) || length > SYNC_DATA_MAX || !sync_socket.read_string(message, length)) {
+        return drop_sync(-5);
+    }
+    return fail_message_to_int(message);
+}
+
+static void queue_stat(const char* path) {
+    sync_socket.write_request(has_stat_v2 ? "STA2" : "STAT", path, strlen(path));
+}
+
+static int read_stat_reply(ADBFileInfo& info, const char* path) {
+    char id[4];
+    if (!sync_socket.read(id, 4)) return drop_sync(-5);
+
+    const char* slash = strrchr(path, '/');
+    std::string name = slash && slash[1] ? slash + 1 : path;
+
+    if (memcmp(id, "STAT", 4) == 0) {
+        uint32_t mode, size, mtime;
+        if (!sync_socket.read_u32(mode) || !sync_socket.read_u32(size) || !sync_socket.read_u32(mtime)) {
+            return drop_sync(-5);
+        }
+        fill_info(info, name, mode, size, mtime);
+        return 0;
+    }
+    if (memcmp(id, "STA2", 4) == 0 || memcmp(id, "LST2", 4) == 0) {
+        uint32_t error, mode, nlink, uid, gid;
+        uint64_t dev, ino, size, atime, mtime, ctime;
+        if (!sync_socket.read_u32(error) || !sync_socket.read_u64(dev) || !sync_socket.read_u64(ino) ||
+            !sync_socket.read_u32(mode) || !sync_socket.read_u32(nlink) || !sync_socket.read_u32(uid) ||
+            !sync_socket.read_u32(gid) || !sync_socket.read_u64(size) || !sync_socket.read_u64(atime) ||
+            !sync_socket.read_u64(mtime) || !sync_socket.read_u64(ctime)) {
+            return drop_sync(-5);
+        }
+        // v2 reports errno instead of a zero mode for missing paths
+        fill_info(info, name, error == 0 ? mode : 0, size, mtime);
+        return 0;
+    }
+    if (memcmp(id, "FAIL", 4) == 0) {
+        std::string message;
+        return read_fail(message);
+    }
+    return drop_sync(-5);
+}
+
+int adb_stat(const char* path, ADBFileInfo* info) {
+    return adb_stat_many(&path, 1, info);
+}
+
+int adb_stat_many(const char* const* paths, int count, ADBFileInfo* infos) {
+    if (!paths || !infos || count < 0) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(bridge_lock);
+    if (!open_sync()) return -1;
+
+    for (int i = 0; i < count; i++) {
+        if (!paths[i] || strlen(paths[i]) > SYNC_PATH_MAX) return -1;
+    }
+
+    // Queue every request before reading any reply; the device answers in order
+    for (int i = 0; i < count; i++) {
+        queue_stat(paths[i]);
+    }
+    if (!sync_socket.flush()) return drop_sync(-5);
+
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        int ret = read_stat_reply(infos[i], paths[i]);
+        if (ret != 0) {
+            if (!sync_socket.valid()) return ret;
+            memset(&infos[i], 0, sizeof(infos[i]));
+            result = ret;
+        }
+    }
+    return result;
+}
+
+// One LIST on the current sync connection. Returns 0 or a negative code;
+// -5 means the connection was dropped mid-reply.
+static int list_directory(const std::string& path, std::vector<ADBFileInfo>& entries) {
+    entries.clear();
+    if (!open_sync()) return -1;
+
+    sync_socket.write_request(has_ls_v2 ? "LIS2" : "LIST", path.data(), path.size());
+    if (!sync_socket.flush()) return drop_sync(-5);
+
+    while (true) {
+        char id[4];
+        if (!sync_socket.read(id, 4)) return drop_sync(-5);
+
+        uint32_t mode = 0, nameLength = 0;
+        uint64_t size = 0, mtime = 0;
+        bool v2 = memcmp(id, "DNT2", 4) == 0 || (has_ls_v2 && memcmp(id, "DONE", 4) == 0);
+
+        if (memcmp(id, "FAIL", 4) == 0) {
+            std::string message;
+            return read_fail(message);
+        }
+
+        if (v2) {
+            uint32_t error, nlink, uid, gid;
+            uint64_t dev, ino, atime, ctime;
+            if (!sync_socket.read_u32(error) || !sync_socket.read_u64(dev) || !sync_socket.read_u64(ino) ||
+                !sync_socket.read_u32(mode) || !sync_socket.read_u32(nlink) || !sync_socket.read_u32(uid) ||
+                !sync_socket.read_u32(gid) || !sync_socket.read_u64(size) || !sync_socket.read_u64(atime) ||
+                !sync_socket.read_u64(mtime) || !sync_socket.read_u64(ctime) || !sync_socket.read_u32(nameLength)) {
+                return drop_sync(-5);
+            }
+        } else {
+            uint32_t size32, mtime32;
+            if (!sync_socket.read_u32(mode) || !sync_socket.read_u32(size32) ||
+                !sync_socket.read_u32(mtime32) || !sync_socket.read_u32(nameLength)) {
+                return drop_sync(-5);
+            }
+            size = size32;
+            mtime = mtime32;
+        }
+
+        if (memcmp(id, "DONE", 4) == 0) return 0;
+        if (memcmp(id, "DENT", 4) != 0 && memcmp(id, "DNT2", 4) != 0) return drop_sync(-5);
+
+        std::string name;
+        if (nameLength > SYNC_PATH_MAX || !sync_socket.read_string(name, nameLength)) return drop_sync(-5);
+        if (name == "." || name == "..") continue;
+
+        entries.emplace_back();
+        fill_info(entries.back(), name, mode, size, mtime);
+    }
+}
+
+ADBFileInfo* adb_list_files(const char* path, int* count) {
+    if (!count) return NULL;
+    *count = -1;
+    if (!path) return NULL;
+
+    std::lock_guard<std::mutex> guard(bridge_lock);
+
+    // Ensure we have a trailing slash so symlinked folders (/sdcard) are followed
+    std::string normalized = path;
+    if (normalized.empty() || normalized.back() != '/') normalized += "/";
+    if (normalized.size() > SYNC_PATH_MAX) return NULL;
+
+    std::vector<ADBFileInfo> entries;
+    int ret = list_directory(normalized, entries);
+    // A connection that went stale between calls (server restart, replug) fails
+    // on first use; try once more on a fresh one
+    if (ret == -5) ret = list_directory(normalized, entries);
+    if (ret != 0) {
+        *count = ret;
+        return NULL;
+    }
+
+    *count = 0;
+    if (entries.empty()) {
+        return NULL;
+    }
+
+    ADBFileInfo* result = (ADBFileInfo*)malloc(sizeof(ADBFileInfo) * entries.size());
+    if (!result) {
+        *count = -5;
+        return NULL;
+    }
+    memcpy(result, entries.data(), sizeof(ADBFileInfo) * entries.size());
+    *count = (int)entries.size();
+    return result;
+}
+
+void adb_free_files(ADBFileInfo* files) {
+    if (files) {
+        free(files);
+    }
+}
+
+// MARK: - Transfers
+
+int adb_download_file(const char* device_path, const char* dest_path, ADBProgressCallback callback, const void* context) {
+    if (!device_path || !dest_path || strlen(device_path) > SYNC_PATH_MAX) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(bridge_lock);
+    if (!open_sync()) return -1;
+
+    // Pipeline STAT (for the progress total) and RECV in a single round trip
+    queue_stat(device_path);
+    sync_socket.write_request("RECV", device_path, strlen(device_path));
+    if (!sync_socket.flush()) return drop_sync(-5);
+
+    ADBFileInfo info;
+    int ret = read_stat_reply(info, device_path);
+    if (!sync_socket.valid()) return ret;
+    uint64_t total = (ret == 0) ? info.size : 0;
+
+    // Open destination file on host
+    FILE* dest_file = fopen(dest_path, "wb");
+    bool write_failed = (dest_file == NULL);
+
+    ADBBridgeCallbackData cbData = { callback, context, 0, std::chrono::steady_clock::now() };
+    std::vector<char> buffer(SYNC_DATA_MAX);
+    uint64_t bytes_written = 0;
+    int result = 0;
+
+    // The RECV reply must be drained even if we can't write, or the stream desyncs
+    while (true) {
+        char id[4];
+        uint32_t length = 0;
+        if (!sync_socket.read(id, 4) || !sync_socket.read_u32(length)) {
+            result = drop_sync(-5);
+            break;
+        }
+        if (memcmp(id, "DONE", 4) == 0) {
+            break;
+        }
+        if (memcmp(id, "FAIL", 4) == 0) {
+            std::string message;
+            if (length > SYNC_DATA_MAX || !sync_socket.read_string(message, length)) {
+                result = drop_sync(-5);
+            } else {
+                result = fail_message_to_int(message);
+            }
+            break;
+        }
+        if (memcmp(id, "DATA", 4) != 0 || length > SYNC_DATA_MAX || !sync_socket.read(buffer.data(), length)) {
+            result = drop_sync(-5);
+            break;
+        }
+
+        if (!write_failed && fwrite(buffer.data(), 1, length, dest_file) != length) {
+            write_failed = true;
+        }
+        bytes_written += length;
+
+        // Report progress
+        if (callback && total > 0) {
+            adb_bridge_progress_wrapper(bytes_written, total, &cbData);
+        }
+    }
+
+    if (dest_file) {
+        fclose(dest_file);
+    }
+    if (result == 0 && write_failed) {
+        result = -5; // IO error
+    }
+    if (result != 0) {
+        unlink(dest_path);
+    }
+    return result;
+}
+
+int adb_upload_file(const char* source_path, const char* device_path, ADBProgressCallback callback, const void* context) {
+    if (!source_path || !device_path) {
+        return -1;
+    }
+
+    // Open source file on host
+    FILE* source_file = fopen(source_path, "rb");
+    if (!source_file) {
+        return -5; // IO error
+    }
+
+    struct stat st;
+    uint64_t total_bytes = 0;
+    uint32_t mode = MODE_REGULAR | 0644;
+    uint32_t mtime = (uint32_t)time(NULL);
+    if (fstat(fileno(source_file), &st) == 0) {
+        total_bytes = (uint64_t)st.st_size;
+        mode = MODE_REGULAR | (st.st_mode & 0777);
+        mtime = (uint32_t)st.st_mtime;
+    }
+
+    // "path,mode" with mode in decimal, as adb push sends it
+    std::string target = std::string(device_path) + "," + std::to_string(mode);
+    if (target.size() > SYNC_PATH_MAX) {
+        fclose(source_file);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(bridge_lock);
+    if (!open_sync()) {
+        fclose(source_file);
+        return -1;
+    }
+
+    ADBBridgeCallbackData cbData = { callback, context, 0, std::chrono::steady_clock::now() };
+    sync_socket.write_request("SEND", target.data(), target.size());
+
+    // DATA packets stream back to back; the device only answers once after DONE
+    std::vector<char> buffer(SYNC_DATA_MAX);
+    uint64_t bytes_read = 0;
+    while (true) {
+        size_t n = fread(buffer.data(), 1, buffer.size(), source_file);
+        if (n == 0) break;
+        sync_socket.write_request("DATA", buffer.data(), n);
+        if (!sync_socket.flush()) {
+            fclose(source_file);
+            return drop_sync(-5);
+        }
+        bytes_read += n;
+
+        // Report progress
+        if (callback && total_bytes > 0) {
+            adb_bridge_progress_wrapper(bytes_read, total_bytes, &cbData);
+        }
+    }
+    bool read_error = ferror(source_file) != 0;
+    fclose(source_file);
+
+    if (read_error) {
+        // No way to abort a SEND cleanly; dropping the connection discards the partial file
+        return drop_sync(-5);
+    }
+
+    // DONE carries the modification time in place of a length
+    sync_socket.write("DONE", 4);
+    sync_socket.write_u32(mtime);
+    if (!sync_socket.flush()) return drop_sync(-5);
+
+    char id[4];
+    uint32_t length = 0;
+    if (!sync_socket.read(id, 4) || !sync_socket.read_u32(length)) {
+        return drop_sync(-5);
+    }
+    if (memcmp(id, "OKAY", 4) == 0) {
+        return 0;
+    }
+    if (memcmp(id, "FAIL", 4) == 0) {
+        std::string message;
+        if (length > SYNC_DATA_MAX || !sync_socket.read_string(message, length)) {
+            return drop_sync(-5);
+        }
+        return fail_message_to_int(message);
+    }
+    return drop_sync(-5);
+}
+
+// Quotes a path for the device shell: 'it'\''s'
+static std::string shell_quote(const std::string& s) {
+    std::string quoted = "'";
+    for (char c : s) {
+        if (c == '\'') quoted += "'\\''";
+        else quoted += c;
+    }
+    return quoted + "'";
+}
+
+int adb_delete_file(const char* device_path) {
+    if (!device_path) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(bridge_lock);
+
+    // The sync protocol has no delete; a shell service consumes its own connection
+    SyncSocket shell;
+    if (!open_transport(shell)) {
+        return -1;
+    }
+    write_host_request(shell, "shell:rm -r -- " + shell_quote(device_path) + " 2>&1; echo \"rc=$?\"");
+    if (!read_host_status(shell, NULL)) {
+        shell.close_socket();
+        return -1;
+    }
+
+    std::string output;
+    char c;
+    while (shell.read(&c, 1)) {
+        output.push_back(c);
+    }
+    shell.close_socket();
+
+    size_t rc = output.rfind("rc=");
+    if (rc == std::string::npos) return -5;
+    if (atoi(output.c_str() + rc + 3) == 0) return 0;
+    return fail_message_to_int(output);
+}
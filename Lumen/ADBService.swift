@@ -12,109 +12,255 @@ class ADBService: FileService {
     // In a real app, this should be configurable or auto-detected.
     private let adbPath = "/Users/afraasheriff/Library/Android/sdk/platform-tools/adb"
     
+    // Serial queue: the native client keeps one sync connection to the adb server
+    private let queue = DispatchQueue(label: "com.oneshare.adb.queue", qos: .userInitiated)
+    
+    // Device whose listings are in the search index; only touched on queue
+    nonisolated(unsafe) private var indexedSerial: String?
+    private var deviceMonitoringTimer: Timer?
+    
+    init() {
+        startDeviceMonitoring()
+    }
+    
+    deinit {
+        deviceMonitoringTimer?.invalidate()
+    }
+    
+    private class ProgressContext {
+        let progress: (Double, String) -> Void
+        let totalSize: Double
+        let verb: String
+        
+        init(progress: @escaping (Double, String) -> Void, totalSize: Double, verb: String) {
+            self.progress = progress
+            self.totalSize = totalSize
+            self.verb = verb
+        }
+    }
+    
     func listItems(at path: String) async throws -> [FileSystemItem] {
-        return try await Task.detached(priority: .userInitiated) {
-            // 1. Check if device is connected
-            try self.checkDeviceConnection()
-            
-            // 2. Construct command: adb shell "ls -la <path>"
-            // Ensure path ends with / to list contents of symlinks/dirs
-            let listPath = path.hasSuffix("/") ? path : path + "/"
-            
-            // We wrap the path in single quotes for the shell command string
-            // and pass the whole command as a single argument to "shell"
-            // This avoids adb's argument parsing issues
-            let shellCmd = "ls -la '\(listPath)'"
-            
-            let output = try self.runADBCommand(["shell", shellCmd])
-            
-            // DEBUG: Log output to file
-            let debugLog = "Command: adb shell \(shellCmd)\nPath: \(path)\nOutput:\n\(output)\n"
-            try? debugLog.write(to: URL(fileURLWithPath: "/Users/afraasheriff/Desktop/lumen_debug_ls.txt"), atomically: true, encoding: .utf8)
-            
-            return self.parseLSOutput(output, parentPath: path)
-        }.value
+        return try await withCheckedThrowingContinuation { continuation in
+            queue.async {
+                do {
+                    // 1. Check if device is connected
+                    try self.checkDeviceConnection()
+                    
+                    // 2. LIST over the sync connection (trailing slash follows symlinked dirs like /sdcard)
+                    var count: Int32 = 0
+                    let filesPtr = adb_list_files(path, &count)
+                    defer { adb_free_files(filesPtr) }
+                    // A failed listing must never reach the index as an empty folder
+                    if count < 0 {
+                        throw self.error(for: count, path: path)
+                    }
+                    
+                    var items: [FileSystemItem] = []
+                    if let files = filesPtr {
+                        items.reserveCapacity(Int(count))
+                        for i in 0..<Int(count) {
+                            let info = files[i]
+                            let name = withUnsafePointer(to: info.name) {
+                                $0.withMemoryRebound(to: CChar.self, capacity: 256) { String(cString: $0) }
+                            }
+                            let itemPath = path.hasSuffix("/") ? "\(path)\(name)" : "\(path)/\(name)"
+                            items.append(FileSystemItem(
+                                name: name,
+                                path: itemPath,
+                                size: Int64(info.size),
+                                type: self.fileType(for: name, isDirectory: info.is_directory),
+                                modificationDate: Date(timeIntervalSince1970: TimeInterval(info.modification_date))
+                            ))
+                        }
+                    } else {
+                        // adbd answers LIST on a missing path with an empty listing; STAT tells them apart
+                        var info = ADBFileInfo()
+                        if adb_stat(path, &info) != 0 || !info.exists {
+                            throw NSError(domain: "ADBService", code: 3, userInfo: [NSLocalizedDescriptionKey: "Path not found: \(path)"])
+                        }
+                    }
+                    SearchCatalog.shared.ingest(items, listedAt: path, source: SEARCH_SOURCE_ADB)
+                    continuation.resume(returning: items)
+                } catch {
+                    continuation.resume(throwing: error)
+                }
+            }
+        }
     }
     
-    // Helper to run ADB command synchronously (called from background task)
+    nonisolated private func fileType(for name: String, isDirectory: Bool) -> FileType {
+        if isDirectory {
+            return .folder
+        }
+        let ext = (name as NSString).pathExtension.lowercased()
+        switch ext {
+        case "jpg", "jpeg", "png", "heic", "gif": return .image
+        case "mp4", "mov", "mkv", "avi": return .video
+        case "mp3", "wav", "m4a": return .audio
+        case "pdf", "doc", "docx", "txt", "md": return .document
+        case "zip", "rar", "7z", "tar": return .archive
+        default: return .file
+        }
+    }
+    
+    // Polls for the indexed device between operations, so an unplugged phone
+    // leaves search even when nothing else touches the service
+    private func startDeviceMonitoring() {
+        deviceMonitoringTimer = Timer.scheduledTimer(withTimeInterval: 2.0, repeats: true) { [weak self] _ in
+            guard let self = self else { return }
+            self.queue.async {
+                guard self.indexedSerial != nil else { return }
+                var devices = [ADBDeviceInfo](repeating: ADBDeviceInfo(), count: 8)
+                let found = adb_list_devices(&devices, Int32(devices.count))
+                self.noteDevice(self.readySerial(devices, found: found))
+            }
+        }
+    }
+    
+    // Serial of the first device in the "device" state
+    nonisolated private func readySerial(_ devices: [ADBDeviceInfo], found: Int32) -> String? {
+        for device in devices.prefix(Int(max(found, 0))) {
+            let state = withUnsafePointer(to: device.state) {
+                $0.withMemoryRebound(to: CChar.self, capacity: 32) { String(cString: $0) }
+            }
+            if state == "device" {
+                return withUnsafePointer(to: device.serial) {
+                    $0.withMemoryRebound(to: CChar.self, capacity: 128) { String(cString: $0) }
+                }
+            }
+        }
+        return nil
+    }
+    
+    // Called on the service queue. A device that went away, or was swapped for
+    // another, takes its files out of search.
+    nonisolated private func noteDevice(_ serial: String?) {
+        if indexedSerial != nil && indexedSerial != serial {
+            SearchCatalog.shared.clear(source: SEARCH_SOURCE_ADB)
+            // The sync connection belonged to the old device's transport
+            adb_disconnect()
+        }
+        indexedSerial = serial
+    }
+    
+    // Called on the service queue
     nonisolated private func checkDeviceConnection() throws {
-        let output = try runADBCommand(["devices"])
-        let lines = output.components(separatedBy: .newlines)
-        let hasDevice = lines.dropFirst().contains { line in
-            let parts = line.components(separatedBy: .whitespaces).filter { !$0.isEmpty }
-            return parts.count >= 2 && parts[1] == "device"
+        var devices = [ADBDeviceInfo](repeating: ADBDeviceInfo(), count: 8)
+        var found = adb_list_devices(&devices, Int32(devices.count))
+        if found < 0 {
+            // Server not running yet; this is the only time we still spawn adb
+            _ = try? runADBCommand(["start-server"])
+            found = adb_list_devices(&devices, Int32(devices.count))
         }
         
-        if !hasDevice {
-            let isUnauthorized = lines.dropFirst().contains { $0.contains("unauthorized") }
-            if isUnauthorized {
+        let states = devices.prefix(Int(max(found, 0))).map { device in
+            withUnsafePointer(to: device.state) {
+                $0.withMemoryRebound(to: CChar.self, capacity: 32) { String(cString: $0) }
+            }
+        }
+        
+        noteDevice(readySerial(devices, found: found))
+        
+        if !states.contains("device") {
+            if states.contains("unauthorized") {
                  throw NSError(domain: "ADBService", code: 5, userInfo: [NSLocalizedDescriptionKey: "Device unauthorized. Check phone screen."])
             }
-            let isOffline = lines.dropFirst().contains { $0.contains("offline") }
-            if isOffline {
+            if states.contains("offline") {
                  throw NSError(domain: "ADBService", code: 6, userInfo: [NSLocalizedDescriptionKey: "Device is offline. Try reconnecting USB."])
             }
             throw NSError(domain: "ADBService", code: 7, userInfo: [NSLocalizedDescriptionKey: "No Android device found."])
         }
+        
+        if !adb_connect(nil) {
+            throw NSError(domain: "ADBService", code: 8, userInfo: [NSLocalizedDescriptionKey: "Could not open ADB sync session."])
+        }
+    }
+    
+    nonisolated private func error(for code: Int32, path: String) -> NSError {
+        switch code {
+        case -4:
+            return NSError(domain: "ADBService", code: 3, userInfo: [NSLocalizedDescriptionKey: "Path not found: \(path)"])
+        case -3:
+            return NSError(domain: "ADBService", code: 4, userInfo: [NSLocalizedDescriptionKey: "Permission denied"])
+        default:
+            return NSError(domain: "ADBService", code: Int(code), userInfo: [NSLocalizedDescriptionKey: "ADB Error: \(code)"])
+        }
+    }
+    
+    private static let progressCallback: ADBProgressCallback = { sent, total, ctx in
+        guard let ctx = ctx else { return }
+        let context = Unmanaged<ProgressContext>.fromOpaque(ctx).takeUnretainedValue()
+        
+        let totalSize = context.totalSize > 0 ? context.totalSize : Double(total)
+        let percentage = totalSize > 0 ? Double(sent) / totalSize : 0
+        let status = "\(context.verb) \(ByteCountFormatter.string(fromByteCount: Int64(sent), countStyle: .file)) / \(ByteCountFormatter.string(fromByteCount: Int64(totalSize), countStyle: .file))"
+        
+        DispatchQueue.main.async {
+            context.progress(percentage, status)
+        }
     }
     
     func downloadFile(at path: String, to localURL: URL, size: Int64, progress: @escaping (Double, String) -> Void) async throws {
         // Immediate feedback
         progress(0.0, "Starting download...")
         
-        let _ = try await Task.detached(priority: .userInitiated) {
-            // Use -p flag for progress
-            // adb pull -p <remote> <local>
-            try self.runADBCommand(["pull", "-p", path, localURL.path]) { line in
-                // Parse progress from output like: [ 45%] /path/to/file
-                // ADB pull output format can vary, but often shows percentage
-                // This is a simplified parser
-                if let range = line.range(of: #"\d+%"#, options: .regularExpression) {
-                    let percentStr = String(line[range]).dropLast()
-                    if let percent = Double(percentStr) {
-                        let sizeMB = Double(size) / 1024 / 1024
-                        let downloadedMB = sizeMB * (percent / 100.0)
-                        let status = String(format: "%.1f MB of %.1f MB", downloadedMB, sizeMB)
-                        progress(percent / 100.0, status)
-                    }
+        try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+            queue.async {
+                do {
+                    try self.checkDeviceConnection()
+                } catch {
+                    continuation.resume(throwing: error)
+                    return
+                }
+                
+                let context = ProgressContext(progress: progress, totalSize: Double(size), verb: "Downloading")
+                let contextPtr = Unmanaged.passRetained(context).toOpaque()
+                
+                let ret = adb_download_file(path, localURL.path, ADBService.progressCallback, contextPtr)
+                
+                Unmanaged<ProgressContext>.fromOpaque(contextPtr).release()
+                
+                if ret == 0 {
+                    // Ensure 100% at end
+                    progress(1.0, "Completed")
+                    continuation.resume()
                 } else {
-                    // Fallback for non-progress lines
-                    if !line.trimmingCharacters(in: .whitespaces).isEmpty {
-                        // Check for "Transferring" or similar if needed, or just ignore
-                    }
+                    continuation.resume(throwing: self.error(for: ret, path: path))
                 }
             }
-            
-            // Ensure 100% at end
-            progress(1.0, "Completed")
-        }.value
+        }
     }
     
     func uploadFile(from localURL: URL, to path: String, progress: @escaping (Double, String) -> Void) async throws {
         // Immediate feedback
         progress(0.0, "Starting upload...")
         
-        let _ = try await Task.detached(priority: .userInitiated) {
-            // Use -p flag for progress
-            // adb push -p <local> <remote>
-            try self.runADBCommand(["push", "-p", localURL.path, path]) { line in
-                if let percent = self.parseProgress(from: line) {
-                    progress(percent, "Uploading...")
+        try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+            queue.async {
+                do {
+                    try self.checkDeviceConnection()
+                } catch {
+                    continuation.resume(throwing: error)
+                    return
+                }
+                
+                let fileSize = (try? localURL.resourceValues(forKeys: [.fileSizeKey]).fileSize).flatMap { Double($0) } ?? 0
+                let context = ProgressContext(progress: progress, totalSize: fileSize, verb: "Uploading")
+                let contextPtr = Unmanaged.passRetained(context).toOpaque()
+                
+                let ret = adb_upload_file(localURL.path, path, ADBService.progressCallback, contextPtr)
+                
+                Unmanaged<ProgressContext>.fromOpaque(contextPtr).release()
+                
+                if ret == 0 {
+                    // Ensure 100% at end
+                    progress(1.0, "Completed")
+                    continuation.resume()
+                } else {
+                    continuation.resume(throwing: self.error(for: ret, path: path))
                 }
             }
-            // Ensure 100% at end
-            progress(1.0, "Completed")
-        }.value
-    }
-    
-    nonisolated private func parseProgress(from line: String) -> Double? {
-        if let range = line.range(of: "\\[\\s*(\\d+)%\\]", options: .regularExpression) {
-             let matchString = line[range].components(separatedBy: CharacterSet.decimalDigits.inverted).joined()
-             if let match = Double(matchString) {
-                 return match / 100.0
-             }
         }
-        return nil
     }
     
     // Internal helper to handle both modes
@@ -190,152 +336,25 @@ class ADBService: FileService {
         return outputQueue.sync { fullOutput }
     }
     
-    nonisolated private func parseLSOutput(_ output: String, parentPath: String) -> [FileSystemItem] {
-        var items: [FileSystemItem] = []
-        let lines = output.components(separatedBy: .newlines)
-        
-        let dateFormatterISO = DateFormatter()
-        dateFormatterISO.dateFormat = "yyyy-MM-dd HH:mm"
-        
-        let dateFormatterShort = DateFormatter()
-        dateFormatterShort.dateFormat = "MMM dd HH:mm" // e.g. Jan 01 12:00
-        
-        let dateFormatterYear = DateFormatter()
-        dateFormatterYear.dateFormat = "MMM dd yyyy" // e.g. Jan 01 2023
-        
-        for line in lines {
-            // Skip "total <number>" line
-            if line.hasPrefix("total") { continue }
-            if line.trimmingCharacters(in: .whitespaces).isEmpty { continue }
-            
-            let parts = line.components(separatedBy: .whitespaces).filter { !$0.isEmpty }
-            
-            // We need at least 7 parts to have a chance at metadata
-            // perms links owner group size [date parts...] name
-            guard parts.count >= 7 else { continue }
-            
-            let perms = parts[0]
-            // Basic validation of perms to ensure it's a file line
-            guard perms.hasPrefix("d") || perms.hasPrefix("-") || perms.hasPrefix("l") else { continue }
-            
-            let isDirectory = perms.hasPrefix("d")
-            
-            // Size is usually at index 4
-            let size = Int64(parts[4]) ?? 0
-            
-            // Date parsing strategy
-            var modificationDate = Date()
-            var nameStartIndex = 0
-            
-            // Try ISO format (YYYY-MM-DD HH:MM) -> parts[5], parts[6]
-            if parts.count >= 8, let date = dateFormatterISO.date(from: "\(parts[5]) \(parts[6])") {
-                modificationDate = date
-                // Name starts after time string
-                if let timeRange = line.range(of: parts[6], options: .backwards) {
-                     nameStartIndex = timeRange.upperBound.utf16Offset(in: line)
+    func deleteItem(at path: String) async throws {
+        try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+            queue.async {
+                do {
+                    // 1. Check if device is connected
+                    try self.checkDeviceConnection()
+                } catch {
+                    continuation.resume(throwing: error)
+                    return
                 }
-            }
-            // Try Short format (MMM dd HH:MM) -> parts[5], parts[6], parts[7]
-            else if parts.count >= 9, let date = dateFormatterShort.date(from: "\(parts[5]) \(parts[6]) \(parts[7])") {
-                // Fix year
-                var components = Calendar.current.dateComponents([.year, .month, .day, .hour, .minute], from: date)
-                components.year = Calendar.current.component(.year, from: Date())
-                modificationDate = Calendar.current.date(from: components) ?? date
                 
-                if let timeRange = line.range(of: parts[7], options: .backwards) {
-                     nameStartIndex = timeRange.upperBound.utf16Offset(in: line)
-                }
-            }
-            // Try Year format (MMM dd yyyy) -> parts[5], parts[6], parts[7]
-            else if parts.count >= 9, let date = dateFormatterYear.date(from: "\(parts[5]) \(parts[6]) \(parts[7])") {
-                modificationDate = date
-                if let timeRange = line.range(of: parts[7], options: .backwards) {
-                     nameStartIndex = timeRange.upperBound.utf16Offset(in: line)
-                }
-            }
-            // Fallback: Assume name is the last part (risky for spaces) or everything after 7th token
-            else {
-                if parts.count >= 8 {
-                    // Assume parts[7] is the start of the name?
-                    // Reconstruct name from parts[7...]
-                    // This loses spaces between name parts if we just join.
-                    // But we can try to find the substring in the line.
-                    let searchStart = parts[6] // Time or Year
-                    if let range = line.range(of: searchStart, options: .backwards) {
-                        nameStartIndex = range.upperBound.utf16Offset(in: line)
-                    } else {
-                        // Desperation: just take the last part
-                        // items.append(...)
-                        // continue
-                    }
-                }
-            }
-            
-            // Extract name
-            var namePart = ""
-            if nameStartIndex > 0 && nameStartIndex < line.count {
-                let index = line.index(line.startIndex, offsetBy: nameStartIndex)
-                namePart = String(line[index...]).trimmingCharacters(in: .whitespaces)
-            } else {
-                // Fallback if index logic failed but we have parts
-                if parts.count > 7 {
-                    namePart = parts.suffix(from: 7).joined(separator: " ")
-                }
-            }
-            
-            guard !namePart.isEmpty else { continue }
-            if namePart == "." || namePart == ".." { continue }
-            
-            // Handle Symlinks (l...) -> name -> target
-            // ls -l output: lrwxrwxrwx ... name -> target
-            if perms.hasPrefix("l") {
-                if let arrowRange = namePart.range(of: " -> ") {
-                    namePart = String(namePart[..<arrowRange.lowerBound])
-                }
-            }
-            
-            let type: FileType
-            if isDirectory {
-                type = .folder
-            } else {
-                let ext = (namePart as NSString).pathExtension.lowercased()
-                switch ext {
-                case "jpg", "jpeg", "png", "heic", "gif": type = .image
-                case "mp4", "mov", "mkv", "avi": type = .video
-                case "mp3", "wav", "m4a": type = .audio
-                case "pdf", "doc", "docx", "txt", "md": type = .document
-                case "zip", "rar", "7z", "tar": type = .archive
-                default: type = .file
+                // 2. rm -r through the adb server's shell service
+                let ret = adb_delete_file(path)
+                if ret == 0 {
+                    continuation.resume()
+                } else {
+                    continuation.resume(throwing: self.error(for: ret, path: path))
                 }
             }
-            
-            let itemPath = parentPath.hasSuffix("/") ? "\(parentPath)\(namePart)" : "\(parentPath)/\(namePart)"
-            
-            items.append(FileSystemItem(
-                name: namePart,
-                path: itemPath,
-                size: size,
-                type: type,
-                modificationDate: modificationDate
-            ))
         }
-        
-        return items
-    }
-    
-    func deleteItem(at path: String) async throws {
-        let _ = try await Task.detached(priority: .userInitiated) {
-            // 1. Check if device is connected
-            try self.checkDeviceConnection()
-            
-            // 2. Construct command: adb shell "rm -r <path>"
-            let shellCmd = "rm -r '\(path)'"
-            
-            let output = try self.runADBCommand(["shell", shellCmd])
-            
-            // DEBUG: Log output to file
-            let debugLog = "Command: adb shell \(shellCmd)\nPath: \(path)\nOutput:\n\(output)\n"
-            try? debugLog.write(to: URL(fileURLWithPath: "/Users/afraasheriff/Desktop/lumen_debug_rm.txt"), atomically: true, encoding: .utf8)
-        }.value
     }
 }
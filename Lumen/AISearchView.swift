@@ -15,7 +15,18 @@ struct AISearchView: View {
         case all = "All"
         case mac = "Mac"
         case android = "Android"
+        case iphone = "iPhone"
         var id: String { self.rawValue }
+        
+        // Android covers both MTP and adb listings
+        var sources: [SearchSource] {
+            switch self {
+            case .all: return [SEARCH_SOURCE_LOCAL, SEARCH_SOURCE_MTP, SEARCH_SOURCE_ADB, SEARCH_SOURCE_IOS]
+            case .mac: return [SEARCH_SOURCE_LOCAL]
+            case .android: return [SEARCH_SOURCE_MTP, SEARCH_SOURCE_ADB]
+            case .iphone: return [SEARCH_SOURCE_IOS]
+            }
+        }
     }
 
     @State private var searchScope: SearchScope = .all
@@ -56,10 +67,16 @@ struct AISearchView: View {
         }
         .onAppear {
             apiKeyInput = geminiService.apiKey
-            if scanner.indexedFiles.isEmpty {
+            if scanner.indexedCount == 0 {
                 scanner.startScan()
             }
         }
+        .onChange(of: query) { _, _ in
+            updateFilenameMatches()
+        }
+        .onChange(of: searchScope) { _, _ in
+            updateFilenameMatches()
+        }
     }
     
     private var headerView: some View {
@@ -133,7 +150,7 @@ struct AISearchView: View {
                 }
                 .pickerStyle(.segmented)
                 .labelsHidden()
-                .frame(width: 200)
+                .frame(width: 260)
                 
                 Spacer()
                 
@@ -307,7 +324,7 @@ struct AISearchView: View {
                     .font(.caption)
                     .foregroundStyle(.secondary)
             } else {
-                Text("\(scanner.indexedFiles.count) files indexed")
+                Text("\(scanner.catalog.count(sources: searchScope.sources, types: SearchCatalog.fileTypes)) files indexed")
                     .font(.caption)
                     .foregroundStyle(.secondary)
             }
@@ -321,6 +338,14 @@ struct AISearchView: View {
         .background(VisualEffectView(material: .headerView, blendingMode: .withinWindow))
     }
     
+    // Instant filename matches while typing; submitting asks Gemini
+    private func updateFilenameMatches() {
+        guard !isSearching else { return }
+        errorMessage = nil
+        let text = query.trimmingCharacters(in: .whitespaces)
+        results = text.isEmpty ? [] : scanner.catalog.search(text, sources: searchScope.sources, types: SearchCatalog.fileTypes, limit: 50).files
+    }
+    
     private func performSearch() {
         guard !query.isEmpty else { return }
         isSearching = true
@@ -329,30 +354,24 @@ struct AISearchView: View {
         Task {
             do {
                 // Ensure we have files
-                if scanner.indexedFiles.isEmpty {
+                if scanner.indexedCount == 0 {
                     print("Index empty. Triggering scan...")
                     scanner.startScan()
                     
                     // Wait briefly for some files to appear (simple polling)
                     var attempts = 0
-                    while scanner.indexedFiles.isEmpty && attempts < 10 {
+                    while scanner.indexedCount == 0 && attempts < 10 {
                         try await Task.sleep(nanoseconds: 500_000_000) // 0.5s
                         attempts += 1
                     }
                     
-                    if scanner.indexedFiles.isEmpty {
+                    if scanner.indexedCount == 0 {
                         throw NSError(domain: "OneShare", code: 404, userInfo: [NSLocalizedDescriptionKey: "No files found to search. Please ensure you have files in Documents, Downloads, or Pictures."])
                     }
                 }
                 
-                // Filter files based on scope
-                let scopedFiles = scanner.indexedFiles.filter { file in
-                    switch searchScope {
-                    case .all: return true
-                    case .mac: return !file.isRemote
-                    case .android: return file.isRemote
-                    }
-                }
+                // Newest files in scope, straight from the index (Gemini only looks at 2000)
+                let scopedFiles = scanner.catalog.search("", sources: searchScope.sources, types: SearchCatalog.fileTypes, limit: 2000).files
                 
                 if scopedFiles.isEmpty {
                      throw NSError(domain: "OneShare", code: 404, userInfo: [NSLocalizedDescriptionKey: "No files found in selected scope (\(searchScope.rawValue))."])
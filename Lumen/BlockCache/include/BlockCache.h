@@ -0,0 +1,43 @@
+#ifndef BlockCache_h
+#define BlockCache_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// C interface to BlockCache (BlockCache.hpp) for Swift. The bridges' streams
+// use the C++ class directly; this lets a caller supply the fetch.
+
+// Reads length bytes at offset into out. Returns the bytes read (short only
+// at the end of the object) or a negative error code.
+typedef int64_t (*BlockCacheFetchCallback)(uint64_t offset, uint32_t length, uint8_t* out, const void* context);
+
+// Structs to pass data to Swift
+typedef struct {
+    uint64_t reads;
+    uint64_t fetches;
+    uint64_t bytes_fetched;
+    uint64_t block_hits;
+    uint64_t block_misses;
+} BlockCacheStats;
+
+typedef struct BlockCacheHandle BlockCacheHandle;
+
+// 0 for block_size, capacity or max_readahead picks the default
+BlockCacheHandle* block_cache_create(uint64_t size, BlockCacheFetchCallback fetch, const void* context,
+                                     uint32_t block_size, int capacity, uint32_t max_readahead);
+void block_cache_free(BlockCacheHandle* cache);
+
+// Returns the bytes copied, 0 at the end of the object, or the fetch's negative error code
+int64_t block_cache_read(BlockCacheHandle* cache, uint64_t offset, void* buffer, uint32_t length);
+BlockCacheStats block_cache_stats(BlockCacheHandle* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BlockCache_h */
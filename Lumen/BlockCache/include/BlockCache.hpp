@@ -0,0 +1,77 @@
+#ifndef BlockCache_hpp
+#define BlockCache_hpp
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Random access over a remote object that can only be fetched in ranges.
+//
+// The object is split into fixed-size blocks kept in a small LRU cache, so
+// scrubbing back over something already seen costs nothing. Each miss is a
+// single fetch of one or more whole blocks: random access fetches one block,
+// and once reads run sequentially the fetch grows (doubling up to a limit)
+// to read ahead, which keeps a player ahead of playback with few round trips.
+//
+// Not thread-safe; the bridges lock around it together with the device handle.
+class BlockCache {
+public:
+    // Reads length bytes at offset into out. Returns the bytes read (short
+    // only at the end of the object) or a negative error code.
+    typedef std::function<int64_t(uint64_t offset, uint32_t length, uint8_t* out)> Fetch;
+
+    struct Stats {
+        uint64_t reads = 0;
+        uint64_t fetches = 0;
+        uint64_t bytes_fetched = 0;
+        uint64_t block_hits = 0;
+        uint64_t block_misses = 0;
+    };
+
+    static const uint32_t DEFAULT_BLOCK_SIZE = 512 * 1024;
+    static const size_t DEFAULT_CAPACITY = 32;          // Blocks, 16 MB by default
+    static const uint32_t DEFAULT_MAX_READAHEAD = 16;   // Blocks per fetch
+
+    BlockCache(uint64_t size, Fetch fetch,
+               uint32_t block_size = DEFAULT_BLOCK_SIZE,
+               size_t capacity = DEFAULT_CAPACITY,
+               uint32_t max_readahead = DEFAULT_MAX_READAHEAD);
+
+    // Copies up to length bytes at offset. Returns the bytes copied, 0 at the
+    // end of the object, or the fetch's negative error code.
+    int64_t read(uint64_t offset, void* buffer, uint32_t length);
+
+    uint64_t size() const { return object_size; }
+    const Stats& stats() const { return counters; }
+
+private:
+    struct Block {
+        uint64_t index;
+        std::vector<uint8_t> data;
+    };
+
+    Block* lookup(uint64_t index);
+    int64_t fill(uint64_t index);
+    std::vector<uint8_t> take_buffer();
+
+    uint64_t object_size;
+    Fetch fetch;
+    uint32_t block_size;
+    size_t capacity;
+    uint32_t max_readahead;
+
+    // Most recently used first
+    std::list<Block> blocks;
+    std::unordered_map<uint64_t, std::list<Block>::iterator> index_map;
+    std::vector<uint8_t> staging;
+
+    uint64_t next_sequential_block = UINT64_MAX;
+    uint32_t readahead = 1;
+
+    Stats counters;
+};
+
+#endif /* BlockCache_hpp */
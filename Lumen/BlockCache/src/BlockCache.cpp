@@ -0,0 +1,151 @@
+#include "BlockCache.hpp"
+#include "BlockCache.h"
+
+#include <string.h>
+#include <algorithm>
+
+BlockCache::BlockCache(uint64_t size, Fetch fetch, uint32_t block_size, size_t capacity, uint32_t max_readahead)
+    : object_size(size),
+      fetch(std::move(fetch)),
+      block_size(block_size > 0 ? block_size : DEFAULT_BLOCK_SIZE),
+      capacity(capacity > 1 ? capacity : 2),
+      max_readahead(max_readahead > 0 ? max_readahead : 1) {
+    // A fetch never evicts the blocks it just brought in
+    this->max_readahead = std::min<uint32_t>(this->max_readahead, (uint32_t)(this->capacity / 2));
+    if (this->max_readahead == 0) this->max_readahead = 1;
+}
+
+int64_t BlockCache::read(uint64_t offset, void* buffer, uint32_t length) {
+    counters.reads++;
+    if (!buffer || offset >= object_size || length == 0) return 0;
+    if ((uint64_t)length > object_size - offset) {
+        length = (uint32_t)(object_size - offset);
+    }
+
+    uint8_t* out = (uint8_t*)buffer;
+    uint32_t copied = 0;
+    while (copied < length) {
+        uint64_t position = offset + copied;
+        uint64_t index = position / block_size;
+
+        Block* block = lookup(index);
+        if (block) {
+            counters.block_hits++;
+        } else {
+            counters.block_misses++;
+            int64_t fetched = fill(index);
+            if (fetched < 0) return copied > 0 ? copied : fetched;
+            block = lookup(index);
+            if (!block) break;
+        }
+
+        uint64_t within = position - index * block_size;
+        if (within >= block->data.size()) break; // Object shrank under us
+        uint32_t n = (uint32_t)std::min<uint64_t>(block->data.size() - within, length - copied);
+        memcpy(out + copied, block->data.data() + within, n);
+        copied += n;
+        next_sequential_block = index + 1;
+    }
+    return copied;
+}
+
+BlockCache::Block* BlockCache::lookup(uint64_t index) {
+    auto found = index_map.find(index);
+    if (found == index_map.end()) return nullptr;
+    blocks.splice(blocks.begin(), blocks, found->second);
+    return &blocks.front();
+}
+
+int64_t BlockCache::fill(uint64_t index) {
+    // Reading on from where the last read stopped: widen the fetch.
+    // Anything else is a seek and starts over with a single block.
+    if (index == next_sequential_block) {
+        readahead = std::min(readahead * 2, max_readahead);
+    } else {
+        readahead = 1;
+    }
+
+    uint64_t block_count = (object_size + block_size - 1) / block_size;
+    uint32_t span = 1;
+    while (span < readahead && index + span < block_count && index_map.find(index + span) == index_map.end()) {
+        span++;
+    }
+
+    uint64_t start = index * block_size;
+    uint32_t length = (uint32_t)std::min<uint64_t>((uint64_t)span * block_size, object_size - start);
+    staging.resize(length);
+
+    int64_t fetched = fetch(start, length, staging.data());
+    counters.fetches++;
+    if (fetched < 0) return fetched;
+    counters.bytes_fetched += (uint64_t)fetched;
+
+    for (uint64_t consumed = 0; consumed < (uint64_t)fetched; consumed += block_size) {
+        uint64_t n = std::min<uint64_t>(block_size, (uint64_t)fetched - consumed);
+        std::vector<uint8_t> data = take_buffer();
+        data.assign(staging.begin() + consumed, staging.begin() + consumed + n);
+
+        uint64_t block_index = index + consumed / block_size;
+        blocks.push_front(Block{ block_index, std::move(data) });
+        index_map[block_index] = blocks.begin();
+    }
+    return fetched;
+}
+
+// Recycles the least recently used block's buffer once the cache is full
+std::vector<uint8_t> BlockCache::take_buffer() {
+    if (blocks.size() < capacity) {
+        std::vector<uint8_t> data;
+        data.reserve(block_size);
+        return data;
+    }
+    Block& victim = blocks.back();
+    index_map.erase(victim.index);
+    std::vector<uint8_t> data = std::move(victim.data);
+    blocks.pop_back();
+    return data;
+}
+
+// MARK: - C interface
+
+struct BlockCacheHandle {
+    BlockCache cache;
+
+    BlockCacheHandle(uint64_t size, BlockCache::Fetch fetch, uint32_t block_size, size_t capacity, uint32_t max_readahead)
+        : cache(size, std::move(fetch), block_size, capacity, max_readahead) {}
+};
+
+extern "C" {
+
+BlockCacheHandle* block_cache_create(uint64_t size, BlockCacheFetchCallback fetch, const void* context,
+                                     uint32_t block_size, int capacity, uint32_t max_readahead) {
+    if (!fetch) return NULL;
+    return new BlockCacheHandle(size, [fetch, context](uint64_t offset, uint32_t length, uint8_t* out) {
+        return fetch(offset, length, out, context);
+    }, block_size ? block_size : BlockCache::DEFAULT_BLOCK_SIZE,
+       capacity > 0 ? (size_t)capacity : BlockCache::DEFAULT_CAPACITY,
+       max_readahead ? max_readahead : BlockCache::DEFAULT_MAX_READAHEAD);
+}
+
+void block_cache_free(BlockCacheHandle* cache) {
+    delete cache;
+}
+
+int64_t block_cache_read(BlockCacheHandle* cache, uint64_t offset, void* buffer, uint32_t length) {
+    if (!cache || (!buffer && length > 0)) return -1;
+    return cache->cache.read(offset, buffer, length);
+}
+
+BlockCacheStats block_cache_stats(BlockCacheHandle* cache) {
+    BlockCacheStats stats = {};
+    if (!cache) return stats;
+    const BlockCache::Stats& counters = cache->cache.stats();
+    stats.reads = counters.reads;
+    stats.fetches = counters.fetches;
+    stats.bytes_fetched = counters.bytes_fetched;
+    stats.block_hits = counters.block_hits;
+    stats.block_misses = counters.block_misses;
+    return stats;
+}
+
+} // extern "C"
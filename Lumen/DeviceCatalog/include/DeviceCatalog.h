@@ -0,0 +1,50 @@
+#ifndef DeviceCatalog_h
+#define DeviceCatalog_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// C interface to DeviceCatalog (DeviceCatalog.hpp) for Swift. The bridges
+// use the C++ class directly; this copies whole folders in and out.
+
+// Structs to pass data to Swift
+typedef struct {
+    uint64_t id;
+    char name[256];
+    uint64_t size;
+    uint64_t modification_date;
+    uint32_t storage_id;
+    uint32_t parent_id;
+    bool is_directory;
+} DeviceCatalogItem;
+
+typedef struct DeviceCatalogHandle DeviceCatalogHandle;
+
+DeviceCatalogHandle* device_catalog_create(void);
+// Closes without saving
+void device_catalog_free(DeviceCatalogHandle* catalog);
+
+// Maps <directory>/<prefix>-<device_key>.catalog, see DeviceCatalog::open
+bool device_catalog_open(DeviceCatalogHandle* catalog, const char* directory, const char* prefix, const char* device_key);
+void device_catalog_close(DeviceCatalogHandle* catalog);
+
+void device_catalog_put(DeviceCatalogHandle* catalog, const char* key, const DeviceCatalogItem* items, int count, int64_t listed_at);
+// Fills up to max items. Returns the folder's entry count, or -1 if the folder is unknown.
+// listed_at (optional) receives the Unix timestamp of the listing.
+int device_catalog_get(DeviceCatalogHandle* catalog, const char* key, DeviceCatalogItem* items, int max, int64_t* listed_at);
+void device_catalog_invalidate(DeviceCatalogHandle* catalog, const char* key);
+void device_catalog_invalidate_tree(DeviceCatalogHandle* catalog, const char* key);
+
+bool device_catalog_save(DeviceCatalogHandle* catalog);
+int device_catalog_folder_count(DeviceCatalogHandle* catalog);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DeviceCatalog_h */
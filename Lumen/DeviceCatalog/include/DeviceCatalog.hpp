@@ -0,0 +1,128 @@
+#ifndef DeviceCatalog_hpp
+#define DeviceCatalog_hpp
+
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Persistent snapshot of the folders a bridge has listed on one device.
+//
+// The file is a fixed little-endian layout that is used straight from mmap:
+//   header | folder table (sorted by key) | entry records | name bytes
+// Looking a folder up is a binary search over the folder table and hands back
+// pointers into the mapping, so reopening a device costs one mmap, no parsing.
+// New listings collect in memory and are merged into a fresh file by save(),
+// which writes a temp file and renames it over the old one.
+
+static const uint32_t DEVICE_CATALOG_VERSION = 1;
+
+#pragma pack(push, 1)
+struct DeviceCatalogEntry {
+    uint64_t id;
+    uint64_t size;
+    uint64_t modification_date;
+    uint32_t storage_id;
+    uint32_t parent_id;
+    uint32_t name_offset;       // Into the folder's name bytes
+    uint16_t name_length;
+    uint8_t is_directory;
+    uint8_t reserved;
+};
+#pragma pack(pop)
+
+// A listed folder, backed either by the mapping or by a pending listing.
+// Pointers stay valid until the next put(), save() or close().
+struct DeviceCatalogFolder {
+    const DeviceCatalogEntry* entries;
+    uint32_t count;
+    const char* names;
+    size_t names_size;
+    int64_t listed_at;          // Unix timestamp of the listing
+};
+
+// Copies an entry's name into a fixed buffer. False if the record points
+// outside its folder, which only a damaged file can produce.
+inline bool device_catalog_copy_name(const DeviceCatalogFolder& folder, const DeviceCatalogEntry& entry,
+                                     char* out, size_t out_size) {
+    if ((size_t)entry.name_offset + entry.name_length > folder.names_size || out_size == 0) return false;
+    size_t length = entry.name_length < out_size - 1 ? entry.name_length : out_size - 1;
+    for (size_t i = 0; i < length; i++) out[i] = folder.names[entry.name_offset + i];
+    out[length] = '\0';
+    return true;
+}
+
+class DeviceCatalog {
+public:
+    DeviceCatalog() = default;
+    ~DeviceCatalog();
+    DeviceCatalog(const DeviceCatalog&) = delete;
+    DeviceCatalog& operator=(const DeviceCatalog&) = delete;
+
+    // Maps <directory>/<prefix>-<device_key>.catalog if it exists and is valid.
+    // Returns false only when the device key or directory is unusable; a missing
+    // or stale file just starts an empty catalog.
+    bool open(const std::string& directory, const std::string& prefix, const std::string& device_key);
+    // Drops the mapping and pending listings without saving
+    void close();
+    bool is_open();
+
+    // Copies the folder's entries out under the catalog lock.
+    // fn(const DeviceCatalogFolder&) runs only if the folder is known.
+    template <typename Fn>
+    bool with_folder(const std::string& key, Fn fn) {
+        std::lock_guard<std::mutex> guard(lock);
+        DeviceCatalogFolder folder;
+        if (!find(key, folder)) return false;
+        fn(folder);
+        return true;
+    }
+
+    // Records a fresh listing. Names are copied.
+    void put(const std::string& key, const std::vector<DeviceCatalogEntry>& entries,
+             const std::vector<std::string>& names, int64_t listed_at);
+    // Same, with the names already packed into one blob that each entry's
+    // name_offset and name_length point into. Re-listing a known folder
+    // reuses its pending buffers.
+    void put(const std::string& key, const DeviceCatalogEntry* entries, size_t count,
+             const char* names, size_t names_size, int64_t listed_at);
+    // Forgets a folder, e.g. after its contents changed under us
+    void invalidate(const std::string& key);
+    // Forgets a folder and every key below it ("key/..."), for path-keyed
+    // catalogs where a moved or deleted folder takes its subtree along
+    void invalidate_tree(const std::string& key);
+
+    // Writes pending listings to disk and remaps. No-op when nothing changed.
+    bool save();
+
+    size_t folder_count();
+
+private:
+    struct Pending {
+        std::vector<DeviceCatalogEntry> entries;
+        std::string names;
+        int64_t listed_at = 0;
+        bool removed = false;
+    };
+
+    bool find(const std::string& key, DeviceCatalogFolder& folder);
+    bool find_mapped(const std::string& key, DeviceCatalogFolder& folder) const;
+    void remove_pending(const std::string& key);
+    bool map_file();
+    void unmap_file();
+
+    std::mutex lock;
+    bool opened = false;
+    std::string path;
+    uint64_t device_hash = 0;
+
+    const uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+    uint32_t mapped_folders = 0;
+
+    std::map<std::string, Pending> pending;
+};
+
+#endif /* DeviceCatalog_hpp */
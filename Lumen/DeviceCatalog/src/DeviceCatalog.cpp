@@ -0,0 +1,527 @@
+#include "DeviceCatalog.hpp"
+#include "DeviceCatalog.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+static const char CATALOG_MAGIC[8] = { 'L', 'U', 'M', 'E', 'N', 'C', 'A', 'T' };
+
+#pragma pack(push, 1)
+struct CatalogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t folder_record_size;
+    uint32_t entry_record_size;
+    uint64_t device_hash;       // Guards against two keys sanitizing to one file name
+    uint32_t folder_count;
+    uint32_t entry_count;
+    uint64_t folders_offset;
+    uint64_t entries_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t file_size;         // A torn write fails this check
+};
+
+struct CatalogFolderRecord {
+    uint64_t key_offset;        // Into the string pool
+    uint64_t names_offset;      // Into the string pool
+    uint32_t first_entry;
+    uint32_t entry_count;
+    uint32_t key_length;
+    uint32_t names_size;
+    int64_t listed_at;
+};
+#pragma pack(pop)
+
+static uint64_t hash_key(const std::string& key) {
+    // FNV-1a, 64 bit
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static std::string sanitize(const std::string& key) {
+    std::string out;
+    for (char c : key) {
+        bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+        out += safe ? c : '_';
+    }
+    return out;
+}
+
+static int compare_key(const char* a, size_t a_length, const std::string& b) {
+    int c = memcmp(a, b.data(), a_length < b.size() ? a_length : b.size());
+    if (c != 0) return c;
+    return a_length < b.size() ? -1 : (a_length > b.size() ? 1 : 0);
+}
+
+static bool fits(uint64_t offset, uint64_t length, uint64_t limit) {
+    return offset <= limit && length <= limit - offset;
+}
+
+DeviceCatalog::~DeviceCatalog() {
+    close();
+}
+
+bool DeviceCatalog::open(const std::string& directory, const std::string& prefix, const std::string& device_key) {
+    if (directory.empty() || device_key.empty()) return false;
+
+    std::string new_path = directory;
+    if (new_path.back() != '/') new_path += '/';
+    new_path += prefix + "-" + sanitize(device_key) + ".catalog";
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (opened && path == new_path) return true;
+
+    unmap_file();
+    pending.clear();
+    path = new_path;
+    device_hash = hash_key(device_key);
+    opened = true;
+
+    if (!map_file()) {
+        // Missing, old version or damaged: start over, the next save replaces it
+        unmap_file();
+    }
+    return true;
+}
+
+void DeviceCatalog::close() {
+    std::lock_guard<std::mutex> guard(lock);
+    unmap_file();
+    pending.clear();
+    opened = false;
+    path.clear();
+}
+
+bool DeviceCatalog::is_open() {
+    std::lock_guard<std::mutex> guard(lock);
+    return opened;
+}
+
+size_t DeviceCatalog::folder_count() {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t count = mapped_folders;
+    for (const auto& item : pending) {
+        DeviceCatalogFolder folder;
+        bool mapped = find_mapped(item.first, folder);
+        if (item.second.removed && mapped) count--;
+        if (!item.second.removed && !mapped) count++;
+    }
+    return count;
+}
+
+void DeviceCatalog::put(const std::string& key, const std::vector<DeviceCatalogEntry>& entries,
+                        const std::vector<std::string>& names, int64_t listed_at) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!opened) return;
+
+    Pending& folder = pending[key];
+    folder.entries = entries;
+    folder.names.clear();
+    folder.listed_at = listed_at;
+    folder.removed = false;
+    for (size_t i = 0; i < folder.entries.size() && i < names.size(); i++) {
+        size_t length = names[i].size() > 0xFFFF ? 0xFFFF : names[i].size();
+        folder.entries[i].name_offset = (uint32_t)folder.names.size();
+        folder.entries[i].name_length = (uint16_t)length;
+        folder.names.append(names[i], 0, length);
+    }
+}
+
+void DeviceCatalog::put(const std::string& key, const DeviceCatalogEntry* entries, size_t count,
+                        const char* names, size_t names_size, int64_t listed_at) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!opened) return;
+
+    Pending& folder = pending[key];
+    folder.entries.assign(entries, entries + count);
+    folder.names.assign(names, names_size);
+    folder.listed_at = listed_at;
+    folder.removed = false;
+}
+
+void DeviceCatalog::invalidate(const std::string& key) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!opened) return;
+    remove_pending(key);
+}
+
+static bool in_tree(const char* candidate, size_t length, const std::string& key) {
+    if (length < key.size() || memcmp(candidate, key.data(), key.size()) != 0) return false;
+    return length == key.size() || candidate[key.size()] == '/' || (!key.empty() && key.back() == '/');
+}
+
+void DeviceCatalog::invalidate_tree(const std::string& key) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!opened) return;
+
+    // Keys under the folder all sort at or after it and share its bytes,
+    // so both walks start at the folder and stop at the first other prefix
+    std::vector<std::string> doomed;
+    for (auto it = pending.lower_bound(key); it != pending.end(); ++it) {
+        if (it->first.compare(0, key.size(), key) != 0) break;
+        if (in_tree(it->first.data(), it->first.size(), key)) doomed.push_back(it->first);
+    }
+
+    if (mapping) {
+        const CatalogHeader* header = (const CatalogHeader*)mapping;
+        const CatalogFolderRecord* folders = (const CatalogFolderRecord*)(mapping + header->folders_offset);
+        const char* strings = (const char*)(mapping + header->strings_offset);
+
+        uint32_t low = 0;
+        uint32_t high = mapped_folders;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            if (compare_key(strings + folders[middle].key_offset, folders[middle].key_length, key) < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        for (uint32_t i = low; i < mapped_folders; i++) {
+            const char* candidate = strings + folders[i].key_offset;
+            size_t length = folders[i].key_length;
+            if (length < key.size() || memcmp(candidate, key.data(), key.size()) != 0) break;
+            if (in_tree(candidate, length, key)) doomed.push_back(std::string(candidate, length));
+        }
+    }
+
+    for (const std::string& doomed_key : doomed) {
+        remove_pending(doomed_key);
+    }
+}
+
+void DeviceCatalog::remove_pending(const std::string& key) {
+    Pending& folder = pending[key];
+    folder.entries.clear();
+    folder.names.clear();
+    folder.removed = true;
+}
+
+bool DeviceCatalog::find(const std::string& key, DeviceCatalogFolder& folder) {
+    if (!opened) return false;
+
+    auto found = pending.find(key);
+    if (found != pending.end()) {
+        if (found->second.removed) return false;
+        folder.entries = found->second.entries.data();
+        folder.count = (uint32_t)found->second.entries.size();
+        folder.names = found->second.names.data();
+        folder.names_size = found->second.names.size();
+        folder.listed_at = found->second.listed_at;
+        return true;
+    }
+    return find_mapped(key, folder);
+}
+
+bool DeviceCatalog::find_mapped(const std::string& key, DeviceCatalogFolder& folder) const {
+    if (!mapping) return false;
+
+    const CatalogHeader* header = (const CatalogHeader*)mapping;
+    const CatalogFolderRecord* folders = (const CatalogFolderRecord*)(mapping + header->folders_offset);
+    const char* strings = (const char*)(mapping + header->strings_offset);
+
+    uint32_t low = 0;
+    uint32_t high = mapped_folders;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        const CatalogFolderRecord& record = folders[middle];
+        int c = compare_key(strings + record.key_offset, record.key_length, key);
+        if (c == 0) {
+            folder.entries = (const DeviceCatalogEntry*)(mapping + header->entries_offset) + record.first_entry;
+            folder.count = record.entry_count;
+            folder.names = strings + record.names_offset;
+            folder.names_size = record.names_size;
+            folder.listed_at = record.listed_at;
+            return true;
+        }
+        if (c < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+bool DeviceCatalog::map_file() {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CatalogHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    mapping = (const uint8_t*)map;
+    mapping_size = (size_t)st.st_size;
+
+    // Validate the layout once so lookups can trust every offset
+    const CatalogHeader* header = (const CatalogHeader*)mapping;
+    uint64_t size = mapping_size;
+    if (memcmp(header->magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0 ||
+        header->version != DEVICE_CATALOG_VERSION ||
+        header->header_size != sizeof(CatalogHeader) ||
+        header->folder_record_size != sizeof(CatalogFolderRecord) ||
+        header->entry_record_size != sizeof(DeviceCatalogEntry) ||
+        header->device_hash != device_hash ||
+        header->file_size != size ||
+        !fits(header->folders_offset, (uint64_t)header->folder_count * sizeof(CatalogFolderRecord), size) ||
+        !fits(header->entries_offset, (uint64_t)header->entry_count * sizeof(DeviceCatalogEntry), size) ||
+        !fits(header->strings_offset, header->strings_size, size)) {
+        return false;
+    }
+
+    const CatalogFolderRecord* folders = (const CatalogFolderRecord*)(mapping + header->folders_offset);
+    for (uint32_t i = 0; i < header->folder_count; i++) {
+        const CatalogFolderRecord& record = folders[i];
+        if (!fits(record.key_offset, record.key_length, header->strings_size) ||
+            !fits(record.names_offset, record.names_size, header->strings_size) ||
+            !fits(record.first_entry, record.entry_count, header->entry_count)) {
+            return false;
+        }
+    }
+
+    mapped_folders = header->folder_count;
+    return true;
+}
+
+void DeviceCatalog::unmap_file() {
+    if (mapping) {
+        munmap((void*)mapping, mapping_size);
+    }
+    mapping = nullptr;
+    mapping_size = 0;
+    mapped_folders = 0;
+}
+
+bool DeviceCatalog::save() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!opened) return false;
+    if (pending.empty()) return true;
+
+    // Merge the mapped folders with pending listings, both already in key order
+    struct Source {
+        std::string key;
+        DeviceCatalogFolder folder;
+    };
+    std::vector<Source> folders;
+    folders.reserve(mapped_folders + pending.size());
+
+    const CatalogHeader* header = mapping ? (const CatalogHeader*)mapping : nullptr;
+    const CatalogFolderRecord* records = header ? (const CatalogFolderRecord*)(mapping + header->folders_offset) : nullptr;
+    const char* strings = header ? (const char*)(mapping + header->strings_offset) : nullptr;
+
+    uint32_t m = 0;
+    auto p = pending.begin();
+    while (m < mapped_folders || p != pending.end()) {
+        std::string mapped_key;
+        if (m < mapped_folders) {
+            mapped_key.assign(strings + records[m].key_offset, records[m].key_length);
+        }
+        bool take_pending = m >= mapped_folders || (p != pending.end() && p->first <= mapped_key);
+        if (take_pending) {
+            if (m < mapped_folders && p->first == mapped_key) m++;  // Replaced
+            if (!p->second.removed) {
+                Source source;
+                source.key = p->first;
+                find(p->first, source.folder);
+                folders.push_back(source);
+            }
+            ++p;
+        } else {
+            Source source;
+            source.key = mapped_key;
+            find_mapped(mapped_key, source.folder);
+            folders.push_back(source);
+            m++;
+        }
+    }
+
+    uint64_t entry_count = 0;
+    uint64_t strings_size = 0;
+    for (const Source& source : folders) {
+        entry_count += source.folder.count;
+        strings_size += source.key.size() + source.folder.names_size;
+    }
+    if (entry_count > 0xFFFFFFFFull) return false;
+
+    CatalogHeader out;
+    memset(&out, 0, sizeof(out));
+    memcpy(out.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    out.version = DEVICE_CATALOG_VERSION;
+    out.header_size = sizeof(CatalogHeader);
+    out.folder_record_size = sizeof(CatalogFolderRecord);
+    out.entry_record_size = sizeof(DeviceCatalogEntry);
+    out.device_hash = device_hash;
+    out.folder_count = (uint32_t)folders.size();
+    out.entry_count = (uint32_t)entry_count;
+    out.folders_offset = sizeof(CatalogHeader);
+    out.entries_offset = out.folders_offset + folders.size() * sizeof(CatalogFolderRecord);
+    out.strings_offset = out.entries_offset + entry_count * sizeof(DeviceCatalogEntry);
+    out.strings_size = strings_size;
+    out.file_size = out.strings_offset + strings_size;
+
+    std::vector<uint8_t> buffer((size_t)out.file_size);
+    memcpy(buffer.data(), &out, sizeof(out));
+
+    CatalogFolderRecord* out_folders = (CatalogFolderRecord*)(buffer.data() + out.folders_offset);
+    DeviceCatalogEntry* out_entries = (DeviceCatalogEntry*)(buffer.data() + out.entries_offset);
+    char* out_strings = (char*)(buffer.data() + out.strings_offset);
+
+    uint32_t next_entry = 0;
+    uint64_t next_string = 0;
+    for (size_t i = 0; i < folders.size(); i++) {
+        const Source& source = folders[i];
+        CatalogFolderRecord record;
+        record.key_offset = next_string;
+        record.key_length = (uint32_t)source.key.size();
+        memcpy(out_strings + next_string, source.key.data(), source.key.size());
+        next_string += source.key.size();
+
+        record.names_offset = next_string;
+        record.names_size = (uint32_t)source.folder.names_size;
+        memcpy(out_strings + next_string, source.folder.names, source.folder.names_size);
+        next_string += source.folder.names_size;
+
+        record.first_entry = next_entry;
+        record.entry_count = source.folder.count;
+        memcpy(out_entries + next_entry, source.folder.entries, source.folder.count * sizeof(DeviceCatalogEntry));
+        next_entry += source.folder.count;
+
+        record.listed_at = source.folder.listed_at;
+        memcpy(out_folders + i, &record, sizeof(record));
+    }
+
+    std::string temp_path = path + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t n = write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ::close(fd);
+            unlink(temp_path.c_str());
+            return false;
+        }
+        written += (size_t)n;
+    }
+    ::close(fd);
+
+    if (rename(temp_path.c_str(), path.c_str()) != 0) {
+        unlink(temp_path.c_str());
+        return false;
+    }
+
+    unmap_file();
+    pending.clear();
+    if (!map_file()) {
+        unmap_file();
+        return false;
+    }
+    return true;
+}
+
+// MARK: - C interface
+
+struct DeviceCatalogHandle {
+    DeviceCatalog catalog;
+};
+
+extern "C" {
+
+DeviceCatalogHandle* device_catalog_create(void) {
+    return new DeviceCatalogHandle();
+}
+
+void device_catalog_free(DeviceCatalogHandle* catalog) {
+    delete catalog;
+}
+
+bool device_catalog_open(DeviceCatalogHandle* catalog, const char* directory, const char* prefix, const char* device_key) {
+    if (!catalog || !directory || !prefix || !device_key) return false;
+    return catalog->catalog.open(directory, prefix, device_key);
+}
+
+void device_catalog_close(DeviceCatalogHandle* catalog) {
+    if (catalog) catalog->catalog.close();
+}
+
+void device_catalog_put(DeviceCatalogHandle* catalog, const char* key, const DeviceCatalogItem* items, int count, int64_t listed_at) {
+    if (!catalog || !key || count < 0 || (count > 0 && !items)) return;
+
+    std::vector<DeviceCatalogEntry> entries(count);
+    std::string names;
+    for (int i = 0; i < count; i++) {
+        DeviceCatalogEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.id = items[i].id;
+        entry.size = items[i].size;
+        entry.modification_date = items[i].modification_date;
+        entry.storage_id = items[i].storage_id;
+        entry.parent_id = items[i].parent_id;
+        entry.is_directory = items[i].is_directory ? 1 : 0;
+        size_t length = strnlen(items[i].name, sizeof(items[i].name));
+        entry.name_offset = (uint32_t)names.size();
+        entry.name_length = (uint16_t)length;
+        names.append(items[i].name, length);
+    }
+    catalog->catalog.put(key, entries.data(), entries.size(), names.data(), names.size(), listed_at);
+}
+
+int device_catalog_get(DeviceCatalogHandle* catalog, const char* key, DeviceCatalogItem* items, int max, int64_t* listed_at) {
+    if (!catalog || !key) return -1;
+
+    int count = -1;
+    catalog->catalog.with_folder(key, [&](const DeviceCatalogFolder& folder) {
+        count = (int)folder.count;
+        if (listed_at) *listed_at = folder.listed_at;
+        for (int i = 0; items && i < count && i < max; i++) {
+            const DeviceCatalogEntry& entry = folder.entries[i];
+            DeviceCatalogItem& item = items[i];
+            if (!device_catalog_copy_name(folder, entry, item.name, sizeof(item.name))) item.name[0] = '\0';
+            item.id = entry.id;
+            item.size = entry.size;
+            item.modification_date = entry.modification_date;
+            item.storage_id = entry.storage_id;
+            item.parent_id = entry.parent_id;
+            item.is_directory = entry.is_directory != 0;
+        }
+    });
+    return count;
+}
+
+void device_catalog_invalidate(DeviceCatalogHandle* catalog, const char* key) {
+    if (catalog && key) catalog->catalog.invalidate(key);
+}
+
+void device_catalog_invalidate_tree(DeviceCatalogHandle* catalog, const char* key) {
+    if (catalog && key) catalog->catalog.invalidate_tree(key);
+}
+
+bool device_catalog_save(DeviceCatalogHandle* catalog) {
+    return catalog && catalog->catalog.save();
+}
+
+int device_catalog_folder_count(DeviceCatalogHandle* catalog) {
+    return catalog ? (int)catalog->catalog.folder_count() : 0;
+}
+
+} // extern "C"
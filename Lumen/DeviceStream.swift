@@ -0,0 +1,196 @@
+//
+//  DeviceStream.swift
+//  One Share
+//
+
+import Foundation
+import AVFoundation
+import AVKit
+import SwiftUI
+import UniformTypeIdentifiers
+
+// Random-access reader over a file on a device, backed by a native stream
+// (mtp_stream_* / ios_stream_*). Reads run on the queue the owning service
+// hands in, so MTP streams stay serialized with the rest of the MTP traffic.
+final class DeviceStream: @unchecked Sendable {
+    let size: Int64
+
+    private let queue: DispatchQueue
+    private let readChunk: (UInt64, UnsafeMutableRawPointer, UInt32) -> Int64
+    private let closeStream: () -> Void
+    private var closed = false
+
+    init(size: Int64, queue: DispatchQueue,
+         read: @escaping (UInt64, UnsafeMutableRawPointer, UInt32) -> Int64,
+         close: @escaping () -> Void) {
+        self.size = size
+        self.queue = queue
+        self.readChunk = read
+        self.closeStream = close
+    }
+
+    deinit {
+        if !closed {
+            let closeStream = self.closeStream
+            queue.async { closeStream() }
+        }
+    }
+
+    // Data is short only at the end of the file
+    func read(at offset: Int64, length: Int, completion: @escaping (Result<Data, Error>) -> Void) {
+        queue.async {
+            guard !self.closed else {
+                completion(.failure(NSError(domain: "DeviceStream", code: -1, userInfo: [NSLocalizedDescriptionKey: "Stream closed"])))
+                return
+            }
+            var data = Data(count: length)
+            let ret = data.withUnsafeMutableBytes { buffer -> Int64 in
+                guard let base = buffer.baseAddress else { return 0 }
+                return self.readChunk(UInt64(offset), base, UInt32(length))
+            }
+            if ret < 0 {
+                completion(.failure(NSError(domain: "DeviceStream", code: Int(ret), userInfo: [NSLocalizedDescriptionKey: "Failed to read from device"])))
+                return
+            }
+            data.count = Int(ret)
+            completion(.success(data))
+        }
+    }
+
+    func read(at offset: Int64, length: Int) async throws -> Data {
+        try await withCheckedThrowingContinuation { continuation in
+            read(at: offset, length: length) { continuation.resume(with: $0) }
+        }
+    }
+
+    func close() {
+        queue.async {
+            guard !self.closed else { return }
+            self.closed = true
+            self.closeStream()
+        }
+    }
+}
+
+// Services that can read device files in place instead of downloading them
+protocol StreamingFileService: FileService {
+    func openStream(for item: FileSystemItem) async throws -> DeviceStream
+}
+
+// Feeds AVPlayer from a DeviceStream through a custom URL scheme, answering
+// the byte ranges the player asks for as it probes, plays and seeks.
+final class DeviceStreamLoader: NSObject, AVAssetResourceLoaderDelegate {
+    static let scheme = "onesharestream"
+
+    private let stream: DeviceStream
+    private let contentType: String?
+    // Matches the native block size so each response is one cache block
+    private let chunkSize = 512 * 1024
+
+    init(stream: DeviceStream, fileName: String) {
+        self.stream = stream
+        self.contentType = UTType(filenameExtension: (fileName as NSString).pathExtension)?.identifier
+    }
+
+    func resourceLoader(_ resourceLoader: AVAssetResourceLoader, shouldWaitForLoadingOfRequestedResource loadingRequest: AVAssetResourceLoadingRequest) -> Bool {
+        if let info = loadingRequest.contentInformationRequest {
+            info.contentType = contentType
+            info.contentLength = stream.size
+            info.isByteRangeAccessSupported = true
+        }
+
+        guard let dataRequest = loadingRequest.dataRequest else {
+            loadingRequest.finishLoading()
+            return true
+        }
+
+        let start = dataRequest.currentOffset != 0 ? dataRequest.currentOffset : dataRequest.requestedOffset
+        let end = dataRequest.requestsAllDataToEndOfResource
+            ? stream.size
+            : min(stream.size, dataRequest.requestedOffset + Int64(dataRequest.requestedLength))
+        respond(to: loadingRequest, from: start, to: end)
+        return true
+    }
+
+    private func respond(to loadingRequest: AVAssetResourceLoadingRequest, from offset: Int64, to end: Int64) {
+        guard !loadingRequest.isCancelled else { return }
+        guard offset < end, let dataRequest = loadingRequest.dataRequest else {
+            loadingRequest.finishLoading()
+            return
+        }
+
+        let length = Int(min(Int64(chunkSize), end - offset))
+        stream.read(at: offset, length: length) { [weak self] result in
+            switch result {
+            case .success(let data):
+                guard !loadingRequest.isCancelled else { return }
+                if data.isEmpty {
+                    loadingRequest.finishLoading()
+                    return
+                }
+                dataRequest.respond(with: data)
+                self?.respond(to: loadingRequest, from: offset + Int64(data.count), to: end)
+            case .failure(let error):
+                if !loadingRequest.isCancelled {
+                    loadingRequest.finishLoading(with: error)
+                }
+            }
+        }
+    }
+}
+
+// One open stream with its player, presented as a sheet from the browser
+final class DeviceStreamPlayback: Identifiable {
+    let id = UUID()
+    let name: String
+    let player: AVPlayer
+
+    private let stream: DeviceStream
+    // AVAssetResourceLoader only keeps a weak reference to its delegate
+    private let loader: DeviceStreamLoader
+    private let loaderQueue = DispatchQueue(label: "com.oneshare.stream.loader")
+
+    init?(stream: DeviceStream, name: String) {
+        let encodedName = name.addingPercentEncoding(withAllowedCharacters: .urlPathAllowed) ?? "media"
+        guard let url = URL(string: "\(DeviceStreamLoader.scheme)://device/\(encodedName)") else { return nil }
+
+        self.name = name
+        self.stream = stream
+        self.loader = DeviceStreamLoader(stream: stream, fileName: name)
+
+        let asset = AVURLAsset(url: url)
+        asset.resourceLoader.setDelegate(loader, queue: loaderQueue)
+        self.player = AVPlayer(playerItem: AVPlayerItem(asset: asset))
+    }
+
+    func stop() {
+        player.pause()
+        player.replaceCurrentItem(with: nil)
+        stream.close()
+    }
+}
+
+struct DeviceStreamPlayerView: View {
+    let playback: DeviceStreamPlayback
+    @Environment(\.dismiss) private var dismiss
+
+    var body: some View {
+        VStack(spacing: 0) {
+            HStack {
+                Text(playback.name)
+                    .font(.headline)
+                    .lineLimit(1)
+                    .truncationMode(.middle)
+                Spacer()
+                Button("Done") { dismiss() }
+                    .keyboardShortcut(.cancelAction)
+            }
+            .padding()
+
+            VideoPlayer(player: playback.player)
+                .frame(minWidth: 640, minHeight: 360)
+        }
+        .onAppear { playback.player.play() }
+        .onDisappear { playback.stop() }
+    }
+}
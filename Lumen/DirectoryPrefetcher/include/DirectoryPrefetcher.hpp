@@ -0,0 +1,87 @@
+#ifndef DirectoryPrefetcher_hpp
+#define DirectoryPrefetcher_hpp
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Lists folders the user is likely to open next while the device is idle.
+//
+// The bridge hands in the subfolders of the folder being shown (in display
+// order) and, as the pointer moves, the folder under it, which jumps the
+// queue. A worker thread lists them one at a time through the bridge's own
+// listing, which records the result in the bridge's listing cache.
+//
+// Real work always goes first. Every bridge call that talks to the device
+// holds a Foreground for its duration; the worker only starts a folder once
+// no Foreground is held and the bus has been quiet for idle_delay, and a
+// Foreground that arrives mid-folder waits for that one listing, never more.
+// Foregrounds do not exclude each other, so bridges that run operations in
+// parallel keep doing so.
+class DirectoryPrefetcher {
+public:
+    // Lists one folder and records it. Skips folders that are already fresh.
+    typedef std::function<void(const std::string& key)> List;
+
+    static const size_t DEFAULT_MAX_PENDING = 32;
+
+    explicit DirectoryPrefetcher(List list,
+                                 std::chrono::milliseconds idle_delay = std::chrono::milliseconds(250),
+                                 size_t max_pending = DEFAULT_MAX_PENDING);
+    ~DirectoryPrefetcher();
+    DirectoryPrefetcher(const DirectoryPrefetcher&) = delete;
+    DirectoryPrefetcher& operator=(const DirectoryPrefetcher&) = delete;
+
+    // Held by real work. Nests. The List callback must not take one.
+    class Foreground {
+    public:
+        explicit Foreground(DirectoryPrefetcher& prefetcher);
+        ~Foreground();
+        Foreground(const Foreground&) = delete;
+        Foreground& operator=(const Foreground&) = delete;
+    private:
+        DirectoryPrefetcher& prefetcher;
+    };
+
+    // Replaces the queue with the subfolders of a newly shown folder.
+    // Keeps a pending hint, since the pointer may still be over it.
+    void schedule(const std::vector<std::string>& keys);
+    // The folder under the pointer: listed before anything else
+    void hint(const std::string& key);
+    // Drops everything queued, e.g. on disconnect. A listing in flight finishes.
+    void cancel();
+
+    size_t pending();
+    uint64_t completed() const { return listed.load(); }
+
+private:
+    void run();
+    bool idle_for(std::chrono::steady_clock::duration& wait);
+
+    List list;
+    std::chrono::milliseconds idle_delay;
+    size_t max_pending;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    // Real work in progress, and whether the worker is listing a folder.
+    // The two never overlap.
+    int foreground = 0;
+    bool prefetching = false;
+    std::chrono::steady_clock::time_point last_foreground;
+    std::deque<std::string> queue;
+    std::string hinted;
+    bool stopping = false;
+    std::thread worker;
+
+    std::atomic<uint64_t> listed{0};
+};
+
+#endif /* DirectoryPrefetcher_hpp */
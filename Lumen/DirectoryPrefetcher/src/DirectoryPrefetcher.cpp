@@ -0,0 +1,121 @@
+#include "DirectoryPrefetcher.hpp"
+
+#include <algorithm>
+
+DirectoryPrefetcher::DirectoryPrefetcher(List list, std::chrono::milliseconds idle_delay, size_t max_pending)
+    : list(std::move(list)),
+      idle_delay(idle_delay),
+      max_pending(max_pending > 0 ? max_pending : DEFAULT_MAX_PENDING) {}
+
+DirectoryPrefetcher::~DirectoryPrefetcher() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        queue.clear();
+        hinted.clear();
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+DirectoryPrefetcher::Foreground::Foreground(DirectoryPrefetcher& prefetcher) : prefetcher(prefetcher) {
+    std::unique_lock<std::mutex> guard(prefetcher.lock);
+    // Counted first so the worker does not start another folder while we wait
+    prefetcher.foreground++;
+    prefetcher.wake.wait(guard, [&] { return !prefetcher.prefetching; });
+}
+
+DirectoryPrefetcher::Foreground::~Foreground() {
+    std::lock_guard<std::mutex> guard(prefetcher.lock);
+    prefetcher.last_foreground = std::chrono::steady_clock::now();
+    if (--prefetcher.foreground == 0) {
+        prefetcher.wake.notify_all();
+    }
+}
+
+void DirectoryPrefetcher::schedule(const std::vector<std::string>& keys) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        queue.clear();
+        for (const std::string& key : keys) {
+            if (queue.size() >= max_pending) break;
+            if (key == hinted || std::find(queue.begin(), queue.end(), key) != queue.end()) continue;
+            queue.push_back(key);
+        }
+        if (!worker.joinable() && !queue.empty()) {
+            worker = std::thread(&DirectoryPrefetcher::run, this);
+        }
+    }
+    wake.notify_all();
+}
+
+void DirectoryPrefetcher::hint(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (key.empty() || key == hinted) return;
+        // A previous hint the pointer has left is still a likely pick
+        if (!hinted.empty() && queue.size() < max_pending) queue.push_front(hinted);
+        hinted = key;
+        queue.erase(std::remove(queue.begin(), queue.end(), key), queue.end());
+        if (!worker.joinable()) {
+            worker = std::thread(&DirectoryPrefetcher::run, this);
+        }
+    }
+    wake.notify_all();
+}
+
+void DirectoryPrefetcher::cancel() {
+    std::lock_guard<std::mutex> guard(lock);
+    queue.clear();
+    hinted.clear();
+}
+
+size_t DirectoryPrefetcher::pending() {
+    std::lock_guard<std::mutex> guard(lock);
+    return queue.size() + (hinted.empty() ? 0 : 1);
+}
+
+// Called with lock held. True once nothing is in the foreground and the bus
+// has been quiet long enough; otherwise how long to wait before looking again.
+bool DirectoryPrefetcher::idle_for(std::chrono::steady_clock::duration& wait) {
+    if (foreground > 0) {
+        wait = idle_delay;
+        return false;
+    }
+    auto quiet = std::chrono::steady_clock::now() - last_foreground;
+    if (quiet >= idle_delay) return true;
+    wait = idle_delay - quiet;
+    return false;
+}
+
+void DirectoryPrefetcher::run() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (!stopping) {
+        if (hinted.empty() && queue.empty()) {
+            wake.wait(guard);
+            continue;
+        }
+        std::chrono::steady_clock::duration wait;
+        if (!idle_for(wait)) {
+            wake.wait_for(guard, wait);
+            continue;
+        }
+
+        std::string key;
+        if (!hinted.empty()) {
+            key.swap(hinted);
+        } else {
+            key = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        // Foregrounds arriving from here on wait for this one folder
+        prefetching = true;
+        guard.unlock();
+        list(key);
+        listed++;
+        guard.lock();
+        prefetching = false;
+        wake.notify_all();
+    }
+}
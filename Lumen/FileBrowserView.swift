@@ -242,6 +242,10 @@ struct FileBrowserView: View {
                     self.items = newItems
                     self.isLoading = false
                     self.updateFilteredItems()
+                    // List the subfolders in the order shown while the device is idle
+                    if let prefetching = self.fileService as? PrefetchingFileService {
+                        prefetching.prefetchFolders(self.filteredAndSortedItems.filter { $0.isDirectory })
+                    }
                 }
             } catch {
                 await MainActor.run {
@@ -405,14 +409,27 @@ struct FileBrowserView: View {
     // Delete a file
     private func deleteFile(_ item: FileSystemItem) {
         itemToDelete = item
+        // Deleting from a multi-selection deletes the whole selection
+        if selection.contains(item.id) && selection.count > 1 {
+            itemsToDelete = filteredAndSortedItems.filter { selection.contains($0.id) }
+        } else {
+            itemsToDelete = [item]
+        }
         showingDeleteConfirmation = true
     }
     
     // Perform the actual file deletion
     private func performDelete(_ item: FileSystemItem) {
+        if itemsToDelete.count > 1, let batchService = fileService as? BatchFileService {
+            performBatchDelete(itemsToDelete, on: batchService)
+            return
+        }
+        
         Task {
             do {
-                try await fileService.deleteItem(at: item.path)
+                for item in itemsToDelete.isEmpty ? [item] : itemsToDelete {
+                    try await fileService.deleteItem(at: item.path)
+                }
                 // Refresh the file list
                 await MainActor.run {
                     loadItems()
@@ -425,6 +442,26 @@ struct FileBrowserView: View {
         }
     }
     
+    // Phones delete a whole selection in one batch on the device
+    private func performBatchDelete(_ items: [FileSystemItem], on service: BatchFileService) {
+        Task {
+            do {
+                let failures = try await service.applyBatch(items.map { .delete(path: $0.path) }) { _, _ in }
+                await MainActor.run {
+                    if !failures.isEmpty {
+                        errorMessage = "Failed to delete \(failures.count) of \(items.count) items"
+                    }
+                    selection.removeAll()
+                    loadItems()
+                }
+            } catch {
+                await MainActor.run {
+                    errorMessage = "Failed to delete files: \(error.localizedDescription)"
+                }
+            }
+        }
+    }
+    
     // Handle double click on items
     private func handleDoubleClick(on item: FileSystemItem) {
         // For folders, navigate into them
@@ -443,7 +480,10 @@ struct FileBrowserView: View {
         print("Opening file with default app: \(item.path)")
 #endif
         
-        if item.path.hasPrefix("mtp://") || item.path.hasPrefix("ios://") || fileService is iOSDeviceService {
+        if (item.type == .video || item.type == .audio), let streamingService = fileService as? StreamingFileService {
+            // Play device media in place; fall back to a full download if the device can't stream
+            streamRemoteFile(item, from: streamingService)
+        } else if item.path.hasPrefix("mtp://") || item.path.hasPrefix("ios://") || fileService is iOSDeviceService {
             // For remote files (MTP/iOS), download to temp first then open
             downloadAndOpenRemoteFile(item)
         } else {
@@ -453,6 +493,23 @@ struct FileBrowserView: View {
         }
     }
     
+    private func streamRemoteFile(_ item: FileSystemItem, from service: StreamingFileService) {
+        isLoading = true
+        
+        Task {
+            let stream = try? await service.openStream(for: item)
+            await MainActor.run {
+                isLoading = false
+                if let stream = stream, let playback = DeviceStreamPlayback(stream: stream, name: item.name) {
+                    streamingPlayback = playback
+                } else {
+                    stream?.close()
+                    downloadAndOpenRemoteFile(item)
+                }
+            }
+        }
+    }
+    
     // Download a remote file (MTP/iOS) and open it
     private func downloadAndOpenRemoteFile(_ item: FileSystemItem) {
         // Show loading indicator
@@ -534,10 +591,12 @@ struct FileBrowserView: View {
     
     // State for file info sheet
     @State private var selectedFileInfoItem: FileSystemItem?
+    @State private var streamingPlayback: DeviceStreamPlayback?
     
     // State for delete confirmation
     @State private var showingDeleteConfirmation = false
     @State private var itemToDelete: FileSystemItem?
+    @State private var itemsToDelete: [FileSystemItem] = []
     
     // Computed property for the header/toolbar
     private var headerView: some View {
@@ -1395,6 +1454,11 @@ struct FileBrowserView: View {
         .contextMenu {
             fileContextMenu(for: item)
         }
+        .onHover { inside in
+            if inside && item.isDirectory, let prefetching = fileService as? PrefetchingFileService {
+                prefetching.prefetchHint(item)
+            }
+        }
         .background(
             GeometryReader { geo in
                 Color.clear.preference(
@@ -1537,6 +1601,11 @@ struct FileBrowserView: View {
         .contextMenu {
             fileContextMenu(for: item)
         }
+        .onHover { inside in
+            if inside && item.isDirectory, let prefetching = fileService as? PrefetchingFileService {
+                prefetching.prefetchHint(item)
+            }
+        }
         .background(
             GeometryReader { geo in
                 Color.clear.preference(
@@ -1862,6 +1931,9 @@ struct FileBrowserView: View {
             .sheet(item: $selectedFileInfoItem) { item in
                 FileInfoView(item: item)
             }
+            .sheet(item: $streamingPlayback) { playback in
+                DeviceStreamPlayerView(playback: playback)
+            }
             .alert("Delete File", isPresented: $showingDeleteConfirmation) {
                 Button("Cancel", role: .cancel) { }
                 Button("Delete", role: .destructive) {
@@ -1870,7 +1942,9 @@ struct FileBrowserView: View {
                     }
                 }
             } message: {
-                if let item = itemToDelete {
+                if itemsToDelete.count > 1 {
+                    Text("Are you sure you want to delete \(itemsToDelete.count) items? This action cannot be undone.")
+                } else if let item = itemToDelete {
                     Text("Are you sure you want to delete \(item.name)? This action cannot be undone.")
                 }
             }
@@ -1902,6 +1976,12 @@ struct FileBrowserView: View {
             .onChange(of: sortOrder) { _, _ in
                 updateFilteredItems()
             }
+            // A folder shown from a device snapshot turned out to be stale
+            .onReceive(NotificationCenter.default.publisher(for: Notification.Name("DeviceListingRefreshed"))) { notification in
+                if let path = notification.userInfo?["path"] as? String, path == currentPath {
+                    loadItems()
+                }
+            }
             .background(keyboardShortcuts)
             
         }
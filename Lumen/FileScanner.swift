@@ -25,9 +25,12 @@ struct FileMetadata: Codable, Identifiable, Hashable {
 
 class FileScanner: ObservableObject {
     @Published var isScanning = false
-    @Published var indexedFiles: [FileMetadata] = []
+    @Published var indexedCount = 0
     @Published var scanProgress: Double = 0.0
     
+    // Files live in the native index, not in a Swift array
+    let catalog = SearchCatalog.shared
+    
     let localService = LocalFileService()
     let mtpService: MTPService
     
@@ -38,7 +41,8 @@ class FileScanner: ObservableObject {
     func startScan() {
         guard !isScanning else { return }
         isScanning = true
-        indexedFiles.removeAll()
+        catalog.clear(source: SEARCH_SOURCE_LOCAL)
+        indexedCount = catalog.count(types: SearchCatalog.fileTypes)
         scanProgress = 0.0
         
         Task {
@@ -50,7 +54,8 @@ class FileScanner: ObservableObject {
             
             await MainActor.run {
                 self.isScanning = false
-                print("Scan complete. Indexed \(self.indexedFiles.count) files.")
+                self.indexedCount = self.catalog.count(types: SearchCatalog.fileTypes)
+                print("Scan complete. Indexed \(self.indexedCount) files.")
             }
         }
     }
@@ -72,7 +77,7 @@ class FileScanner: ObservableObject {
     private func recursiveLocalScan(at url: URL) async {
         let enumerator = FileManager.default.enumerator(at: url, includingPropertiesForKeys: [.nameKey, .fileSizeKey, .contentModificationDateKey, .isDirectoryKey], options: [.skipsHiddenFiles, .skipsPackageDescendants])
         
-        var batch: [FileMetadata] = []
+        var batchCount = 0
         
         while let fileURL = enumerator?.nextObject() as? URL {
             // Check for cancellation
@@ -88,15 +93,13 @@ class FileScanner: ObservableObject {
                     let type = getFileType(for: name)
                     
                     let metadata = FileMetadata(name: name, path: fileURL.path, size: size, modificationDate: date, type: type, isRemote: false)
-                    batch.append(metadata)
+                    catalog.add(metadata, source: SEARCH_SOURCE_LOCAL)
+                    batchCount += 1
                     
-                    // Update UI every 50 files to keep it responsive but not spam the main thread
-                    if batch.count >= 50 {
-                        let batchCopy = batch
-                        await MainActor.run {
-                            self.indexedFiles.append(contentsOf: batchCopy)
-                        }
-                        batch.removeAll()
+                    // Update UI every 500 files to keep it responsive but not spam the main thread
+                    if batchCount >= 500 {
+                        await publishCount()
+                        batchCount = 0
                     }
                 }
             } catch {
@@ -104,12 +107,16 @@ class FileScanner: ObservableObject {
             }
         }
         
-        // Append remaining
-        if !batch.isEmpty {
-            let batchCopy = batch
-            await MainActor.run {
-                self.indexedFiles.append(contentsOf: batchCopy)
-            }
+        // Count the remainder
+        if batchCount > 0 {
+            await publishCount()
+        }
+    }
+    
+    private func publishCount() async {
+        let count = catalog.count(types: SearchCatalog.fileTypes)
+        await MainActor.run {
+            self.indexedCount = count
         }
     }
     
@@ -120,28 +127,19 @@ class FileScanner: ObservableObject {
     
     private func recursiveMTPScan(at path: String) async {
         do {
+            // MTPService feeds every listing into the catalog; we only walk the tree
             let items = try await mtpService.listItems(at: path)
             
-            var batch: [FileMetadata] = []
-            
-            for item in items {
-                if item.isDirectory {
-                    // Recursive call
-                    // Limit depth or specific folders for performance
-                    if ["DCIM", "Pictures", "Download", "Music", "Movies"].contains(item.name) || path != "mtp://" {
-                         await recursiveMTPScan(at: item.path)
-                    }
-                } else {
-                    let metadata = FileMetadata(name: item.name, path: item.path, size: item.size, modificationDate: item.modificationDate, type: item.type, isRemote: true)
-                    batch.append(metadata)
+            for item in items where item.isDirectory {
+                // Recursive call
+                // Limit depth or specific folders for performance
+                if ["DCIM", "Pictures", "Download", "Music", "Movies"].contains(item.name) || path != "mtp://" {
+                     await recursiveMTPScan(at: item.path)
                 }
             }
             
-            if !batch.isEmpty {
-                let batchCopy = batch
-                await MainActor.run {
-                    self.indexedFiles.append(contentsOf: batchCopy)
-                }
+            if items.contains(where: { !$0.isDirectory }) {
+                await publishCount()
             }
             
         } catch {
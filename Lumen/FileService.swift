@@ -15,6 +15,16 @@ enum ConnectionState: String, Equatable {
     case error
 }
 
+// Where the device bridges keep their listing snapshots between connections
+func deviceCatalogDirectory() -> String? {
+    guard let support = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first else {
+        return nil
+    }
+    let url = support.appendingPathComponent("One Share/Catalogs", isDirectory: true)
+    try? FileManager.default.createDirectory(at: url, withIntermediateDirectories: true)
+    return url.path
+}
+
 protocol FileService {
     func listItems(at path: String) async throws -> [FileSystemItem]
     func downloadFile(at path: String, to localURL: URL, size: Int64, progress: @escaping (Double, String) -> Void) async throws
@@ -22,6 +32,45 @@ protocol FileService {
     func deleteItem(at path: String) async throws
 }
 
+// A change the device carries out itself, without file data crossing the cable
+enum DeviceBatchOperation {
+    case delete(path: String)
+    case move(path: String, toFolder: String)
+    case copy(path: String, toFolder: String)
+    case rename(path: String, newName: String)
+    
+    var path: String {
+        switch self {
+        case .delete(let path), .move(let path, _), .copy(let path, _), .rename(let path, _):
+            return path
+        }
+    }
+}
+
+protocol BatchFileService: FileService {
+    // Applies independent operations in one go. Returns the operations that
+    // failed with the bridge's error code; progress reports (done, total).
+    func applyBatch(_ operations: [DeviceBatchOperation], progress: @escaping (Int, Int) -> Void) async throws -> [(operation: DeviceBatchOperation, code: Int)]
+}
+
+// Services whose bridge lists likely-next folders while the device is idle.
+// Both calls only queue work and return immediately.
+protocol PrefetchingFileService: FileService {
+    // Subfolders of the folder just shown, most likely first
+    func prefetchFolders(_ folders: [FileSystemItem])
+    // The folder under the pointer
+    func prefetchHint(_ folder: FileSystemItem)
+}
+
+// Passed through the bridges' batch callbacks
+final class BatchProgressContext {
+    let progress: (Int, Int) -> Void
+    
+    init(progress: @escaping (Int, Int) -> Void) {
+        self.progress = progress
+    }
+}
+
 class MockFileService: FileService {
     let mockItems: [FileSystemItem]
     
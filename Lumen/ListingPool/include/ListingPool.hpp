@@ -0,0 +1,80 @@
+#ifndef ListingPool_hpp
+#define ListingPool_hpp
+
+#include <stddef.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Reusable memory for one device's folder listings.
+//
+// A listing hands Swift a flat array of fixed-size records and builds a few
+// strings on the way (paths, catalog keys, name blobs). Allocating those on
+// every call churns the allocator while the user browses, so each bridge
+// keeps a pool for its device:
+// - Result arrays come from a few cached blocks, sized in powers of two, and
+//   return to the pool when Swift frees them.
+// - Scratch strings are lent out empty but with the capacity they had last time.
+// Once a folder of a given size has been listed, listing it again allocates
+// nothing in the bridge. Thread-safe.
+class ListingPool {
+public:
+    static const size_t DEFAULT_MAX_BLOCKS = 4;
+    static const size_t DEFAULT_MAX_STRINGS = 8;
+    static const size_t MIN_BLOCK_SIZE = 4096;
+
+    struct Stats {
+        size_t blocks_allocated = 0;    // Fresh from the heap
+        size_t blocks_reused = 0;
+        size_t strings_lent = 0;
+        size_t cached_bytes = 0;
+    };
+
+    explicit ListingPool(size_t max_blocks = DEFAULT_MAX_BLOCKS, size_t max_strings = DEFAULT_MAX_STRINGS);
+    ~ListingPool();
+    ListingPool(const ListingPool&) = delete;
+    ListingPool& operator=(const ListingPool&) = delete;
+
+    // At least size bytes, aligned for any record type. NULL only when the heap is exhausted.
+    void* acquire(size_t size);
+    // Takes back a block from acquire. NULL is ignored.
+    void release(void* block);
+
+    // A string borrowed from the pool for the lifetime of the lease
+    class Scratch {
+    public:
+        explicit Scratch(ListingPool& pool);
+        ~Scratch();
+        Scratch(const Scratch&) = delete;
+        Scratch& operator=(const Scratch&) = delete;
+
+        std::string& operator*() { return value; }
+        std::string* operator->() { return &value; }
+
+    private:
+        ListingPool& pool;
+        std::string value;
+    };
+
+    // Frees everything cached, e.g. when the device goes away
+    void trim();
+
+    Stats stats();
+
+private:
+    // Sits in front of every block; 16 bytes keeps the block itself aligned
+    struct alignas(16) BlockHeader {
+        size_t capacity;
+    };
+
+    static void free_block(BlockHeader* header);
+
+    std::mutex lock;
+    size_t max_blocks;
+    size_t max_strings;
+    std::vector<BlockHeader*> blocks;
+    std::vector<std::string> strings;
+    Stats counters;
+};
+
+#endif /* ListingPool_hpp */
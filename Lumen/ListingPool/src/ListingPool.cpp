@@ -0,0 +1,106 @@
+#include "ListingPool.hpp"
+
+#include <new>
+
+ListingPool::ListingPool(size_t max_blocks, size_t max_strings)
+    : max_blocks(max_blocks), max_strings(max_strings) {
+    // Reserved up front so handing memory back never allocates
+    blocks.reserve(max_blocks);
+    strings.reserve(max_strings);
+}
+
+ListingPool::~ListingPool() {
+    trim();
+}
+
+static size_t block_size_for(size_t size) {
+    size_t capacity = ListingPool::MIN_BLOCK_SIZE;
+    while (capacity < size) capacity *= 2;
+    return capacity;
+}
+
+void* ListingPool::acquire(size_t size) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        // Smallest cached block that fits
+        size_t best = blocks.size();
+        for (size_t i = 0; i < blocks.size(); i++) {
+            if (blocks[i]->capacity >= size && (best == blocks.size() || blocks[i]->capacity < blocks[best]->capacity)) {
+                best = i;
+            }
+        }
+        if (best < blocks.size()) {
+            BlockHeader* header = blocks[best];
+            blocks[best] = blocks.back();
+            blocks.pop_back();
+            counters.blocks_reused++;
+            counters.cached_bytes -= header->capacity;
+            return header + 1;
+        }
+        counters.blocks_allocated++;
+    }
+
+    size_t capacity = block_size_for(size);
+    void* memory = ::operator new(sizeof(BlockHeader) + capacity, std::nothrow);
+    if (!memory) return NULL;
+    BlockHeader* header = new (memory) BlockHeader();
+    header->capacity = capacity;
+    return header + 1;
+}
+
+void ListingPool::release(void* block) {
+    if (!block) return;
+    BlockHeader* header = (BlockHeader*)block - 1;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (blocks.size() < max_blocks) {
+        blocks.push_back(header);
+        counters.cached_bytes += header->capacity;
+        return;
+    }
+    // Full: keep the larger blocks, they serve every smaller listing too
+    size_t smallest = 0;
+    for (size_t i = 1; i < blocks.size(); i++) {
+        if (blocks[i]->capacity < blocks[smallest]->capacity) smallest = i;
+    }
+    if (!blocks.empty() && blocks[smallest]->capacity < header->capacity) {
+        std::swap(blocks[smallest], header);
+        counters.cached_bytes += blocks[smallest]->capacity - header->capacity;
+    }
+    free_block(header);
+}
+
+void ListingPool::free_block(BlockHeader* header) {
+    header->~BlockHeader();
+    ::operator delete(header);
+}
+
+ListingPool::Scratch::Scratch(ListingPool& pool) : pool(pool) {
+    std::lock_guard<std::mutex> guard(pool.lock);
+    pool.counters.strings_lent++;
+    if (!pool.strings.empty()) {
+        value.swap(pool.strings.back());
+        pool.strings.pop_back();
+    }
+}
+
+ListingPool::Scratch::~Scratch() {
+    std::lock_guard<std::mutex> guard(pool.lock);
+    if (pool.strings.size() < pool.max_strings) {
+        value.clear();
+        pool.strings.push_back(std::move(value));
+    }
+}
+
+void ListingPool::trim() {
+    std::lock_guard<std::mutex> guard(lock);
+    for (BlockHeader* header : blocks) free_block(header);
+    blocks.clear();
+    strings.clear();
+    counters.cached_bytes = 0;
+}
+
+ListingPool::Stats ListingPool::stats() {
+    std::lock_guard<std::mutex> guard(lock);
+    return counters;
+}
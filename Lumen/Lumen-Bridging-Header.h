@@ -3,4 +3,10 @@
 //
 
 #import "MTPBridge.hpp"
-#import "iOSBridge/include/iOSBridge.h"
\ No newline at end of file
+#import "iOSBridge/include/iOSBridge.h"
+#import "WirelessBridge/include/WirelessBridge.h"
+#import "ADBBridge/include/ADBBridge.h"
+#import "SearchIndex/include/SearchIndex.h"
+#import "TransferScheduler/include/TransferScheduler.h"
+#import "DeviceCatalog/include/DeviceCatalog.h"
+#import "BlockCache/include/BlockCache.h"
@@ -49,7 +49,7 @@ struct OneShareApp: App {
         WindowGroup(id: "transfer-progress") {
             TransferProgressWindow()
                 .environmentObject(transferManager)
-                .frame(width: 400, height: 160)
+                .frame(width: 400)
                 .fixedSize()
         }
         .windowStyle(.hiddenTitleBar)
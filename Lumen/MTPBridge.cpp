@@ -1,15 +1,111 @@
 #include "MTPBridge.hpp"
+#include "DeviceCatalog.hpp"
+#include "BlockCache.hpp"
+#include "DirectoryPrefetcher.hpp"
+#include "ListingPool.hpp"
 #include <libmtp.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <iostream>
+#include <string>
 #include <vector>
+#include <unordered_map>
+#include <algorithm>
 #include <chrono>
 
 // Global device pointer (simplified for single device support)
 static LIBMTP_mtpdevice_t *device = NULL;
 
+// Listing snapshot of the connected device
+static DeviceCatalog catalog;
+static std::string catalog_directory;
+
+// Result arrays and scratch strings for the connected device's listings
+static ListingPool listing_pool;
+
+static void open_catalog() {
+    if (!device || catalog_directory.empty()) return;
+
+    char* serial = LIBMTP_Get_Serialnumber(device);
+    if (serial) {
+        if (serial[0] != '\0') {
+            catalog.open(catalog_directory, "mtp", serial);
+        }
+        free(serial);
+    }
+}
+
+static std::string catalog_key(uint32_t storage_id, uint32_t parent_id) {
+    return std::to_string(storage_id) + "/" + std::to_string(parent_id);
+}
+
+static void invalidate_listing(uint32_t storage_id, uint32_t parent_id) {
+    catalog.invalidate(catalog_key(storage_id, parent_id));
+    // Listings are keyed by the storage id asked for, which may have been 0
+    catalog.invalidate(catalog_key(0, parent_id));
+    // The root may have been listed without a storage id
+    if (parent_id == 0xFFFFFFFF || parent_id == 0) {
+        catalog.invalidate(catalog_key(0, 0xFFFFFFFF));
+        catalog.invalidate(catalog_key(storage_id, 0xFFFFFFFF));
+    }
+}
+
+static void record_listing(uint32_t storage_id, uint32_t parent_id, const MTPFileInfo* files, int count) {
+    if (!catalog.is_open()) return;
+
+    DeviceCatalogEntry* entries = (DeviceCatalogEntry*)listing_pool.acquire(sizeof(DeviceCatalogEntry) * count);
+    if (!entries) return;
+    ListingPool::Scratch names(listing_pool);
+    for (int i = 0; i < count; i++) {
+        DeviceCatalogEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.id = files[i].id;
+        entry.size = files[i].size;
+        entry.modification_date = files[i].modification_date;
+        entry.storage_id = files[i].storage_id;
+        entry.parent_id = files[i].parent_id;
+        entry.is_directory = files[i].is_folder ? 1 : 0;
+        size_t length = strnlen(files[i].name, sizeof(files[i].name));
+        entry.name_offset = (uint32_t)names->size();
+        entry.name_length = (uint16_t)length;
+        names->append(files[i].name, length);
+    }
+
+    char key_buffer[32];
+    snprintf(key_buffer, sizeof(key_buffer), "%u/%u", storage_id, parent_id);
+    ListingPool::Scratch key(listing_pool);
+    key->assign(key_buffer);
+    catalog.put(*key, entries, count, names->data(), names->size(), (int64_t)time(NULL));
+    listing_pool.release(entries);
+}
+
+// Folders the prefetcher lists are skipped if listed this recently
+static const int64_t prefetch_fresh_seconds = 30;
+
+static MTPFileInfo* list_folder(uint32_t storage_id, uint32_t parent_id, int* count);
+
+static void prefetch_folder(const std::string& key) {
+    if (!device || !catalog.is_open()) return;
+
+    bool fresh = false;
+    catalog.with_folder(key, [&](const DeviceCatalogFolder& folder) {
+        fresh = (int64_t)time(NULL) - folder.listed_at < prefetch_fresh_seconds;
+    });
+    if (fresh) return;
+
+    uint32_t storage_id = 0, parent_id = 0;
+    if (sscanf(key.c_str(), "%u/%u", &storage_id, &parent_id) != 2) return;
+    int count = 0;
+    mtp_free_files(list_folder(storage_id, parent_id, &count));
+}
+
+// libmtp is not thread-safe: every call below that talks to the device holds
+// a Foreground, which also keeps the prefetcher off the bus
+static DirectoryPrefetcher prefetcher(prefetch_folder);
+
 bool mtp_connect() {
+    DirectoryPrefetcher::Foreground work(prefetcher);
     if (device != NULL) {
         return true; // Already connected
     }
@@ -31,10 +127,18 @@ bool mtp_connect() {
     // Free raw devices
     free(raw_devices); // LIBMTP_Detect_Raw_Devices allocates this array
 
+    open_catalog();
+
     return (device != NULL);
 }
 
 void mtp_disconnect() {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    prefetcher.cancel();
+    catalog.save();
+    catalog.close();
+    listing_pool.trim();
+
     if (device != NULL) {
         LIBMTP_Release_Device(device);
         device = NULL;
@@ -51,6 +155,7 @@ bool mtp_is_connected() {
 }
 
 bool mtp_check_storage() {
+    DirectoryPrefetcher::Foreground work(prefetcher);
     if (device == NULL) return false;
     
     // Refresh storage list
@@ -76,18 +181,46 @@ bool mtp_check_storage() {
 }
 
 char* mtp_get_device_name() {
+    DirectoryPrefetcher::Foreground work(prefetcher);
     if (!device) return NULL;
     char* name = LIBMTP_Get_Modelname(device);
     // Note: Caller is responsible for freeing this string
     return name;
 }
 
+MTPDeviceInfo mtp_get_device_info() {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    MTPDeviceInfo info = {};
+    if (!device) return info;
+
+    char* model = LIBMTP_Get_Modelname(device);
+    if (model) {
+        strncpy(info.model, model, sizeof(info.model) - 1);
+        free(model);
+    }
+
+    char* serial = LIBMTP_Get_Serialnumber(device);
+    if (serial) {
+        strncpy(info.serial, serial, sizeof(info.serial) - 1);
+        free(serial);
+    }
+    return info;
+}
+
 MTPFileInfo* mtp_list_files(uint32_t storage_id, uint32_t parent_id, int* count) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    return list_folder(storage_id, parent_id, count);
+}
+
+static MTPFileInfo* list_folder(uint32_t storage_id, uint32_t parent_id, int* count) {
     if (!device || !count) {
         if (count) *count = 0;
         return NULL;
     }
 
+    // The snapshot is keyed by what the caller asked for, before 0 is resolved
+    const uint32_t requested_storage_id = storage_id;
+
     // If storage_id is 0, try to get the first storage
     if (storage_id == 0) {
          // Ensure device parameters are up to date
@@ -124,10 +257,17 @@ MTPFileInfo* mtp_list_files(uint32_t storage_id, uint32_t parent_id, int* count)
             files = files->next;
             LIBMTP_destroy_file_t(tmp);
         }
+
+        // Empty folder, unless libmtp reported an error
+        if (LIBMTP_Get_Errorstack(device) == NULL) {
+            record_listing(requested_storage_id, parent_id, NULL, 0);
+        } else {
+            LIBMTP_Clear_Errorstack(device);
+        }
         return NULL;
     }
 
-    MTPFileInfo* result = (MTPFileInfo*)malloc(sizeof(MTPFileInfo) * c);
+    MTPFileInfo* result = (MTPFileInfo*)listing_pool.acquire(sizeof(MTPFileInfo) * c);
     if (!result) {
         // Memory allocation failed, clean up and return NULL
         LIBMTP_file_t *tmp;
@@ -169,16 +309,74 @@ MTPFileInfo* mtp_list_files(uint32_t storage_id, uint32_t parent_id, int* count)
         LIBMTP_destroy_file_t(tmp);
     }
 
+    record_listing(requested_storage_id, parent_id, result, c);
     return result;
 }
 
 void mtp_free_files(MTPFileInfo* files) {
-    // Free the array of MTPFileInfo structs
-    // Note: This only frees the array itself, not any strings within the structs
-    // since we use fixed-size char arrays rather than dynamically allocated strings
-    if (files) {
-        free(files);
+    // Back to the pool for the next listing; the structs hold no pointers
+    listing_pool.release(files);
+}
+
+void mtp_set_catalog_directory(const char* directory) {
+    catalog_directory = directory ? directory : "";
+    open_catalog();
+}
+
+MTPFileInfo* mtp_list_cached_files(uint32_t storage_id, uint32_t parent_id, int* count, uint64_t* listed_at) {
+    if (!count) return NULL;
+    *count = -1;
+
+    MTPFileInfo* result = NULL;
+    catalog.with_folder(catalog_key(storage_id, parent_id), [&](const DeviceCatalogFolder& folder) {
+        *count = 0;
+        if (listed_at) *listed_at = (uint64_t)folder.listed_at;
+        if (folder.count == 0) return;
+
+        result = (MTPFileInfo*)listing_pool.acquire(sizeof(MTPFileInfo) * folder.count);
+        if (!result) return;
+
+        int c = 0;
+        for (uint32_t i = 0; i < folder.count; i++) {
+            const DeviceCatalogEntry& entry = folder.entries[i];
+            MTPFileInfo& info = result[c];
+            if (!device_catalog_copy_name(folder, entry, info.name, sizeof(info.name))) continue;
+            info.id = (uint32_t)entry.id;
+            info.storage_id = entry.storage_id;
+            info.size = entry.size;
+            info.is_folder = entry.is_directory != 0;
+            info.parent_id = entry.parent_id;
+            info.modification_date = entry.modification_date;
+            c++;
+        }
+        *count = c;
+    });
+
+    if (result && *count == 0) {
+        listing_pool.release(result);
+        result = NULL;
     }
+    return result;
+}
+
+bool mtp_save_catalog() {
+    return catalog.save();
+}
+
+void mtp_prefetch_folders(const MTPFolderRef* folders, int count) {
+    std::vector<std::string> keys;
+    for (int i = 0; folders && i < count; i++) {
+        keys.push_back(catalog_key(folders[i].storage_id, folders[i].parent_id));
+    }
+    prefetcher.schedule(keys);
+}
+
+void mtp_prefetch_hint(uint32_t storage_id, uint32_t parent_id) {
+    prefetcher.hint(catalog_key(storage_id, parent_id));
+}
+
+void mtp_prefetch_cancel() {
+    prefetcher.cancel();
 }
 
 // Progress callback wrapper
@@ -218,6 +416,7 @@ static int mtp_bridge_progress_wrapper(uint64_t const sent, uint64_t const total
 }
 
 int mtp_download_file(uint32_t file_id, const char* dest_path, MTPProgressCallback callback, const void* context) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
     if (!device) return -1;
     
     MTPBridgeCallbackData cbData = { callback, context, 0, std::chrono::steady_clock::now() };
@@ -234,6 +433,7 @@ int mtp_download_file(uint32_t file_id, const char* dest_path, MTPProgressCallba
 }
 
 int mtp_upload_file(const char* source_path, uint32_t storage_id, uint32_t parent_id, const char* filename, uint64_t size, MTPProgressCallback callback, const void* context) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
     if (!device) return -1;
     
     // If storage_id is 0, use first storage
@@ -263,18 +463,213 @@ int mtp_upload_file(const char* source_path, uint32_t storage_id, uint32_t paren
     if (ret != 0) {
         // Log error or handle specific cases
         // For now, just return the error code
+    } else {
+        invalidate_listing(storage_id, parent_id);
     }
     
     return ret;
 }
 
 int mtp_delete_file(uint32_t file_id) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
     if (!device) return -1;
     
+    // The object's parent is only known before it goes
+    LIBMTP_file_t* file = NULL;
+    if (catalog.is_open()) {
+        file = LIBMTP_Get_Filemetadata(device, file_id);
+        if (!file) LIBMTP_Clear_Errorstack(device);
+    }
+    
     int ret = LIBMTP_Delete_Object(device, file_id);
+    if (file) {
+        if (ret == 0) {
+            invalidate_listing(file->storage_id, file->parent_id);
+            // A deleted folder's own listing is gone too
+            invalidate_listing(file->storage_id, file_id);
+        }
+        LIBMTP_destroy_file_t(file);
+    }
+    return ret;
+}
+
+struct MTPStream {
+    uint32_t file_id;
+    BlockCache cache;
+
+    MTPStream(uint32_t file_id, uint64_t size, BlockCache::Fetch fetch)
+        : file_id(file_id), cache(size, std::move(fetch)) {}
+};
+
+MTPStream* mtp_stream_open(uint32_t file_id, uint64_t size) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    if (!device) return NULL;
+    if (!LIBMTP_Check_Capability(device, LIBMTP_DEVICECAP_GetPartialObject)) return NULL;
+
+    return new MTPStream(file_id, size, [file_id](uint64_t offset, uint32_t length, uint8_t* out) -> int64_t {
+        if (!device) return -1;
+
+        // libmtp allocates the buffer for each partial read
+        unsigned char* data = NULL;
+        unsigned int received = 0;
+        if (LIBMTP_GetPartialObject(device, file_id, offset, length, &data, &received) != 0) {
+            LIBMTP_Clear_Errorstack(device);
+            free(data);
+            return -5;
+        }
+        if (received > length) received = length;
+        if (data) memcpy(out, data, received);
+        free(data);
+        return received;
+    });
+}
+
+int64_t mtp_stream_read(MTPStream* stream, uint64_t offset, void* buffer, uint32_t length) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    if (!stream) return -1;
+    return stream->cache.read(offset, buffer, length);
+}
+
+uint64_t mtp_stream_size(MTPStream* stream) {
+    return stream ? stream->cache.size() : 0;
+}
+
+void mtp_stream_close(MTPStream* stream) {
+    delete stream;
+}
+
+// Root is 0xFFFFFFFF when listing but 0 when addressing a parent
+static uint32_t object_parent(uint32_t parent_id) {
+    return parent_id == 0xFFFFFFFF ? 0 : parent_id;
+}
+
+static uint32_t resolve_storage(uint32_t storage_id) {
+    if (storage_id == 0 && device->storage) {
+        return device->storage->id;
+    }
+    return storage_id;
+}
+
+static int rename_object(uint32_t object_id, const char* new_name) {
+    if (!new_name || new_name[0] == '\0') return -1;
+
+    LIBMTP_file_t* file = LIBMTP_Get_Filemetadata(device, object_id);
+    if (!file) return 1;
+    int ret = LIBMTP_Set_File_Name(device, file, new_name);
+    LIBMTP_destroy_file_t(file);
     return ret;
 }
 
+// The folder and its ancestors up to the storage root, nearest first
+static std::vector<uint32_t> folder_chain(uint32_t folder_id) {
+    std::vector<uint32_t> chain;
+    uint32_t id = object_parent(folder_id);
+    while (id != 0 && chain.size() < 256) {
+        chain.push_back(id);
+        LIBMTP_file_t* file = LIBMTP_Get_Filemetadata(device, id);
+        if (!file) {
+            LIBMTP_Clear_Errorstack(device);
+            break;
+        }
+        id = file->parent_id;
+        LIBMTP_destroy_file_t(file);
+    }
+    return chain;
+}
+
+int mtp_batch_apply(MTPBatchOp* ops, int count, MTPBatchCallback callback, const void* context) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    if (!device) return -1;
+    if (!ops || count <= 0) return 0;
+
+    // MTP runs one transaction at a time per session, so the batch goes
+    // back to back on this thread with storage resolved once up front
+    if (device->storage == NULL) {
+        LIBMTP_Get_Storage(device, LIBMTP_STORAGE_SORTBY_NOTSORTED);
+    }
+    bool can_move = LIBMTP_Check_Capability(device, LIBMTP_DEVICECAP_MoveObject) != 0;
+    bool can_copy = LIBMTP_Check_Capability(device, LIBMTP_DEVICECAP_CopyObject) != 0;
+
+    // A batch usually shares one destination, so each folder is walked once
+    std::unordered_map<uint32_t, std::vector<uint32_t>> dest_chains;
+
+    int failed = 0;
+    auto last_report = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        MTPBatchOp& op = ops[i];
+        uint32_t storage_id = resolve_storage(op.storage_id);
+        uint32_t dest_storage_id = resolve_storage(op.dest_storage_id);
+
+        // A folder can't go into itself or anything below it
+        bool into_itself = false;
+        if (op.type == MTP_BATCH_MOVE || op.type == MTP_BATCH_COPY) {
+            auto chain = dest_chains.find(op.dest_parent_id);
+            if (chain == dest_chains.end()) {
+                chain = dest_chains.emplace(op.dest_parent_id, folder_chain(op.dest_parent_id)).first;
+            }
+            into_itself = std::find(chain->second.begin(), chain->second.end(), op.object_id) != chain->second.end();
+        }
+
+        if (into_itself) {
+            op.result = -1;
+        } else switch (op.type) {
+            case MTP_BATCH_DELETE:
+                op.result = LIBMTP_Delete_Object(device, op.object_id);
+                break;
+            case MTP_BATCH_MOVE:
+                if (can_move) {
+                    op.result = LIBMTP_Move_Object(device, op.object_id, dest_storage_id, object_parent(op.dest_parent_id));
+                } else if (can_copy) {
+                    // Some devices only copy; copy then delete still stays on the device
+                    op.result = LIBMTP_Copy_Object(device, op.object_id, dest_storage_id, object_parent(op.dest_parent_id));
+                    if (op.result == 0) {
+                        LIBMTP_Clear_Errorstack(device);
+                        if (LIBMTP_Delete_Object(device, op.object_id) != 0) {
+                            op.result = MTP_BATCH_COPY_REMAINS;
+                        }
+                    }
+                } else {
+                    op.result = -1;
+                }
+                break;
+            case MTP_BATCH_COPY:
+                op.result = can_copy ? LIBMTP_Copy_Object(device, op.object_id, dest_storage_id, object_parent(op.dest_parent_id)) : -1;
+                break;
+            case MTP_BATCH_RENAME:
+                op.result = rename_object(op.object_id, op.new_name);
+                break;
+            default:
+                op.result = -1;
+                break;
+        }
+
+        if (op.result != 0) {
+            failed++;
+            LIBMTP_Clear_Errorstack(device);
+            if (op.result == MTP_BATCH_COPY_REMAINS) {
+                invalidate_listing(dest_storage_id, op.dest_parent_id);
+            }
+        } else {
+            invalidate_listing(storage_id, op.parent_id);
+            if (op.type == MTP_BATCH_MOVE || op.type == MTP_BATCH_COPY) {
+                invalidate_listing(dest_storage_id, op.dest_parent_id);
+            }
+            if (op.type == MTP_BATCH_DELETE) {
+                // A deleted folder's own listing is gone too
+                catalog.invalidate(catalog_key(storage_id, op.object_id));
+            }
+        }
+
+        // Throttle callbacks the same way as transfer progress
+        auto now = std::chrono::steady_clock::now();
+        if (callback && (i + 1 == count || std::chrono::duration_cast<std::chrono::milliseconds>(now - last_report).count() >= 100)) {
+            callback(i + 1, count, context);
+            last_report = now;
+        }
+    }
+    return failed;
+}
+
 #ifdef __cplusplus
 
 #endif
@@ -29,6 +29,32 @@ typedef struct {
 // Callback for progress: transferred bytes, total bytes, context
 typedef void (*MTPProgressCallback)(uint64_t sent, uint64_t total, const void* context);
 
+// Batch operations, carried out by the device without moving file data over USB
+typedef enum {
+    MTP_BATCH_DELETE,
+    MTP_BATCH_MOVE,     // To dest_storage_id / dest_parent_id
+    MTP_BATCH_COPY,     // To dest_storage_id / dest_parent_id
+    MTP_BATCH_RENAME    // To new_name
+} MTPBatchOpType;
+
+typedef struct {
+    MTPBatchOpType type;
+    uint32_t object_id;
+    uint32_t storage_id;        // Where the object is now, as listed
+    uint32_t parent_id;
+    uint32_t dest_storage_id;
+    uint32_t dest_parent_id;
+    char new_name[256];
+    int result;                 // Set by mtp_batch_apply: 0 on success
+} MTPBatchOp;
+
+// Result of a move done as copy then delete when the delete failed:
+// the copy is in the destination and the original is still in place
+#define MTP_BATCH_COPY_REMAINS -6
+
+// Callback for batch progress: operations finished, total, context
+typedef void (*MTPBatchCallback)(int done, int total, const void* context);
+
 // Functions
 bool mtp_connect(void);
 bool mtp_reconnect(void);
@@ -36,18 +62,60 @@ void mtp_disconnect(void);
 bool mtp_is_connected(void);
 bool mtp_check_storage(void);
 char* mtp_get_device_name(void);
+MTPDeviceInfo mtp_get_device_info(void);
 
 // Listing
 // Returns an array of MTPFileInfo, caller must free it with mtp_free_files
 MTPFileInfo* mtp_list_files(uint32_t storage_id, uint32_t parent_id, int* count);
 void mtp_free_files(MTPFileInfo* files);
 
+// Catalog snapshots
+// Folder listings are kept per device (by serial number) in a memory-mapped
+// file under directory, so a reconnected phone can be browsed before it is re-listed.
+void mtp_set_catalog_directory(const char* directory);
+// Returns the last recorded listing of a folder, caller must free it with mtp_free_files.
+// count is -1 when the folder is not in the snapshot; listed_at (optional) receives the listing time.
+MTPFileInfo* mtp_list_cached_files(uint32_t storage_id, uint32_t parent_id, int* count, uint64_t* listed_at);
+// Writes new listings to disk. Also happens on disconnect.
+bool mtp_save_catalog(void);
+
+// Prefetch
+// Lists folders the user is likely to open next into the catalog while the
+// device is idle, so mtp_list_cached_files can answer a drill-down with a
+// fresh listing. Any other call waits at most for the one folder in flight.
+typedef struct {
+    uint32_t storage_id;
+    uint32_t parent_id;
+} MTPFolderRef;
+
+// Subfolders of the folder being shown, most likely first. Replaces what was queued.
+void mtp_prefetch_folders(const MTPFolderRef* folders, int count);
+// The folder under the pointer, listed before anything else
+void mtp_prefetch_hint(uint32_t storage_id, uint32_t parent_id);
+void mtp_prefetch_cancel(void);
+
 // Transfer
 // Returns 0 on success, non-zero on error
 int mtp_download_file(uint32_t file_id, const char* dest_path, MTPProgressCallback callback, const void* context);
 int mtp_upload_file(const char* source_path, uint32_t storage_id, uint32_t parent_id, const char* filename, uint64_t size, MTPProgressCallback callback, const void* context);
 int mtp_delete_file(uint32_t file_id);
 
+// Streaming
+// Random access to an object without downloading it, for previews and playback.
+// Reads go through a block cache with readahead for sequential access.
+typedef struct MTPStream MTPStream;
+// size is the object size from the listing. Returns NULL if the device cannot do partial reads.
+MTPStream* mtp_stream_open(uint32_t file_id, uint64_t size);
+// Returns bytes read, 0 at the end of the object, or a negative error
+int64_t mtp_stream_read(MTPStream* stream, uint64_t offset, void* buffer, uint32_t length);
+uint64_t mtp_stream_size(MTPStream* stream);
+void mtp_stream_close(MTPStream* stream);
+
+// Batch
+// Applies independent operations in one pass and fills in each result.
+// Returns the number of operations that failed, or -1 if no device is connected.
+int mtp_batch_apply(MTPBatchOp* ops, int count, MTPBatchCallback callback, const void* context);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,7 +8,7 @@
 import Foundation
 import Combine
 
-class MTPService: FileService, ObservableObject, @unchecked Sendable {
+class MTPService: BatchFileService, StreamingFileService, PrefetchingFileService, ObservableObject, @unchecked Sendable {
     
     // Serial queue for thread safety with libmtp which is not thread-safe
     private let queue = DispatchQueue(label: "com.oneshare.mtp.queue", qos: .userInitiated)
@@ -21,6 +21,15 @@ class MTPService: FileService, ObservableObject, @unchecked Sendable {
     private var listingCache: [String: CacheEntry] = [:]
     private let cacheTimeout: TimeInterval = 300 // Cache for 5 minutes
     
+    // Folders listed from the device this session; anything else may still be
+    // served from the catalog snapshot of a previous connection
+    private var livePaths: Set<String> = []
+    private var catalogSaveWork: DispatchWorkItem?
+    private let catalogSaveDelay: TimeInterval = 5
+    // A snapshot listed this recently was prefetched this session and is
+    // served as live; matches prefetch_fresh_seconds in the bridge
+    private let prefetchFreshness: TimeInterval = 30
+    
     // Device monitoring
     @Published var connectionState: ConnectionState = .disconnected
     
@@ -30,6 +39,9 @@ class MTPService: FileService, ObservableObject, @unchecked Sendable {
     init() {
         log("MTPService init")
         queue.async {
+            if let directory = deviceCatalogDirectory() {
+                mtp_set_catalog_directory(directory)
+            }
             self.log("Attempting initial connection...")
             let success = mtp_connect()
             self.log("Initial connection result: \(success)")
@@ -123,6 +135,11 @@ class MTPService: FileService, ObservableObject, @unchecked Sendable {
             // If connection state changed, notify
             if currentState != self.connectionState {
                 self.log("Connection state changed: \(self.connectionState) -> \(currentState)")
+                if currentState == .disconnected {
+                    SearchCatalog.shared.clear(source: SEARCH_SOURCE_MTP)
+                    self.livePaths.removeAll()
+                    self.listingCache.removeAll()
+                }
                 DispatchQueue.main.async {
                     self.connectionState = currentState
                     self.onDeviceConnectionChange?(currentState)
@@ -241,62 +258,142 @@ class MTPService: FileService, ObservableObject, @unchecked Sendable {
                     return
                 }
                 
-                self.log("listItems: Calling mtp_list_files")
-                var count: Int32 = 0
-                let filesPtr = mtp_list_files(storageId, parentId, &count)
-                self.log("listItems: mtp_list_files returned count: \(count)")
-                
-                var items: [FileSystemItem] = []
-                
-                if count > 0, let files = filesPtr {
-                    let buffer = UnsafeBufferPointer(start: files, count: Int(count))
-                    
-                    for file in buffer {
-                        let nameStr = withUnsafePointer(to: file.name) { ptr in
-                            return ptr.withMemoryRebound(to: CChar.self, capacity: 256) { charPtr in
-                                return String(cString: charPtr)
-                            }
-                        }
-                        
-                        // Determine file type based on extension
-                        let fileType = self.getFileType(for: nameStr, isFolder: file.is_folder)
-                        
-                        // Construct hierarchical path: currentPath + "/" + fileID
-                        // Ensure no double slashes
-                        let separator = path.hasSuffix("/") ? "" : "/"
-                        let itemPath = "\(path)\(separator)\(file.id)"
-                        
-                        let finalPath: String
-                        // Only use the simple storageId/fileId format for actual root paths
-                        if path == "mtp://" || path == "/" || path.isEmpty { // Handle root
-                             finalPath = "mtp://\(file.storage_id)/\(file.id)"
-                        } else {
-                             finalPath = itemPath
-                        }
-                        
-                        let item = FileSystemItem(
-                            name: nameStr,
-                            path: finalPath,
-                            size: Int64(file.size),
-                            type: fileType, // Use the determined file type instead of always .file
-                            modificationDate: Date(timeIntervalSince1970: TimeInterval(file.modification_date)),
-                            creationDate: Date(timeIntervalSince1970: TimeInterval(file.modification_date)) // Use mod date as creation date fallback
-                        )
-                        items.append(item)
+                // First visit this session: show the snapshot from the last connection
+                // right away and re-list in the background
+                if !self.livePaths.contains(path), let snapshot = self.snapshotItems(at: path, storageId: storageId, parentId: parentId) {
+                    if Date().timeIntervalSince(snapshot.listedAt) < self.prefetchFreshness {
+                        self.log("listItems: Returning \(snapshot.items.count) prefetched items")
+                        self.recordLive(snapshot.items, at: path)
+                        continuation.resume(returning: snapshot.items)
+                        return
                     }
                     
-                    mtp_free_files(files)
+                    self.log("listItems: Returning \(snapshot.items.count) items from catalog snapshot")
+                    self.listingCache[path] = CacheEntry(items: snapshot.items, timestamp: Date())
+                    continuation.resume(returning: snapshot.items)
+                    
+                    self.queue.async {
+                        self.revalidate(path: path, storageId: storageId, parentId: parentId, shown: snapshot.items)
+                    }
+                    return
                 }
                 
-                // Cache the results
-                self.listingCache[path] = CacheEntry(items: items, timestamp: Date())
-                
+                let items = self.listLive(at: path, storageId: storageId, parentId: parentId)
                 self.log("listItems: Returning \(items.count) items")
                 continuation.resume(returning: items)
             }
         }
     }
     
+    // MARK: - Listing helpers (call on queue)
+    
+    private func listLive(at path: String, storageId: UInt32, parentId: UInt32) -> [FileSystemItem] {
+        self.log("listItems: Calling mtp_list_files")
+        var count: Int32 = 0
+        let filesPtr = mtp_list_files(storageId, parentId, &count)
+        self.log("listItems: mtp_list_files returned count: \(count)")
+        
+        var items: [FileSystemItem] = []
+        if count > 0, let files = filesPtr {
+            items = makeItems(UnsafeBufferPointer(start: files, count: Int(count)), listedAt: path)
+            mtp_free_files(files)
+        }
+        
+        recordLive(items, at: path)
+        return items
+    }
+    
+    private func recordLive(_ items: [FileSystemItem], at path: String) {
+        listingCache[path] = CacheEntry(items: items, timestamp: Date())
+        livePaths.insert(path)
+        SearchCatalog.shared.ingest(items, listedAt: path, source: SEARCH_SOURCE_MTP)
+        scheduleCatalogSave()
+    }
+    
+    private func snapshotItems(at path: String, storageId: UInt32, parentId: UInt32) -> (items: [FileSystemItem], listedAt: Date)? {
+        var count: Int32 = 0
+        var listedAt: UInt64 = 0
+        let filesPtr = mtp_list_cached_files(storageId, parentId, &count, &listedAt)
+        guard count >= 0 else { return nil }
+        
+        var items: [FileSystemItem] = []
+        if count > 0, let files = filesPtr {
+            items = makeItems(UnsafeBufferPointer(start: files, count: Int(count)), listedAt: path)
+            mtp_free_files(files)
+        }
+        return (items, Date(timeIntervalSince1970: TimeInterval(listedAt)))
+    }
+    
+    // Re-lists a folder that was served from the snapshot and tells the
+    // browser if the device no longer matches what it showed
+    private func revalidate(path: String, storageId: UInt32, parentId: UInt32, shown: [FileSystemItem]) {
+        guard !livePaths.contains(path), mtp_is_connected() else { return }
+        let items = listLive(at: path, storageId: storageId, parentId: parentId)
+        
+        let changed = items.count != shown.count || zip(items, shown).contains { fresh, old in
+            fresh.path != old.path || fresh.name != old.name || fresh.size != old.size ||
+            fresh.type != old.type || fresh.modificationDate != old.modificationDate
+        }
+        if changed {
+            log("listItems: Snapshot of \(path) was stale, refreshed \(items.count) items")
+            DispatchQueue.main.async {
+                NotificationCenter.default.post(name: Notification.Name("DeviceListingRefreshed"), object: self, userInfo: ["path": path])
+            }
+        }
+    }
+    
+    private func makeItems(_ buffer: UnsafeBufferPointer<MTPFileInfo>, listedAt path: String) -> [FileSystemItem] {
+        var items: [FileSystemItem] = []
+        items.reserveCapacity(buffer.count)
+        
+        for file in buffer {
+            let nameStr = withUnsafePointer(to: file.name) { ptr in
+                return ptr.withMemoryRebound(to: CChar.self, capacity: 256) { charPtr in
+                    return String(cString: charPtr)
+                }
+            }
+            
+            // Determine file type based on extension
+            let fileType = self.getFileType(for: nameStr, isFolder: file.is_folder)
+            
+            // Construct hierarchical path: currentPath + "/" + fileID
+            // Ensure no double slashes
+            let separator = path.hasSuffix("/") ? "" : "/"
+            let itemPath = "\(path)\(separator)\(file.id)"
+            
+            let finalPath: String
+            // Only use the simple storageId/fileId format for actual root paths
+            if path == "mtp://" || path == "/" || path.isEmpty { // Handle root
+                 finalPath = "mtp://\(file.storage_id)/\(file.id)"
+            } else {
+                 finalPath = itemPath
+            }
+            
+            let item = FileSystemItem(
+                name: nameStr,
+                path: finalPath,
+                size: Int64(file.size),
+                type: fileType, // Use the determined file type instead of always .file
+                modificationDate: Date(timeIntervalSince1970: TimeInterval(file.modification_date)),
+                creationDate: Date(timeIntervalSince1970: TimeInterval(file.modification_date)) // Use mod date as creation date fallback
+            )
+            items.append(item)
+        }
+        return items
+    }
+    
+    // Batches catalog writes; a browsing session lists many folders in a row
+    private func scheduleCatalogSave() {
+        catalogSaveWork?.cancel()
+        let work = DispatchWorkItem {
+            if mtp_is_connected() && !mtp_save_catalog() {
+                self.log("Catalog save failed")
+            }
+        }
+        catalogSaveWork = work
+        queue.asyncAfter(deadline: .now() + catalogSaveDelay, execute: work)
+    }
+    
     func downloadFile(at path: String, to localURL: URL, size: Int64, progress: @escaping (Double, String) -> Void) async throws {
         let (_, fileId) = parsePath(path)
         
@@ -434,6 +531,140 @@ class MTPService: FileService, ObservableObject, @unchecked Sendable {
         }
     }
     
+    // MARK: - Prefetch
+    
+    func prefetchFolders(_ folders: [FileSystemItem]) {
+        var refs = folders.filter { $0.isDirectory }.map { folder -> MTPFolderRef in
+            let (storageId, parentId) = parsePath(folder.path)
+            return MTPFolderRef(storage_id: storageId, parent_id: parentId)
+        }
+        mtp_prefetch_folders(&refs, Int32(refs.count))
+    }
+    
+    func prefetchHint(_ folder: FileSystemItem) {
+        guard folder.isDirectory else { return }
+        let (storageId, parentId) = parsePath(folder.path)
+        mtp_prefetch_hint(storageId, parentId)
+    }
+    
+    // MARK: - Streaming
+    
+    // Reads stay on the serial queue; libmtp handles one request at a time
+    func openStream(for item: FileSystemItem) async throws -> DeviceStream {
+        let (_, fileId) = parsePath(item.path)
+        
+        return try await withCheckedThrowingContinuation { continuation in
+            queue.async {
+                guard mtp_connect() else {
+                    continuation.resume(throwing: NSError(domain: "MTPService", code: 1, userInfo: [NSLocalizedDescriptionKey: "Device not connected"]))
+                    return
+                }
+                guard let stream = mtp_stream_open(fileId, UInt64(max(item.size, 0))) else {
+                    continuation.resume(throwing: NSError(domain: "MTPService", code: 2, userInfo: [NSLocalizedDescriptionKey: "Device does not support partial reads"]))
+                    return
+                }
+                continuation.resume(returning: DeviceStream(
+                    size: Int64(mtp_stream_size(stream)),
+                    queue: self.queue,
+                    read: { offset, buffer, length in mtp_stream_read(stream, offset, buffer, length) },
+                    close: { mtp_stream_close(stream) }
+                ))
+            }
+        }
+    }
+    
+    // MARK: - Batch operations
+    
+    func applyBatch(_ operations: [DeviceBatchOperation], progress: @escaping (Int, Int) -> Void) async throws -> [(operation: DeviceBatchOperation, code: Int)] {
+        var failures: [(operation: DeviceBatchOperation, code: Int)] = []
+        var ops: [MTPBatchOp] = []
+        var opSources: [DeviceBatchOperation] = []
+        for operation in operations {
+            if let op = makeBatchOp(operation) {
+                ops.append(op)
+                opSources.append(operation)
+            } else {
+                failures.append((operation, -1))
+            }
+        }
+        let batch = ops
+        let sources = opSources
+        let invalid = failures
+        
+        return try await withCheckedThrowingContinuation { continuation in
+            queue.async {
+                guard mtp_connect() else {
+                    continuation.resume(throwing: NSError(domain: "MTPService", code: 1, userInfo: [NSLocalizedDescriptionKey: "Device not connected"]))
+                    return
+                }
+                
+                let context = BatchProgressContext(progress: progress)
+                let contextPtr = Unmanaged.passRetained(context).toOpaque()
+                let callback: MTPBatchCallback = { done, total, ctx in
+                    guard let ctx = ctx else { return }
+                    let context = Unmanaged<BatchProgressContext>.fromOpaque(ctx).takeUnretainedValue()
+                    DispatchQueue.main.async {
+                        context.progress(Int(done), Int(total))
+                    }
+                }
+                
+                var results = batch
+                let failed = results.withUnsafeMutableBufferPointer { buffer in
+                    mtp_batch_apply(buffer.baseAddress, Int32(buffer.count), callback, contextPtr)
+                }
+                Unmanaged<BatchProgressContext>.fromOpaque(contextPtr).release()
+                self.log("applyBatch: \(results.count) operations, \(failed) failed")
+                
+                // Folders on both ends changed; the next listing goes to the device
+                self.listingCache.removeAll()
+                
+                var failures = invalid
+                for (index, op) in results.enumerated() where op.result != 0 {
+                    failures.append((sources[index], Int(op.result)))
+                }
+                continuation.resume(returning: failures)
+            }
+        }
+    }
+    
+    private func makeBatchOp(_ operation: DeviceBatchOperation) -> MTPBatchOp? {
+        let (storageId, objectId) = parsePath(operation.path)
+        guard objectId != 0xFFFFFFFF else { return nil }
+        
+        // The object's folder is its path minus the last component
+        var components = operation.path.replacingOccurrences(of: "mtp://", with: "").split(separator: "/")
+        components.removeLast()
+        let (_, parentId) = parsePath("mtp://" + components.joined(separator: "/"))
+        
+        var op = MTPBatchOp()
+        op.object_id = objectId
+        op.storage_id = storageId
+        op.parent_id = parentId
+        
+        switch operation {
+        case .delete:
+            op.type = MTP_BATCH_DELETE
+        case .move(_, let folder):
+            op.type = MTP_BATCH_MOVE
+            (op.dest_storage_id, op.dest_parent_id) = parsePath(folder)
+        case .copy(_, let folder):
+            op.type = MTP_BATCH_COPY
+            (op.dest_storage_id, op.dest_parent_id) = parsePath(folder)
+        case .rename(_, let newName):
+            op.type = MTP_BATCH_RENAME
+            guard !newName.isEmpty, newName.utf8.count < 256 else { return nil }
+            withUnsafeMutablePointer(to: &op.new_name) { ptr in
+                ptr.withMemoryRebound(to: CChar.self, capacity: 256) { charPtr in
+                    _ = strncpy(charPtr, newName, 255)
+                }
+            }
+        }
+        if op.dest_storage_id == 0 {
+            op.dest_storage_id = storageId
+        }
+        return op
+    }
+    
     func deleteItem(at path: String) async throws {
         let (_, fileId) = parsePath(path)
         
@@ -0,0 +1,142 @@
+//
+//  SearchCatalog.swift
+//  One Share
+//
+
+import Foundation
+
+// Filename index shared by the local scanner and the device services.
+// Wraps the native SearchIndex so six-figure catalogs stay out of Swift arrays;
+// services feed it from their listings and views query it directly.
+final class SearchCatalog: @unchecked Sendable {
+    static let shared = SearchCatalog()
+
+    // Device listings also index folders; what users count and search is files
+    static let fileTypes: [FileType] = [.file, .image, .video, .audio, .document, .archive]
+
+    // SearchIndex does its own locking
+    private let index: OpaquePointer
+
+    private init() {
+        index = search_index_create()
+    }
+
+    deinit {
+        search_index_free(index)
+    }
+
+    // MARK: - Feeding
+
+    // Replaces whatever the index had for a listed folder
+    func ingest(_ items: [FileSystemItem], listedAt directory: String, source: SearchSource) {
+        search_index_begin_directory(index, source, directory)
+        for item in items {
+            add(item, in: directory, source: source)
+        }
+    }
+
+    func add(_ item: FileSystemItem, in directory: String, source: SearchSource) {
+        search_index_add(index, source, directory, item.path, item.name,
+                         UInt64(max(item.size, 0)),
+                         Int64(item.modificationDate.timeIntervalSince1970),
+                         SearchCatalog.searchType(for: item.type))
+    }
+
+    func add(_ file: FileMetadata, source: SearchSource) {
+        let directory = (file.path as NSString).deletingLastPathComponent
+        search_index_add(index, source, directory, file.path, file.name,
+                         UInt64(max(file.size, 0)),
+                         Int64(file.modificationDate.timeIntervalSince1970),
+                         SearchCatalog.searchType(for: file.type))
+    }
+
+    func remove(path: String, in directory: String, source: SearchSource) {
+        search_index_remove(index, source, directory, path)
+    }
+
+    func clear(source: SearchSource) {
+        search_index_clear_source(index, source)
+    }
+
+    // MARK: - Querying
+
+    func count(sources: [SearchSource]? = nil, types: [FileType]? = nil) -> Int {
+        return Int(search_index_count(index, SearchCatalog.mask(for: sources), SearchCatalog.mask(for: types)))
+    }
+
+    // Empty text returns the newest files matching the facets
+    func search(_ text: String,
+                sources: [SearchSource]? = nil,
+                types: [FileType]? = nil,
+                modifiedAfter: Date? = nil,
+                limit: Int = 100) -> (files: [FileMetadata], total: Int) {
+        var query = search_default_query()
+        query.source_mask = SearchCatalog.mask(for: sources)
+        query.type_mask = SearchCatalog.mask(for: types)
+        if let date = modifiedAfter {
+            query.modified_after = Int64(date.timeIntervalSince1970)
+        }
+
+        var results = [SearchResult](repeating: SearchResult(), count: limit)
+        var total: Int32 = 0
+        let count = text.withCString { cText -> Int32 in
+            query.text = cText
+            return search_index_query(index, &query, &results, Int32(limit), &total)
+        }
+
+        guard count > 0 else { return ([], Int(total)) }
+        let files = results.prefix(Int(count)).map { result -> FileMetadata in
+            let name = withUnsafePointer(to: result.name) {
+                $0.withMemoryRebound(to: CChar.self, capacity: 256) { String(cString: $0) }
+            }
+            let path = withUnsafePointer(to: result.path) {
+                $0.withMemoryRebound(to: CChar.self, capacity: 1024) { String(cString: $0) }
+            }
+            return FileMetadata(
+                name: name,
+                path: path,
+                size: Int64(result.size),
+                modificationDate: Date(timeIntervalSince1970: TimeInterval(result.modification_date)),
+                type: SearchCatalog.fileType(for: result.type),
+                isRemote: result.source != UInt8(SEARCH_SOURCE_LOCAL.rawValue)
+            )
+        }
+        return (files, Int(total))
+    }
+
+    // MARK: - Helpers
+
+    private static func mask(for sources: [SearchSource]?) -> UInt32 {
+        guard let sources = sources else { return 0xFFFF_FFFF }
+        return sources.reduce(0) { $0 | (1 << $1.rawValue) }
+    }
+
+    private static func mask(for types: [FileType]?) -> UInt32 {
+        guard let types = types else { return 0xFFFF_FFFF }
+        return types.reduce(0) { $0 | (1 << SearchCatalog.searchType(for: $1).rawValue) }
+    }
+
+    private static func searchType(for type: FileType) -> SearchFileType {
+        switch type {
+        case .file: return SEARCH_TYPE_FILE
+        case .folder: return SEARCH_TYPE_FOLDER
+        case .image: return SEARCH_TYPE_IMAGE
+        case .video: return SEARCH_TYPE_VIDEO
+        case .audio: return SEARCH_TYPE_AUDIO
+        case .document: return SEARCH_TYPE_DOCUMENT
+        case .archive: return SEARCH_TYPE_ARCHIVE
+        }
+    }
+
+    private static func fileType(for type: UInt8) -> FileType {
+        switch UInt32(type) {
+        case SEARCH_TYPE_FOLDER.rawValue: return .folder
+        case SEARCH_TYPE_IMAGE.rawValue: return .image
+        case SEARCH_TYPE_VIDEO.rawValue: return .video
+        case SEARCH_TYPE_AUDIO.rawValue: return .audio
+        case SEARCH_TYPE_DOCUMENT.rawValue: return .document
+        case SEARCH_TYPE_ARCHIVE.rawValue: return .archive
+        default: return .file
+        }
+    }
+}
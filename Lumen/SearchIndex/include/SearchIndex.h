@@ -0,0 +1,100 @@
+#ifndef SearchIndex_h
+#define SearchIndex_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// In-memory filename index shared by the local scanner and the device bridges.
+//
+// Names are interned once and indexed by trigram postings (delta-encoded),
+// so substring queries touch only the names that contain every trigram of the
+// query. Queries that find too little fall back to fuzzy matching with a
+// small edit budget. Size, date, type and source facets filter the hits.
+// Matching is case-insensitive for ASCII; other UTF-8 bytes compare as-is.
+//
+// All functions are thread-safe.
+
+typedef enum {
+    SEARCH_SOURCE_LOCAL = 0,
+    SEARCH_SOURCE_MTP = 1,
+    SEARCH_SOURCE_IOS = 2,
+    SEARCH_SOURCE_ADB = 3
+} SearchSource;
+
+// Same order as FileType in Swift
+typedef enum {
+    SEARCH_TYPE_FILE = 0,
+    SEARCH_TYPE_FOLDER = 1,
+    SEARCH_TYPE_IMAGE = 2,
+    SEARCH_TYPE_VIDEO = 3,
+    SEARCH_TYPE_AUDIO = 4,
+    SEARCH_TYPE_DOCUMENT = 5,
+    SEARCH_TYPE_ARCHIVE = 6
+} SearchFileType;
+
+#define SEARCH_SOURCE_BIT(source) (1u << (source))
+#define SEARCH_TYPE_BIT(type) (1u << (type))
+#define SEARCH_ALL 0xFFFFFFFFu
+
+typedef struct {
+    const char* text;           // Whitespace-separated terms, all must match. NULL or "" lists by date.
+    uint32_t source_mask;       // SEARCH_SOURCE_BIT()s, SEARCH_ALL for every source
+    uint32_t type_mask;         // SEARCH_TYPE_BIT()s, SEARCH_ALL for every type
+    uint64_t min_size;
+    uint64_t max_size;          // 0 means no upper bound
+    int64_t modified_after;     // Unix timestamps, 0 means unbounded
+    int64_t modified_before;
+    bool fuzzy;                 // Allow typo matches when exact matches run short
+} SearchQuery;
+
+// Structs to pass data to Swift
+typedef struct {
+    char name[256];
+    char path[1024];
+    uint64_t size;
+    int64_t modification_date;  // Unix timestamp
+    uint8_t type;               // SearchFileType
+    uint8_t source;             // SearchSource
+    uint16_t score;             // Higher is better; results are sorted by it
+} SearchResult;
+
+typedef struct SearchIndex SearchIndex;
+
+SearchIndex* search_index_create(void);
+void search_index_free(SearchIndex* index);
+
+SearchQuery search_default_query(void);
+
+// Feeding
+// Call before re-adding the contents of a listed folder: drops what the index
+// had for it, so repeated listings replace rather than duplicate.
+void search_index_begin_directory(SearchIndex* index, SearchSource source, const char* directory);
+// directory is the listed folder, path the item's own path (usually directory/name)
+void search_index_add(SearchIndex* index, SearchSource source, const char* directory, const char* path,
+                      const char* name, uint64_t size, int64_t modification_date, SearchFileType type);
+// Returns true if an entry with this path was removed
+bool search_index_remove(SearchIndex* index, SearchSource source, const char* directory, const char* path);
+// Forgets everything from one source, e.g. when its device disconnects
+void search_index_clear_source(SearchIndex* index, SearchSource source);
+
+// Querying
+// Fills up to max_results entries, best first. total_matches (optional) receives
+// the number of entries that matched before truncation. Returns the count written.
+int search_index_query(SearchIndex* index, const SearchQuery* query, SearchResult* results, int max_results, int* total_matches);
+
+// Stats
+// Entries from the masked sources whose type is in type_mask
+int search_index_count(SearchIndex* index, uint32_t source_mask, uint32_t type_mask);
+// Approximate heap bytes held by the index
+size_t search_index_memory_usage(SearchIndex* index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SearchIndex_h */
@@ -0,0 +1,831 @@
+#include "SearchIndex.h"
+
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const uint32_t NONE = 0xFFFFFFFFu;
+
+// Entry::leaf values that need no storage: path is directory + "/" + name
+static const uint32_t LEAF_JOIN = 0xFFFFFFFFu;
+// Otherwise leaf is an offset into the leaf arena; this bit marks a full path
+// that does not start with the listed directory
+static const uint32_t LEAF_ABSOLUTE = 0x80000000u;
+
+// Rebuild once a third of the entries are tombstones (and there are enough to matter)
+static const uint32_t COMPACT_MIN_DEAD = 4096;
+
+// Fuzzy matching: terms this short only match exactly
+static const size_t FUZZY_MIN_TERM = 4;
+static const size_t FUZZY_TWO_EDITS_TERM = 8;
+
+// Score bands for a term found in a name
+static const int SCORE_EXACT = 1000;
+static const int SCORE_PREFIX = 600;
+static const int SCORE_WORD = 400;
+static const int SCORE_SUBSTRING = 200;
+static const int SCORE_FUZZY = 120;
+static const int SCORE_PER_EDIT = 40;
+
+static inline unsigned char fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+static inline uint32_t trigram_at(const unsigned char* s) {
+    return ((uint32_t)s[0] << 16) | ((uint32_t)s[1] << 8) | (uint32_t)s[2];
+}
+
+static inline bool is_word_char(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+static uint32_t hash_bytes(const char* s, size_t length) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void fold_into(const char* s, size_t length, std::string& out) {
+    out.resize(length);
+    for (size_t i = 0; i < length; i++) {
+        out[i] = (char)fold((unsigned char)s[i]);
+    }
+}
+
+// Unique, sorted trigrams of an already folded string
+static void collect_trigrams(const std::string& folded, std::vector<uint32_t>& out) {
+    out.clear();
+    if (folded.size() < 3) return;
+    const unsigned char* p = (const unsigned char*)folded.data();
+    for (size_t i = 0; i + 3 <= folded.size(); i++) {
+        out.push_back(trigram_at(p + i));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+// Smallest edit distance between term and any substring of text (Sellers),
+// counting a swap of neighbouring letters as one edit. Clamped to limit + 1.
+static size_t substring_edit_distance(const std::string& term, const std::string& text, size_t limit,
+                                      std::vector<size_t>& columns) {
+    size_t m = term.size();
+    // Three columns: two back for transpositions, previous, current
+    columns.assign(3 * (m + 1), 0);
+    size_t* before = columns.data();
+    size_t* previous = before + (m + 1);
+    size_t* current = previous + (m + 1);
+    for (size_t i = 0; i <= m; i++) previous[i] = before[i] = i;
+
+    size_t best = m;
+    for (size_t j = 0; j < text.size(); j++) {
+        current[0] = 0;  // A match may start anywhere
+        for (size_t i = 1; i <= m; i++) {
+            size_t cost = term[i - 1] == text[j] ? 0 : 1;
+            size_t value = std::min(std::min(current[i - 1] + 1, previous[i] + 1), previous[i - 1] + cost);
+            if (i > 1 && j > 0 && term[i - 1] == text[j - 1] && term[i - 2] == text[j]) {
+                value = std::min(value, before[i - 2] + 1);
+            }
+            current[i] = value;
+        }
+        best = std::min(best, current[m]);
+        if (best == 0) break;
+        size_t* recycled = before;
+        before = previous;
+        previous = current;
+        current = recycled;
+    }
+    return best <= limit ? best : limit + 1;
+}
+
+// MARK: - Postings
+
+// Name ids only ever grow, so each list is appended in order and stored as
+// varint deltas: common trigrams cost about a byte per name.
+struct Postings {
+    std::vector<uint8_t> bytes;
+    uint32_t last = 0;
+    uint32_t count = 0;
+
+    void append(uint32_t id) {
+        uint32_t delta = count == 0 ? id : id - last;
+        while (delta >= 0x80) {
+            bytes.push_back((uint8_t)(delta | 0x80));
+            delta >>= 7;
+        }
+        bytes.push_back((uint8_t)delta);
+        last = id;
+        count++;
+    }
+};
+
+class PostingsCursor {
+public:
+    explicit PostingsCursor(const Postings* postings)
+        : p(postings->bytes.data()), end(postings->bytes.data() + postings->bytes.size()) {
+        advance();
+    }
+
+    bool done() const { return exhausted; }
+    uint32_t value() const { return current; }
+
+    void advance() {
+        if (p == end) {
+            exhausted = true;
+            return;
+        }
+        uint32_t delta = 0;
+        int shift = 0;
+        while (p < end) {
+            uint8_t b = *p++;
+            delta |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+            shift += 7;
+        }
+        current = started ? current + delta : delta;
+        started = true;
+    }
+
+    // Moves to the first value >= target
+    void seek(uint32_t target) {
+        while (!exhausted && current < target) advance();
+    }
+
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    uint32_t current = 0;
+    bool started = false;
+    bool exhausted = false;
+};
+
+// MARK: - Catalog
+
+// 32 bytes per file
+struct Entry {
+    uint64_t size;
+    int64_t modification_date;
+    uint32_t name;              // Interned name id
+    uint32_t leaf;              // LEAF_JOIN or leaf arena offset
+    uint32_t next;              // Next entry with the same name
+    uint32_t directory : 24;    // Listed folder id
+    uint32_t type : 7;
+    uint32_t live : 1;
+};
+
+struct Directory {
+    std::string path;
+    uint8_t source;
+    std::vector<uint32_t> entries;
+};
+
+struct Candidate {
+    int score;
+    int64_t modification_date;
+    uint32_t entry;
+};
+
+// Used as the heap order, so the heap front is the weakest result kept so far
+static bool candidate_better(const Candidate& a, const Candidate& b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.modification_date != b.modification_date) return a.modification_date > b.modification_date;
+    return a.entry < b.entry;
+}
+
+class Catalog {
+public:
+    Catalog() {
+        name_offsets.push_back(0);
+        name_slots.assign(1024, 0);
+    }
+
+    void begin_directory(uint8_t source, const char* directory) {
+        uint32_t dir = find_directory(source, directory);
+        if (dir == NONE) return;
+        for (uint32_t e : directories[dir].entries) kill(e);
+        directories[dir].entries.clear();
+        directories[dir].entries.shrink_to_fit();
+    }
+
+    void add(uint8_t source, const char* directory, const char* path, const char* name,
+             uint64_t size, int64_t modification_date, uint8_t type) {
+        uint32_t dir = intern_directory(source, directory);
+        const std::string& dir_path = directories[dir].path;
+        size_t name_length = strlen(name);
+
+        uint32_t leaf = LEAF_JOIN;
+        if (!path_is_join(dir_path, path, name, name_length)) {
+            size_t dir_length = dir_path.size();
+            if (strncmp(path, dir_path.c_str(), dir_length) == 0) {
+                leaf = store_leaf(path + dir_length);
+            } else {
+                leaf = store_leaf(path) | LEAF_ABSOLUTE;
+            }
+        }
+        insert(dir, name, name_length, leaf, size, modification_date, type);
+    }
+
+    bool remove(uint8_t source, const char* directory, const char* path) {
+        uint32_t dir = find_directory(source, directory);
+        if (dir == NONE) return false;
+        std::vector<uint32_t>& children = directories[dir].entries;
+        std::string full;
+        for (size_t i = 0; i < children.size(); i++) {
+            build_path(children[i], full);
+            if (full == path) {
+                kill(children[i]);
+                children[i] = children.back();
+                children.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear_source(uint8_t source) {
+        for (Directory& directory : directories) {
+            if (directory.source != source) continue;
+            for (uint32_t e : directory.entries) kill(e);
+            directory.entries.clear();
+            directory.entries.shrink_to_fit();
+        }
+    }
+
+    bool needs_compaction() const {
+        return dead_count >= COMPACT_MIN_DEAD && dead_count > live_count / 2;
+    }
+
+    // Re-adds live entries into a fresh catalog: drops tombstones, names and
+    // trigrams nobody references any more.
+    void compact_into(Catalog& fresh) const {
+        std::string leaf_text;
+        for (const Directory& directory : directories) {
+            if (directory.entries.empty()) continue;
+            uint32_t dir = fresh.intern_directory(directory.source, directory.path.c_str());
+            for (uint32_t e : directory.entries) {
+                const Entry& entry = entries[e];
+                uint32_t leaf = LEAF_JOIN;
+                if (entry.leaf != LEAF_JOIN) {
+                    leaf = fresh.store_leaf(&leaves[entry.leaf & ~LEAF_ABSOLUTE]) | (entry.leaf & LEAF_ABSOLUTE);
+                }
+                fresh.insert(dir, name_at(entry.name), name_length(entry.name), leaf,
+                             entry.size, entry.modification_date, entry.type);
+            }
+        }
+    }
+
+    int count(uint32_t source_mask, uint32_t type_mask) const {
+        if (source_mask == SEARCH_ALL && type_mask == SEARCH_ALL) return (int)live_count;
+        size_t total = 0;
+        for (const Directory& directory : directories) {
+            if (!(source_mask & (1u << directory.source))) continue;
+            if (type_mask == SEARCH_ALL) {
+                total += directory.entries.size();
+                continue;
+            }
+            for (uint32_t e : directory.entries) {
+                if (type_mask & (1u << entries[e].type)) total++;
+            }
+        }
+        return (int)total;
+    }
+
+    size_t memory_usage() const {
+        size_t bytes = entries.capacity() * sizeof(Entry)
+            + name_bytes.capacity()
+            + name_offsets.capacity() * sizeof(uint32_t)
+            + name_heads.capacity() * sizeof(uint32_t)
+            + name_slots.capacity() * sizeof(uint32_t)
+            + leaves.capacity()
+            + scratch_counts.capacity();
+        for (const auto& item : postings) {
+            bytes += sizeof(item) + sizeof(void*) * 2 + item.second.bytes.capacity();
+        }
+        for (const Directory& directory : directories) {
+            bytes += sizeof(Directory) + directory.path.capacity() + directory.entries.capacity() * sizeof(uint32_t);
+        }
+        bytes += directory_ids.size() * (sizeof(std::string) + sizeof(uint32_t) + sizeof(void*) * 2);
+        return bytes;
+    }
+
+    int query(const SearchQuery& query, SearchResult* results, int max_results, int* total_matches) {
+        std::vector<std::string> terms;
+        split_terms(query.text, terms);
+
+        Collector collector(max_results);
+        if (terms.empty()) {
+            collect_recent(query, collector);
+        } else {
+            std::vector<uint32_t> exact_names;
+            collect_exact(query, terms, collector, exact_names);
+            if (query.fuzzy && collector.total < max_results) {
+                collect_fuzzy(query, terms, collector, exact_names);
+            }
+        }
+
+        if (total_matches) *total_matches = collector.total;
+        std::vector<Candidate> best = collector.finish();
+        for (size_t i = 0; i < best.size(); i++) {
+            fill_result(best[i], results[i]);
+        }
+        return (int)best.size();
+    }
+
+private:
+    std::vector<Entry> entries;
+    uint32_t live_count = 0;
+    uint32_t dead_count = 0;
+
+    // Interned names: bytes as given, NUL-terminated, addressed by offset
+    std::vector<char> name_bytes;
+    std::vector<uint32_t> name_offsets;     // name id -> start, plus one past the last name
+    std::vector<uint32_t> name_heads;       // name id -> first entry
+    std::vector<uint32_t> name_slots;       // Open addressing, name id + 1, 0 is empty
+
+    std::unordered_map<uint32_t, Postings> postings;
+
+    std::vector<Directory> directories;
+    std::unordered_map<std::string, uint32_t> directory_ids;  // source byte + path
+
+    std::vector<char> leaves;
+
+    // Per-query scratch, reused to keep queries allocation-light
+    std::vector<uint8_t> scratch_counts;
+    std::vector<uint32_t> scratch_trigrams;
+    std::string scratch_folded;
+    std::vector<size_t> scratch_columns;
+
+    // MARK: Names
+
+    const char* name_at(uint32_t id) const { return &name_bytes[name_offsets[id]]; }
+    size_t name_length(uint32_t id) const { return name_offsets[id + 1] - name_offsets[id] - 1; }
+
+    uint32_t intern_name(const char* name, size_t length) {
+        size_t mask = name_slots.size() - 1;
+        size_t slot = hash_bytes(name, length) & mask;
+        while (name_slots[slot] != 0) {
+            uint32_t id = name_slots[slot] - 1;
+            if (name_length(id) == length && memcmp(name_at(id), name, length) == 0) return id;
+            slot = (slot + 1) & mask;
+        }
+
+        uint32_t id = (uint32_t)name_heads.size();
+        name_bytes.insert(name_bytes.end(), name, name + length);
+        name_bytes.push_back('\0');
+        name_offsets.push_back((uint32_t)name_bytes.size());
+        name_heads.push_back(NONE);
+        name_slots[slot] = id + 1;
+
+        fold_into(name, length, scratch_folded);
+        collect_trigrams(scratch_folded, scratch_trigrams);
+        for (uint32_t trigram : scratch_trigrams) {
+            postings[trigram].append(id);
+        }
+
+        // Keep the table under 70% full
+        if ((size_t)name_heads.size() * 10 > name_slots.size() * 7) grow_name_slots();
+        return id;
+    }
+
+    void grow_name_slots() {
+        std::vector<uint32_t> bigger(name_slots.size() * 2, 0);
+        size_t mask = bigger.size() - 1;
+        for (uint32_t id = 0; id < (uint32_t)name_heads.size(); id++) {
+            size_t slot = hash_bytes(name_at(id), name_length(id)) & mask;
+            while (bigger[slot] != 0) slot = (slot + 1) & mask;
+            bigger[slot] = id + 1;
+        }
+        name_slots.swap(bigger);
+    }
+
+    // MARK: Entries
+
+    uint32_t intern_directory(uint8_t source, const char* path) {
+        std::string key(1, (char)source);
+        key += path;
+        auto found = directory_ids.find(key);
+        if (found != directory_ids.end()) return found->second;
+
+        uint32_t id = (uint32_t)directories.size();
+        directories.push_back(Directory{ path, source, {} });
+        directory_ids.emplace(std::move(key), id);
+        return id;
+    }
+
+    uint32_t find_directory(uint8_t source, const char* path) const {
+        std::string key(1, (char)source);
+        key += path;
+        auto found = directory_ids.find(key);
+        return found == directory_ids.end() ? NONE : found->second;
+    }
+
+    uint32_t store_leaf(const char* leaf) {
+        uint32_t offset = (uint32_t)leaves.size();
+        leaves.insert(leaves.end(), leaf, leaf + strlen(leaf) + 1);
+        return offset;
+    }
+
+    static bool path_is_join(const std::string& directory, const char* path, const char* name, size_t name_length) {
+        size_t dir_length = directory.size();
+        if (strncmp(path, directory.c_str(), dir_length) != 0) return false;
+        const char* rest = path + dir_length;
+        if (dir_length == 0 || directory[dir_length - 1] != '/') {
+            if (*rest != '/') return false;
+            rest++;
+        }
+        return strlen(rest) == name_length && memcmp(rest, name, name_length) == 0;
+    }
+
+    void build_path(uint32_t e, std::string& out) const {
+        const Entry& entry = entries[e];
+        const std::string& directory = directories[entry.directory].path;
+        if (entry.leaf == LEAF_JOIN) {
+            out = directory;
+            if (out.empty() || out.back() != '/') out += '/';
+            out.append(name_at(entry.name), name_length(entry.name));
+        } else if (entry.leaf & LEAF_ABSOLUTE) {
+            out = &leaves[entry.leaf & ~LEAF_ABSOLUTE];
+        } else {
+            out = directory;
+            out += &leaves[entry.leaf];
+        }
+    }
+
+    void insert(uint32_t dir, const char* name, size_t name_length, uint32_t leaf,
+                uint64_t size, int64_t modification_date, uint8_t type) {
+        uint32_t name_id = intern_name(name, name_length);
+        uint32_t e = (uint32_t)entries.size();
+        Entry entry;
+        entry.size = size;
+        entry.modification_date = modification_date;
+        entry.name = name_id;
+        entry.leaf = leaf;
+        entry.next = name_heads[name_id];
+        entry.directory = dir;
+        entry.type = type;
+        entry.live = 1;
+        entries.push_back(entry);
+        name_heads[name_id] = e;
+        directories[dir].entries.push_back(e);
+        live_count++;
+    }
+
+    void kill(uint32_t e) {
+        if (!entries[e].live) return;
+        entries[e].live = 0;
+        live_count--;
+        dead_count++;
+    }
+
+    // MARK: Query
+
+    struct Collector {
+        explicit Collector(int limit) : limit(limit > 0 ? (size_t)limit : 0) {}
+
+        void offer(const Candidate& candidate) {
+            total++;
+            if (limit == 0) return;
+            if (heap.size() < limit) {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end(), candidate_better);
+            } else if (candidate_better(candidate, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), candidate_better);
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end(), candidate_better);
+            }
+        }
+
+        std::vector<Candidate> finish() {
+            std::sort_heap(heap.begin(), heap.end(), candidate_better);
+            return std::move(heap);
+        }
+
+        size_t limit;
+        int total = 0;
+        std::vector<Candidate> heap;
+    };
+
+    static void split_terms(const char* text, std::vector<std::string>& terms) {
+        if (!text) return;
+        const char* p = text;
+        while (*p) {
+            while (*p == ' ' || *p == '\t' || *p == '\n') p++;
+            const char* start = p;
+            while (*p && *p != ' ' && *p != '\t' && *p != '\n') p++;
+            if (p > start) {
+                std::string term;
+                fold_into(start, (size_t)(p - start), term);
+                terms.push_back(std::move(term));
+            }
+        }
+    }
+
+    bool passes_facets(const SearchQuery& query, const Entry& entry) const {
+        if (!entry.live) return false;
+        if (!(query.source_mask & (1u << directories[entry.directory].source))) return false;
+        if (!(query.type_mask & (1u << entry.type))) return false;
+        if (entry.size < query.min_size) return false;
+        if (query.max_size != 0 && entry.size > query.max_size) return false;
+        if (query.modified_after != 0 && entry.modification_date < query.modified_after) return false;
+        if (query.modified_before != 0 && entry.modification_date > query.modified_before) return false;
+        return true;
+    }
+
+    void offer_name(const SearchQuery& query, uint32_t name_id, int score, Collector& collector) const {
+        for (uint32_t e = name_heads[name_id]; e != NONE; e = entries[e].next) {
+            const Entry& entry = entries[e];
+            if (passes_facets(query, entry)) {
+                collector.offer(Candidate{ score, entry.modification_date, e });
+            }
+        }
+    }
+
+    // Facet-only query: newest first
+    void collect_recent(const SearchQuery& query, Collector& collector) const {
+        for (uint32_t e = 0; e < (uint32_t)entries.size(); e++) {
+            const Entry& entry = entries[e];
+            if (passes_facets(query, entry)) {
+                collector.offer(Candidate{ 0, entry.modification_date, e });
+            }
+        }
+    }
+
+    static int term_score(const std::string& folded_name, size_t position, size_t term_length) {
+        if (position == 0 && term_length == folded_name.size()) return SCORE_EXACT;
+        if (position == 0) return SCORE_PREFIX;
+        unsigned char before = (unsigned char)folded_name[position - 1];
+        return is_word_char(before) ? SCORE_SUBSTRING : SCORE_WORD;
+    }
+
+    // Shorter names win among equal matches: "report.pdf" before "report-final-v2.pdf"
+    static int length_bonus(size_t name_length, size_t matched_length) {
+        size_t extra = name_length > matched_length ? name_length - matched_length : 0;
+        return extra >= 100 ? 0 : (int)(100 - extra);
+    }
+
+    // Cheap prefilter for one- and two-letter terms, straight off the name arena
+    bool contains_short_terms(uint32_t name_id, const std::vector<std::string>& terms) const {
+        const unsigned char* name = (const unsigned char*)name_at(name_id);
+        size_t length = name_length(name_id);
+        for (const std::string& term : terms) {
+            unsigned char first = (unsigned char)term[0];
+            bool found = false;
+            for (size_t i = 0; i + term.size() <= length && !found; i++) {
+                found = fold(name[i]) == first && (term.size() == 1 || fold(name[i + 1]) == (unsigned char)term[1]);
+            }
+            if (!found) return false;
+        }
+        return true;
+    }
+
+    // Every term must appear; returns the score or -1
+    int score_exact(uint32_t name_id, const std::vector<std::string>& terms) {
+        fold_into(name_at(name_id), name_length(name_id), scratch_folded);
+        int total = 0;
+        size_t matched = 0;
+        for (const std::string& term : terms) {
+            size_t position = scratch_folded.find(term);
+            if (position == std::string::npos) return -1;
+            total += term_score(scratch_folded, position, term.size());
+            matched += term.size();
+        }
+        return total / (int)terms.size() + length_bonus(scratch_folded.size(), matched);
+    }
+
+    void collect_exact(const SearchQuery& query, const std::vector<std::string>& terms,
+                       Collector& collector, std::vector<uint32_t>& matched_names) {
+        // Trigrams of every term long enough to have one
+        std::vector<uint32_t> trigrams;
+        for (const std::string& term : terms) {
+            collect_trigrams(term, scratch_trigrams);
+            trigrams.insert(trigrams.end(), scratch_trigrams.begin(), scratch_trigrams.end());
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+        uint32_t name_count = (uint32_t)name_heads.size();
+        if (trigrams.empty()) {
+            // Only one- and two-letter terms: a scan of the name arena is still cheap
+            for (uint32_t id = 0; id < name_count; id++) {
+                if (!contains_short_terms(id, terms)) continue;
+                int score = score_exact(id, terms);
+                if (score >= 0) {
+                    matched_names.push_back(id);
+                    offer_name(query, id, score, collector);
+                }
+            }
+            return;
+        }
+
+        // Intersect postings, rarest first so the lead cursor skips the most
+        std::vector<const Postings*> lists;
+        for (uint32_t trigram : trigrams) {
+            auto found = postings.find(trigram);
+            if (found == postings.end()) return;
+            lists.push_back(&found->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const Postings* a, const Postings* b) {
+            return a->count < b->count;
+        });
+
+        std::vector<PostingsCursor> cursors;
+        cursors.reserve(lists.size());
+        for (const Postings* list : lists) cursors.emplace_back(list);
+
+        PostingsCursor& lead = cursors[0];
+        while (!lead.done()) {
+            uint32_t id = lead.value();
+            bool all = true;
+            for (size_t i = 1; i < cursors.size(); i++) {
+                cursors[i].seek(id);
+                if (cursors[i].done()) return;
+                if (cursors[i].value() != id) {
+                    all = false;
+                    lead.seek(cursors[i].value());
+                    break;
+                }
+            }
+            if (!all) continue;
+
+            // Trigrams can match out of order; confirm the terms really occur
+            int score = score_exact(id, terms);
+            if (score >= 0) {
+                matched_names.push_back(id);
+                offer_name(query, id, score, collector);
+            }
+            lead.advance();
+        }
+    }
+
+    static size_t edit_budget(size_t term_length) {
+        if (term_length < FUZZY_MIN_TERM) return 0;
+        return term_length >= FUZZY_TWO_EDITS_TERM ? 2 : 1;
+    }
+
+    // Terms may each be off by their edit budget; returns the score or -1
+    int score_fuzzy(uint32_t name_id, const std::vector<std::string>& terms) {
+        fold_into(name_at(name_id), name_length(name_id), scratch_folded);
+        int total = 0;
+        size_t matched = 0;
+        for (const std::string& term : terms) {
+            size_t position = scratch_folded.find(term);
+            if (position != std::string::npos) {
+                total += term_score(scratch_folded, position, term.size());
+            } else {
+                size_t budget = edit_budget(term.size());
+                if (budget == 0) return -1;
+                size_t edits = substring_edit_distance(term, scratch_folded, budget, scratch_columns);
+                if (edits > budget) return -1;
+                total += SCORE_FUZZY - SCORE_PER_EDIT * (int)edits;
+            }
+            matched += term.size();
+        }
+        return total / (int)terms.size() + length_bonus(scratch_folded.size(), matched) / 2;
+    }
+
+    void collect_fuzzy(const SearchQuery& query, const std::vector<std::string>& terms,
+                       Collector& collector, std::vector<uint32_t>& exact_names) {
+        // Candidates come from the longest term: each edit touches at most four
+        // of its trigrams (a swap), so a name within k edits shares the rest
+        const std::string* anchor = nullptr;
+        for (const std::string& term : terms) {
+            if (!anchor || term.size() > anchor->size()) anchor = &term;
+        }
+        size_t budget = edit_budget(anchor->size());
+        if (budget == 0) return;
+
+        std::vector<uint32_t> trigrams;
+        collect_trigrams(*anchor, trigrams);
+        size_t needed = trigrams.size() > 4 * budget ? trigrams.size() - 4 * budget : 1;
+
+        uint32_t name_count = (uint32_t)name_heads.size();
+        scratch_counts.assign(name_count, 0);
+        std::vector<uint32_t> touched;
+        for (uint32_t trigram : trigrams) {
+            auto found = postings.find(trigram);
+            if (found == postings.end()) continue;
+            for (PostingsCursor cursor(&found->second); !cursor.done(); cursor.advance()) {
+                uint8_t& hits = scratch_counts[cursor.value()];
+                if (hits == 0) touched.push_back(cursor.value());
+                if (hits < 255) hits++;
+            }
+        }
+
+        // Names already reported by the exact pass
+        for (uint32_t id : exact_names) scratch_counts[id] = 0;
+
+        for (uint32_t id : touched) {
+            if (scratch_counts[id] < needed || name_heads[id] == NONE) continue;
+            int score = score_fuzzy(id, terms);
+            if (score >= 0) offer_name(query, id, score, collector);
+        }
+    }
+
+    void fill_result(const Candidate& candidate, SearchResult& result) const {
+        const Entry& entry = entries[candidate.entry];
+        memset(&result, 0, sizeof(result));
+
+        size_t length = std::min(name_length(entry.name), sizeof(result.name) - 1);
+        memcpy(result.name, name_at(entry.name), length);
+
+        std::string path;
+        build_path(candidate.entry, path);
+        length = std::min(path.size(), sizeof(result.path) - 1);
+        memcpy(result.path, path.data(), length);
+
+        result.size = entry.size;
+        result.modification_date = entry.modification_date;
+        result.type = entry.type;
+        result.source = directories[entry.directory].source;
+        result.score = (uint16_t)std::max(0, std::min(candidate.score, 0xFFFF));
+    }
+};
+
+struct SearchIndex {
+    std::mutex lock;
+    Catalog catalog;
+
+    void compact_if_needed() {
+        if (!catalog.needs_compaction()) return;
+        Catalog fresh;
+        catalog.compact_into(fresh);
+        std::swap(catalog, fresh);
+    }
+};
+
+// MARK: - C API
+
+extern "C" {
+
+SearchIndex* search_index_create(void) {
+    return new SearchIndex();
+}
+
+void search_index_free(SearchIndex* index) {
+    delete index;
+}
+
+SearchQuery search_default_query(void) {
+    SearchQuery query;
+    memset(&query, 0, sizeof(query));
+    query.source_mask = SEARCH_ALL;
+    query.type_mask = SEARCH_ALL;
+    query.fuzzy = true;
+    return query;
+}
+
+void search_index_begin_directory(SearchIndex* index, SearchSource source, const char* directory) {
+    if (!index || !directory) return;
+    std::lock_guard<std::mutex> guard(index->lock);
+    index->catalog.begin_directory((uint8_t)source, directory);
+    index->compact_if_needed();
+}
+
+void search_index_add(SearchIndex* index, SearchSource source, const char* directory, const char* path,
+                      const char* name, uint64_t size, int64_t modification_date, SearchFileType type) {
+    if (!index || !directory || !path || !name || !*name) return;
+    std::lock_guard<std::mutex> guard(index->lock);
+    index->catalog.add((uint8_t)source, directory, path, name, size, modification_date, (uint8_t)type);
+}
+
+bool search_index_remove(SearchIndex* index, SearchSource source, const char* directory, const char* path) {
+    if (!index || !directory || !path) return false;
+    std::lock_guard<std::mutex> guard(index->lock);
+    bool removed = index->catalog.remove((uint8_t)source, directory, path);
+    index->compact_if_needed();
+    return removed;
+}
+
+void search_index_clear_source(SearchIndex* index, SearchSource source) {
+    if (!index) return;
+    std::lock_guard<std::mutex> guard(index->lock);
+    index->catalog.clear_source((uint8_t)source);
+    index->compact_if_needed();
+}
+
+int search_index_query(SearchIndex* index, const SearchQuery* query, SearchResult* results, int max_results, int* total_matches) {
+    if (total_matches) *total_matches = 0;
+    if (!index || !query || (max_results > 0 && !results)) return -1;
+    std::lock_guard<std::mutex> guard(index->lock);
+    return index->catalog.query(*query, results, max_results, total_matches);
+}
+
+int search_index_count(SearchIndex* index, uint32_t source_mask, uint32_t type_mask) {
+    if (!index) return 0;
+    std::lock_guard<std::mutex> guard(index->lock);
+    return index->catalog.count(source_mask, type_mask);
+}
+
+size_t search_index_memory_usage(SearchIndex* index) {
+    if (!index) return 0;
+    std::lock_guard<std::mutex> guard(index->lock);
+    return index->catalog.memory_usage();
+}
+
+} // extern "C"
@@ -20,119 +20,206 @@ class TransferManager: ObservableObject {
     @Published var totalSize: Int64 = 0
     @Published var bytesTransferred: Int64 = 0
     
-    private var currentTask: Task<Void, any Error>?
+    // Per-link queue state for the progress window
+    @Published var queueSummary: [TransferLinkSummary] = []
+    
     private var transferStartTime: Date?
     private var lastUpdateTime: Date?
     private var lastBytesTransferred: Int64 = 0
     private var speedSamples: [Double] = [] // Rolling window for smooth speed calculation
     private let maxSpeedSamples = 10 // Keep last 10 samples
     
+    // Jobs waiting for a slot, by scheduler id. The closure reports the job's
+    // own progress (0...1) and a status line.
+    private struct QueuedJob {
+        let link: String
+        let size: Int64
+        let run: (_ report: @escaping (Double, String) -> Void) async throws -> Void
+    }
+    
+    private let queue = TransferQueue()
+    private var waiting: [UInt64: QueuedJob] = [:]
+    private var running: [UInt64: Task<Void, Never>] = [:]
+    
+    // One session runs from the first job queued to the queue draining
+    private var session = 0
+    private var sessionJobs = 0
+    private var sessionFailures = 0
+    private var lastError: Error?
+    
     func startTransfer(item: ClipboardItem, to destService: FileService, at destPath: String) {
-        guard !isTransferring else { return }
         guard !item.items.isEmpty else { return }
+        let link = TransferQueue.link(for: item.sourceService, destService)
+        
+        // Within one phone: let the device move or copy, nothing crosses the cable
+        if let batchService = destService as? BatchFileService,
+           (item.sourceService as AnyObject) === (batchService as AnyObject) {
+            let name = item.items.count == 1 ? item.items[0].name : "\(item.items.count) items"
+            let size = item.items.reduce(0) { $0 + $1.size }
+            enqueue(name: name, size: size, link: link) { [weak self] report in
+                try await self?.runDeviceBatch(item, on: batchService, to: destPath, report: report)
+            }
+            return
+        }
+        
+        for fileItem in item.items {
+            enqueue(name: fileItem.name, size: fileItem.size, link: link) { report in
+                try await TransferManager.copy(fileItem, from: item.sourceService, to: destService, at: destPath, report: report)
+            }
+        }
+    }
+    
+    // One file between two services
+    private static func copy(_ fileItem: FileSystemItem, from sourceService: FileService, to destService: FileService,
+                             at destPath: String, report: @escaping (Double, String) -> Void) async throws {
+        if sourceService is LocalFileService && destService is MTPService {
+            // Mac -> Android (Upload)
+            let sourceURL = URL(fileURLWithPath: fileItem.path)
+            try await destService.uploadFile(from: sourceURL, to: destPath) { fileProgress, _ in
+                report(fileProgress, "Uploading \(fileItem.name)...")
+            }
+        } else if sourceService is MTPService && destService is LocalFileService {
+            // Android -> Mac (Download)
+            let destURL = URL(fileURLWithPath: destPath).appendingPathComponent(fileItem.name)
+            try await sourceService.downloadFile(at: fileItem.path, to: destURL, size: fileItem.size) { fileProgress, _ in
+                report(fileProgress, "Downloading \(fileItem.name)...")
+            }
+        } else if let localService = sourceService as? LocalFileService, destService is LocalFileService {
+            // Mac -> Mac (Local Copy)
+            let destURL = URL(fileURLWithPath: destPath).appendingPathComponent(fileItem.name)
+            try await localService.downloadFile(at: fileItem.path, to: destURL, size: fileItem.size) { fileProgress, _ in
+                report(fileProgress, "Copying \(fileItem.name)...")
+            }
+        } else if sourceService is LocalFileService && destService is iOSDeviceService {
+            // Mac -> iOS (Upload)
+            let sourceURL = URL(fileURLWithPath: fileItem.path)
+            try await destService.uploadFile(from: sourceURL, to: destPath) { fileProgress, _ in
+                report(fileProgress, "Uploading \(fileItem.name)...")
+            }
+        } else if sourceService is iOSDeviceService && destService is LocalFileService {
+            // iOS -> Mac (Download)
+            let destURL = URL(fileURLWithPath: destPath).appendingPathComponent(fileItem.name)
+            try await sourceService.downloadFile(at: fileItem.path, to: destURL, size: fileItem.size) { fileProgress, _ in
+                report(fileProgress, "Downloading \(fileItem.name)...")
+            }
+        } else {
+            // Unsupported combinations
+            throw NSError(domain: "TransferManager", code: 1, userInfo: [NSLocalizedDescriptionKey: "Unsupported transfer type"])
+        }
+    }
+    
+    // MARK: - Queue
+    
+    private func enqueue(name: String, size: Int64, link: String,
+                         run: @escaping (_ report: @escaping (Double, String) -> Void) async throws -> Void) {
+        if !isTransferring || queue.isIdle {
+            beginSession()
+        }
+        let job = queue.submit(link: link, name: name, size: size)
+        waiting[job] = QueuedJob(link: link, size: size, run: run)
+        sessionJobs += 1
+        filename = sessionJobs == 1 ? name : "\(sessionJobs) files"
+        refreshQueue()
+        pump(link)
+    }
+    
+    private func beginSession() {
+        session += 1
+        sessionJobs = 0
+        sessionFailures = 0
+        lastError = nil
+        queue.clearFinished()
         
         isTransferring = true
-        filename = item.items.count == 1 ? item.items[0].name : "\(item.items.count) files"
         progress = 0
         status = "Preparing..."
         transferSpeed = ""
         timeRemaining = ""
+        totalSize = 0
+        bytesTransferred = 0
         transferStartTime = Date()
         lastUpdateTime = Date()
         lastBytesTransferred = 0
         speedSamples = []
-        
-        currentTask = Task {
-            do {
-                // Small delay to ensure UI shows "Preparing..."
-                try await Task.sleep(nanoseconds: 100_000_000) // 0.1s
-                
-                // Calculate total size
-                let totalSize = item.items.reduce(0) { $0 + $1.size }
-                var totalBytesProcessed: Int64 = 0
-                
-                for fileItem in item.items {
-                    // Determine transfer type
-                    if item.sourceService is LocalFileService && destService is MTPService {
-                        // Mac -> Android (Upload)
-                        let sourceURL = URL(fileURLWithPath: fileItem.path)
-                        try await destService.uploadFile(from: sourceURL, to: destPath) { [weak self] fileProgress, status in
-                            Task { @MainActor in
-                                let currentFileBytes = Int64(Double(fileItem.size) * fileProgress)
-                                let totalProgress = Double(totalBytesProcessed + currentFileBytes) / Double(totalSize > 0 ? totalSize : 1)
-                                self?.updateProgress(progress: totalProgress, status: "Uploading \(fileItem.name)...", totalSize: totalSize)
-                            }
-                        }
-                    } else if item.sourceService is MTPService && destService is LocalFileService {
-                        // Android -> Mac (Download)
-                        let destURL = URL(fileURLWithPath: destPath).appendingPathComponent(fileItem.name)
-                        try await item.sourceService.downloadFile(at: fileItem.path, to: destURL, size: fileItem.size) { [weak self] fileProgress, status in
-                            Task { @MainActor in
-                                let currentFileBytes = Int64(Double(fileItem.size) * fileProgress)
-                                let totalProgress = Double(totalBytesProcessed + currentFileBytes) / Double(totalSize > 0 ? totalSize : 1)
-                                self?.updateProgress(progress: totalProgress, status: "Downloading \(fileItem.name)...", totalSize: totalSize)
-                            }
-                        }
-                    } else if item.sourceService is LocalFileService && destService is LocalFileService {
-                        // Mac -> Mac (Local Copy)
-                        let destURL = URL(fileURLWithPath: destPath).appendingPathComponent(fileItem.name)
-                        try await (item.sourceService as! LocalFileService).downloadFile(at: fileItem.path, to: destURL, size: fileItem.size) { [weak self] fileProgress, status in
-                            Task { @MainActor in
-                                let currentFileBytes = Int64(Double(fileItem.size) * fileProgress)
-                                let totalProgress = Double(totalBytesProcessed + currentFileBytes) / Double(totalSize > 0 ? totalSize : 1)
-                                self?.updateProgress(progress: totalProgress, status: "Copying \(fileItem.name)...", totalSize: totalSize)
-                            }
-                        }
-                    } else if item.sourceService is LocalFileService && destService is iOSDeviceService {
-                        // Mac -> iOS (Upload)
-                        let sourceURL = URL(fileURLWithPath: fileItem.path)
-                        try await destService.uploadFile(from: sourceURL, to: destPath) { [weak self] fileProgress, status in
-                            Task { @MainActor in
-                                let currentFileBytes = Int64(Double(fileItem.size) * fileProgress)
-                                let totalProgress = Double(totalBytesProcessed + currentFileBytes) / Double(totalSize > 0 ? totalSize : 1)
-                                self?.updateProgress(progress: totalProgress, status: "Uploading \(fileItem.name)...", totalSize: totalSize)
-                            }
-                        }
-                    } else if item.sourceService is iOSDeviceService && destService is LocalFileService {
-                        // iOS -> Mac (Download)
-                        let destURL = URL(fileURLWithPath: destPath).appendingPathComponent(fileItem.name)
-                        try await item.sourceService.downloadFile(at: fileItem.path, to: destURL, size: fileItem.size) { [weak self] fileProgress, status in
-                            Task { @MainActor in
-                                let currentFileBytes = Int64(Double(fileItem.size) * fileProgress)
-                                let totalProgress = Double(totalBytesProcessed + currentFileBytes) / Double(totalSize > 0 ? totalSize : 1)
-                                self?.updateProgress(progress: totalProgress, status: "Downloading \(fileItem.name)...", totalSize: totalSize)
-                            }
+    }
+    
+    // Starts whatever the scheduler allows on link
+    private func pump(_ link: String) {
+        while let job = queue.take(link: link) {
+            guard let queued = waiting.removeValue(forKey: job) else {
+                queue.finish(job, result: -1)
+                continue
+            }
+            running[job] = Task { [weak self] in
+                var failure: Error?
+                do {
+                    try Task.checkCancellation()
+                    try await queued.run { fraction, status in
+                        Task { @MainActor in
+                            self?.jobProgressed(job, bytesDone: Int64(Double(queued.size) * fraction), status: status)
                         }
-                    } else {
-                        // Unsupported combinations
-                        self.status = "Unsupported transfer type"
-                        try await Task.sleep(nanoseconds: 1_000_000_000)
                     }
-                    
-                    totalBytesProcessed += fileItem.size
+                } catch {
+                    failure = error
                 }
-                
-                self.status = "Done"
-                self.progress = 1.0
-                self.transferSpeed = ""
-                self.timeRemaining = ""
-                
-                // Keep "Done" message visible for a moment
-                try await Task.sleep(nanoseconds: 1_500_000_000) // 1.5s
-                self.isTransferring = false
-                
-            } catch {
-                self.status = "Error: \(error.localizedDescription)"
-                self.transferSpeed = ""
-                self.timeRemaining = ""
+                self?.jobFinished(job, link: queued.link, error: failure)
+            }
+        }
+    }
+    
+    private func jobProgressed(_ job: UInt64, bytesDone: Int64, status: String) {
+        guard running[job] != nil else { return }
+        queue.progress(job, bytesDone: bytesDone)
+        refreshQueue(status: status)
+    }
+    
+    private func jobFinished(_ job: UInt64, link: String, error: Error?) {
+        queue.finish(job, result: error == nil ? 0 : -5)
+        pump(link)
+        // Jobs cancelled with an earlier session have already been accounted for
+        if running.removeValue(forKey: job) != nil {
+            if let error = error, !(error is CancellationError) {
                 print("Transfer error: \(error)")
-                
-                // Show a more user-friendly error message
-                let userMessage = self.getUserFriendlyErrorMessage(error)
-                self.status = "Error: \(userMessage)"
-                
-                // Keep error visible
-                try await Task.sleep(nanoseconds: 3_000_000_000) // 3s
+                sessionFailures += 1
+                lastError = error
+            }
+            refreshQueue()
+        }
+        if queue.isIdle && isTransferring {
+            endSession()
+        }
+    }
+    
+    // Aggregates every link into the single progress bar, speed and ETA
+    private func refreshQueue(status: String? = nil) {
+        let links = queue.links().filter { $0.running + $0.queued + $0.done + $0.failed + $0.cancelled > 0 }
+        queueSummary = links
+        let total = links.reduce(Int64(0)) { $0 + $1.totalBytes }
+        let done = links.reduce(Int64(0)) { $0 + $1.bytesDone }
+        guard total > 0 else { return }
+        updateProgress(progress: min(Double(done) / Double(total), 1.0), status: status ?? self.status, totalSize: total)
+    }
+    
+    private func endSession() {
+        let ended = session
+        let failures = sessionFailures
+        transferSpeed = ""
+        timeRemaining = ""
+        progress = 1.0
+        if failures == 0 {
+            status = "Done"
+        } else if failures == 1 && sessionJobs == 1, let error = lastError {
+            // Show a more user-friendly error message
+            status = "Error: \(getUserFriendlyErrorMessage(error))"
+        } else {
+            status = "\(failures) of \(sessionJobs) files failed"
+        }
+        
+        Task {
+            // Keep "Done" visible for a moment, errors a little longer
+            try? await Task.sleep(nanoseconds: failures == 0 ? 1_500_000_000 : 3_000_000_000)
+            // Unless more work arrived in the meantime
+            if self.session == ended && self.queue.isIdle {
                 self.isTransferring = false
             }
         }
@@ -212,8 +299,37 @@ class TransferManager: ObservableObject {
         }
     }
     
+    private func runDeviceBatch(_ item: ClipboardItem, on service: BatchFileService, to destPath: String,
+                                report: @escaping (Double, String) -> Void) async throws {
+        let verb = item.isCut ? "Moving" : "Copying"
+        let operations: [DeviceBatchOperation] = item.items.map {
+            item.isCut ? .move(path: $0.path, toFolder: destPath) : .copy(path: $0.path, toFolder: destPath)
+        }
+        
+        report(0, "\(verb) on device...")
+        let failures = try await service.applyBatch(operations) { done, total in
+            report(Double(done) / Double(max(total, 1)), "\(verb) on device (\(done) of \(total))...")
+        }
+        if !failures.isEmpty {
+            var message = "\(failures.count) of \(operations.count) items failed"
+            let copied = failures.filter { $0.code == Int(MTP_BATCH_COPY_REMAINS) }.count
+            if copied > 0 {
+                message += "; \(copied) were copied but the originals could not be removed, so a copy remains in both places"
+            }
+            throw NSError(domain: "TransferManager", code: 2,
+                          userInfo: [NSLocalizedDescriptionKey: message])
+        }
+    }
+    
     func cancel() {
-        currentTask?.cancel()
+        queue.cancelAll()
+        for task in running.values {
+            task.cancel()
+        }
+        running.removeAll()
+        waiting.removeAll()
+        session += 1
+        queueSummary = []
         isTransferring = false
         status = "Cancelled"
         transferSpeed = ""
@@ -283,162 +399,22 @@ class TransferManager: ObservableObject {
     
     // Handle transfers from Finder drops (direct file URLs)
     func startTransferFromURL(_ fileURL: URL, to destService: FileService, at destPath: String) {
-        guard !isTransferring else { return }
-        
-        isTransferring = true
-        filename = fileURL.lastPathComponent
-        progress = 0.01 // Show at least a little bit
-        status = "Preparing..."
-        transferSpeed = ""
-        timeRemaining = "Calculating..."
-        transferStartTime = Date()
-        lastUpdateTime = Date()
-        lastBytesTransferred = 0
-        speedSamples = []
-        
-        currentTask = Task {
-            do {
-                // Small delay to ensure UI shows "Preparing..."
-                try await Task.sleep(nanoseconds: 100_000_000) // 0.1s
-                
-                // Get file size
-                let fileSize = (try? FileManager.default.attributesOfItem(atPath: fileURL.path)[.size] as? Int64) ?? 0
-                
-                if destService is MTPService {
-                    // Upload to Android
-                    try await destService.uploadFile(from: fileURL, to: destPath) { [weak self] progress, status in
-                        Task { @MainActor in
-                            self?.updateProgress(progress: progress, status: status, totalSize: fileSize)
-                        }
-                    }
-                } else if destService is iOSDeviceService {
-                    // Upload to iOS
-                    try await destService.uploadFile(from: fileURL, to: destPath) { [weak self] progress, status in
-                        Task { @MainActor in
-                            self?.updateProgress(progress: progress, status: status, totalSize: fileSize)
-                        }
-                    }
-                } else if destService is LocalFileService {
-                    // Copy to Mac
-                    try await destService.uploadFile(from: fileURL, to: destPath) { [weak self] progress, status in
-                        Task { @MainActor in
-                            self?.updateProgress(progress: progress, status: status, totalSize: fileSize)
-                        }
-                    }
-                }
-                
-                self.status = "Done"
-                self.progress = 1.0
-                self.transferSpeed = ""
-                self.timeRemaining = ""
-                
-                // Keep "Done" message visible for a moment
-                try await Task.sleep(nanoseconds: 1_500_000_000) // 1.5s
-                self.isTransferring = false
-                
-            } catch {
-                self.status = "Error: \(error.localizedDescription)"
-                self.transferSpeed = ""
-                self.timeRemaining = ""
-                print("Transfer error: \(error)")
-                
-                // Show a more user-friendly error message
-                let userMessage = self.getUserFriendlyErrorMessage(error)
-                self.status = "Error: \(userMessage)"
-                
-                // Keep error visible
-                try await Task.sleep(nanoseconds: 3_000_000_000) // 3s
-                self.isTransferring = false
-            }
-        }
+        startMultipleTransfers([fileURL], to: destService, at: destPath)
     }
     
     // Handle multiple file transfers from Finder
     func startMultipleTransfers(_ fileURLs: [URL], to destService: FileService, at destPath: String) {
-        guard !isTransferring else { return }
-        guard !fileURLs.isEmpty else { return }
-        
-        isTransferring = true
-        filename = "\(fileURLs.count) files"
-        progress = 0.01
-        status = "Preparing..."
-        transferSpeed = ""
-        timeRemaining = "Calculating..."
-        transferStartTime = Date()
-        lastUpdateTime = Date()
-        lastBytesTransferred = 0
-        speedSamples = []
-        
-        currentTask = Task {
-            do {
-                // Small delay to ensure UI shows "Preparing..."
-                try await Task.sleep(nanoseconds: 100_000_000) // 0.1s
-                
-                // Calculate total size
-                var totalSize: Int64 = 0
-                for url in fileURLs {
-                    totalSize += (try? FileManager.default.attributesOfItem(atPath: url.path)[.size] as? Int64) ?? 0
+        let link = TransferQueue.link(for: destService)
+        for fileURL in fileURLs {
+            let fileSize = (try? FileManager.default.attributesOfItem(atPath: fileURL.path)[.size] as? Int64) ?? 0
+            let verb = destService is LocalFileService ? "Copying" : "Uploading"
+            enqueue(name: fileURL.lastPathComponent, size: fileSize, link: link) { report in
+                guard destService is MTPService || destService is iOSDeviceService || destService is LocalFileService else {
+                    throw NSError(domain: "TransferManager", code: 1, userInfo: [NSLocalizedDescriptionKey: "Unsupported transfer type"])
                 }
-                
-                var totalBytesProcessed: Int64 = 0
-                
-                for fileURL in fileURLs {
-                    let fileSize = (try? FileManager.default.attributesOfItem(atPath: fileURL.path)[.size] as? Int64) ?? 0
-                    
-                    if destService is MTPService {
-                        try await destService.uploadFile(from: fileURL, to: destPath) { [weak self] fileProgress, status in
-                            Task { @MainActor in
-                                let currentFileBytes = Int64(Double(fileSize) * fileProgress)
-                                let totalProgress = Double(totalBytesProcessed + currentFileBytes) / Double(totalSize > 0 ? totalSize : 1)
-                                
-                                self?.updateProgress(progress: totalProgress, status: "Uploading \(fileURL.lastPathComponent)...", totalSize: totalSize)
-                            }
-                        }
-                    } else if destService is iOSDeviceService {
-                        try await destService.uploadFile(from: fileURL, to: destPath) { [weak self] fileProgress, status in
-                            Task { @MainActor in
-                                let currentFileBytes = Int64(Double(fileSize) * fileProgress)
-                                let totalProgress = Double(totalBytesProcessed + currentFileBytes) / Double(totalSize > 0 ? totalSize : 1)
-                                
-                                self?.updateProgress(progress: totalProgress, status: "Uploading \(fileURL.lastPathComponent)...", totalSize: totalSize)
-                            }
-                        }
-                    } else if destService is LocalFileService {
-                        try await destService.uploadFile(from: fileURL, to: destPath) { [weak self] fileProgress, status in
-                            Task { @MainActor in
-                                let currentFileBytes = Int64(Double(fileSize) * fileProgress)
-                                let totalProgress = Double(totalBytesProcessed + currentFileBytes) / Double(totalSize > 0 ? totalSize : 1)
-                                
-                                self?.updateProgress(progress: totalProgress, status: "Copying \(fileURL.lastPathComponent)...", totalSize: totalSize)
-                            }
-                        }
-                    }
-                    
-                    totalBytesProcessed += fileSize
+                try await destService.uploadFile(from: fileURL, to: destPath) { fileProgress, _ in
+                    report(fileProgress, "\(verb) \(fileURL.lastPathComponent)...")
                 }
-                
-                self.status = "Done"
-                self.progress = 1.0
-                self.transferSpeed = ""
-                self.timeRemaining = ""
-                
-                // Keep "Done" message visible for a moment
-                try await Task.sleep(nanoseconds: 1_500_000_000) // 1.5s
-                self.isTransferring = false
-                
-            } catch {
-                self.status = "Error: \(error.localizedDescription)"
-                self.transferSpeed = ""
-                self.timeRemaining = ""
-                print("Transfer error: \(error)")
-                
-                // Show a more user-friendly error message
-                let userMessage = self.getUserFriendlyErrorMessage(error)
-                self.status = "Error: \(userMessage)"
-                
-                // Keep error visible
-                try await Task.sleep(nanoseconds: 3_000_000_000) // 3s
-                self.isTransferring = false
             }
         }
     }
@@ -15,6 +15,7 @@ struct TransferProgressView: View {
     let timeRemaining: String
     let totalSize: Int64
     let bytesTransferred: Int64
+    var links: [TransferLinkSummary] = [] // Per-device queues, shown when there is more than one file
     let onCancel: () -> Void
     
     // Format bytes to human readable string
@@ -34,6 +35,14 @@ struct TransferProgressView: View {
         }
     }
     
+    private func queueText(for link: TransferLinkSummary) -> String {
+        var parts = ["\(link.running) of \(link.maxConcurrent) running"]
+        if link.queued > 0 { parts.append("\(link.queued) queued") }
+        parts.append("\(link.done) done")
+        if link.failed > 0 { parts.append("\(link.failed) failed") }
+        return parts.joined(separator: " · ")
+    }
+    
     var body: some View {
         VStack(alignment: .leading, spacing: 16) {
             HStack(alignment: .top, spacing: 16) {
@@ -120,6 +129,24 @@ struct TransferProgressView: View {
                 }
             }
             .frame(height: 6)
+            
+            // Queue per device
+            if links.count > 1 || links.contains(where: { $0.queued > 0 }) {
+                VStack(alignment: .leading, spacing: 6) {
+                    ForEach(links) { link in
+                        HStack(spacing: 8) {
+                            Text(link.displayName)
+                                .font(.system(.caption, design: .rounded))
+                                .fontWeight(.medium)
+                            Spacer()
+                            Text(queueText(for: link))
+                                .font(.system(.caption, design: .rounded))
+                                .foregroundStyle(.secondary)
+                                .monospacedDigit()
+                        }
+                    }
+                }
+            }
         }
         .padding(20)
         .frame(width: 400)
@@ -20,6 +20,7 @@ struct TransferProgressWindow: View {
             timeRemaining: transferManager.timeRemaining,
             totalSize: transferManager.totalSize,
             bytesTransferred: transferManager.bytesTransferred,
+            links: transferManager.queueSummary,
             onCancel: {
                 transferManager.cancel()
                 dismiss()
@@ -0,0 +1,126 @@
+//
+//  TransferQueue.swift
+//  One Share
+//
+
+import Foundation
+
+// Per-link summary for the progress window
+struct TransferLinkSummary: Identifiable, Equatable {
+    let link: String
+    let maxConcurrent: Int
+    let running: Int
+    let queued: Int
+    let done: Int
+    let failed: Int
+    let cancelled: Int
+    let totalBytes: Int64
+    let bytesDone: Int64
+
+    var id: String { link }
+
+    var displayName: String {
+        switch link {
+        case TransferQueue.mtpLink: return "Android"
+        case TransferQueue.iosLink: return "iPhone"
+        case TransferQueue.adbLink: return "Android (ADB)"
+        case TransferQueue.localLink: return "This Mac"
+        default:
+            if link.hasPrefix("wireless:") { return String(link.dropFirst("wireless:".count)) }
+            return link
+        }
+    }
+}
+
+// Wraps the native TransferScheduler: one queue and concurrency limit per
+// link, small and large files interleaved within each. TransferManager runs
+// the jobs; this only decides which one goes next.
+final class TransferQueue: @unchecked Sendable {
+    static let mtpLink = "mtp"
+    static let iosLink = "ios"
+    static let adbLink = "adb"
+    static let localLink = "local"
+
+    // TransferScheduler does its own locking
+    private let scheduler: OpaquePointer
+
+    init() {
+        scheduler = transfer_scheduler_create()
+        // MTP allows one operation per session. The iPhone and adb services
+        // each run transfers on one serial queue, so a second slot would only
+        // mark a job as running while it waits behind the first.
+        transfer_scheduler_set_link_limit(scheduler, TransferQueue.mtpLink, 1)
+        transfer_scheduler_set_link_limit(scheduler, TransferQueue.iosLink, 1)
+        transfer_scheduler_set_link_limit(scheduler, TransferQueue.adbLink, 1)
+        transfer_scheduler_set_link_limit(scheduler, TransferQueue.localLink, 4)
+    }
+
+    deinit {
+        transfer_scheduler_free(scheduler)
+    }
+
+    // The device side of a transfer decides which link it uses
+    static func link(for services: FileService...) -> String {
+        for service in services {
+            switch service {
+            case is MTPService: return mtpLink
+            case is iOSDeviceService: return iosLink
+            case is ADBService: return adbLink
+            default: continue
+            }
+        }
+        return localLink
+    }
+
+    func submit(link: String, name: String, size: Int64) -> UInt64 {
+        return transfer_scheduler_submit(scheduler, link, name, UInt64(max(size, 0)))
+    }
+
+    // Next job to start on link, if a slot is free
+    func take(link: String) -> UInt64? {
+        let job = transfer_scheduler_take(scheduler, link)
+        return job == 0 ? nil : job
+    }
+
+    func progress(_ job: UInt64, bytesDone: Int64) {
+        transfer_scheduler_progress(scheduler, job, UInt64(max(bytesDone, 0)))
+    }
+
+    func finish(_ job: UInt64, result: Int32) {
+        transfer_scheduler_finish(scheduler, job, result)
+    }
+
+    @discardableResult
+    func cancelAll() -> Int {
+        return Int(transfer_scheduler_cancel_all(scheduler))
+    }
+
+    func clearFinished() {
+        transfer_scheduler_clear_finished(scheduler)
+    }
+
+    var isIdle: Bool {
+        return transfer_scheduler_idle(scheduler)
+    }
+
+    func links() -> [TransferLinkSummary] {
+        var states = [TransferLinkState](repeating: TransferLinkState(), count: 16)
+        let count = transfer_scheduler_links(scheduler, &states, Int32(states.count))
+        return states.prefix(Int(count)).map { state in
+            let link = withUnsafePointer(to: state.link) {
+                $0.withMemoryRebound(to: CChar.self, capacity: 64) { String(cString: $0) }
+            }
+            return TransferLinkSummary(
+                link: link,
+                maxConcurrent: Int(state.max_concurrent),
+                running: Int(state.running),
+                queued: Int(state.queued_small + state.queued_large),
+                done: Int(state.done),
+                failed: Int(state.failed),
+                cancelled: Int(state.cancelled),
+                totalBytes: Int64(state.queued_bytes + state.running_bytes + state.bytes_done),
+                bytesDone: Int64(state.running_bytes_done + state.bytes_done)
+            )
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef TransferScheduler_h
+#define TransferScheduler_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Orders file transfers across every connected device.
+//
+// Each link (a phone's USB connection, a wireless peer, the local disk) has
+// its own queue and concurrency limit, and links run independently of each
+// other. Within a link, jobs are split by size into a small and a large lane
+// served by deficit round robin on estimated link time: while both lanes have
+// work, each gets an equal share of the link, so hundreds of photos are not
+// stuck behind one video and the video still gets its turn however many
+// photos keep arriving. Within a lane jobs run in submission order. With more
+// than one slot, large jobs never take the last one.
+//
+// The scheduler does no I/O. The caller takes jobs when a slot may be free,
+// runs them, and reports progress and completion. All functions are thread-safe.
+
+typedef enum {
+    TRANSFER_JOB_QUEUED = 0,
+    TRANSFER_JOB_RUNNING = 1,
+    TRANSFER_JOB_DONE = 2,
+    TRANSFER_JOB_FAILED = 3,
+    TRANSFER_JOB_CANCELLED = 4
+} TransferJobState;
+
+// Structs to pass data to Swift
+typedef struct {
+    uint64_t id;
+    char link[64];
+    char name[256];
+    uint64_t size;
+    uint64_t bytes_done;
+    uint8_t state;              // TransferJobState
+    bool large;
+    int result;                 // As passed to transfer_scheduler_finish
+} TransferJobInfo;
+
+typedef struct {
+    char link[64];
+    int max_concurrent;
+    int running;
+    int queued_small;
+    int queued_large;
+    uint64_t queued_bytes;
+    uint64_t running_bytes;     // Sizes of the running jobs
+    uint64_t running_bytes_done;
+    int done;
+    int failed;
+    int cancelled;
+    uint64_t bytes_done;        // Finished jobs, successful or not
+    double bytes_per_second;    // Current estimate
+    double seconds_per_file;
+} TransferLinkState;
+
+typedef struct TransferScheduler TransferScheduler;
+
+TransferScheduler* transfer_scheduler_create(void);
+void transfer_scheduler_free(TransferScheduler* scheduler);
+
+// Configuration
+// Jobs at or above this size go in the large lane. Default 8 MB.
+void transfer_scheduler_set_large_threshold(TransferScheduler* scheduler, uint64_t bytes);
+// Default 1 for links never configured
+void transfer_scheduler_set_link_limit(TransferScheduler* scheduler, const char* link, int max_concurrent);
+// Seeds the cost model. Finished jobs refine it unless they took under a millisecond.
+void transfer_scheduler_set_link_estimate(TransferScheduler* scheduler, const char* link,
+                                          double bytes_per_second, double seconds_per_file);
+
+// Jobs
+// Returns the job id, never 0
+uint64_t transfer_scheduler_submit(TransferScheduler* scheduler, const char* link, const char* name, uint64_t size);
+// Starts the next job on link if a slot is free and returns its id, or 0
+uint64_t transfer_scheduler_take(TransferScheduler* scheduler, const char* link);
+void transfer_scheduler_progress(TransferScheduler* scheduler, uint64_t job, uint64_t bytes_done);
+// result 0 is success
+void transfer_scheduler_finish(TransferScheduler* scheduler, uint64_t job, int result);
+// A queued job is dropped; a running one is reported as cancelled when it finishes.
+// Returns false if the job is unknown or already finished.
+bool transfer_scheduler_cancel(TransferScheduler* scheduler, uint64_t job);
+// Returns the number of jobs cancelled
+int transfer_scheduler_cancel_all(TransferScheduler* scheduler);
+// Forgets finished jobs and resets the per-link totals
+void transfer_scheduler_clear_finished(TransferScheduler* scheduler);
+
+// Queue state
+// True when nothing is queued or running
+bool transfer_scheduler_idle(TransferScheduler* scheduler);
+// Fills up to max links in name order. Returns the count written.
+int transfer_scheduler_links(TransferScheduler* scheduler, TransferLinkState* links, int max);
+// Running jobs first, then queued, then finished, each in submission order.
+// total (optional) receives the number of jobs known. Returns the count written.
+int transfer_scheduler_jobs(TransferScheduler* scheduler, TransferJobInfo* jobs, int max, int* total);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TransferScheduler_h */
@@ -0,0 +1,372 @@
+#include "TransferScheduler.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+static const uint64_t DEFAULT_LARGE_THRESHOLD = 8ull * 1024 * 1024;
+
+// Link time each lane is credited per round while both have work
+static const double QUANTUM_SECONDS = 1.0;
+
+// Cost model before a link has finished anything: USB 2 MTP-ish
+static const double DEFAULT_BYTES_PER_SECOND = 20.0 * 1024 * 1024;
+static const double DEFAULT_SECONDS_PER_FILE = 0.03;
+
+// Weight of each new sample in the running estimates
+static const double ESTIMATE_WEIGHT = 0.2;
+
+enum { LANE_SMALL = 0, LANE_LARGE = 1 };
+
+struct Job {
+    uint64_t id;
+    std::string link;
+    std::string name;
+    uint64_t size;
+    uint64_t bytes_done = 0;
+    TransferJobState state = TRANSFER_JOB_QUEUED;
+    bool large;
+    bool cancel_requested = false;
+    int result = 0;
+    std::chrono::steady_clock::time_point started;
+};
+
+struct Link {
+    int max_concurrent = 1;
+    std::deque<uint64_t> lanes[2];
+    uint64_t queued_bytes = 0;
+
+    // Deficit round robin between the lanes
+    double deficit[2] = { 0, 0 };
+    int turn = LANE_SMALL;
+    bool turn_credited = false;
+
+    int running = 0;
+    int running_large = 0;
+
+    double bytes_per_second = DEFAULT_BYTES_PER_SECOND;
+    double seconds_per_file = DEFAULT_SECONDS_PER_FILE;
+
+    int done = 0;
+    int failed = 0;
+    int cancelled = 0;
+    uint64_t bytes_done = 0;
+};
+
+struct TransferScheduler {
+    std::mutex lock;
+    uint64_t large_threshold = DEFAULT_LARGE_THRESHOLD;
+    uint64_t next_id = 1;
+    std::map<uint64_t, Job> jobs;
+    std::map<std::string, Link> links;
+};
+
+static void copy_string(char* out, size_t out_size, const std::string& value) {
+    size_t length = std::min(value.size(), out_size - 1);
+    memcpy(out, value.data(), length);
+    out[length] = '\0';
+}
+
+static double estimated_seconds(const Link& link, const Job& job) {
+    return link.seconds_per_file + (double)job.size / link.bytes_per_second;
+}
+
+// Large jobs leave one slot for small ones when there is more than one
+static bool lane_can_start(const Link& link, int lane) {
+    if (link.lanes[lane].empty()) return false;
+    if (lane == LANE_LARGE) {
+        return link.running_large < std::max(1, link.max_concurrent - 1);
+    }
+    return true;
+}
+
+static int pick_lane(TransferScheduler* scheduler, Link& link) {
+    bool small = lane_can_start(link, LANE_SMALL);
+    bool large = lane_can_start(link, LANE_LARGE);
+    // A lane with nothing queued carries no credit into its next busy period
+    for (int lane = LANE_SMALL; lane <= LANE_LARGE; lane++) {
+        if (link.lanes[lane].empty()) link.deficit[lane] = 0;
+    }
+    if (!small && !large) return -1;
+    if (small != large) return small ? LANE_SMALL : LANE_LARGE;
+
+    // Each visit credits the lane a quantum of link time; it starts jobs while
+    // its credit covers the next one, then the turn passes. A job larger than
+    // a quantum waits a few rounds, during which the other lane keeps moving.
+    for (;;) {
+        int lane = link.turn;
+        if (!link.turn_credited) {
+            link.deficit[lane] += QUANTUM_SECONDS;
+            link.turn_credited = true;
+        }
+        const Job& head = scheduler->jobs[link.lanes[lane].front()];
+        double cost = estimated_seconds(link, head);
+        if (cost <= link.deficit[lane]) {
+            link.deficit[lane] -= cost;
+            return lane;
+        }
+        link.turn = lane == LANE_SMALL ? LANE_LARGE : LANE_SMALL;
+        link.turn_credited = false;
+    }
+}
+
+static void learn(Link& link, const Job& job) {
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.started).count();
+    // Too short to say anything about the link
+    if (elapsed < 0.001) return;
+    // Concurrent jobs share the link; judge each by its share
+    elapsed /= std::max(1, link.running + 1);
+
+    if (job.large) {
+        double transfer = elapsed - link.seconds_per_file;
+        if (transfer > 0) {
+            double sample = (double)job.size / transfer;
+            link.bytes_per_second += ESTIMATE_WEIGHT * (sample - link.bytes_per_second);
+        }
+    } else {
+        double overhead = std::max(0.0, elapsed - (double)job.size / link.bytes_per_second);
+        link.seconds_per_file += ESTIMATE_WEIGHT * (overhead - link.seconds_per_file);
+    }
+}
+
+TransferScheduler* transfer_scheduler_create(void) {
+    return new TransferScheduler();
+}
+
+void transfer_scheduler_free(TransferScheduler* scheduler) {
+    delete scheduler;
+}
+
+void transfer_scheduler_set_large_threshold(TransferScheduler* scheduler, uint64_t bytes) {
+    if (!scheduler) return;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    scheduler->large_threshold = bytes > 0 ? bytes : DEFAULT_LARGE_THRESHOLD;
+}
+
+void transfer_scheduler_set_link_limit(TransferScheduler* scheduler, const char* link, int max_concurrent) {
+    if (!scheduler || !link) return;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    scheduler->links[link].max_concurrent = std::max(1, max_concurrent);
+}
+
+void transfer_scheduler_set_link_estimate(TransferScheduler* scheduler, const char* link,
+                                          double bytes_per_second, double seconds_per_file) {
+    if (!scheduler || !link) return;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    Link& state = scheduler->links[link];
+    if (bytes_per_second > 0) state.bytes_per_second = bytes_per_second;
+    if (seconds_per_file >= 0) state.seconds_per_file = seconds_per_file;
+}
+
+uint64_t transfer_scheduler_submit(TransferScheduler* scheduler, const char* link, const char* name, uint64_t size) {
+    if (!scheduler || !link) return 0;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+
+    Job job;
+    job.id = scheduler->next_id++;
+    job.link = link;
+    job.name = name ? name : "";
+    job.size = size;
+    job.large = size >= scheduler->large_threshold;
+
+    Link& state = scheduler->links[job.link];
+    state.lanes[job.large ? LANE_LARGE : LANE_SMALL].push_back(job.id);
+    state.queued_bytes += size;
+    scheduler->jobs.emplace(job.id, std::move(job));
+    return scheduler->next_id - 1;
+}
+
+uint64_t transfer_scheduler_take(TransferScheduler* scheduler, const char* link) {
+    if (!scheduler || !link) return 0;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+
+    auto found = scheduler->links.find(link);
+    if (found == scheduler->links.end()) return 0;
+    Link& state = found->second;
+    if (state.running >= state.max_concurrent) return 0;
+
+    int lane = pick_lane(scheduler, state);
+    if (lane < 0) return 0;
+
+    uint64_t id = state.lanes[lane].front();
+    state.lanes[lane].pop_front();
+    Job& job = scheduler->jobs[id];
+    job.state = TRANSFER_JOB_RUNNING;
+    job.started = std::chrono::steady_clock::now();
+    state.queued_bytes -= job.size;
+    state.running++;
+    if (job.large) state.running_large++;
+    return id;
+}
+
+void transfer_scheduler_progress(TransferScheduler* scheduler, uint64_t job, uint64_t bytes_done) {
+    if (!scheduler) return;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    auto found = scheduler->jobs.find(job);
+    if (found == scheduler->jobs.end() || found->second.state != TRANSFER_JOB_RUNNING) return;
+    found->second.bytes_done = std::min(bytes_done, found->second.size);
+}
+
+void transfer_scheduler_finish(TransferScheduler* scheduler, uint64_t job, int result) {
+    if (!scheduler) return;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    auto found = scheduler->jobs.find(job);
+    if (found == scheduler->jobs.end() || found->second.state != TRANSFER_JOB_RUNNING) return;
+
+    Job& finished = found->second;
+    Link& state = scheduler->links[finished.link];
+    state.running--;
+    if (finished.large) state.running_large--;
+
+    finished.result = result;
+    if (finished.cancel_requested) {
+        finished.state = TRANSFER_JOB_CANCELLED;
+        state.cancelled++;
+    } else if (result == 0) {
+        finished.state = TRANSFER_JOB_DONE;
+        finished.bytes_done = finished.size;
+        state.done++;
+        learn(state, finished);
+    } else {
+        finished.state = TRANSFER_JOB_FAILED;
+        state.failed++;
+    }
+    state.bytes_done += finished.bytes_done;
+}
+
+static bool cancel_job(TransferScheduler* scheduler, Job& job) {
+    if (job.state == TRANSFER_JOB_RUNNING) {
+        if (job.cancel_requested) return false;
+        job.cancel_requested = true;
+        return true;
+    }
+    if (job.state != TRANSFER_JOB_QUEUED) return false;
+
+    Link& state = scheduler->links[job.link];
+    std::deque<uint64_t>& lane = state.lanes[job.large ? LANE_LARGE : LANE_SMALL];
+    lane.erase(std::remove(lane.begin(), lane.end(), job.id), lane.end());
+    state.queued_bytes -= job.size;
+    state.cancelled++;
+    job.state = TRANSFER_JOB_CANCELLED;
+    return true;
+}
+
+bool transfer_scheduler_cancel(TransferScheduler* scheduler, uint64_t job) {
+    if (!scheduler) return false;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    auto found = scheduler->jobs.find(job);
+    if (found == scheduler->jobs.end()) return false;
+    return cancel_job(scheduler, found->second);
+}
+
+int transfer_scheduler_cancel_all(TransferScheduler* scheduler) {
+    if (!scheduler) return 0;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    int cancelled = 0;
+    for (auto& entry : scheduler->jobs) {
+        if (cancel_job(scheduler, entry.second)) cancelled++;
+    }
+    return cancelled;
+}
+
+void transfer_scheduler_clear_finished(TransferScheduler* scheduler) {
+    if (!scheduler) return;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    for (auto it = scheduler->jobs.begin(); it != scheduler->jobs.end();) {
+        TransferJobState state = it->second.state;
+        if (state == TRANSFER_JOB_QUEUED || state == TRANSFER_JOB_RUNNING) {
+            ++it;
+        } else {
+            it = scheduler->jobs.erase(it);
+        }
+    }
+    for (auto& entry : scheduler->links) {
+        Link& state = entry.second;
+        state.done = state.failed = state.cancelled = 0;
+        state.bytes_done = 0;
+    }
+}
+
+bool transfer_scheduler_idle(TransferScheduler* scheduler) {
+    if (!scheduler) return true;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    for (const auto& entry : scheduler->links) {
+        const Link& state = entry.second;
+        if (state.running > 0 || !state.lanes[LANE_SMALL].empty() || !state.lanes[LANE_LARGE].empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int transfer_scheduler_links(TransferScheduler* scheduler, TransferLinkState* links, int max) {
+    if (!scheduler || !links || max <= 0) return 0;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+
+    int count = 0;
+    for (const auto& entry : scheduler->links) {
+        if (count >= max) break;
+        const Link& state = entry.second;
+        TransferLinkState& out = links[count++];
+        memset(&out, 0, sizeof(out));
+        copy_string(out.link, sizeof(out.link), entry.first);
+        out.max_concurrent = state.max_concurrent;
+        out.running = state.running;
+        out.queued_small = (int)state.lanes[LANE_SMALL].size();
+        out.queued_large = (int)state.lanes[LANE_LARGE].size();
+        out.queued_bytes = state.queued_bytes;
+        out.done = state.done;
+        out.failed = state.failed;
+        out.cancelled = state.cancelled;
+        out.bytes_done = state.bytes_done;
+        out.bytes_per_second = state.bytes_per_second;
+        out.seconds_per_file = state.seconds_per_file;
+    }
+    // Running totals come from the jobs themselves
+    for (const auto& entry : scheduler->jobs) {
+        const Job& job = entry.second;
+        if (job.state != TRANSFER_JOB_RUNNING) continue;
+        for (int i = 0; i < count; i++) {
+            if (job.link == links[i].link) {
+                links[i].running_bytes += job.size;
+                links[i].running_bytes_done += job.bytes_done;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+int transfer_scheduler_jobs(TransferScheduler* scheduler, TransferJobInfo* jobs, int max, int* total) {
+    if (!scheduler) return 0;
+    std::lock_guard<std::mutex> guard(scheduler->lock);
+    if (total) *total = (int)scheduler->jobs.size();
+    if (!jobs || max <= 0) return 0;
+
+    int count = 0;
+    auto emit = [&](bool (*wanted)(TransferJobState)) {
+        for (const auto& entry : scheduler->jobs) {
+            if (count >= max) return;
+            const Job& job = entry.second;
+            if (!wanted(job.state)) continue;
+            TransferJobInfo& out = jobs[count++];
+            memset(&out, 0, sizeof(out));
+            out.id = job.id;
+            copy_string(out.link, sizeof(out.link), job.link);
+            copy_string(out.name, sizeof(out.name), job.name);
+            out.size = job.size;
+            out.bytes_done = job.bytes_done;
+            out.state = (uint8_t)job.state;
+            out.large = job.large;
+            out.result = job.result;
+        }
+    };
+    emit([](TransferJobState state) { return state == TRANSFER_JOB_RUNNING; });
+    emit([](TransferJobState state) { return state == TRANSFER_JOB_QUEUED; });
+    emit([](TransferJobState state) { return state != TRANSFER_JOB_RUNNING && state != TRANSFER_JOB_QUEUED; });
+    return count;
+}
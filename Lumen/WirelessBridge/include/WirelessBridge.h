@@ -0,0 +1,95 @@
+#ifndef WirelessBridge_h
+#define WirelessBridge_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Native wireless transfer engine.
+//
+// Speaks the same protocol as NetworkManager / the Android app:
+//   sender   -> "FILENAME::SIZE::"
+//   receiver -> "ACCEPT::" or "DECLINE::"
+//   sender   -> raw body, then closes the connection
+//
+// A native receiver answers "ACCEPT::NATIVE::<max streams>::<token>::<codecs>::"
+// instead. A native sender may then push ranges of the file over additional
+// connections that start with "STRIPE::<token>::<offset>::<length>::" (raw
+// bytes) or "ZSTRIPE::<token>::<offset>::<length>::" (compressed frames), and
+// sends only the first range, possibly empty, over the primary connection.
+// Legacy peers only look for the "ACCEPT" prefix, so they keep working over a
+// single uncompressed stream.
+
+typedef enum {
+    WIRELESS_OK = 0,
+    WIRELESS_E_INVALID_ARG = -1,
+    WIRELESS_E_CONNECT = -2,
+    WIRELESS_E_DECLINED = -3,
+    WIRELESS_E_CANCELLED = -4,
+    WIRELESS_E_IO = -5,
+    WIRELESS_E_PROTOCOL = -6
+} WirelessError;
+
+typedef enum {
+    WIRELESS_COMPRESSION_OFF = 0,
+    // Compress per 1 MB chunk with zstd/lz4 when the peer supports it and a quick
+    // entropy sample says the data will shrink. Media passes through untouched.
+    WIRELESS_COMPRESSION_AUTO = 1
+} WirelessCompression;
+
+typedef struct {
+    int max_streams;            // Parallel TCP streams per file (1 disables striping)
+    uint64_t stripe_threshold;  // Files smaller than this always use a single stream
+    int socket_buffer_size;     // SO_SNDBUF / SO_RCVBUF in bytes, 0 keeps the OS default
+    WirelessCompression compression;
+} WirelessConfig;
+
+// Callback for progress: transferred bytes, total bytes, context
+typedef void (*WirelessProgressCallback)(uint64_t sent, uint64_t total, const void* context);
+// Called when a peer offers a file. Return true to accept it.
+typedef bool (*WirelessRequestCallback)(const char* file_name, uint64_t size, const void* context);
+// Called once per accepted file with the name it was offered under, the saved path (NULL on failure) and a WirelessError
+typedef void (*WirelessCompletionCallback)(const char* file_name, const char* saved_path, int result, const void* context);
+// Pairing messages arrive on the transfer port too: message is "PAIR_REQUEST" (value is the
+// peer's port) or "PAIR_VERIFY" (value is the code). For PAIR_VERIFY the return value picks
+// the PAIR_ACK / PAIR_FAIL reply.
+typedef bool (*WirelessPairingCallback)(const char* message, const char* value, const char* peer_host, const void* context);
+
+WirelessConfig wireless_default_config(void);
+
+// Sending
+// A transfer handle targets one peer and can send any number of files, one at a time.
+typedef struct WirelessTransfer WirelessTransfer;
+
+WirelessTransfer* wireless_transfer_create(const char* host, uint16_t port, const WirelessConfig* config);
+// Returns WIRELESS_OK on success, a WirelessError otherwise. Blocks until the file is sent.
+int wireless_transfer_send_file(WirelessTransfer* transfer, const char* source_path, const char* file_name, WirelessProgressCallback callback, const void* context);
+// Safe to call from any thread; aborts the send in progress
+void wireless_transfer_cancel(WirelessTransfer* transfer);
+void wireless_transfer_free(WirelessTransfer* transfer);
+
+// Receiving
+typedef struct WirelessReceiver WirelessReceiver;
+
+// Listens on port (0 picks a free one) and saves accepted files into dest_dir
+WirelessReceiver* wireless_receiver_start(uint16_t port, const char* dest_dir, const WirelessConfig* config,
+                                          WirelessRequestCallback on_request,
+                                          WirelessProgressCallback on_progress,
+                                          WirelessCompletionCallback on_complete,
+                                          WirelessPairingCallback on_pairing,
+                                          const void* context);
+uint16_t wireless_receiver_port(const WirelessReceiver* receiver);
+// Aborts every file being received; the listener keeps running
+void wireless_receiver_cancel_all(WirelessReceiver* receiver);
+// Closes the listener and all connections. No callbacks fire after this returns.
+void wireless_receiver_stop(WirelessReceiver* receiver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WirelessBridge_h */
@@ -0,0 +1,1041 @@
+#include "WirelessBridge.h"
+#include "WirelessCompression.hpp"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+
+// Largest slice handed to a single sendfile/splice call so cancellation stays responsive
+static const uint64_t IO_SLICE = 8ULL * 1024 * 1024;
+// Stripes are aligned to this so ranges line up with file system blocks
+static const uint64_t STRIPE_ALIGN = 1024 * 1024;
+// Headers are tiny; anything longer is a protocol error
+static const size_t MAX_HEADER = 1024;
+// How long a primary connection waits for its stripes to finish
+static const int STRIPE_WAIT_SECONDS = 60;
+// Smaller files aren't worth the extra connection compression needs
+static const uint64_t MIN_COMPRESS_SIZE = 256 * 1024;
+
+// Progress callback wrapper structure
+// Shared between all streams of one file, so it is guarded by a mutex
+struct WirelessBridgeCallbackData {
+    WirelessProgressCallback callback;
+    const void* context;
+    uint64_t total;
+    std::atomic<uint64_t> transferred{0};
+    std::mutex lock;
+    uint64_t lastReportedBytes = 0;
+    std::chrono::steady_clock::time_point lastReportTime = std::chrono::steady_clock::now();
+
+    WirelessBridgeCallbackData(WirelessProgressCallback cb, const void* ctx, uint64_t totalBytes)
+        : callback(cb), context(ctx), total(totalBytes) {}
+
+    void add(uint64_t bytes) {
+        uint64_t sent = transferred.fetch_add(bytes) + bytes;
+        if (!callback) return;
+
+        std::lock_guard<std::mutex> guard(lock);
+        // Throttle callbacks to reduce overhead
+        // Only report every 1MB or every 100ms, whichever comes first
+        auto now = std::chrono::steady_clock::now();
+        uint64_t bytesSinceLastReport = sent - lastReportedBytes;
+        auto timeSinceLastReport = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastReportTime).count();
+
+        const uint64_t MIN_BYTES_DELTA = 1024 * 1024; // 1 MB
+        const int64_t MIN_TIME_DELTA_MS = 100; // 100 ms
+
+        bool shouldReport = (sent >= total) ||
+                           (bytesSinceLastReport >= MIN_BYTES_DELTA) ||
+                           (timeSinceLastReport >= MIN_TIME_DELTA_MS);
+
+        if (shouldReport && sent > lastReportedBytes) {
+            callback(sent, total, context);
+            lastReportedBytes = sent;
+            lastReportTime = now;
+        }
+    }
+};
+
+// MARK: - Socket helpers
+
+static void configure_socket(int fd, const WirelessConfig& config) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+    // macOS: report EPIPE instead of raising SIGPIPE when the peer goes away
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    if (config.socket_buffer_size > 0) {
+        int size = config.socket_buffer_size;
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+}
+
+static int send_flags() {
+#ifdef MSG_NOSIGNAL
+    return MSG_NOSIGNAL;
+#else
+    return 0;
+#endif
+}
+
+static bool send_all(int fd, const void* data, size_t length) {
+    const char* p = (const char*)data;
+    while (length > 0) {
+        ssize_t n = send(fd, p, length, send_flags());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static bool send_string(int fd, const std::string& s) {
+    return send_all(fd, s.data(), s.size());
+}
+
+static bool recv_all(int fd, void* data, size_t length) {
+    char* p = (char*)data;
+    while (length > 0) {
+        ssize_t n = recv(fd, p, length, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static bool pread_full(int fd, void* data, size_t length, uint64_t offset) {
+    char* p = (char*)data;
+    while (length > 0) {
+        ssize_t n = pread(fd, p, length, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return true;
+}
+
+static bool pwrite_full(int fd, const void* data, size_t length, uint64_t offset) {
+    const char* p = (const char*)data;
+    while (length > 0) {
+        ssize_t n = pwrite(fd, p, length, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return true;
+}
+
+// Reads "::"-terminated fields one byte at a time so no body bytes are consumed.
+// The field count depends on the first field, which is passed to fields_for.
+template <typename FieldCount>
+static bool read_header(int fd, std::vector<std::string>& fields, FieldCount fields_for) {
+    fields.clear();
+    std::string current;
+    size_t consumed = 0;
+    size_t wanted = 0;
+
+    while (consumed < MAX_HEADER) {
+        char c;
+        ssize_t n = recv(fd, &c, 1, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        consumed++;
+        current.push_back(c);
+
+        size_t len = current.size();
+        if (len >= 2 && current[len - 2] == ':' && current[len - 1] == ':') {
+            current.resize(len - 2);
+            fields.push_back(current);
+            current.clear();
+            if (fields.size() == 1) {
+                wanted = fields_for(fields[0]);
+                if (wanted == 0) return false;
+            }
+            if (fields.size() == wanted) return true;
+        }
+    }
+    return false;
+}
+
+static int connect_to(const std::string& host, uint16_t port, const WirelessConfig& config) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* res = NULL;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &res) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        // Buffer sizes must be set before connect so the window scale is negotiated
+        configure_socket(fd, config);
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+// Streams [offset, offset + length) of file_fd to sock with the kernel doing the copy.
+static int send_range(int sock, int file_fd, uint64_t offset, uint64_t length,
+                      WirelessBridgeCallbackData& progress, const std::atomic<bool>& cancelled) {
+    while (length > 0) {
+        if (cancelled.load()) return WIRELESS_E_CANCELLED;
+        uint64_t slice = length < IO_SLICE ? length : IO_SLICE;
+        uint64_t sent = 0;
+
+#if defined(__linux__)
+        off_t off = (off_t)offset;
+        ssize_t n = sendfile(sock, file_fd, &off, (size_t)slice);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (n <= 0) return cancelled.load() ? WIRELESS_E_CANCELLED : WIRELESS_E_IO;
+        sent = (uint64_t)n;
+#elif defined(__APPLE__)
+        off_t len = (off_t)slice;
+        int rc = sendfile(file_fd, sock, (off_t)offset, &len, NULL, 0);
+        // On EINTR/EAGAIN len still holds the bytes that made it out
+        if (rc < 0 && errno != EINTR && errno != EAGAIN) {
+            return cancelled.load() ? WIRELESS_E_CANCELLED : WIRELESS_E_IO;
+        }
+        if (rc == 0 && len == 0) return WIRELESS_E_IO; // Unexpected EOF
+        sent = (uint64_t)len;
+#else
+        static thread_local std::vector<char> buffer(1024 * 1024);
+        size_t want = slice < buffer.size() ? (size_t)slice : buffer.size();
+        ssize_t r = pread(file_fd, buffer.data(), want, (off_t)offset);
+        if (r <= 0) return WIRELESS_E_IO;
+        if (!send_all(sock, buffer.data(), (size_t)r)) {
+            return cancelled.load() ? WIRELESS_E_CANCELLED : WIRELESS_E_IO;
+        }
+        sent = (uint64_t)r;
+#endif
+
+        offset += sent;
+        length -= sent;
+        progress.add(sent);
+    }
+    return WIRELESS_OK;
+}
+
+// Receives exactly length bytes from sock into file_fd at offset, stopping early on EOF.
+// Returns the number of bytes written.
+static uint64_t receive_range(int sock, int file_fd, uint64_t offset, uint64_t length,
+                              WirelessBridgeCallbackData& progress) {
+    uint64_t received = 0;
+
+#if defined(__linux__)
+    // splice moves socket pages into the page cache without a user space copy
+    int pipefd[2];
+    if (pipe(pipefd) == 0) {
+        fcntl(pipefd[1], F_SETPIPE_SZ, 1024 * 1024);
+        bool ok = true;
+        while (ok && received < length) {
+            uint64_t remaining = length - received;
+            size_t want = remaining < IO_SLICE ? (size_t)remaining : (size_t)IO_SLICE;
+            ssize_t in = splice(sock, NULL, pipefd[1], NULL, want, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (in < 0 && errno == EINTR) continue;
+            if (in < 0 && errno == EINVAL) break; // Not spliceable here, fall back to recv
+            if (in <= 0) { ok = false; break; }
+
+            ssize_t left = in;
+            while (left > 0) {
+                loff_t off = (loff_t)(offset + received);
+                ssize_t out = splice(pipefd[0], NULL, file_fd, &off, (size_t)left, SPLICE_F_MOVE);
+                if (out < 0 && errno == EINTR) continue;
+                if (out <= 0) { ok = false; break; }
+                left -= out;
+                received += (uint64_t)out;
+                progress.add((uint64_t)out);
+            }
+        }
+        close(pipefd[0]);
+        close(pipefd[1]);
+        if (!ok || received == length) return received;
+    }
+#endif
+
+    static thread_local std::vector<char> buffer(1024 * 1024);
+    while (received < length) {
+        uint64_t remaining = length - received;
+        size_t want = remaining < buffer.size() ? (size_t)remaining : buffer.size();
+        ssize_t n = recv(sock, buffer.data(), want, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        if (!pwrite_full(file_fd, buffer.data(), (size_t)n, offset + received)) {
+            return received;
+        }
+        received += (uint64_t)n;
+        progress.add((uint64_t)n);
+    }
+    return received;
+}
+
+struct EncodedFrame {
+    std::vector<unsigned char> bytes;
+    size_t rawLength = 0;
+    bool ok = false;
+};
+
+// Compressed counterpart of send_range. Chunks are read and encoded on the worker
+// pool while this thread keeps the socket busy with the ones already done.
+static int send_frames(int sock, int file_fd, uint64_t offset, uint64_t length, WirelessCodec codec,
+                       WirelessBridgeCallbackData& progress, const std::atomic<bool>& cancelled) {
+    WirelessWorkerPool& pool = WirelessWorkerPool::shared();
+    const size_t window = pool.size() * 2;
+
+    std::deque<std::future<EncodedFrame>> inflight;
+    uint64_t next = offset;
+    uint64_t end = offset + length;
+    int result = WIRELESS_OK;
+
+    while (next < end || !inflight.empty()) {
+        if (cancelled.load()) {
+            result = WIRELESS_E_CANCELLED;
+            break;
+        }
+
+        if (next < end && inflight.size() < window) {
+            size_t chunk = (end - next) < WIRELESS_FRAME_SIZE ? (size_t)(end - next) : WIRELESS_FRAME_SIZE;
+            uint64_t at = next;
+            inflight.push_back(pool.submit([file_fd, at, chunk, codec]() {
+                static thread_local std::vector<unsigned char> raw;
+                EncodedFrame frame;
+                raw.resize(chunk);
+                if (pread_full(file_fd, raw.data(), chunk, at)) {
+                    wireless_encode_frame(codec, raw.data(), chunk, frame.bytes);
+                    frame.rawLength = chunk;
+                    frame.ok = true;
+                }
+                return frame;
+            }));
+            next += chunk;
+            continue;
+        }
+
+        EncodedFrame frame = inflight.front().get();
+        inflight.pop_front();
+        if (!frame.ok) {
+            result = WIRELESS_E_IO;
+            break;
+        }
+        if (!send_all(sock, frame.bytes.data(), frame.bytes.size())) {
+            result = cancelled.load() ? WIRELESS_E_CANCELLED : WIRELESS_E_IO;
+            break;
+        }
+        progress.add(frame.rawLength);
+    }
+
+    // Encoders still read file_fd, which the caller closes once we return
+    for (auto& pending : inflight) {
+        pending.wait();
+    }
+    return result;
+}
+
+// Compressed counterpart of receive_range. Frames are decoded and written on the
+// worker pool; each one knows its offset so they can land in any order.
+static bool receive_frames(int sock, int file_fd, uint64_t offset, uint64_t length,
+                           WirelessBridgeCallbackData& progress) {
+    WirelessWorkerPool& pool = WirelessWorkerPool::shared();
+    const size_t window = pool.size() * 2;
+
+    std::deque<std::future<bool>> inflight;
+    uint64_t pos = offset;
+    uint64_t end = offset + length;
+    bool ok = true;
+
+    while (ok && pos < end) {
+        unsigned char header[WIRELESS_FRAME_HEADER];
+        WirelessCodec codec;
+        uint32_t rawLength = 0;
+        uint32_t storedLength = 0;
+        if (!recv_all(sock, header, sizeof(header)) ||
+            !wireless_parse_frame_header(header, codec, rawLength, storedLength) ||
+            rawLength > end - pos) {
+            ok = false;
+            break;
+        }
+
+        auto payload = std::make_shared<std::vector<unsigned char>>(storedLength);
+        if (!recv_all(sock, payload->data(), storedLength)) {
+            ok = false;
+            break;
+        }
+
+        uint64_t at = pos;
+        pos += rawLength;
+        inflight.push_back(pool.submit([file_fd, at, codec, rawLength, payload, &progress]() {
+            static thread_local std::vector<unsigned char> out;
+            if (!wireless_decode_frame(codec, payload->data(), payload->size(), rawLength, out) ||
+                !pwrite_full(file_fd, out.data(), rawLength, at)) {
+                return false;
+            }
+            progress.add(rawLength);
+            return true;
+        }));
+
+        while (inflight.size() >= window) {
+            ok = inflight.front().get() && ok;
+            inflight.pop_front();
+        }
+    }
+
+    while (!inflight.empty()) {
+        ok = inflight.front().get() && ok;
+        inflight.pop_front();
+    }
+    return ok && pos == end;
+}
+
+static bool parse_u64(const std::string& s, uint64_t& out) {
+    if (s.empty()) return false;
+    char* end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(s.c_str(), &end, 10);
+    if (errno != 0 || end == NULL || *end != '\0') return false;
+    out = (uint64_t)v;
+    return true;
+}
+
+// MARK: - Configuration
+
+WirelessConfig wireless_default_config() {
+    WirelessConfig config;
+    config.max_streams = 4;
+    config.stripe_threshold = 64ULL * 1024 * 1024; // 64 MB
+    config.socket_buffer_size = 4 * 1024 * 1024;   // 4 MB
+    config.compression = WIRELESS_COMPRESSION_AUTO;
+    return config;
+}
+
+static WirelessConfig sanitize_config(const WirelessConfig* config) {
+    WirelessConfig c = config ? *config : wireless_default_config();
+    if (c.max_streams < 1) c.max_streams = 1;
+    if (c.max_streams > 16) c.max_streams = 16;
+    if (c.socket_buffer_size < 0) c.socket_buffer_size = 0;
+    return c;
+}
+
+// MARK: - Sender
+
+struct WirelessTransfer {
+    std::string host;
+    uint16_t port;
+    WirelessConfig config;
+    std::atomic<bool> cancelled{false};
+
+    // Sockets of the send in progress, so cancel can unblock them
+    std::mutex socketsLock;
+    std::set<int> sockets;
+
+    void track(int fd) {
+        std::lock_guard<std::mutex> guard(socketsLock);
+        sockets.insert(fd);
+        if (cancelled.load()) shutdown(fd, SHUT_RDWR);
+    }
+
+    void untrack(int fd) {
+        std::lock_guard<std::mutex> guard(socketsLock);
+        sockets.erase(fd);
+    }
+
+    // Unblocks every stream of the current file without marking it user-cancelled
+    void abort() {
+        std::lock_guard<std::mutex> guard(socketsLock);
+        for (int fd : sockets) {
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+};
+
+WirelessTransfer* wireless_transfer_create(const char* host, uint16_t port, const WirelessConfig* config) {
+    if (!host || port == 0) {
+        return NULL;
+    }
+    WirelessTransfer* transfer = new WirelessTransfer();
+    transfer->host = host;
+    transfer->port = port;
+    transfer->config = sanitize_config(config);
+    return transfer;
+}
+
+void wireless_transfer_cancel(WirelessTransfer* transfer) {
+    if (!transfer) return;
+    transfer->cancelled.store(true);
+    transfer->abort();
+}
+
+void wireless_transfer_free(WirelessTransfer* transfer) {
+    delete transfer;
+}
+
+// What a native receiver told us in its ACCEPT reply
+struct PeerOffer {
+    int streams = 1;
+    std::string token;           // Empty for legacy receivers
+    std::string codecs = "none";
+};
+
+// Reads the receiver's answer. Legacy receivers send exactly "ACCEPT::" and then wait
+// for the body, so we only keep reading when the reply announces a native peer.
+static int read_accept(int fd, PeerOffer& offer) {
+    std::vector<std::string> fields;
+    // ACCEPT, DECLINE (macOS) or REJECT (Android)
+    bool ok = read_header(fd, fields, [](const std::string&) -> size_t { return 1; });
+    if (!ok || fields.empty()) return WIRELESS_E_PROTOCOL;
+    if (fields[0] != "ACCEPT") return WIRELESS_E_DECLINED;
+
+    // A native receiver follows "ACCEPT::" with "NATIVE::..." in the same segment.
+    // Peek so a legacy receiver (which sends nothing more) never blocks us.
+    char peek[8] = {0};
+    ssize_t n = recv(fd, peek, 8, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 8 && memcmp(peek, "NATIVE::", 8) == 0) {
+        ok = read_header(fd, fields, [](const std::string& first) -> size_t {
+            return first == "NATIVE" ? 4 : 0;
+        });
+        uint64_t max = 0;
+        if (ok && parse_u64(fields[1], max) && max >= 1) {
+            offer.streams = (int)max;
+            offer.token = fields[2];
+            offer.codecs = fields[3];
+        }
+    }
+    return WIRELESS_OK;
+}
+
+int wireless_transfer_send_file(WirelessTransfer* transfer, const char* source_path, const char* file_name,
+                                WirelessProgressCallback callback, const void* context) {
+    if (!transfer || !source_path || !file_name) {
+        return WIRELESS_E_INVALID_ARG;
+    }
+    transfer->cancelled.store(false);
+
+    int file_fd = open(source_path, O_RDONLY);
+    if (file_fd < 0) {
+        return WIRELESS_E_IO;
+    }
+    struct stat st;
+    if (fstat(file_fd, &st) != 0) {
+        close(file_fd);
+        return WIRELESS_E_IO;
+    }
+    uint64_t size = (uint64_t)st.st_size;
+
+    const WirelessConfig& config = transfer->config;
+    int primary = connect_to(transfer->host, transfer->port, config);
+    if (primary < 0) {
+        close(file_fd);
+        return WIRELESS_E_CONNECT;
+    }
+    transfer->track(primary);
+
+    auto finish = [&](int result) {
+        transfer->untrack(primary);
+        close(primary);
+        close(file_fd);
+        return result;
+    };
+
+    std::string header = std::string(file_name) + "::" + std::to_string(size) + "::";
+    if (!send_string(primary, header)) {
+        return finish(transfer->cancelled.load() ? WIRELESS_E_CANCELLED : WIRELESS_E_IO);
+    }
+
+    PeerOffer offer;
+    int ret = read_accept(primary, offer);
+    if (ret != WIRELESS_OK) {
+        return finish(transfer->cancelled.load() ? WIRELESS_E_CANCELLED : ret);
+    }
+    const bool native = !offer.token.empty();
+    const std::string& token = offer.token;
+
+    int streams = 1;
+    if (native && size >= config.stripe_threshold) {
+        streams = offer.streams < config.max_streams ? offer.streams : config.max_streams;
+    }
+
+    // Compressed ranges travel over side connections so the receiver knows to expect
+    // frames; the primary then carries nothing and only closes when we are done.
+    WirelessCodec codec = WIRELESS_CODEC_STORED;
+    if (native && config.compression == WIRELESS_COMPRESSION_AUTO && size >= MIN_COMPRESS_SIZE) {
+        codec = wireless_pick_codec(offer.codecs);
+        if (codec != WIRELESS_CODEC_STORED && !wireless_file_looks_compressible(file_fd, size)) {
+            codec = WIRELESS_CODEC_STORED;
+        }
+    }
+    const bool compress = codec != WIRELESS_CODEC_STORED;
+
+    WirelessBridgeCallbackData progress(callback, context, size);
+
+    // Split into aligned stripes; the primary connection carries the first raw one
+    uint64_t stripe = size;
+    if (streams > 1) {
+        stripe = (size + (uint64_t)streams - 1) / (uint64_t)streams;
+        stripe = (stripe + STRIPE_ALIGN - 1) / STRIPE_ALIGN * STRIPE_ALIGN;
+    }
+
+    std::vector<std::thread> workers;
+    std::atomic<int> workerResult{WIRELESS_OK};
+    for (int i = compress ? 0 : 1; i < streams; i++) {
+        uint64_t offset = stripe * (uint64_t)i;
+        if (offset >= size) break;
+        uint64_t length = (size - offset) < stripe ? (size - offset) : stripe;
+
+        workers.emplace_back([transfer, &config, &token, &progress, &workerResult, file_fd, offset, length,
+                              codec, compress]() {
+            int fd = connect_to(transfer->host, transfer->port, config);
+            if (fd < 0) {
+                workerResult.store(WIRELESS_E_CONNECT);
+                return;
+            }
+            transfer->track(fd);
+            int r = WIRELESS_E_IO;
+            std::string stripeHeader = std::string(compress ? "ZSTRIPE::" : "STRIPE::") + token + "::" +
+                                       std::to_string(offset) + "::" + std::to_string(length) + "::";
+            if (send_string(fd, stripeHeader)) {
+                r = compress ? send_frames(fd, file_fd, offset, length, codec, progress, transfer->cancelled)
+                             : send_range(fd, file_fd, offset, length, progress, transfer->cancelled);
+            }
+            shutdown(fd, SHUT_WR);
+            transfer->untrack(fd);
+            close(fd);
+            if (r != WIRELESS_OK) {
+                // One broken stream fails the whole file, so stop the others too
+                workerResult.store(r);
+                transfer->abort();
+            }
+        });
+    }
+
+    uint64_t primaryLength = compress ? 0 : (stripe < size ? stripe : size);
+    ret = send_range(primary, file_fd, 0, primaryLength, progress, transfer->cancelled);
+    if (ret != WIRELESS_OK) {
+        transfer->abort();
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (ret == WIRELESS_OK) {
+        ret = workerResult.load();
+    }
+    if (ret != WIRELESS_OK) {
+        return finish(ret);
+    }
+
+    shutdown(primary, SHUT_WR);
+    return finish(WIRELESS_OK);
+}
+
+// MARK: - Receiver
+
+// One file being received, possibly over several connections
+struct IncomingFile {
+    std::string path;
+    int fd = -1;
+    uint64_t size = 0;
+    WirelessBridgeCallbackData progress;
+
+    std::mutex lock;
+    std::condition_variable changed;
+    uint64_t primaryBytes = 0;
+    bool primaryDone = false;
+    uint64_t stripeBytes = 0;
+    int activeStripes = 0;
+    bool failed = false;
+    bool finished = false; // Set by the primary once it stops accepting stripes
+
+    IncomingFile(WirelessProgressCallback cb, const void* ctx, uint64_t total)
+        : size(total), progress(cb, ctx, total) {}
+
+    bool complete() const {
+        return primaryDone && activeStripes == 0 && primaryBytes + stripeBytes >= size;
+    }
+};
+
+struct WirelessReceiver {
+    int listenFd = -1;
+    uint16_t port = 0;
+    std::string destDir;
+    WirelessConfig config;
+    WirelessRequestCallback onRequest = NULL;
+    WirelessProgressCallback onProgress = NULL;
+    WirelessCompletionCallback onComplete = NULL;
+    WirelessPairingCallback onPairing = NULL;
+    const void* context = NULL;
+
+    std::thread acceptThread;
+    std::atomic<bool> stopping{false};
+
+    std::mutex lock;
+    std::condition_variable idle;
+    std::set<int> connections;
+    std::map<std::string, std::shared_ptr<IncomingFile>> pending;
+};
+
+static std::string make_token() {
+    static std::mutex m;
+    static std::mt19937_64 rng(std::random_device{}());
+    std::lock_guard<std::mutex> guard(m);
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)rng());
+    return buf;
+}
+
+// Creates a unique file in dir for name, adding _1, _2... like NetworkManager does
+static int create_destination(const std::string& dir, const std::string& rawName, std::string& path) {
+    std::string name = rawName;
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+    if (name.empty() || name == "." || name == "..") name = "received_file";
+
+    std::string stem = name;
+    std::string ext;
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) {
+        stem = name.substr(0, dot);
+        ext = name.substr(dot);
+    }
+
+    std::string base = dir;
+    if (!base.empty() && base.back() != '/') base += "/";
+
+    for (int counter = 0; counter < 10000; counter++) {
+        path = base + (counter == 0 ? name : stem + "_" + std::to_string(counter) + ext);
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0) return fd;
+        if (errno != EEXIST) return -1;
+    }
+    return -1;
+}
+
+static void handle_primary(WirelessReceiver* receiver, int sock, const std::string& name, uint64_t size) {
+    if (receiver->onRequest && !receiver->onRequest(name.c_str(), size, receiver->context)) {
+        send_string(sock, "DECLINE::");
+        return;
+    }
+
+    auto file = std::make_shared<IncomingFile>(receiver->onProgress, receiver->context, size);
+    file->fd = create_destination(receiver->destDir, name, file->path);
+    if (file->fd < 0) {
+        send_string(sock, "DECLINE::");
+        if (receiver->onComplete) receiver->onComplete(name.c_str(), NULL, WIRELESS_E_IO, receiver->context);
+        return;
+    }
+    // Reserve the full size up front so stripes can land anywhere
+    if (size > 0 && ftruncate(file->fd, (off_t)size) != 0) {
+        // Not fatal, pwrite extends the file as needed
+    }
+
+    std::string token = make_token();
+    {
+        std::lock_guard<std::mutex> guard(receiver->lock);
+        receiver->pending[token] = file;
+    }
+    std::string codecs = receiver->config.compression == WIRELESS_COMPRESSION_AUTO ? wireless_supported_codecs() : "none";
+    // Must go out in one write so a native sender sees it together with ACCEPT
+    std::string reply = "ACCEPT::NATIVE::" + std::to_string(receiver->config.max_streams) + "::" + token + "::" +
+                        codecs + "::";
+
+    bool ok = send_string(sock, reply);
+    uint64_t got = ok ? receive_range(sock, file->fd, 0, size, file->progress) : 0;
+
+    bool success = false;
+    {
+        std::unique_lock<std::mutex> guard(file->lock);
+        file->primaryBytes = got;
+        file->primaryDone = true;
+        file->changed.notify_all();
+        // A native sender closes the primary after the first raw stripe; wait for the rest
+        file->changed.wait_for(guard, std::chrono::seconds(STRIPE_WAIT_SECONDS), [&]() {
+            return file->failed || file->complete() || receiver->stopping.load();
+        });
+        success = ok && !file->failed && file->complete();
+        // Late stripes must not write into a file we are about to close
+        file->finished = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(receiver->lock);
+        receiver->pending.erase(token);
+    }
+
+    {
+        std::unique_lock<std::mutex> guard(file->lock);
+        file->changed.wait(guard, [&]() { return file->activeStripes == 0; });
+    }
+
+    close(file->fd);
+    file->fd = -1;
+    if (!success) {
+        unlink(file->path.c_str());
+    }
+    if (receiver->onComplete) {
+        receiver->onComplete(name.c_str(), success ? file->path.c_str() : NULL, success ? WIRELESS_OK : WIRELESS_E_IO,
+                             receiver->context);
+    }
+}
+
+static void handle_stripe(WirelessReceiver* receiver, int sock, const std::string& token,
+                          uint64_t offset, uint64_t length, bool compressed) {
+    std::shared_ptr<IncomingFile> file;
+    {
+        std::lock_guard<std::mutex> guard(receiver->lock);
+        auto it = receiver->pending.find(token);
+        if (it != receiver->pending.end()) file = it->second;
+    }
+    if (!file) return;
+
+    {
+        std::lock_guard<std::mutex> guard(file->lock);
+        if (file->failed || file->finished || offset > file->size || length > file->size - offset) {
+            return;
+        }
+        file->activeStripes++;
+    }
+
+    uint64_t got = 0;
+    if (compressed) {
+        got = receive_frames(sock, file->fd, offset, length, file->progress) ? length : 0;
+    } else {
+        got = receive_range(sock, file->fd, offset, length, file->progress);
+    }
+
+    std::lock_guard<std::mutex> guard(file->lock);
+    file->activeStripes--;
+    if (got == length) {
+        file->stripeBytes += got;
+    } else {
+        file->failed = true;
+    }
+    file->changed.notify_all();
+}
+
+static std::string peer_host(int sock) {
+    struct sockaddr_storage peer;
+    socklen_t peerLen = sizeof(peer);
+    char buf[INET6_ADDRSTRLEN] = "";
+    if (getpeername(sock, (struct sockaddr*)&peer, &peerLen) != 0) return "";
+
+    if (peer.ss_family == AF_INET6) {
+        struct sockaddr_in6* addr = (struct sockaddr_in6*)&peer;
+        if (IN6_IS_ADDR_V4MAPPED(&addr->sin6_addr)) {
+            // IPv4 peers on the dual-stack listener; report them the way they advertise
+            inet_ntop(AF_INET, &addr->sin6_addr.s6_addr[12], buf, sizeof(buf));
+        } else {
+            inet_ntop(AF_INET6, &addr->sin6_addr, buf, sizeof(buf));
+        }
+    } else if (peer.ss_family == AF_INET) {
+        inet_ntop(AF_INET, &((struct sockaddr_in*)&peer)->sin_addr, buf, sizeof(buf));
+    }
+    return buf;
+}
+
+static void handle_pairing(WirelessReceiver* receiver, int sock, const std::string& message, const std::string& value) {
+    std::string host = peer_host(sock);
+    bool accepted = receiver->onPairing &&
+                    receiver->onPairing(message.c_str(), value.c_str(), host.c_str(), receiver->context);
+    if (message != "PAIR_VERIFY") return;
+
+    // macOS peers append their port; read it so closing doesn't reset the reply
+    char rest[64];
+    while (recv(sock, rest, sizeof(rest), MSG_DONTWAIT) > 0) {}
+    send_string(sock, accepted ? "PAIR_ACK::" : "PAIR_FAIL::");
+}
+
+static void handle_connection(WirelessReceiver* receiver, int sock) {
+    std::vector<std::string> fields;
+    bool ok = read_header(sock, fields, [](const std::string& first) -> size_t {
+        if (first == "STRIPE" || first == "ZSTRIPE") return 4;
+        // FILENAME::SIZE::, PAIR_REQUEST::PORT:: and PAIR_VERIFY::CODE::
+        return 2;
+    });
+
+    if (ok) {
+        uint64_t a = 0, b = 0;
+        if (fields[0] == "STRIPE" || fields[0] == "ZSTRIPE") {
+            if (parse_u64(fields[2], a) && parse_u64(fields[3], b)) {
+                handle_stripe(receiver, sock, fields[1], a, b, fields[0] == "ZSTRIPE");
+            }
+        } else if (fields[0] == "PAIR_REQUEST" || fields[0] == "PAIR_VERIFY") {
+            handle_pairing(receiver, sock, fields[0], fields[1]);
+        } else if (parse_u64(fields[1], a)) {
+            handle_primary(receiver, sock, fields[0], a);
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(receiver->lock);
+    receiver->connections.erase(sock);
+    close(sock);
+    receiver->idle.notify_all();
+}
+
+static void accept_loop(WirelessReceiver* receiver) {
+    while (!receiver->stopping.load()) {
+        int sock = accept(receiver->listenFd, NULL, NULL);
+        if (sock < 0) {
+            if (errno == EINTR) continue;
+            break; // Listener closed
+        }
+        configure_socket(sock, receiver->config);
+
+        std::lock_guard<std::mutex> guard(receiver->lock);
+        if (receiver->stopping.load()) {
+            close(sock);
+            break;
+        }
+        receiver->connections.insert(sock);
+        std::thread(handle_connection, receiver, sock).detach();
+    }
+}
+
+WirelessReceiver* wireless_receiver_start(uint16_t port, const char* dest_dir, const WirelessConfig* config,
+                                          WirelessRequestCallback on_request,
+                                          WirelessProgressCallback on_progress,
+                                          WirelessCompletionCallback on_complete,
+                                          WirelessPairingCallback on_pairing,
+                                          const void* context) {
+    if (!dest_dir) {
+        return NULL;
+    }
+
+    WirelessConfig c = sanitize_config(config);
+
+    int fd = socket(AF_INET6, SOCK_STREAM, 0);
+    bool v6 = fd >= 0;
+    if (!v6) fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return NULL;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // Accepted sockets inherit the receive buffer from the listener
+    configure_socket(fd, c);
+
+    int bound;
+    if (v6) {
+        int zero = 0;
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+        struct sockaddr_in6 addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr = in6addr_any;
+        addr.sin6_port = htons(port);
+        bound = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    } else {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        bound = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    if (bound != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    struct sockaddr_storage local;
+    socklen_t localLen = sizeof(local);
+    getsockname(fd, (struct sockaddr*)&local, &localLen);
+
+    WirelessReceiver* receiver = new WirelessReceiver();
+    receiver->listenFd = fd;
+    receiver->port = v6 ? ntohs(((struct sockaddr_in6*)&local)->sin6_port)
+                        : ntohs(((struct sockaddr_in*)&local)->sin_port);
+    receiver->destDir = dest_dir;
+    receiver->config = c;
+    receiver->onRequest = on_request;
+    receiver->onProgress = on_progress;
+    receiver->onComplete = on_complete;
+    receiver->onPairing = on_pairing;
+    receiver->context = context;
+    receiver->acceptThread = std::thread(accept_loop, receiver);
+    return receiver;
+}
+
+uint16_t wireless_receiver_port(const WirelessReceiver* receiver) {
+    return receiver ? receiver->port : 0;
+}
+
+void wireless_receiver_cancel_all(WirelessReceiver* receiver) {
+    if (!receiver) return;
+
+    std::lock_guard<std::mutex> guard(receiver->lock);
+    // Each connection's thread sees the shutdown and reports its file as failed
+    for (int sock : receiver->connections) {
+        shutdown(sock, SHUT_RDWR);
+    }
+    for (auto& entry : receiver->pending) {
+        std::lock_guard<std::mutex> fileGuard(entry.second->lock);
+        entry.second->failed = true;
+        entry.second->changed.notify_all();
+    }
+}
+
+void wireless_receiver_stop(WirelessReceiver* receiver) {
+    if (!receiver) return;
+
+    receiver->stopping.store(true);
+    shutdown(receiver->listenFd, SHUT_RDWR);
+    close(receiver->listenFd);
+    if (receiver->acceptThread.joinable()) {
+        receiver->acceptThread.join();
+    }
+
+    std::unique_lock<std::mutex> guard(receiver->lock);
+    for (int sock : receiver->connections) {
+        shutdown(sock, SHUT_RDWR);
+    }
+    for (auto& entry : receiver->pending) {
+        std::lock_guard<std::mutex> fileGuard(entry.second->lock);
+        entry.second->changed.notify_all();
+    }
+    receiver->idle.wait(guard, [&]() { return receiver->connections.empty(); });
+    guard.unlock();
+
+    delete receiver;
+}
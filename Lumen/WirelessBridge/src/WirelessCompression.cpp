@@ -0,0 +1,245 @@
+#include "WirelessCompression.hpp"
+
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+
+// Codecs come from Homebrew (brew install lz4 zstd). The build defines
+// WIRELESS_WITH_ZSTD / WIRELESS_WITH_LZ4 when it also links the library, so a
+// header alone never pulls in a symbol. Builds without them still work; they
+// just advertise fewer codecs and send stored frames.
+#if defined(WIRELESS_WITH_ZSTD) && __has_include(<zstd.h>)
+#include <zstd.h>
+#define WIRELESS_HAVE_ZSTD 1
+#endif
+#if defined(WIRELESS_WITH_LZ4) && __has_include(<lz4.h>)
+#include <lz4.h>
+#define WIRELESS_HAVE_LZ4 1
+#endif
+
+// Above this many bits per byte a chunk is treated as already compressed
+static const double INCOMPRESSIBLE_ENTROPY = 7.5;
+// zstd level 1 compresses well past Wi-Fi speeds on a single core
+static const int ZSTD_LEVEL = 1;
+// Compressed frames must save at least 1/16 or we send the chunk stored
+static const size_t MIN_SAVINGS_SHIFT = 4;
+
+std::string wireless_supported_codecs() {
+    std::string codecs;
+#ifdef WIRELESS_HAVE_ZSTD
+    codecs += "zstd";
+#endif
+#ifdef WIRELESS_HAVE_LZ4
+    if (!codecs.empty()) codecs += ",";
+    codecs += "lz4";
+#endif
+    return codecs.empty() ? "none" : codecs;
+}
+
+static bool list_contains(const std::string& list, const char* name) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        if (list.compare(start, end - start, name) == 0) return true;
+        start = end + 1;
+    }
+    return false;
+}
+
+WirelessCodec wireless_pick_codec(const std::string& peer_codecs) {
+#ifdef WIRELESS_HAVE_ZSTD
+    if (list_contains(peer_codecs, "zstd")) return WIRELESS_CODEC_ZSTD;
+#endif
+#ifdef WIRELESS_HAVE_LZ4
+    if (list_contains(peer_codecs, "lz4")) return WIRELESS_CODEC_LZ4;
+#endif
+    (void)peer_codecs;
+    (void)list_contains;
+    return WIRELESS_CODEC_STORED;
+}
+
+double wireless_sample_entropy(const unsigned char* data, size_t length) {
+    if (length == 0) return 0.0;
+
+    // ~16K samples is plenty to tell text from JPEG and costs microseconds
+    size_t stride = length / 16384;
+    if (stride == 0) stride = 1;
+
+    uint32_t histogram[256] = {0};
+    size_t samples = 0;
+    for (size_t i = 0; i < length; i += stride) {
+        histogram[data[i]]++;
+        samples++;
+    }
+
+    double entropy = 0.0;
+    for (int i = 0; i < 256; i++) {
+        if (histogram[i] == 0) continue;
+        double p = (double)histogram[i] / (double)samples;
+        entropy -= p * log2(p);
+    }
+    return entropy;
+}
+
+bool wireless_file_looks_compressible(int fd, uint64_t size) {
+    // Start, middle and end: catches containers with a compressible header and media payload
+    const size_t SAMPLE = 64 * 1024;
+    uint64_t offsets[3] = { 0, size / 2, size > SAMPLE ? size - SAMPLE : 0 };
+
+    std::vector<unsigned char> buffer(SAMPLE);
+    int compressible = 0;
+    for (uint64_t offset : offsets) {
+        ssize_t n = pread(fd, buffer.data(), SAMPLE, (off_t)offset);
+        if (n <= 0) return false;
+        if (wireless_sample_entropy(buffer.data(), (size_t)n) < INCOMPRESSIBLE_ENTROPY) {
+            compressible++;
+        }
+    }
+    // Any compressible region is worth it: per-chunk checks still skip the rest
+    return compressible > 0;
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)((v >> 8) & 0xFF);
+    p[2] = (unsigned char)((v >> 16) & 0xFF);
+    p[3] = (unsigned char)((v >> 24) & 0xFF);
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_header(unsigned char* p, WirelessCodec codec, uint32_t raw_length, uint32_t stored_length) {
+    p[0] = (unsigned char)codec;
+    p[1] = p[2] = p[3] = 0;
+    put_u32(p + 4, raw_length);
+    put_u32(p + 8, stored_length);
+}
+
+static void store_frame(const unsigned char* raw, size_t raw_length, std::vector<unsigned char>& frame) {
+    frame.resize(WIRELESS_FRAME_HEADER + raw_length);
+    write_header(frame.data(), WIRELESS_CODEC_STORED, (uint32_t)raw_length, (uint32_t)raw_length);
+    memcpy(frame.data() + WIRELESS_FRAME_HEADER, raw, raw_length);
+}
+
+void wireless_encode_frame(WirelessCodec codec, const unsigned char* raw, size_t raw_length,
+                           std::vector<unsigned char>& frame) {
+    if (codec == WIRELESS_CODEC_STORED || raw_length == 0 ||
+        wireless_sample_entropy(raw, raw_length) >= INCOMPRESSIBLE_ENTROPY) {
+        store_frame(raw, raw_length, frame);
+        return;
+    }
+
+    size_t stored = 0;
+    switch (codec) {
+#ifdef WIRELESS_HAVE_ZSTD
+        case WIRELESS_CODEC_ZSTD: {
+            size_t bound = ZSTD_compressBound(raw_length);
+            frame.resize(WIRELESS_FRAME_HEADER + bound);
+            size_t r = ZSTD_compress(frame.data() + WIRELESS_FRAME_HEADER, bound, raw, raw_length, ZSTD_LEVEL);
+            if (!ZSTD_isError(r)) stored = r;
+            break;
+        }
+#endif
+#ifdef WIRELESS_HAVE_LZ4
+        case WIRELESS_CODEC_LZ4: {
+            int bound = LZ4_compressBound((int)raw_length);
+            frame.resize(WIRELESS_FRAME_HEADER + (size_t)bound);
+            int r = LZ4_compress_default((const char*)raw, (char*)frame.data() + WIRELESS_FRAME_HEADER,
+                                         (int)raw_length, bound);
+            if (r > 0) stored = (size_t)r;
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+
+    if (stored == 0 || stored > raw_length - (raw_length >> MIN_SAVINGS_SHIFT)) {
+        store_frame(raw, raw_length, frame);
+        return;
+    }
+    frame.resize(WIRELESS_FRAME_HEADER + stored);
+    write_header(frame.data(), codec, (uint32_t)raw_length, (uint32_t)stored);
+}
+
+bool wireless_parse_frame_header(const unsigned char* header, WirelessCodec& codec,
+                                 uint32_t& raw_length, uint32_t& stored_length) {
+    if (header[0] > WIRELESS_CODEC_ZSTD) return false;
+    codec = (WirelessCodec)header[0];
+    raw_length = get_u32(header + 4);
+    stored_length = get_u32(header + 8);
+    if (raw_length == 0 || raw_length > WIRELESS_FRAME_SIZE) return false;
+    if (codec == WIRELESS_CODEC_STORED && stored_length != raw_length) return false;
+    // Never trust a payload larger than the worst case of any codec
+    return stored_length <= raw_length + raw_length / 128 + 1024;
+}
+
+bool wireless_decode_frame(WirelessCodec codec, const unsigned char* payload, size_t stored_length,
+                           uint32_t raw_length, std::vector<unsigned char>& out) {
+    out.resize(raw_length);
+    switch (codec) {
+        case WIRELESS_CODEC_STORED:
+            if (stored_length != raw_length) return false;
+            memcpy(out.data(), payload, raw_length);
+            return true;
+#ifdef WIRELESS_HAVE_ZSTD
+        case WIRELESS_CODEC_ZSTD: {
+            size_t r = ZSTD_decompress(out.data(), raw_length, payload, stored_length);
+            return !ZSTD_isError(r) && r == raw_length;
+        }
+#endif
+#ifdef WIRELESS_HAVE_LZ4
+        case WIRELESS_CODEC_LZ4: {
+            int r = LZ4_decompress_safe((const char*)payload, (char*)out.data(), (int)stored_length, (int)raw_length);
+            return r == (int)raw_length;
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+// MARK: - Worker pool
+
+WirelessWorkerPool& WirelessWorkerPool::shared() {
+    // Leave a core for the socket threads
+    static WirelessWorkerPool pool([]() {
+        unsigned n = std::thread::hardware_concurrency();
+        return n > 2 ? (size_t)(n - 1) : (size_t)2;
+    }());
+    return pool;
+}
+
+WirelessWorkerPool::WirelessWorkerPool(size_t threads) {
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&WirelessWorkerPool::run, this);
+    }
+}
+
+WirelessWorkerPool::~WirelessWorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WirelessWorkerPool::run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            available.wait(guard, [&]() { return stopping || !queue.empty(); });
+            if (stopping && queue.empty()) return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef WirelessCompression_hpp
+#define WirelessCompression_hpp
+
+// Internal to WirelessBridge: chunk codecs, entropy sampling and the worker pool
+// that keeps compression off the socket threads.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// Codec ids as they appear on the wire in each frame header
+enum WirelessCodec : uint8_t {
+    WIRELESS_CODEC_STORED = 0,
+    WIRELESS_CODEC_LZ4 = 1,
+    WIRELESS_CODEC_ZSTD = 2
+};
+
+// Raw bytes per compressed frame
+static const size_t WIRELESS_FRAME_SIZE = 1024 * 1024;
+// codec (1) + reserved (3) + raw length (4) + stored length (4), little-endian
+static const size_t WIRELESS_FRAME_HEADER = 12;
+
+// Comma separated list of codecs this build can decode, e.g. "zstd,lz4", or "none"
+std::string wireless_supported_codecs();
+// Best codec present in both lists, WIRELESS_CODEC_STORED if there is none
+WirelessCodec wireless_pick_codec(const std::string& peer_codecs);
+
+// Estimated Shannon entropy in bits per byte from a strided sample of data
+double wireless_sample_entropy(const unsigned char* data, size_t length);
+// Samples a few spots of an open file; false for media and archives that won't shrink
+bool wireless_file_looks_compressible(int fd, uint64_t size);
+
+// Builds one frame (header + payload) for raw. Falls back to a stored frame when the
+// chunk looks incompressible or the codec doesn't win anything.
+void wireless_encode_frame(WirelessCodec codec, const unsigned char* raw, size_t raw_length,
+                           std::vector<unsigned char>& frame);
+// Parses a frame header; false if it is malformed
+bool wireless_parse_frame_header(const unsigned char* header, WirelessCodec& codec,
+                                 uint32_t& raw_length, uint32_t& stored_length);
+// Decodes a payload into out (resized to raw_length); false on corrupt input
+bool wireless_decode_frame(WirelessCodec codec, const unsigned char* payload, size_t stored_length,
+                           uint32_t raw_length, std::vector<unsigned char>& out);
+
+// Fixed size thread pool shared by all transfers
+class WirelessWorkerPool {
+public:
+    static WirelessWorkerPool& shared();
+
+    explicit WirelessWorkerPool(size_t threads);
+    ~WirelessWorkerPool();
+
+    size_t size() const { return workers.size(); }
+
+    template <typename F>
+    auto submit(F task) -> std::future<decltype(task())> {
+        auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+        auto future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queue.push_back([packaged]() { (*packaged)(); });
+        }
+        available.notify_one();
+        return future;
+    }
+
+private:
+    void run();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex lock;
+    std::condition_variable available;
+    bool stopping = false;
+};
+
+#endif /* WirelessCompression_hpp */
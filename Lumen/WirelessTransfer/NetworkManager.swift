@@ -5,365 +5,69 @@ import Foundation
 
 
 
-enum ReceiveState: Sendable {
-    case readingHeader
-    case waitingForApproval
-    case readingBody
-}
+// Receiver threads wait on the user's decision here. Owned by one running
+// receiver; closing it declines everything still waiting.
+private final class NativeReceiveContext {
+    weak var manager: NetworkManager?
 
-class FileReceiver {
-    let id = UUID()
-    let connection: NWConnection
-    
-    var state: ReceiveState = .readingHeader
-    var receivedData = Data() // Only used for header buffering
-    var currentFileName: String = "unknown"
-    var currentFileSize: Int64 = 0
-    var totalBytesReceived: Int64 = 0
-    
-    var tempFileURL: URL?
-    var fileHandle: FileHandle?
-    
-    var onRequest: ((NetworkManager.TransferRequest) -> Void)?
-    var onPairingRequest: ((String) -> Bool)? // For verifying code (Receiver)
-    var onPairingInitiated: ((String, UInt16) -> Void)? // For generating code (Receiver)
-    var onProgress: ((Double) -> Void)?
-    var onSpeedUpdate: ((String) -> Void)?
-    var onTimeRemainingUpdate: ((String) -> Void)?
-    var onComplete: (() -> Void)?
-    var onCancel: (() -> Void)?
-    
-    // ETA State
-    private var transferStartTime: Date?
-    private var lastUpdateTime: Date?
-    private var lastBytesTransferred: Int64 = 0
-    private var speedSamples: [Double] = []
-    
-    init(connection: NWConnection) {
-        self.connection = connection
-    }
-    
-    func start() {
-        connection.start(queue: .global())
-        receive()
-    }
-    
-    private func receive() {
-        connection.receive(minimumIncompleteLength: 1, maximumLength: 1048576) { [weak self] content, _, isComplete, error in
-            guard let self = self else { return }
-            
-            if let data = content, !data.isEmpty {
-                self.processData(data)
-            }
-            
-            if isComplete {
-                print("Connection closed by peer.")
-                self.finishFile()
-            } else if error == nil {
-                self.receive()
-            } else {
-                print("Error receiving: \(String(describing: error))")
-                self.cleanup()
-                self.onCancel?()
-            }
-        }
-    }
-    
-    private func updateSpeedAndETA() {
-        guard let startTime = transferStartTime else { return }
-        let now = Date()
-        
-        if let lastUpdate = lastUpdateTime {
-            let timeDelta = now.timeIntervalSince(lastUpdate)
-            if timeDelta > 0.5 { // Update every 500ms
-                let bytesDelta = totalBytesReceived - lastBytesTransferred
-                let instantSpeed = Double(bytesDelta) / timeDelta
-                
-                speedSamples.append(instantSpeed)
-                if speedSamples.count > 10 { speedSamples.removeFirst() }
-                
-                let avgSpeed = speedSamples.reduce(0, +) / Double(speedSamples.count)
-                
-                // Speed String
-                let speedStr = ByteCountFormatter.string(fromByteCount: Int64(avgSpeed), countStyle: .file) + "/s"
-                onSpeedUpdate?(speedStr)
-                
-                // ETA String
-                let remainingBytes = currentFileSize - totalBytesReceived
-                if avgSpeed > 0 {
-                    let secondsRemaining = Double(remainingBytes) / avgSpeed
-                    let timeStr = formatTime(seconds: secondsRemaining)
-                    onTimeRemainingUpdate?(timeStr)
-                }
-                
-                lastUpdateTime = now
-                lastBytesTransferred = totalBytesReceived
-            }
-        } else {
-             lastUpdateTime = now
-             lastBytesTransferred = totalBytesReceived
-        }
-    }
-    
-    private func formatTime(seconds: Double) -> String {
-        if seconds < 1 { return "Done" }
-        if seconds < 60 { return String(format: "%.0fs left", seconds) }
-        let minutes = Int(seconds / 60)
-        let secs = Int(seconds.truncatingRemainder(dividingBy: 60))
-        return "\(minutes)m \(secs)s left"
+    private let lock = NSLock()
+    private var decisions: [UUID: (semaphore: DispatchSemaphore, accepted: Bool)] = [:]
+    private var closed = false
+
+    init(manager: NetworkManager) {
+        self.manager = manager
     }
 
-    private func processData(_ data: Data) {
-        switch state {
-        case .readingHeader:
-            receivedData.append(data)
-            
-            // Attempt to parse header from Data directly to avoid UTF8 issues with binary body
-            // We expect: FILENAME::SIZE::
-            // We look for the sequence "::" (0x3A, 0x3A)
-            
-            let colonColon = "::".data(using: .utf8)!
-            
-            // Helper to find all occurrences of "::"
-            var ranges: [Range<Data.Index>] = []
-            var searchRange = receivedData.startIndex..<receivedData.endIndex
-            while let range = receivedData.range(of: colonColon, options: [], in: searchRange) {
-                ranges.append(range)
-                searchRange = range.upperBound..<receivedData.endIndex
-                if ranges.count >= 2 { break } // We need at least 2 for FILENAME::SIZE::
-            }
-            
-            // Check for PAIR_REQUEST::PORT:: (2 colons)
-            // Check for PAIR_VERIFY::CODE:: (2 colons)
-            // Check for FILENAME::SIZE:: (2 colons)
-            
-            if ranges.count >= 2 {
-                // We have enough delimiters to potentially be a valid header
-                // We MUST use the second delimiter (index 1) as the end of the header.
-                // Using .last! is dangerous because the body might contain "::" too.
-                let headerEndIndex = ranges[1].upperBound
-                let headerData = receivedData.subdata(in: receivedData.startIndex..<headerEndIndex)
-                
-                if let headerString = String(data: headerData, encoding: .utf8) {
-                    let components = headerString.components(separatedBy: "::")
-                    
-                    // 1. PAIR_REQUEST
-                    if headerString.contains("PAIR_REQUEST") && components.count >= 3 {
-                         if let port = UInt16(components[1]) {
-                            print("Received Pairing Request from port \(port)")
-                            if let remoteIP = connection.endpoint.hostString {
-                                 onPairingInitiated?(remoteIP, port)
-                            }
-                        }
-                        receivedData = Data() // Clear
-                        return
-                    }
-                    
-                    // 2. PAIR_VERIFY
-                    if headerString.contains("PAIR_VERIFY") && components.count >= 3 {
-                        let code = components[1]
-                        print("Received Pairing Verification with code: \(code)")
-                        let success = onPairingRequest?(code) ?? false
-                        sendPairResponse(success: success)
-                        receivedData = Data() // Clear
-                        return
-                    }
-                    
-                    // 3. File Transfer
-                    if components.count >= 3 {
-                        currentFileName = components[0]
-                        if let size = Int64(components[1]) {
-                            currentFileSize = size
-                            // print("Header Parsed. FileName: \(currentFileName), Size: \(currentFileSize)")
-                            
-                            // Initialize ETA
-                            self.transferStartTime = Date()
-                            self.lastUpdateTime = Date()
-                            self.lastBytesTransferred = 0
-                            self.speedSamples = []
-
-                            // Slice off the header
-                            let bodyData = receivedData.subdata(in: headerEndIndex..<receivedData.count)
-                            // print("Initial Body Data Count: \(bodyData.count)")
-                            
-                            // Initialize Temp File
-                            if setupTempFile() {
-                                writeToTempFile(bodyData)
-                                totalBytesReceived = Int64(bodyData.count)
-                                receivedData = Data() // Clear buffer, we are streaming now
-                                
-                                state = .waitingForApproval
-                                
-                                let request = NetworkManager.TransferRequest(
-                                    fileName: currentFileName,
-                                    fileSize: currentFileSize,
-                                    connection: connection,
-                                    receiverId: id
-                                )
-                                onRequest?(request)
-                            } else {
-                                print("Failed to create temp file")
-                                onCancel?()
-                            }
-                        } else {
-                            print("Failed to parse file size from header: \(components[1])")
-                        }
-                    }
-                }
-            }
-        case .waitingForApproval:
-            // Waiting for user to accept/decline. 
-            // Any data received here is likely body data sent early or buffered.
-            if !data.isEmpty {
-                writeToTempFile(data)
-                totalBytesReceived += Int64(data.count)
-            }
-            
-        case .readingBody:
-            writeToTempFile(data)
-            totalBytesReceived += Int64(data.count)
-            onProgress?(Double(totalBytesReceived) / Double(currentFileSize) * 100)
-            updateSpeedAndETA()
-            
-            if totalBytesReceived >= currentFileSize {
-                finishFile()
-            }
-        }
+    // Called before the request is shown, so a resolve can never arrive for
+    // an id that is not waiting yet. Returns false once closed.
+    func register(_ id: UUID) -> Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        if closed { return false }
+        decisions[id] = (DispatchSemaphore(value: 0), false)
+        return true
     }
-    
-    private func setupTempFile() -> Bool {
-        let tempDir = FileManager.default.temporaryDirectory
-        tempFileURL = tempDir.appendingPathComponent(UUID().uuidString)
-        guard let url = tempFileURL else { return false }
-        
-        do {
-            try Data().write(to: url) // Create empty file
-            fileHandle = try FileHandle(forWritingTo: url)
-            print("Temp file created at: \(url.path)")
-            return true
-        } catch {
-            print("Error creating temp file: \(error)")
+
+    // Blocks the calling receiver thread until resolve or close
+    func waitForDecision(_ id: UUID) -> Bool {
+        lock.lock()
+        guard let semaphore = decisions[id]?.semaphore else {
+            lock.unlock()
             return false
         }
-    }
-    
-    private func writeToTempFile(_ data: Data) {
-        if let handle = fileHandle {
-            do {
-                if #available(macOS 10.15.4, *) {
-                    try handle.write(contentsOf: data)
-                } else {
-                    handle.write(data)
-                }
-            } catch {
-                print("Error writing to temp file: \(error)")
-                cleanup()
-                onCancel?()
-            }
-        }
-    }
-    
-    private func cleanup() {
-        try? fileHandle?.close()
-        fileHandle = nil
-        if let url = tempFileURL {
-            try? FileManager.default.removeItem(at: url)
-        }
-        tempFileURL = nil
-    }
+        lock.unlock()
 
-    private func sendPairResponse(success: Bool) {
-        let response = success ? "PAIR_ACK::" : "PAIR_FAIL::"
-        connection.send(content: response.data(using: .utf8), completion: .contentProcessed { error in
-            if let error = error {
-                print("Error sending PAIR response: \(error)")
-            }
-            // Keep connection open? Usually pairing is quick.
-            // If success, we might want to keep it for session, but for now let's close or reset.
-            // The client will likely reconnect for file transfer or keep this open.
-        })
-    }
-    
-    func resolveRequest(accept: Bool) {
-        if accept {
-            let response = "ACCEPT::"
-            connection.send(content: response.data(using: .utf8), completion: .contentProcessed { [weak self] error in
-                guard let self = self else { return }
-                if let error = error {
-                    print("Error sending ACCEPT: \(error)")
-                    return
-                }
-                print("Sent ACCEPT. Switching to readingBody.")
-                self.state = .readingBody
-                // self.receive() // REMOVED: Do NOT call receive() here. The loop is already running from start().
-            })
-        } else {
-            let response = "DECLINE::"
-            connection.send(content: response.data(using: .utf8), completion: .contentProcessed { [weak self] _ in
-                self?.cleanup()
-                self?.connection.cancel()
-                self?.onCancel?()
-            })
-        }
-    }
-    
-    private var isFileSaved = false
+        semaphore.wait()
 
-    private func finishFile() {
-        if isFileSaved { return } // Prevent duplicate saves
-        if state == .readingHeader { return } // Didn't even start
-        
-        // Don't save if it's a pairing request/verify that fell through (shouldn't happen with fix)
-        if currentFileName == "unknown" { return }
+        lock.lock()
+        defer { lock.unlock() }
+        return decisions.removeValue(forKey: id)?.accepted ?? false
+    }
 
-        print("Finishing file. Received: \(totalBytesReceived), Expected: \(currentFileSize)")
+    func resolve(_ id: UUID, accept: Bool) {
+        lock.lock()
+        defer { lock.unlock() }
+        guard let decision = decisions[id] else { return }
+        decisions[id] = (decision.semaphore, accept)
+        decision.semaphore.signal()
+    }
 
-        if totalBytesReceived < currentFileSize {
-            print("Warning: Transfer incomplete. Received: \(totalBytesReceived), Expected: \(currentFileSize). Saving anyway.")
-            // We proceed to save because the sender closed the connection, implying they possess no more data.
-            // This handles cases where the Reported File Size (Content-Length) was incorrect.
-        }
-        
-        isFileSaved = true // Mark as saved
-        
-        // Close handle before moving
-        try? fileHandle?.close()
-        fileHandle = nil
-        
-        guard let tempURL = tempFileURL else {
-            onCancel?()
-            return
-        }
-        
-        let fileManager = FileManager.default
-        if let downloadsURL = fileManager.urls(for: .downloadsDirectory, in: .userDomainMask).first {
-            var destinationURL = downloadsURL.appendingPathComponent(currentFileName)
-            var counter = 1
-            let nameWithoutExt = (currentFileName as NSString).deletingPathExtension
-            let ext = (currentFileName as NSString).pathExtension
-            
-            while fileManager.fileExists(atPath: destinationURL.path) {
-                let newName = "\(nameWithoutExt)_\(counter)\(ext.isEmpty ? "" : ".\(ext)")"
-                destinationURL = downloadsURL.appendingPathComponent(newName)
-                counter += 1
-            }
-            
-            do {
-                try fileManager.moveItem(at: tempURL, to: destinationURL)
-                print("File saved to: \(destinationURL.path)")
-                onComplete?()
-            } catch {
-                print("Error saving file: \(error)")
-                cleanup() // Will remove temp file
-                onCancel?()
-            }
+    func declineAll(closing: Bool = false) {
+        lock.lock()
+        defer { lock.unlock() }
+        if closing { closed = true }
+        for (id, decision) in decisions {
+            decisions[id] = (decision.semaphore, false)
+            decision.semaphore.signal()
         }
     }
 }
 
 class NetworkManager: ObservableObject {
-    private var listener: NWListener?
-    private var activeReceivers: [UUID: FileReceiver] = [:]
+    // Native engine (WirelessBridge) receiving on serverPort. Native senders get
+    // parallel streams and compression, legacy senders a single plain stream.
+    private var receiver: OpaquePointer?
+    private var receiverContext: Unmanaged<NativeReceiveContext>?
     
     @Published var serverIP: String = ""
     @Published var serverPort: UInt16 = 0
@@ -380,8 +84,6 @@ class NetworkManager: ObservableObject {
         let id = UUID()
         let fileName: String
         let fileSize: Int64
-        let connection: NWConnection
-        let receiverId: UUID
     }
     
     @Published var pendingRequest: TransferRequest?
@@ -393,52 +95,99 @@ class NetworkManager: ObservableObject {
     @Published var transferHistory: [TransferHistoryItem] = []
     
     func startServer(port: UInt16 = 0) {
-        do {
-            let parameters = NWParameters.tcp
-            let tcpOptions = parameters.defaultProtocolStack.transportProtocol as? NWProtocolTCP.Options
-            tcpOptions?.enableKeepalive = true
-            tcpOptions?.noDelay = true
-            parameters.acceptLocalOnly = false
-            
-            if port != 0 {
-                let endpointPort = NWEndpoint.Port(rawValue: port)!
-                listener = try NWListener(using: parameters, on: endpointPort)
+        guard receiver == nil else { return }
+        guard let downloadsURL = FileManager.default.urls(for: .downloadsDirectory, in: .userDomainMask).first else {
+            print("Failed to create listener: no Downloads folder")
+            serverStatus = "Failed"
+            return
+        }
+        
+        let onRequest: WirelessRequestCallback = { name, size, ctx in
+            guard let name = name, let ctx = ctx else { return false }
+            let context = Unmanaged<NativeReceiveContext>.fromOpaque(ctx).takeUnretainedValue()
+            guard let manager = context.manager else { return false }
+            return manager.decideIncoming(fileName: String(cString: name), fileSize: Int64(size), context: context)
+        }
+        
+        let onProgress: WirelessProgressCallback = { received, total, ctx in
+            guard let ctx = ctx else { return }
+            let context = Unmanaged<NativeReceiveContext>.fromOpaque(ctx).takeUnretainedValue()
+            DispatchQueue.main.async {
+                context.manager?.updateProgress(offset: Int64(received), fileSize: Int64(total), isIncoming: true)
+            }
+        }
+        
+        let onComplete: WirelessCompletionCallback = { name, savedPath, result, ctx in
+            guard let ctx = ctx else { return }
+            let context = Unmanaged<NativeReceiveContext>.fromOpaque(ctx).takeUnretainedValue()
+            let fileName = name.map { String(cString: $0) } ?? ""
+            let saved = savedPath != nil && result == WIRELESS_OK.rawValue
+            if let savedPath = savedPath, saved {
+                print("File saved to: \(String(cString: savedPath))")
             } else {
-                listener = try NWListener(using: parameters)
+                print("Receiving \(fileName) failed with error \(result)")
             }
-            
-            listener?.stateUpdateHandler = { newState in
-                switch newState {
-                case .ready:
-                    if let port = self.listener?.port?.rawValue {
-                        print("Server ready on port \(port)")
-                        self.serverPort = port
-                        self.serverStatus = "Running"
-                        self.updateServerIP()
-                    }
-                case .failed(let error):
-                    print("Server failed: \(error)")
-                    self.serverStatus = "Failed"
-                default:
-                    break
-                }
+            DispatchQueue.main.async {
+                context.manager?.finishIncoming(fileName: fileName, saved: saved)
             }
+        }
+        
+        // Pairing shares the port with transfers
+        let onPairing: WirelessPairingCallback = { message, value, peerHost, ctx in
+            guard let message = message, let value = value, let ctx = ctx else { return false }
+            let context = Unmanaged<NativeReceiveContext>.fromOpaque(ctx).takeUnretainedValue()
+            guard let manager = context.manager else { return false }
             
-            listener?.newConnectionHandler = { newConnection in
-                print("New connection: \(newConnection)")
-                self.handleConnection(newConnection)
+            let value = String(cString: value)
+            switch String(cString: message) {
+            case "PAIR_REQUEST":
+                print("Received Pairing Request from port \(value)")
+                if let port = UInt16(value), let peerHost = peerHost, peerHost.pointee != 0 {
+                    manager.onPairingInitiated?(String(cString: peerHost), port)
+                }
+                return true
+            case "PAIR_VERIFY":
+                print("Received Pairing Verification with code: \(value)")
+                return manager.onPairingRequest?(value) ?? false
+            default:
+                return false
             }
-            
-            listener?.start(queue: .global())
-        } catch {
-            print("Failed to create listener: \(error)")
         }
+        
+        var config = wireless_default_config()
+        let context = Unmanaged.passRetained(NativeReceiveContext(manager: self))
+        guard let receiver = wireless_receiver_start(port, downloadsURL.path, &config,
+                                                     onRequest, onProgress, onComplete, onPairing,
+                                                     context.toOpaque()) else {
+            context.release()
+            print("Failed to create listener on port \(port)")
+            serverStatus = "Failed"
+            return
+        }
+        self.receiver = receiver
+        self.receiverContext = context
+        
+        serverPort = wireless_receiver_port(receiver)
+        serverStatus = "Running"
+        print("Server ready on port \(serverPort)")
+        updateServerIP()
     }
     
     func stopServer() {
-        listener?.cancel()
-        listener = nil
+        guard let receiver = receiver, let context = receiverContext else { return }
+        self.receiver = nil
+        self.receiverContext = nil
+        
+        // Receiver threads may be waiting on the user or on the main queue,
+        // so release them and wait for the connections off main
+        context.takeUnretainedValue().declineAll(closing: true)
+        DispatchQueue.global(qos: .utility).async {
+            wireless_receiver_stop(receiver)
+            context.release()
+        }
+        
         serverStatus = "Stopped"
+        pendingRequest = nil
         print("Server stopped")
     }
     
@@ -476,125 +225,108 @@ class NetworkManager: ObservableObject {
         return address
     }
     
-    private func handleConnection(_ connection: NWConnection) {
-        let receiver = FileReceiver(connection: connection)
-        
-        // Pass the pairing callbacks
-        receiver.onPairingRequest = self.onPairingRequest
-        receiver.onPairingInitiated = self.onPairingInitiated
-        
-        receiver.onRequest = { [weak self] request in
-            DispatchQueue.main.async {
-                guard let self = self else { return }
-                
-                // Add to history immediately when request is received
-                let historyItem = TransferHistoryItem(
-                    id: request.id,
-                    fileName: request.fileName,
-                    fileSize: request.fileSize,
-                    isIncoming: true,
-                    progress: 0.0,
-                    state: .transferring,
-                    date: Date()
-                )
-                self.transferHistory.insert(historyItem, at: 0)
-                
-                // Check for Auto-Accept (Trusted Session)
-                if let shouldAutoAccept = self.shouldAutoAccept, shouldAutoAccept() {
-                    print("Auto-accepting transfer from trusted peer")
-                    self.isTransferring = true
-                    self.currentTransferFileName = request.fileName
-                    self.transferProgress = 0.0
-                    // Do NOT set pendingRequest, so no alert is shown
-                    receiver.resolveRequest(accept: true)
-                } else {
-                    self.pendingRequest = request
-                }
-            }
-        }
-        
-        receiver.onProgress = { [weak self] progress in
-            DispatchQueue.main.async {
-                self?.transferProgress = progress
-                // Update history item
-                if let index = self?.transferHistory.firstIndex(where: { $0.id == receiver.id && $0.isIncoming }) {
-                    self?.transferHistory[index].progress = progress
-                }
-            }
-        }
+    // Called on a receiver thread when a peer offers a file; returns once the user decides
+    private func decideIncoming(fileName: String, fileSize: Int64, context: NativeReceiveContext) -> Bool {
+        let request = TransferRequest(fileName: fileName, fileSize: fileSize)
+        guard context.register(request.id) else { return false }
         
-        receiver.onSpeedUpdate = { [weak self] speed in
-            DispatchQueue.main.async {
-                self?.transferSpeed = speed
+        DispatchQueue.main.async {
+            // Add to history immediately when request is received
+            let historyItem = TransferHistoryItem(
+                id: request.id,
+                fileName: request.fileName,
+                fileSize: request.fileSize,
+                isIncoming: true,
+                progress: 0.0,
+                state: .transferring,
+                date: Date()
+            )
+            self.transferHistory.insert(historyItem, at: 0)
+            
+            // Check for Auto-Accept (Trusted Session)
+            if let shouldAutoAccept = self.shouldAutoAccept, shouldAutoAccept() {
+                print("Auto-accepting transfer from trusted peer")
+                // Do NOT set pendingRequest, so no alert is shown
+                self.beginIncoming(request)
+                context.resolve(request.id, accept: true)
+            } else {
+                self.pendingRequest = request
             }
         }
         
-        receiver.onTimeRemainingUpdate = { [weak self] time in
-            DispatchQueue.main.async {
-                self?.timeRemaining = time
-            }
+        return context.waitForDecision(request.id)
+    }
+    
+    private func beginIncoming(_ request: TransferRequest) {
+        isTransferring = true
+        currentTransferFileName = request.fileName
+        transferProgress = 0.0
+        lastProgressUpdateTime = Date()
+        lastProgressBytes = 0
+        speedSamples = []
+        transferSpeed = ""
+        timeRemaining = "Calculating..."
+    }
+    
+    private func finishIncoming(fileName: String, saved: Bool) {
+        isTransferring = false
+        if saved {
+            transferProgress = 100.0
         }
-        
-        receiver.onComplete = { [weak self] in
-            DispatchQueue.main.async {
-                self?.isTransferring = false
-                self?.transferProgress = 100.0
-                self?.pendingRequest = nil
-                // Mark as completed
-                if let index = self?.transferHistory.firstIndex(where: { $0.id == receiver.id && $0.isIncoming }) {
-                    self?.transferHistory[index].progress = 100.0
-                    self?.transferHistory[index].state = .completed
-                }
+        if let index = transferHistory.firstIndex(where: { $0.fileName == fileName && $0.isIncoming && $0.state == .transferring }) {
+            if saved {
+                transferHistory[index].progress = 100.0
+                transferHistory[index].state = .completed
+            } else {
+                transferHistory[index].state = .failed
             }
-            self?.activeReceivers.removeValue(forKey: receiver.id)
         }
-        
-        receiver.onCancel = { [weak self] in
-            DispatchQueue.main.async {
-                self?.isTransferring = false
-                self?.pendingRequest = nil
-            }
-            self?.activeReceivers.removeValue(forKey: receiver.id)
+    }
+    
+    private func markIncomingCancelled(_ request: TransferRequest) {
+        if let index = transferHistory.firstIndex(where: { $0.id == request.id }) {
+            transferHistory[index].state = .cancelled
         }
-        
-        activeReceivers[receiver.id] = receiver
-        receiver.start()
     }
     
     func resolveRequest(accept: Bool) {
-        guard let request = pendingRequest, let receiver = activeReceivers[request.receiverId] else { return }
+        guard let request = pendingRequest, let context = receiverContext?.takeUnretainedValue() else { return }
         
-        if accept {
-            DispatchQueue.main.async {
-                self.isTransferring = true
-                self.currentTransferFileName = request.fileName
-                self.transferProgress = 0.0
-                self.pendingRequest = nil // Clear request immediately
-            }
-            receiver.resolveRequest(accept: true)
-        } else {
-            receiver.resolveRequest(accept: false)
-            DispatchQueue.main.async {
-                self.pendingRequest = nil
+        DispatchQueue.main.async {
+            self.pendingRequest = nil // Clear request immediately
+            if accept {
+                self.beginIncoming(request)
+            } else {
+                self.markIncomingCancelled(request)
             }
         }
+        context.resolve(request.id, accept: accept)
     }
     
     private var sendingConnection: NWConnection?
 
+    // Native engine (WirelessBridge): sendfile + parallel streams when the peer supports them
+    private var nativeTransfer: OpaquePointer?
+
     func cancelTransfer() {
         print("Cancelling transfer...")
-        // Cancel all active receivers
-        for receiver in activeReceivers.values {
-            receiver.connection.cancel()
+        // Cancel everything being received, and decline what is still waiting
+        if let receiver = receiver {
+            wireless_receiver_cancel_all(receiver)
+        }
+        receiverContext?.takeUnretainedValue().declineAll()
+        if let request = pendingRequest {
+            DispatchQueue.main.async { self.markIncomingCancelled(request) }
         }
-        activeReceivers.removeAll()
         
         // Cancel sending
         if let connection = sendingConnection {
             connection.cancel()
             sendingConnection = nil
         }
+        if let transfer = nativeTransfer {
+            wireless_transfer_cancel(transfer)
+        }
         
         DispatchQueue.main.async {
             self.isTransferring = false
@@ -607,16 +339,16 @@ class NetworkManager: ObservableObject {
     private var transferQueue: [URL] = []
     private var currentTarget: (ip: String, port: UInt16)?
     
-    // Sender Speed Tracking
-    private var lastSendingUpdateTime: Date?
-    private var lastSendingBytesTransferred: Int64 = 0
-    private var sendingSpeedSamples: [Double] = []
+    // Speed tracking for the transfer on screen
+    private var lastProgressUpdateTime: Date?
+    private var lastProgressBytes: Int64 = 0
+    private var speedSamples: [Double] = []
 
     func sendFiles(urls: [URL], to ip: String, port: UInt16) {
         self.transferQueue.append(contentsOf: urls)
         self.currentTarget = (ip, port)
         
-        if self.sendingConnection == nil {
+        if self.sendingConnection == nil && self.nativeTransfer == nil {
             processQueue()
         }
     }
@@ -649,13 +381,18 @@ class NetworkManager: ObservableObject {
             self.transferProgress = 0
             
             // Reset speed stats
-            self.lastSendingUpdateTime = Date()
-            self.lastSendingBytesTransferred = 0
-            self.sendingSpeedSamples = []
+            self.lastProgressUpdateTime = Date()
+            self.lastProgressBytes = 0
+            self.speedSamples = []
             self.transferSpeed = ""
             self.timeRemaining = "Calculating..."
         }
 
+        sendFileNative(to: ip, port: port, url: url)
+    }
+
+    // Single NWConnection stream, used when the native engine could not send the file
+    private func sendFileLegacy(to ip: String, port: UInt16, url: URL) {
         let host = NWEndpoint.Host(ip)
         let port = NWEndpoint.Port(rawValue: port)!
         
@@ -681,7 +418,10 @@ class NetworkManager: ObservableObject {
                 self.sendHeader(connection: connection, url: url)
             case .failed(let error):
                 print("Connection failed: \(error)")
-                DispatchQueue.main.async { self.isTransferring = false }
+                DispatchQueue.main.async {
+                    self.isTransferring = false
+                    self.markOutgoingFailed(url.lastPathComponent)
+                }
                 self.sendingConnection = nil
                 self.processQueue()
             case .cancelled:
@@ -717,7 +457,10 @@ class NetworkManager: ObservableObject {
                         if let error = error {
                             print("Error receiving ACCEPT: \(error)")
                             connection.cancel()
-                            DispatchQueue.main.async { self.isTransferring = false }
+                            DispatchQueue.main.async {
+                                self.isTransferring = false
+                                self.markOutgoingFailed(url.lastPathComponent)
+                            }
                             self.processQueue()
                             return
                         }
@@ -730,7 +473,10 @@ class NetworkManager: ObservableObject {
                             } else {
                                 print("Receiver declined or invalid response: \(response)")
                                 connection.cancel()
-                                DispatchQueue.main.async { self.isTransferring = false }
+                                DispatchQueue.main.async {
+                                    self.isTransferring = false
+                                    self.markOutgoingFailed(url.lastPathComponent)
+                                }
                                 self.processQueue()
                             }
                         } else {
@@ -741,7 +487,10 @@ class NetworkManager: ObservableObject {
             }
         } catch {
             print("Error reading file attributes: \(error)")
-            DispatchQueue.main.async { self.isTransferring = false }
+            DispatchQueue.main.async {
+                self.isTransferring = false
+                self.markOutgoingFailed(url.lastPathComponent)
+            }
             self.processQueue()
         }
     }
@@ -811,57 +560,16 @@ class NetworkManager: ObservableObject {
                         if let error = error {
                             print("Error sending chunk: \(error)")
                             try? fileHandle.close()
+                            DispatchQueue.main.async { self.markOutgoingFailed(url.lastPathComponent) }
                             self.cancelTransfer()
                             return
                         }
                         
                         offset += Int64(currentChunkSize)
                         
+                        let sentBytes = offset
                         DispatchQueue.main.async {
-                            let progress = Double(offset) / Double(fileSize) * 100
-                            self.transferProgress = progress
-                            
-                            // Speed & ETA Calculation for Sender
-                            let now = Date()
-                            if let lastTime = self.lastSendingUpdateTime {
-                                let timeDelta = now.timeIntervalSince(lastTime)
-                                if timeDelta > 0.5 { // Update every 500ms
-                                    let bytesDelta = offset - self.lastSendingBytesTransferred
-                                    let instantSpeed = Double(bytesDelta) / timeDelta
-                                    
-                                    self.sendingSpeedSamples.append(instantSpeed)
-                                    if self.sendingSpeedSamples.count > 10 { self.sendingSpeedSamples.removeFirst() }
-                                    
-                                    let avgSpeed = self.sendingSpeedSamples.reduce(0, +) / Double(self.sendingSpeedSamples.count)
-                                    
-                                    // Speed String
-                                    self.transferSpeed = ByteCountFormatter.string(fromByteCount: Int64(avgSpeed), countStyle: .file) + "/s"
-                                    
-                                    // ETA String
-                                    let remainingBytes = fileSize - offset
-                                    if avgSpeed > 0 {
-                                        let secondsRemaining = Double(remainingBytes) / avgSpeed
-                                        if secondsRemaining < 1 { self.timeRemaining = "Done" }
-                                        else if secondsRemaining < 60 { self.timeRemaining = String(format: "%.0fs left", secondsRemaining) }
-                                        else {
-                                            let minutes = Int(secondsRemaining / 60)
-                                            let secs = Int(secondsRemaining.truncatingRemainder(dividingBy: 60))
-                                            self.timeRemaining = "\(minutes)m \(secs)s left"
-                                        }
-                                    }
-                                    
-                                    self.lastSendingUpdateTime = now
-                                    self.lastSendingBytesTransferred = offset
-                                }
-                            } else {
-                                self.lastSendingUpdateTime = now
-                                self.lastSendingBytesTransferred = offset
-                            }
-
-                            // Update History
-                            if let index = self.transferHistory.firstIndex(where: { $0.fileName == self.currentTransferFileName && !$0.isIncoming && $0.state == .transferring }) {
-                                self.transferHistory[index].progress = progress
-                            }
+                            self.updateProgress(offset: sentBytes, fileSize: fileSize)
                         }
                         
                         // Continue sending
@@ -874,11 +582,140 @@ class NetworkManager: ObservableObject {
                 
             } catch {
                 print("Error opening file handle: \(error)")
+                DispatchQueue.main.async { self.markOutgoingFailed(url.lastPathComponent) }
                 self.cancelTransfer()
             }
         }
     }
     
+    private class NativeSendContext {
+        weak var manager: NetworkManager?
+        let fileSize: Int64
+
+        init(manager: NetworkManager, fileSize: Int64) {
+            self.manager = manager
+            self.fileSize = fileSize
+        }
+    }
+
+    private func sendFileNative(to ip: String, port: UInt16, url: URL) {
+        var config = wireless_default_config()
+        guard let transfer = wireless_transfer_create(ip, port, &config) else {
+            print("Failed to create native transfer for \(ip):\(port), using a single stream")
+            sendFileLegacy(to: ip, port: port, url: url)
+            return
+        }
+        nativeTransfer = transfer
+
+        let fileSize = (try? url.resourceValues(forKeys: [.fileSizeKey]).fileSize).flatMap { Int64($0) } ?? 0
+
+        DispatchQueue.global(qos: .userInitiated).async { [weak self] in
+            guard let self = self else { return }
+
+            let context = NativeSendContext(manager: self, fileSize: fileSize)
+            let contextPtr = Unmanaged.passRetained(context).toOpaque()
+
+            let callback: WirelessProgressCallback = { sent, _, ctx in
+                guard let ctx = ctx else { return }
+                let context = Unmanaged<NativeSendContext>.fromOpaque(ctx).takeUnretainedValue()
+                let fileSize = context.fileSize
+                DispatchQueue.main.async {
+                    context.manager?.updateProgress(offset: Int64(sent), fileSize: fileSize)
+                }
+            }
+
+            let ret = wireless_transfer_send_file(transfer, url.path, url.lastPathComponent, callback, contextPtr)
+
+            Unmanaged<NativeSendContext>.fromOpaque(contextPtr).release()
+
+            DispatchQueue.main.async {
+                // Freed on main so cancelTransfer never sees a dangling handle
+                self.nativeTransfer = nil
+                wireless_transfer_free(transfer)
+
+                if ret == WIRELESS_OK.rawValue {
+                    print("File streaming complete")
+                    self.transferProgress = 100.0
+                    if let index = self.transferHistory.firstIndex(where: { $0.fileName == self.currentTransferFileName && !$0.isIncoming && $0.state == .transferring }) {
+                        self.transferHistory[index].progress = 100.0
+                        self.transferHistory[index].state = .completed
+                    }
+                    if self.transferQueue.isEmpty {
+                        self.isTransferring = false
+                        self.currentTarget = nil
+                    } else {
+                        self.processQueue()
+                    }
+                } else if ret == WIRELESS_E_CANCELLED.rawValue {
+                    print("Transfer cancelled during streaming")
+                    self.transferQueue.removeAll()
+                } else if ret == WIRELESS_E_DECLINED.rawValue {
+                    print("Receiver declined")
+                    self.isTransferring = false
+                    self.markOutgoingFailed(url.lastPathComponent)
+                    self.processQueue()
+                } else {
+                    // A native receiver drops the partial file, so the whole file goes again
+                    print("Native send failed with error \(ret), retrying over a single stream")
+                    self.sendFileLegacy(to: ip, port: port, url: url)
+                }
+            }
+        }
+    }
+
+    private func markOutgoingFailed(_ fileName: String) {
+        if let index = transferHistory.firstIndex(where: { $0.fileName == fileName && !$0.isIncoming && $0.state == .transferring }) {
+            transferHistory[index].state = .failed
+        }
+    }
+
+    private func updateProgress(offset: Int64, fileSize: Int64, isIncoming: Bool = false) {
+        let progress = fileSize > 0 ? Double(offset) / Double(fileSize) * 100 : 100
+        self.transferProgress = progress
+
+        // Speed & ETA Calculation
+        let now = Date()
+        if let lastTime = self.lastProgressUpdateTime {
+            let timeDelta = now.timeIntervalSince(lastTime)
+            if timeDelta > 0.5 { // Update every 500ms
+                let bytesDelta = offset - self.lastProgressBytes
+                let instantSpeed = Double(bytesDelta) / timeDelta
+
+                self.speedSamples.append(instantSpeed)
+                if self.speedSamples.count > 10 { self.speedSamples.removeFirst() }
+
+                let avgSpeed = self.speedSamples.reduce(0, +) / Double(self.speedSamples.count)
+
+                // Speed String
+                self.transferSpeed = ByteCountFormatter.string(fromByteCount: Int64(avgSpeed), countStyle: .file) + "/s"
+
+                // ETA String
+                let remainingBytes = fileSize - offset
+                if avgSpeed > 0 {
+                    let secondsRemaining = Double(remainingBytes) / avgSpeed
+                    if secondsRemaining < 1 { self.timeRemaining = "Done" }
+                    else if secondsRemaining < 60 { self.timeRemaining = String(format: "%.0fs left", secondsRemaining) }
+                    else {
+                        let minutes = Int(secondsRemaining / 60)
+                        let secs = Int(secondsRemaining.truncatingRemainder(dividingBy: 60))
+                        self.timeRemaining = "\(minutes)m \(secs)s left"
+                    }
+                }
+
+                self.lastProgressUpdateTime = now
+                self.lastProgressBytes = offset
+            }
+        } else {
+            self.lastProgressUpdateTime = now
+            self.lastProgressBytes = offset
+        }
+
+        // Update History
+        if let index = self.transferHistory.firstIndex(where: { $0.fileName == self.currentTransferFileName && $0.isIncoming == isIncoming && $0.state == .transferring }) {
+            self.transferHistory[index].progress = progress
+        }
+    }
+
     func sendPairingRequest(to ip: String, port: UInt16, completion: @escaping (Bool) -> Void) {
         print("Sending PAIR_REQUEST to \(ip):\(port)")
         let host = NWEndpoint.Host(ip)
@@ -976,43 +813,3 @@ class NetworkManager: ObservableObject {
         connection.start(queue: .global())
     }
 }
-
-
-
-extension NWEndpoint {
-    var hostString: String? {
-        switch self {
-        case .hostPort(let host, _):
-            switch host {
-            case .ipv4(let ipv4):
-                // ipv4.debugDescription returns "x.x.x.x" (or similar, verifying)
-                // Actually, IPv4Address doesn't have a simple .ipString property in Network framework?
-                // It conforms to CustomDebugStringConvertible.
-                // Let's use a safer way if possible, but debugDescription usually works.
-                // A better way:
-                return ipv4.rawValue.withUnsafeBytes { ptr in
-                    var addr = in_addr(s_addr: ptr.load(as: UInt32.self))
-                    var buffer = [CChar](repeating: 0, count: Int(INET_ADDRSTRLEN))
-                    inet_ntop(AF_INET, &addr, &buffer, socklen_t(INET_ADDRSTRLEN))
-                    return String(cString: buffer)
-                }
-            case .ipv6(let ipv6):
-                 return ipv6.rawValue.withUnsafeBytes { ptr in
-                    var addr = in6_addr()
-                    withUnsafeMutableBytes(of: &addr) { addrPtr in
-                        addrPtr.copyMemory(from: ptr)
-                    }
-                    var buffer = [CChar](repeating: 0, count: Int(INET6_ADDRSTRLEN))
-                    inet_ntop(AF_INET6, &addr, &buffer, socklen_t(INET6_ADDRSTRLEN))
-                    return String(cString: buffer)
-                }
-            case .name(let name, _):
-                return name
-            default:
-                return nil
-            }
-        default:
-            return nil
-        }
-    }
-}
@@ -37,6 +37,24 @@ typedef enum {
 // Callback for progress: transferred bytes, total bytes, context
 typedef void (*iOSProgressCallback)(uint64_t sent, uint64_t total, const void* context);
 
+// Batch operations on device paths
+typedef enum {
+    IOS_BATCH_DELETE,   // Files or whole folders
+    IOS_BATCH_MOVE,     // path -> destination (full path)
+    IOS_BATCH_COPY,     // path -> destination (full path)
+    IOS_BATCH_RENAME    // path -> destination (new name in the same folder)
+} iOSBatchOpType;
+
+typedef struct {
+    iOSBatchOpType type;
+    char path[1024];
+    char destination[1024];
+    int result;                 // Set by ios_batch_apply: 0 on success
+} iOSBatchOp;
+
+// Callback for batch progress: operations finished, total, context
+typedef void (*iOSBatchCallback)(int done, int total, const void* context);
+
 // Device Management
 bool ios_connect(void);
 void ios_disconnect(void);
@@ -49,17 +67,78 @@ char* ios_get_device_name(void);
 iOSFileInfo* ios_list_files(const char* path, int* count);
 void ios_free_files(iOSFileInfo* files);
 
+// Catalog snapshots
+// Folder listings are kept per device (by UDID) in a memory-mapped file under
+// directory, so a reconnected device can be browsed before it is re-listed.
+// App sandboxes opened through House Arrest are not recorded.
+void ios_set_catalog_directory(const char* directory);
+// Returns the last recorded listing of a folder, caller must free it with ios_free_files.
+// count is -1 when the folder is not in the snapshot; listed_at (optional) receives the listing time.
+iOSFileInfo* ios_list_cached_files(const char* path, int* count, uint64_t* listed_at);
+// Writes new listings to disk. Also happens on disconnect.
+bool ios_save_catalog(void);
+
 // Transfer Operations
 int ios_download_file(const char* device_path, const char* dest_path, iOSProgressCallback callback, const void* context);
 int ios_upload_file(const char* source_path, const char* device_path, iOSProgressCallback callback, const void* context);
 int ios_delete_file(const char* device_path);
 int ios_create_directory(const char* device_path);
 
+// Prefetch
+// Lists media folders the user is likely to open next into the catalog while
+// the device is idle, so ios_list_cached_files can answer a drill-down with a
+// fresh listing. Other calls wait at most for the one folder in flight, and
+// nothing is prefetched while House Arrest is active.
+// Subfolders of the folder being shown, most likely first. Replaces what was queued.
+void ios_prefetch_folders(const char* const* paths, int count);
+// The folder under the pointer, listed before anything else
+void ios_prefetch_hint(const char* path);
+void ios_prefetch_cancel(void);
+
+// Streaming
+// Random access to a file without downloading it, for previews and playback.
+// Reads go through a block cache with readahead for sequential access.
+// bundle_id is NULL or "" for the media filesystem. A stream may be read from
+// any thread, one read at a time.
+typedef struct iOSStream iOSStream;
+iOSStream* ios_stream_open(const char* bundle_id, const char* device_path);
+// Returns bytes read, 0 at the end of the file, or a negative error
+int64_t ios_stream_read(iOSStream* stream, uint64_t offset, void* buffer, uint32_t length);
+uint64_t ios_stream_size(iOSStream* stream);
+void ios_stream_close(iOSStream* stream);
+
 // House Arrest (App Sandbox Access)
+// While active, the file operations above go to the app's sandbox instead of
+// the media filesystem. Both stay open, so switching back and forth is cheap.
 bool ios_house_arrest_start(const char* bundle_id);
 void ios_house_arrest_stop(void);
 bool ios_house_arrest_is_active(void);
 
+// App Sessions
+// AFC sessions for the media filesystem and several app sandboxes are kept open
+// at once; the least recently used sandbox is closed when the limit is reached.
+// These calls take the sandbox explicitly (NULL or "" for the media filesystem)
+// and may run concurrently with each other and with the calls above.
+// count is -1 when the sandbox could not be opened
+iOSFileInfo* ios_app_list_files(const char* bundle_id, const char* path, int* count);
+int ios_app_download_file(const char* bundle_id, const char* device_path, const char* dest_path, iOSProgressCallback callback, const void* context);
+int ios_app_upload_file(const char* bundle_id, const char* source_path, const char* device_path, iOSProgressCallback callback, const void* context);
+int ios_app_delete_file(const char* bundle_id, const char* device_path);
+int ios_app_create_directory(const char* bundle_id, const char* device_path);
+// Default 4 sandboxes; the media session does not count
+void ios_set_max_app_sessions(int count);
+int ios_app_session_count(void);
+void ios_close_app_session(const char* bundle_id);
+
+// Batch
+// Applies independent operations, in no particular order, to the media
+// filesystem (bundle_id NULL or "") or an app sandbox. Large batches are spread
+// over several AFC connections so requests overlap. Moves and renames are done
+// by the device; AFC has no copy, so copies stream through memory without
+// touching the disk. The callback may come from worker threads.
+// Returns the number of operations that failed, or -1 if the session could not be opened.
+int ios_batch_apply(const char* bundle_id, iOSBatchOp* ops, int count, iOSBatchCallback callback, const void* context);
+
 #ifdef __cplusplus
 }
 #endif
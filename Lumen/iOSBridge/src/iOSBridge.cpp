@@ -1,4 +1,8 @@
 #include "iOSBridge.h"
+#include "DeviceCatalog.hpp"
+#include "BlockCache.hpp"
+#include "DirectoryPrefetcher.hpp"
+#include "ListingPool.hpp"
 #include <libimobiledevice/libimobiledevice.h>
 #include <libimobiledevice/lockdown.h>
 #include <libimobiledevice/afc.h>
@@ -6,17 +10,65 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <atomic>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <chrono>
 #include <thread>
 
-// Global device pointers
+// Owns the idevice handle. AFC sessions keep a reference, so a client that is
+// still in use elsewhere never outlives the device it was opened on.
+struct DeviceHandle {
+    idevice_t device = NULL;
+    ~DeviceHandle() {
+        if (device) idevice_free(device);
+    }
+};
+
+// One AFC connection: the media filesystem or one app's sandbox via House Arrest.
+// Operations hold a shared_ptr for their whole duration, so evicting a session
+// or disconnecting only frees the client once the last operation is done.
+// afc_client_t serializes its own requests, so one session can serve several
+// operations at once.
+struct AFCSession {
+    std::string bundle_id;          // Empty for the media filesystem
+    std::shared_ptr<DeviceHandle> handle;
+    house_arrest_client_t house_arrest_client = NULL;
+    afc_client_t afc_client = NULL;
+
+    ~AFCSession() {
+        if (afc_client) afc_client_free(afc_client);
+        if (house_arrest_client) house_arrest_client_free(house_arrest_client);
+    }
+};
+
+typedef std::shared_ptr<AFCSession> AFCSessionRef;
+
+// Global device pointers, guarded by device_lock
+static std::recursive_mutex device_lock;
 static idevice_t device = NULL;
 static lockdownd_client_t lockdown_client = NULL;
-static afc_client_t afc_client = NULL;
-static house_arrest_client_t house_arrest_client = NULL;
-static bool house_arrest_active = false;
+
+// Session pool, guarded by pool_lock (taken after device_lock, never before).
+// The media session is never evicted; app sessions are kept most recently used first.
+static std::mutex pool_lock;
+static std::shared_ptr<DeviceHandle> device_handle;
+static AFCSessionRef media_session;
+static std::list<AFCSessionRef> app_sessions;
+static size_t max_app_sessions = 4;
+// Sandbox the unqualified ios_* calls go to while House Arrest is active
+static std::string active_bundle_id;
+
+// Listing snapshot of the connected device
+static DeviceCatalog catalog;
+static std::string catalog_directory;
+
+// Result arrays and scratch strings for the connected device's listings
+static ListingPool listing_pool;
 
 // Progress callback wrapper structure
 struct iOSBridgeCallbackData {
@@ -48,8 +100,163 @@ static uint64_t simple_hash(const std::string& str) {
     return hash;
 }
 
+static std::string normalize_path(const char* path) {
+    std::string normalized_path = path;
+    if (normalized_path.empty() || normalized_path[0] != '/') {
+        normalized_path = "/" + normalized_path;
+    }
+    return normalized_path;
+}
+
+// Same, into a buffer that may already have the capacity
+static void normalize_path(const char* path, std::string& out) {
+    out.clear();
+    if (path[0] != '/') out += '/';
+    out += path;
+}
+
+static std::string parent_path(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos || slash == 0) return "/";
+    return path.substr(0, slash);
+}
+
+// After a change on the media filesystem: the folder it happened in, and with
+// tree set everything under path, no longer match their recorded listings
+static void invalidate_path(const char* path, bool tree) {
+    if (!catalog.is_open() || !path) return;
+    std::string normalized = normalize_path(path);
+    catalog.invalidate(parent_path(normalized));
+    if (tree) catalog.invalidate_tree(normalized);
+}
+
+// Needs a lockdown session, so only call once the device is connected
+static void open_catalog() {
+    if (!device || catalog_directory.empty() || catalog.is_open()) return;
+
+    iOSDeviceInfo info = ios_get_device_info();
+    if (info.device_udid[0] != '\0') {
+        catalog.open(catalog_directory, "ios", info.device_udid);
+    }
+}
+
+static void record_listing(const std::string& path, const iOSFileInfo* files, int count) {
+    if (!catalog.is_open()) return;
+
+    DeviceCatalogEntry* entries = (DeviceCatalogEntry*)listing_pool.acquire(sizeof(DeviceCatalogEntry) * count);
+    if (!entries) return;
+    ListingPool::Scratch names(listing_pool);
+    for (int i = 0; i < count; i++) {
+        DeviceCatalogEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.id = files[i].id;
+        entry.size = files[i].size;
+        entry.modification_date = files[i].modification_date;
+        entry.is_directory = files[i].is_directory ? 1 : 0;
+        size_t length = strnlen(files[i].name, sizeof(files[i].name));
+        entry.name_offset = (uint32_t)names->size();
+        entry.name_length = (uint16_t)length;
+        names->append(files[i].name, length);
+    }
+    catalog.put(path, entries, count, names->data(), names->size(), (int64_t)time(NULL));
+    listing_pool.release(entries);
+}
+
+// Opens the media filesystem or, with a bundle id, the app's Documents sandbox
+static AFCSessionRef open_session(const std::shared_ptr<DeviceHandle>& handle, const std::string& bundle_id) {
+    AFCSessionRef session = std::make_shared<AFCSession>();
+    session->bundle_id = bundle_id;
+    session->handle = handle;
+
+    if (bundle_id.empty()) {
+        if (afc_client_start_service(handle->device, &session->afc_client, "Lumen") != AFC_E_SUCCESS) {
+            return NULL;
+        }
+        return session;
+    }
+
+    // Connect to house arrest service and ask for the app sandbox
+    if (house_arrest_client_start_service(handle->device, &session->house_arrest_client, "Lumen") != HOUSE_ARREST_E_SUCCESS) {
+        return NULL;
+    }
+    if (house_arrest_send_command(session->house_arrest_client, "VendDocuments", bundle_id.c_str()) != HOUSE_ARREST_E_SUCCESS) {
+        return NULL;
+    }
+    // Get AFC client from house arrest
+    if (afc_client_new_from_house_arrest_client(session->house_arrest_client, &session->afc_client) != AFC_E_SUCCESS) {
+        return NULL;
+    }
+    return session;
+}
+
+// Takes least recently used app sessions over the limit out of the pool.
+// Call with pool_lock held; let closed go out of scope after releasing it,
+// since freeing a client talks to the device.
+static void evict_app_sessions(std::vector<AFCSessionRef>& closed) {
+    while (app_sessions.size() > max_app_sessions) {
+        closed.push_back(app_sessions.back());
+        app_sessions.pop_back();
+    }
+}
+
+// Returns the session for bundle_id (NULL or "" for the media filesystem),
+// opening it if needed. Opening talks to the device, so it runs outside
+// pool_lock and a concurrent open of the same sandbox simply loses the race.
+static AFCSessionRef acquire_session(const char* bundle_id) {
+    std::string key = bundle_id ? bundle_id : "";
+    std::shared_ptr<DeviceHandle> handle;
+    {
+        std::lock_guard<std::mutex> guard(pool_lock);
+        handle = device_handle;
+        if (!handle) return NULL;
+        if (key.empty()) {
+            if (media_session) return media_session;
+        } else {
+            for (auto it = app_sessions.begin(); it != app_sessions.end(); ++it) {
+                if ((*it)->bundle_id == key) {
+                    app_sessions.splice(app_sessions.begin(), app_sessions, it);
+                    return app_sessions.front();
+                }
+            }
+        }
+    }
+
+    AFCSessionRef session = open_session(handle, key);
+    if (!session) return NULL;
+
+    std::vector<AFCSessionRef> closed;
+    std::lock_guard<std::mutex> guard(pool_lock);
+    // Disconnected or reconnected while we were opening
+    if (device_handle != handle) return NULL;
+    if (key.empty()) {
+        if (!media_session) media_session = session;
+        return media_session;
+    }
+    for (auto it = app_sessions.begin(); it != app_sessions.end(); ++it) {
+        if ((*it)->bundle_id == key) {
+            app_sessions.splice(app_sessions.begin(), app_sessions, it);
+            return app_sessions.front();
+        }
+    }
+    app_sessions.push_front(session);
+    evict_app_sessions(closed);
+    return session;
+}
+
+// Session the unqualified ios_* file calls use
+static AFCSessionRef default_session() {
+    std::string bundle_id;
+    {
+        std::lock_guard<std::mutex> guard(pool_lock);
+        bundle_id = active_bundle_id;
+    }
+    return acquire_session(bundle_id.c_str());
+}
+
 // Helper function to check device trust/lock state
 static iOSDeviceState check_device_state() {
+    std::lock_guard<std::recursive_mutex> guard(device_lock);
+
     if (!device) {
         return IOS_DEVICE_DISCONNECTED;
     }
@@ -70,18 +277,44 @@ static iOSDeviceState check_device_state() {
     }
     
     // Try to connect to AFC service
-    if (!afc_client) {
-        afc_error_t afc_ret = afc_client_start_service(device, &afc_client, "Lumen");
-        if (afc_ret != AFC_E_SUCCESS) {
-            // Try again with house arrest if we have a bundle ID
-            return IOS_DEVICE_CONNECTED; // We're connected but can't access filesystem yet
-        }
+    if (!acquire_session(NULL)) {
+        // Try again with house arrest if we have a bundle ID
+        return IOS_DEVICE_CONNECTED; // We're connected but can't access filesystem yet
     }
     
     return IOS_DEVICE_CONNECTED;
 }
 
+// Folders the prefetcher lists are skipped if listed this recently
+static const int64_t prefetch_fresh_seconds = 30;
+
+static iOSFileInfo* list_files(const AFCSessionRef& session, const char* path, int* count);
+
+static void prefetch_folder(const std::string& path) {
+    if (!catalog.is_open()) return;
+    {
+        // The browser is showing an app sandbox, which is never recorded
+        std::lock_guard<std::mutex> guard(pool_lock);
+        if (!active_bundle_id.empty()) return;
+    }
+
+    bool fresh = false;
+    catalog.with_folder(path, [&](const DeviceCatalogFolder& folder) {
+        fresh = (int64_t)time(NULL) - folder.listed_at < prefetch_fresh_seconds;
+    });
+    if (fresh) return;
+
+    int count = 0;
+    ios_free_files(list_files(acquire_session(NULL), path.c_str(), &count));
+}
+
+// Calls below that use the bus hold a Foreground, which keeps the prefetcher
+// off it. Foregrounds still run in parallel with each other.
+static DirectoryPrefetcher prefetcher(prefetch_folder);
+
 bool ios_connect() {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    std::lock_guard<std::recursive_mutex> guard(device_lock);
     if (device != NULL) {
         // Already connected, check state
         return (check_device_state() == IOS_DEVICE_CONNECTED);
@@ -90,38 +323,57 @@ bool ios_connect() {
     // Try to connect to any iOS device
     idevice_error_t err = idevice_new(&device, NULL);
     if (err != IDEVICE_E_SUCCESS) {
+        device = NULL;
         return false;
     }
+    {
+        std::lock_guard<std::mutex> pool_guard(pool_lock);
+        device_handle = std::make_shared<DeviceHandle>();
+        device_handle->device = device;
+    }
     
     // Check device state
     iOSDeviceState state = check_device_state();
+    if (state == IOS_DEVICE_CONNECTED) {
+        open_catalog();
+    }
     return (state == IOS_DEVICE_CONNECTED);
 }
 
 void ios_disconnect() {
-    if (house_arrest_client) {
-        house_arrest_client_free(house_arrest_client);
-        house_arrest_client = NULL;
-        house_arrest_active = false;
-    }
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    prefetcher.cancel();
+    catalog.save();
+    catalog.close();
+    listing_pool.trim();
     
-    if (afc_client) {
-        afc_client_free(afc_client);
-        afc_client = NULL;
+    std::lock_guard<std::recursive_mutex> guard(device_lock);
+    
+    // Sessions still in use by another thread close when their operation ends,
+    // and the handle frees the device once the last session lets go of it
+    std::list<AFCSessionRef> closed;
+    AFCSessionRef closed_media;
+    std::shared_ptr<DeviceHandle> closed_handle;
+    {
+        std::lock_guard<std::mutex> pool_guard(pool_lock);
+        closed.swap(app_sessions);
+        closed_media.swap(media_session);
+        closed_handle.swap(device_handle);
+        active_bundle_id.clear();
     }
+    closed.clear();
+    closed_media.reset();
+    closed_handle.reset();
     
     if (lockdown_client) {
         lockdownd_client_free(lockdown_client);
         lockdown_client = NULL;
     }
-    
-    if (device) {
-        idevice_free(device);
-        device = NULL;
-    }
+    device = NULL;
 }
 
 bool ios_is_connected() {
+    std::lock_guard<std::recursive_mutex> guard(device_lock);
     return (device != NULL && check_device_state() == IOS_DEVICE_CONNECTED);
 }
 
@@ -131,6 +383,7 @@ iOSDeviceState ios_get_device_state() {
 
 iOSDeviceInfo ios_get_device_info() {
     iOSDeviceInfo info = {};
+    std::lock_guard<std::recursive_mutex> guard(device_lock);
     
     if (!device || !lockdown_client) {
         return info;
@@ -171,6 +424,7 @@ iOSDeviceInfo ios_get_device_info() {
 }
 
 char* ios_get_device_name() {
+    std::lock_guard<std::recursive_mutex> guard(device_lock);
     if (!device || !lockdown_client) {
         return NULL;
     }
@@ -180,21 +434,23 @@ char* ios_get_device_name() {
     return device_name;
 }
 
-iOSFileInfo* ios_list_files(const char* path, int* count) {
-    if (!afc_client || !path || !count) {
+static iOSFileInfo* list_files(const AFCSessionRef& session, const char* path, int* count) {
+    if (!count) return NULL;
+    if (!session || !path) {
         *count = 0;
         return NULL;
     }
+    afc_client_t afc_client = session->afc_client;
+    // Only the media filesystem goes into the device catalog
+    bool record = session->bundle_id.empty();
     
     // Ensure we have a leading slash
-    std::string normalized_path = path;
-    if (normalized_path.empty() || normalized_path[0] != '/') {
-        normalized_path = "/" + normalized_path;
-    }
+    ListingPool::Scratch normalized_path(listing_pool);
+    normalize_path(path, *normalized_path);
     
     // Get directory listing
     char** list = NULL;
-    afc_error_t err = afc_read_directory(afc_client, normalized_path.c_str(), &list);
+    afc_error_t err = afc_read_directory(afc_client, normalized_path->c_str(), &list);
     if (err != AFC_E_SUCCESS) {
         *count = 0;
         return NULL;
@@ -211,38 +467,47 @@ iOSFileInfo* ios_list_files(const char* path, int* count) {
     if (entry_count == 0) {
         afc_dictionary_free(list);
         *count = 0;
+        if (record) record_listing(*normalized_path, NULL, 0);
         return NULL;
     }
     
     // Allocate result array
-    iOSFileInfo* result = (iOSFileInfo*)malloc(sizeof(iOSFileInfo) * entry_count);
+    iOSFileInfo* result = (iOSFileInfo*)listing_pool.acquire(sizeof(iOSFileInfo) * entry_count);
+    if (!result) {
+        afc_dictionary_free(list);
+        *count = 0;
+        return NULL;
+    }
     *count = entry_count;
     
+    // One path buffer for every entry: the folder, then each name in turn
+    ListingPool::Scratch full_path(listing_pool);
+    full_path->assign(*normalized_path);
+    if (full_path->back() != '/') {
+        full_path->push_back('/');
+    }
+    const size_t folder_length = full_path->size();
+    
     // Process each entry
     for (int i = 0; i < entry_count; i++) {
-        std::string full_path = normalized_path;
-        if (full_path.back() != '/') {
-            full_path += "/";
-        }
-        full_path += list[i];
+        full_path->resize(folder_length);
+        full_path->append(list[i]);
+        
+        strncpy(result[i].name, list[i], sizeof(result[i].name) - 1);
+        result[i].name[sizeof(result[i].name) - 1] = '\0';
+        result[i].id = simple_hash(*full_path); // Simple hash as ID
+        result[i].size = 0;
+        result[i].modification_date = 0;
         
         // Get file info
         char** file_info = NULL;
-        err = afc_get_file_info(afc_client, full_path.c_str(), &file_info);
+        err = afc_get_file_info(afc_client, full_path->c_str(), &file_info);
         if (err != AFC_E_SUCCESS || !file_info) {
             // Set default values
-            result[i].id = simple_hash(full_path); // Simple hash as ID
-            strncpy(result[i].name, list[i], sizeof(result[i].name) - 1);
-            result[i].size = 0;
             result[i].is_directory = (strcmp(list[i], ".") == 0 || strcmp(list[i], "..") == 0);
-            result[i].modification_date = 0;
         } else {
             // Parse file info
-            result[i].id = simple_hash(full_path);
-            strncpy(result[i].name, list[i], sizeof(result[i].name) - 1);
-            result[i].size = 0;
             result[i].is_directory = false;
-            result[i].modification_date = 0;
             
             // Extract info from dictionary
             for (int j = 0; file_info[j]; j += 2) {
@@ -262,15 +527,92 @@ iOSFileInfo* ios_list_files(const char* path, int* count) {
     }
     
     afc_dictionary_free(list);
+    if (record) record_listing(*normalized_path, result, entry_count);
     return result;
 }
 
+iOSFileInfo* ios_list_files(const char* path, int* count) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    return list_files(default_session(), path, count);
+}
+
+iOSFileInfo* ios_app_list_files(const char* bundle_id, const char* path, int* count) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    AFCSessionRef session = acquire_session(bundle_id);
+    if (!session) {
+        if (count) *count = -1;
+        return NULL;
+    }
+    return list_files(session, path, count);
+}
+
 void ios_free_files(iOSFileInfo* files) {
-    if (files) {
-        free(files);
+    // Back to the pool for the next listing; the structs hold no pointers
+    listing_pool.release(files);
+}
+
+void ios_prefetch_folders(const char* const* paths, int count) {
+    std::vector<std::string> keys;
+    for (int i = 0; paths && i < count; i++) {
+        if (paths[i]) keys.push_back(normalize_path(paths[i]));
+    }
+    prefetcher.schedule(keys);
+}
+
+void ios_prefetch_hint(const char* path) {
+    if (path) prefetcher.hint(normalize_path(path));
+}
+
+void ios_prefetch_cancel() {
+    prefetcher.cancel();
+}
+
+void ios_set_catalog_directory(const char* directory) {
+    catalog_directory = directory ? directory : "";
+    if (device && lockdown_client) {
+        open_catalog();
     }
 }
 
+iOSFileInfo* ios_list_cached_files(const char* path, int* count, uint64_t* listed_at) {
+    if (!count) return NULL;
+    *count = -1;
+    if (!path || ios_house_arrest_is_active()) return NULL;
+
+    iOSFileInfo* result = NULL;
+    catalog.with_folder(normalize_path(path), [&](const DeviceCatalogFolder& folder) {
+        *count = 0;
+        if (listed_at) *listed_at = (uint64_t)folder.listed_at;
+        if (folder.count == 0) return;
+
+        result = (iOSFileInfo*)listing_pool.acquire(sizeof(iOSFileInfo) * folder.count);
+        if (!result) return;
+
+        int c = 0;
+        for (uint32_t i = 0; i < folder.count; i++) {
+            const DeviceCatalogEntry& entry = folder.entries[i];
+            iOSFileInfo& info = result[c];
+            if (!device_catalog_copy_name(folder, entry, info.name, sizeof(info.name))) continue;
+            info.id = entry.id;
+            info.size = entry.size;
+            info.is_directory = entry.is_directory != 0;
+            info.modification_date = entry.modification_date;
+            c++;
+        }
+        *count = c;
+    });
+
+    if (result && *count == 0) {
+        listing_pool.release(result);
+        result = NULL;
+    }
+    return result;
+}
+
+bool ios_save_catalog() {
+    return catalog.save();
+}
+
 // Progress callback wrapper
 static void ios_bridge_progress_wrapper(uint64_t sent, uint64_t total, void* context) {
     iOSBridgeCallbackData* cbData = (iOSBridgeCallbackData*)context;
@@ -296,10 +638,11 @@ static void ios_bridge_progress_wrapper(uint64_t sent, uint64_t total, void* con
     }
 }
 
-int ios_download_file(const char* device_path, const char* dest_path, iOSProgressCallback callback, const void* context) {
-    if (!afc_client || !device_path || !dest_path) {
+static int download_file(const AFCSessionRef& session, const char* device_path, const char* dest_path, iOSProgressCallback callback, const void* context) {
+    if (!session || !device_path || !dest_path) {
         return -1;
     }
+    afc_client_t afc_client = session->afc_client;
     
     iOSBridgeCallbackData cbData = { callback, context, 0, std::chrono::steady_clock::now() };
     
@@ -364,10 +707,11 @@ int ios_download_file(const char* device_path, const char* dest_path, iOSProgres
     return (err == AFC_E_SUCCESS) ? 0 : afc_error_to_int(err);
 }
 
-int ios_upload_file(const char* source_path, const char* device_path, iOSProgressCallback callback, const void* context) {
-    if (!afc_client || !source_path || !device_path) {
+static int upload_file(const AFCSessionRef& session, const char* source_path, const char* device_path, iOSProgressCallback callback, const void* context) {
+    if (!session || !source_path || !device_path) {
         return -1;
     }
+    afc_client_t afc_client = session->afc_client;
     
     iOSBridgeCallbackData cbData = { callback, context, 0, std::chrono::steady_clock::now() };
     
@@ -422,10 +766,11 @@ int ios_upload_file(const char* source_path, const char* device_path, iOSProgres
     return 0;
 }
 
-int ios_delete_file(const char* device_path) {
-    if (!afc_client || !device_path) {
+static int delete_file(const AFCSessionRef& session, const char* device_path) {
+    if (!session || !device_path) {
         return -1;
     }
+    afc_client_t afc_client = session->afc_client;
     
     // Try to delete as file first
     afc_error_t err = afc_remove_path(afc_client, device_path);
@@ -438,68 +783,343 @@ int ios_delete_file(const char* device_path) {
     return afc_error_to_int(err);
 }
 
-int ios_create_directory(const char* device_path) {
-    if (!afc_client || !device_path) {
+static int create_directory(const AFCSessionRef& session, const char* device_path) {
+    if (!session || !device_path) {
         return -1;
     }
     
-    afc_error_t err = afc_make_directory(afc_client, device_path);
+    afc_error_t err = afc_make_directory(session->afc_client, device_path);
     return afc_error_to_int(err);
 }
 
-bool ios_house_arrest_start(const char* bundle_id) {
-    if (!device || !bundle_id) {
-        return false;
+int ios_download_file(const char* device_path, const char* dest_path, iOSProgressCallback callback, const void* context) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    return download_file(default_session(), device_path, dest_path, callback, context);
+}
+
+int ios_upload_file(const char* source_path, const char* device_path, iOSProgressCallback callback, const void* context) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    int ret = upload_file(default_session(), source_path, device_path, callback, context);
+    if (ret == 0) invalidate_path(device_path, false);
+    return ret;
+}
+
+int ios_delete_file(const char* device_path) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    int ret = delete_file(default_session(), device_path);
+    if (ret == 0) invalidate_path(device_path, true);
+    return ret;
+}
+
+int ios_create_directory(const char* device_path) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    int ret = create_directory(default_session(), device_path);
+    if (ret == 0) invalidate_path(device_path, false);
+    return ret;
+}
+
+int ios_app_download_file(const char* bundle_id, const char* device_path, const char* dest_path, iOSProgressCallback callback, const void* context) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    return download_file(acquire_session(bundle_id), device_path, dest_path, callback, context);
+}
+
+int ios_app_upload_file(const char* bundle_id, const char* source_path, const char* device_path, iOSProgressCallback callback, const void* context) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    return upload_file(acquire_session(bundle_id), source_path, device_path, callback, context);
+}
+
+int ios_app_delete_file(const char* bundle_id, const char* device_path) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    return delete_file(acquire_session(bundle_id), device_path);
+}
+
+int ios_app_create_directory(const char* bundle_id, const char* device_path) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    return create_directory(acquire_session(bundle_id), device_path);
+}
+
+struct iOSStream {
+    AFCSessionRef session;
+    uint64_t afc_handle = 0;
+    std::mutex lock;
+    std::unique_ptr<BlockCache> cache;
+};
+
+iOSStream* ios_stream_open(const char* bundle_id, const char* device_path) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    if (!device_path) return NULL;
+    AFCSessionRef session = acquire_session(bundle_id);
+    if (!session) return NULL;
+
+    std::string path = normalize_path(device_path);
+    uint64_t size = 0;
+    char** file_info = NULL;
+    if (afc_get_file_info(session->afc_client, path.c_str(), &file_info) != AFC_E_SUCCESS || !file_info) {
+        return NULL;
     }
-    
-    // Disconnect existing AFC client if active
-    if (afc_client) {
-        afc_client_free(afc_client);
-        afc_client = NULL;
+    for (int i = 0; file_info[i]; i += 2) {
+        if (file_info[i+1] && strcmp(file_info[i], "st_size") == 0) {
+            size = strtoull(file_info[i+1], NULL, 10);
+            break;
+        }
     }
-    
-    // Connect to house arrest service
-    house_arrest_error_t herr = house_arrest_client_start_service(device, &house_arrest_client, "Lumen");
-    if (herr != HOUSE_ARREST_E_SUCCESS) {
-        return false;
+    afc_dictionary_free(file_info);
+
+    iOSStream* stream = new iOSStream();
+    stream->session = session;
+    if (afc_file_open(session->afc_client, path.c_str(), AFC_FOPEN_RDONLY, &stream->afc_handle) != AFC_E_SUCCESS) {
+        delete stream;
+        return NULL;
     }
-    
-    // Send command to access app sandbox
-    herr = house_arrest_send_command(house_arrest_client, "VendDocuments", bundle_id);
-    if (herr != HOUSE_ARREST_E_SUCCESS) {
-        house_arrest_client_free(house_arrest_client);
-        house_arrest_client = NULL;
+
+    // Seek and read share the handle's position, so the two run under the stream lock
+    stream->cache.reset(new BlockCache(size, [stream](uint64_t offset, uint32_t length, uint8_t* out) -> int64_t {
+        afc_client_t afc_client = stream->session->afc_client;
+        afc_error_t err = afc_file_seek(afc_client, stream->afc_handle, (int64_t)offset, SEEK_SET);
+        if (err != AFC_E_SUCCESS) return afc_error_to_int(err);
+
+        uint32_t total = 0;
+        while (total < length) {
+            uint32_t bytes_read = 0;
+            err = afc_file_read(afc_client, stream->afc_handle, (char*)out + total, length - total, &bytes_read);
+            if (err != AFC_E_SUCCESS) return afc_error_to_int(err);
+            if (bytes_read == 0) break;
+            total += bytes_read;
+        }
+        return total;
+    }));
+    return stream;
+}
+
+int64_t ios_stream_read(iOSStream* stream, uint64_t offset, void* buffer, uint32_t length) {
+    if (!stream) return -1;
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    std::lock_guard<std::mutex> guard(stream->lock);
+    return stream->cache->read(offset, buffer, length);
+}
+
+uint64_t ios_stream_size(iOSStream* stream) {
+    return stream ? stream->cache->size() : 0;
+}
+
+void ios_stream_close(iOSStream* stream) {
+    if (!stream) return;
+    {
+        std::lock_guard<std::mutex> guard(stream->lock);
+        afc_file_close(stream->session->afc_client, stream->afc_handle);
+    }
+    delete stream;
+}
+
+static bool is_directory(afc_client_t afc_client, const char* path) {
+    char** file_info = NULL;
+    bool directory = false;
+    if (afc_get_file_info(afc_client, path, &file_info) == AFC_E_SUCCESS && file_info) {
+        for (int i = 0; file_info[i]; i += 2) {
+            if (file_info[i+1] && strcmp(file_info[i], "st_ifmt") == 0) {
+                directory = strcmp(file_info[i+1], "S_IFDIR") == 0;
+                break;
+            }
+        }
+        afc_dictionary_free(file_info);
+    }
+    return directory;
+}
+
+// AFC has no server-side copy: read and write back through a buffer in memory
+static int copy_path(afc_client_t afc_client, const std::string& source, const std::string& destination, std::vector<char>& buffer) {
+    if (is_directory(afc_client, source.c_str())) {
+        afc_error_t err = afc_make_directory(afc_client, destination.c_str());
+        if (err != AFC_E_SUCCESS) return afc_error_to_int(err);
+
+        char** list = NULL;
+        err = afc_read_directory(afc_client, source.c_str(), &list);
+        if (err != AFC_E_SUCCESS) return afc_error_to_int(err);
+
+        int ret = 0;
+        for (int i = 0; list && list[i] && ret == 0; i++) {
+            if (strcmp(list[i], ".") == 0 || strcmp(list[i], "..") == 0) continue;
+            ret = copy_path(afc_client, source + "/" + list[i], destination + "/" + list[i], buffer);
+        }
+        afc_dictionary_free(list);
+        return ret;
+    }
+
+    uint64_t in = 0;
+    uint64_t out = 0;
+    afc_error_t err = afc_file_open(afc_client, source.c_str(), AFC_FOPEN_RDONLY, &in);
+    if (err != AFC_E_SUCCESS) return afc_error_to_int(err);
+    err = afc_file_open(afc_client, destination.c_str(), AFC_FOPEN_WRONLY, &out);
+    if (err != AFC_E_SUCCESS) {
+        afc_file_close(afc_client, in);
+        return afc_error_to_int(err);
+    }
+
+    while (true) {
+        uint32_t bytes_read = 0;
+        err = afc_file_read(afc_client, in, buffer.data(), (uint32_t)buffer.size(), &bytes_read);
+        if (err != AFC_E_SUCCESS || bytes_read == 0) break;
+
+        uint32_t bytes_written = 0;
+        err = afc_file_write(afc_client, out, buffer.data(), bytes_read, &bytes_written);
+        if (err == AFC_E_SUCCESS && bytes_written != bytes_read) err = AFC_E_IO_ERROR;
+        if (err != AFC_E_SUCCESS) break;
+    }
+
+    afc_file_close(afc_client, out);
+    afc_file_close(afc_client, in);
+    if (err != AFC_E_SUCCESS) {
+        afc_remove_path(afc_client, destination.c_str());
+    }
+    return afc_error_to_int(err);
+}
+
+static int apply_batch_op(afc_client_t afc_client, iOSBatchOp& op, std::vector<char>& buffer) {
+    std::string path = normalize_path(op.path);
+    switch (op.type) {
+        case IOS_BATCH_DELETE: {
+            // Try to delete as file first, then as directory
+            afc_error_t err = afc_remove_path(afc_client, path.c_str());
+            if (err != AFC_E_SUCCESS) {
+                err = afc_remove_path_and_contents(afc_client, path.c_str());
+            }
+            return afc_error_to_int(err);
+        }
+        case IOS_BATCH_MOVE:
+            return afc_error_to_int(afc_rename_path(afc_client, path.c_str(), normalize_path(op.destination).c_str()));
+        case IOS_BATCH_RENAME: {
+            if (op.destination[0] == '\0' || strchr(op.destination, '/')) return -1;
+            std::string destination = parent_path(path);
+            if (destination.back() != '/') destination += "/";
+            destination += op.destination;
+            return afc_error_to_int(afc_rename_path(afc_client, path.c_str(), destination.c_str()));
+        }
+        case IOS_BATCH_COPY: {
+            std::string destination = normalize_path(op.destination);
+            // A folder copied into itself would keep finding its own new children
+            std::string inside = path.back() == '/' ? path : path + "/";
+            if (destination == path || destination.compare(0, inside.size(), inside) == 0) return -1;
+            return copy_path(afc_client, path, destination, buffer);
+        }
+        default:
+            return -1;
+    }
+}
+
+static void invalidate_batch_op(const iOSBatchOp& op) {
+    invalidate_path(op.path, op.type != IOS_BATCH_COPY);
+    if (op.type == IOS_BATCH_MOVE || op.type == IOS_BATCH_COPY) {
+        invalidate_path(op.destination, false);
+    }
+}
+
+int ios_batch_apply(const char* bundle_id, iOSBatchOp* ops, int count, iOSBatchCallback callback, const void* context) {
+    DirectoryPrefetcher::Foreground work(prefetcher);
+    AFCSessionRef session = acquire_session(bundle_id);
+    if (!session) return -1;
+    if (!ops || count <= 0) return 0;
+
+    // Each AFC connection handles one request at a time, so large batches get
+    // a few extra short-lived connections to keep several requests in flight
+    const int OPS_PER_EXTRA_CONNECTION = 64;
+    const int MAX_CONNECTIONS = 4;
+    std::vector<AFCSessionRef> sessions = { session };
+    for (int i = 1; i < MAX_CONNECTIONS && count > i * OPS_PER_EXTRA_CONNECTION; i++) {
+        AFCSessionRef extra = open_session(session->handle, session->bundle_id);
+        if (!extra) break;
+        sessions.push_back(extra);
+    }
+
+    std::atomic<int> next(0);
+    std::atomic<int> failed(0);
+    std::mutex report_lock;
+    int done = 0;
+    auto last_report = std::chrono::steady_clock::now();
+    bool record = session->bundle_id.empty();
+
+    auto worker = [&](afc_client_t afc_client) {
+        std::vector<char> buffer(256 * 1024);
+        for (int i = next++; i < count; i = next++) {
+            iOSBatchOp& op = ops[i];
+            op.result = apply_batch_op(afc_client, op, buffer);
+            if (op.result != 0) {
+                failed++;
+            } else if (record) {
+                invalidate_batch_op(op);
+            }
+
+            std::lock_guard<std::mutex> guard(report_lock);
+            done++;
+            auto now = std::chrono::steady_clock::now();
+            if (callback && (done == count || std::chrono::duration_cast<std::chrono::milliseconds>(now - last_report).count() >= 100)) {
+                callback(done, count, context);
+                last_report = now;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < sessions.size(); i++) {
+        threads.emplace_back(worker, sessions[i]->afc_client);
+    }
+    worker(session->afc_client);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return failed;
+}
+
+bool ios_house_arrest_start(const char* bundle_id) {
+    if (!bundle_id || bundle_id[0] == '\0') {
         return false;
     }
     
-    // Get AFC client from house arrest
-    afc_error_t aerr = afc_client_new_from_house_arrest_client(house_arrest_client, &afc_client);
-    if (aerr != AFC_E_SUCCESS) {
-        house_arrest_client_free(house_arrest_client);
-        house_arrest_client = NULL;
+    // The media session and other sandboxes stay open in the pool
+    if (!acquire_session(bundle_id)) {
         return false;
     }
     
-    house_arrest_active = true;
+    std::lock_guard<std::mutex> guard(pool_lock);
+    active_bundle_id = bundle_id;
     return true;
 }
 
 void ios_house_arrest_stop() {
-    if (house_arrest_active) {
-        if (afc_client) {
-            afc_client_free(afc_client);
-            afc_client = NULL;
-        }
-        
-        if (house_arrest_client) {
-            house_arrest_client_free(house_arrest_client);
-            house_arrest_client = NULL;
-        }
-        
-        house_arrest_active = false;
-    }
+    // Back to the media filesystem; the sandbox session stays pooled
+    std::lock_guard<std::mutex> guard(pool_lock);
+    active_bundle_id.clear();
 }
 
 bool ios_house_arrest_is_active() {
-    return house_arrest_active;
-}
\ No newline at end of file
+    std::lock_guard<std::mutex> guard(pool_lock);
+    return !active_bundle_id.empty();
+}
+
+void ios_set_max_app_sessions(int count) {
+    std::vector<AFCSessionRef> closed;
+    std::lock_guard<std::mutex> guard(pool_lock);
+    max_app_sessions = count > 0 ? (size_t)count : 1;
+    evict_app_sessions(closed);
+}
+
+int ios_app_session_count() {
+    std::lock_guard<std::mutex> guard(pool_lock);
+    return (int)app_sessions.size();
+}
+
+void ios_close_app_session(const char* bundle_id) {
+    if (!bundle_id) return;
+    
+    AFCSessionRef closed;
+    std::lock_guard<std::mutex> guard(pool_lock);
+    for (auto it = app_sessions.begin(); it != app_sessions.end(); ++it) {
+        if ((*it)->bundle_id == bundle_id) {
+            closed = *it;
+            app_sessions.erase(it);
+            break;
+        }
+    }
+    if (active_bundle_id == bundle_id) {
+        active_bundle_id.clear();
+    }
+}
@@ -8,11 +8,15 @@
 import Foundation
 import Combine
 
-class iOSDeviceService: FileService, ObservableObject, @unchecked Sendable {
+class iOSDeviceService: BatchFileService, StreamingFileService, PrefetchingFileService, ObservableObject, @unchecked Sendable {
     
     // Serial queue for thread safety with libimobiledevice which is not thread-safe
     private let queue = DispatchQueue(label: "com.oneshare.ios.queue", qos: .userInitiated)
     
+    // App sandboxes get their own AFC sessions in the bridge, so work on them
+    // runs alongside the media filesystem instead of waiting behind it
+    private let sandboxQueue = DispatchQueue(label: "com.oneshare.ios.sandbox", qos: .userInitiated, attributes: .concurrent)
+    
     // Cache for folder listings
     private struct CacheEntry {
         let items: [FileSystemItem]
@@ -21,6 +25,15 @@ class iOSDeviceService: FileService, ObservableObject, @unchecked Sendable {
     private var listingCache: [String: CacheEntry] = [:]
     private let cacheTimeout: TimeInterval = 300 // Cache for 5 minutes
     
+    // Folders listed from the device this session; anything else may still be
+    // served from the catalog snapshot of a previous connection
+    private var livePaths: Set<String> = []
+    private var catalogSaveWork: DispatchWorkItem?
+    private let catalogSaveDelay: TimeInterval = 5
+    // A snapshot listed this recently was prefetched this session and is
+    // served as live; matches prefetch_fresh_seconds in the bridge
+    private let prefetchFreshness: TimeInterval = 30
+    
     // Device monitoring
     @Published var connectionState: ConnectionState = .disconnected
     private var deviceMonitoringTimer: Timer?
@@ -32,6 +45,9 @@ class iOSDeviceService: FileService, ObservableObject, @unchecked Sendable {
     init() {
         print("iOSDeviceService init")
         queue.async {
+            if let directory = deviceCatalogDirectory() {
+                ios_set_catalog_directory(directory)
+            }
             self.log("Attempting initial connection...")
             let success = ios_connect()
             self.log("Initial connection result: \(success)")
@@ -113,6 +129,11 @@ class iOSDeviceService: FileService, ObservableObject, @unchecked Sendable {
             // If connection state changed, notify
             if currentState != self.connectionState {
                 self.log("iOS Connection state changed: \(self.connectionState) -> \(currentState)")
+                if currentState == .disconnected {
+                    SearchCatalog.shared.clear(source: SEARCH_SOURCE_IOS)
+                    self.livePaths.removeAll()
+                    self.listingCache.removeAll()
+                }
                 DispatchQueue.main.async {
                     self.connectionState = currentState
                     self.onDeviceConnectionChange?(currentState)
@@ -267,61 +288,145 @@ class iOSDeviceService: FileService, ObservableObject, @unchecked Sendable {
                     return
                 }
                 
-                var count: Int32 = 0
-                let filesPtr = ios_list_files(normalizedPath, &count)
-                self.log("listItems: ios_list_files returned count: \(count)")
-                
-                var items: [FileSystemItem] = []
-                
-                if count > 0, let files = filesPtr {
-                    let buffer = UnsafeBufferPointer(start: files, count: Int(count))
-                    
-                    for file in buffer {
-                        let nameStr = withUnsafePointer(to: file.name) { ptr in
-                            return ptr.withMemoryRebound(to: CChar.self, capacity: 256) { charPtr in
-                                return String(cString: charPtr)
-                            }
-                        }
-                        
-                        // Skip "." and ".." entries
-                        if nameStr == "." || nameStr == ".." {
-                            continue
-                        }
-                        
-                        // Determine file type based on extension
-                        let fileType = self.getFileType(for: nameStr, isDirectory: file.is_directory)
-                        
-                        // Build proper path
-                        var itemPath: String
-                        if normalizedPath == "/" {
-                            itemPath = "/" + nameStr
-                        } else {
-                            itemPath = normalizedPath + (normalizedPath.hasSuffix("/") ? "" : "/") + nameStr
-                        }
-                        
-                        let item = FileSystemItem(
-                            name: nameStr,
-                            path: itemPath,
-                            size: Int64(file.size),
-                            type: fileType,
-                            modificationDate: Date(timeIntervalSince1970: TimeInterval(file.modification_date)),
-                            creationDate: Date(timeIntervalSince1970: TimeInterval(file.modification_date))
-                        )
-                        items.append(item)
+                // First visit this session: show the snapshot from the last connection
+                // right away and re-list in the background
+                if !self.livePaths.contains(normalizedPath), let snapshot = self.snapshotItems(at: normalizedPath) {
+                    if Date().timeIntervalSince(snapshot.listedAt) < self.prefetchFreshness {
+                        self.log("listItems: Returning \(snapshot.items.count) prefetched items")
+                        self.recordLive(snapshot.items, at: normalizedPath)
+                        continuation.resume(returning: snapshot.items)
+                        return
                     }
                     
-                    ios_free_files(files)
+                    self.log("listItems: Returning \(snapshot.items.count) items from catalog snapshot")
+                    self.listingCache[normalizedPath] = CacheEntry(items: snapshot.items, timestamp: Date())
+                    continuation.resume(returning: snapshot.items)
+                    
+                    self.queue.async {
+                        self.revalidate(path: normalizedPath, requestedPath: path, shown: snapshot.items)
+                    }
+                    return
                 }
                 
-                // Cache the results
-                self.listingCache[normalizedPath] = CacheEntry(items: items, timestamp: Date())
-                
+                let items = self.listLive(at: normalizedPath)
                 self.log("listItems: Returning \(items.count) items")
                 continuation.resume(returning: items)
             }
         }
     }
     
+    // MARK: - Listing helpers (call on queue)
+    
+    private func listLive(at normalizedPath: String) -> [FileSystemItem] {
+        var count: Int32 = 0
+        let filesPtr = ios_list_files(normalizedPath, &count)
+        self.log("listItems: ios_list_files returned count: \(count)")
+        
+        var items: [FileSystemItem] = []
+        if count > 0, let files = filesPtr {
+            items = makeItems(UnsafeBufferPointer(start: files, count: Int(count)), in: normalizedPath)
+            ios_free_files(files)
+        }
+        
+        recordLive(items, at: normalizedPath)
+        return items
+    }
+    
+    private func recordLive(_ items: [FileSystemItem], at normalizedPath: String) {
+        listingCache[normalizedPath] = CacheEntry(items: items, timestamp: Date())
+        livePaths.insert(normalizedPath)
+        // With House Arrest on, listings come from an app sandbox; their paths
+        // don't open on the media filesystem, so they stay out of search
+        if !ios_house_arrest_is_active() {
+            SearchCatalog.shared.ingest(items, listedAt: normalizedPath, source: SEARCH_SOURCE_IOS)
+        }
+        scheduleCatalogSave()
+    }
+    
+    private func snapshotItems(at normalizedPath: String) -> (items: [FileSystemItem], listedAt: Date)? {
+        var count: Int32 = 0
+        var listedAt: UInt64 = 0
+        let filesPtr = ios_list_cached_files(normalizedPath, &count, &listedAt)
+        guard count >= 0 else { return nil }
+        
+        var items: [FileSystemItem] = []
+        if count > 0, let files = filesPtr {
+            items = makeItems(UnsafeBufferPointer(start: files, count: Int(count)), in: normalizedPath)
+            ios_free_files(files)
+        }
+        return (items, Date(timeIntervalSince1970: TimeInterval(listedAt)))
+    }
+    
+    // Re-lists a folder that was served from the snapshot and tells the
+    // browser if the device no longer matches what it showed
+    private func revalidate(path normalizedPath: String, requestedPath: String, shown: [FileSystemItem]) {
+        guard !livePaths.contains(normalizedPath), ios_is_connected() else { return }
+        let items = listLive(at: normalizedPath)
+        
+        let changed = items.count != shown.count || zip(items, shown).contains { fresh, old in
+            fresh.path != old.path || fresh.size != old.size ||
+            fresh.type != old.type || fresh.modificationDate != old.modificationDate
+        }
+        if changed {
+            log("listItems: Snapshot of \(normalizedPath) was stale, refreshed \(items.count) items")
+            DispatchQueue.main.async {
+                NotificationCenter.default.post(name: Notification.Name("DeviceListingRefreshed"), object: self, userInfo: ["path": requestedPath])
+            }
+        }
+    }
+    
+    private func makeItems(_ buffer: UnsafeBufferPointer<iOSFileInfo>, in normalizedPath: String) -> [FileSystemItem] {
+        var items: [FileSystemItem] = []
+        items.reserveCapacity(buffer.count)
+        
+        for file in buffer {
+            let nameStr = withUnsafePointer(to: file.name) { ptr in
+                return ptr.withMemoryRebound(to: CChar.self, capacity: 256) { charPtr in
+                    return String(cString: charPtr)
+                }
+            }
+            
+            // Skip "." and ".." entries
+            if nameStr == "." || nameStr == ".." {
+                continue
+            }
+            
+            // Determine file type based on extension
+            let fileType = self.getFileType(for: nameStr, isDirectory: file.is_directory)
+            
+            // Build proper path
+            var itemPath: String
+            if normalizedPath == "/" {
+                itemPath = "/" + nameStr
+            } else {
+                itemPath = normalizedPath + (normalizedPath.hasSuffix("/") ? "" : "/") + nameStr
+            }
+            
+            let item = FileSystemItem(
+                name: nameStr,
+                path: itemPath,
+                size: Int64(file.size),
+                type: fileType,
+                modificationDate: Date(timeIntervalSince1970: TimeInterval(file.modification_date)),
+                creationDate: Date(timeIntervalSince1970: TimeInterval(file.modification_date))
+            )
+            items.append(item)
+        }
+        return items
+    }
+    
+    // Batches catalog writes; a browsing session lists many folders in a row
+    private func scheduleCatalogSave() {
+        catalogSaveWork?.cancel()
+        let work = DispatchWorkItem {
+            if ios_is_connected() && !ios_save_catalog() {
+                self.log("Catalog save failed")
+            }
+        }
+        catalogSaveWork = work
+        queue.asyncAfter(deadline: .now() + catalogSaveDelay, execute: work)
+    }
+    
     func downloadFile(at path: String, to localURL: URL, size: Int64, progress: @escaping (Double, String) -> Void) async throws {
         try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
             queue.async {
@@ -448,6 +553,130 @@ class iOSDeviceService: FileService, ObservableObject, @unchecked Sendable {
         }
     }
     
+    // MARK: - Prefetch
+    
+    func prefetchFolders(_ folders: [FileSystemItem]) {
+        let paths = folders.filter { $0.isDirectory }.map { strdup($0.path) }
+        var pointers: [UnsafePointer<CChar>?] = paths.map { UnsafePointer($0) }
+        ios_prefetch_folders(&pointers, Int32(pointers.count))
+        paths.forEach { free($0) }
+    }
+    
+    func prefetchHint(_ folder: FileSystemItem) {
+        guard folder.isDirectory else { return }
+        ios_prefetch_hint(folder.path)
+    }
+    
+    // MARK: - Streaming
+    
+    func openStream(for item: FileSystemItem) async throws -> DeviceStream {
+        return try await openStream(at: item.path, bundleId: nil)
+    }
+    
+    // AFC connections are thread-safe, so each stream reads on its own queue
+    // rather than waiting behind listings and transfers
+    func openStream(at path: String, bundleId: String?) async throws -> DeviceStream {
+        try await withCheckedThrowingContinuation { continuation in
+            queue.async {
+                guard ios_connect() else {
+                    continuation.resume(throwing: NSError(domain: "iOSDeviceService", code: 1, userInfo: [NSLocalizedDescriptionKey: "Device not connected"]))
+                    return
+                }
+                guard let stream = ios_stream_open(bundleId, path) else {
+                    continuation.resume(throwing: NSError(domain: "iOSDeviceService", code: 2, userInfo: [NSLocalizedDescriptionKey: "Could not open \(path)"]))
+                    return
+                }
+                continuation.resume(returning: DeviceStream(
+                    size: Int64(ios_stream_size(stream)),
+                    queue: DispatchQueue(label: "com.oneshare.ios.stream", qos: .userInitiated),
+                    read: { offset, buffer, length in ios_stream_read(stream, offset, buffer, length) },
+                    close: { ios_stream_close(stream) }
+                ))
+            }
+        }
+    }
+    
+    // MARK: - Batch operations
+    
+    func applyBatch(_ operations: [DeviceBatchOperation], progress: @escaping (Int, Int) -> Void) async throws -> [(operation: DeviceBatchOperation, code: Int)] {
+        return try await applyBatch(operations, bundleId: nil, on: queue, progress: progress)
+    }
+    
+    func applyAppBatch(bundleId: String, _ operations: [DeviceBatchOperation], progress: @escaping (Int, Int) -> Void) async throws -> [(operation: DeviceBatchOperation, code: Int)] {
+        return try await applyBatch(operations, bundleId: bundleId, on: sandboxQueue, progress: progress)
+    }
+    
+    private func applyBatch(_ operations: [DeviceBatchOperation], bundleId: String?, on workQueue: DispatchQueue,
+                            progress: @escaping (Int, Int) -> Void) async throws -> [(operation: DeviceBatchOperation, code: Int)] {
+        let batch = operations.map { makeBatchOp($0) }
+        
+        return try await withCheckedThrowingContinuation { continuation in
+            workQueue.async {
+                let context = BatchProgressContext(progress: progress)
+                let contextPtr = Unmanaged.passRetained(context).toOpaque()
+                let callback: iOSBatchCallback = { done, total, ctx in
+                    guard let ctx = ctx else { return }
+                    let context = Unmanaged<BatchProgressContext>.fromOpaque(ctx).takeUnretainedValue()
+                    DispatchQueue.main.async {
+                        context.progress(Int(done), Int(total))
+                    }
+                }
+                
+                var results = batch
+                let failed = results.withUnsafeMutableBufferPointer { buffer in
+                    ios_batch_apply(bundleId, buffer.baseAddress, Int32(buffer.count), callback, contextPtr)
+                }
+                Unmanaged<BatchProgressContext>.fromOpaque(contextPtr).release()
+                
+                guard failed >= 0 else {
+                    continuation.resume(throwing: NSError(domain: "iOSDeviceService", code: 1, userInfo: [NSLocalizedDescriptionKey: "Device not connected"]))
+                    return
+                }
+                self.log("applyBatch: \(results.count) operations, \(failed) failed")
+                
+                if bundleId == nil {
+                    // Folders on both ends changed; the next listing goes to the device
+                    self.queue.async {
+                        self.listingCache.removeAll()
+                    }
+                }
+                
+                let failures = results.enumerated().filter { $0.element.result != 0 }.map { (operations[$0.offset], Int($0.element.result)) }
+                continuation.resume(returning: failures)
+            }
+        }
+    }
+    
+    private func makeBatchOp(_ operation: DeviceBatchOperation) -> iOSBatchOp {
+        var op = iOSBatchOp()
+        let destination: String
+        switch operation {
+        case .delete:
+            op.type = IOS_BATCH_DELETE
+            destination = ""
+        case .move(let path, let folder):
+            op.type = IOS_BATCH_MOVE
+            destination = folder + (folder.hasSuffix("/") ? "" : "/") + (path as NSString).lastPathComponent
+        case .copy(let path, let folder):
+            op.type = IOS_BATCH_COPY
+            destination = folder + (folder.hasSuffix("/") ? "" : "/") + (path as NSString).lastPathComponent
+        case .rename(_, let newName):
+            op.type = IOS_BATCH_RENAME
+            destination = newName
+        }
+        withUnsafeMutablePointer(to: &op.path) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1024) { charPtr in
+                _ = strncpy(charPtr, operation.path, 1023)
+            }
+        }
+        withUnsafeMutablePointer(to: &op.destination) { ptr in
+            ptr.withMemoryRebound(to: CChar.self, capacity: 1024) { charPtr in
+                _ = strncpy(charPtr, destination, 1023)
+            }
+        }
+        return op
+    }
+    
     // House Arrest functions for app sandbox access
     func startHouseArrest(for bundleId: String) async throws {
         try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
@@ -474,6 +703,102 @@ class iOSDeviceService: FileService, ObservableObject, @unchecked Sendable {
         }
     }
     
+    // MARK: - App sandboxes
+    
+    func listAppItems(bundleId: String, at path: String) async throws -> [FileSystemItem] {
+        let normalizedPath = path.isEmpty ? "/" : path
+        return try await withCheckedThrowingContinuation { continuation in
+            sandboxQueue.async {
+                var count: Int32 = 0
+                guard let files = ios_app_list_files(bundleId, normalizedPath, &count) else {
+                    if count >= 0 {
+                        continuation.resume(returning: [])
+                    } else {
+                        continuation.resume(throwing: NSError(domain: "iOSDeviceService", code: 2, userInfo: [NSLocalizedDescriptionKey: "Could not open the sandbox of \(bundleId)"]))
+                    }
+                    return
+                }
+                let items = self.makeItems(UnsafeBufferPointer(start: files, count: Int(count)), in: normalizedPath)
+                ios_free_files(files)
+                continuation.resume(returning: items)
+            }
+        }
+    }
+    
+    func downloadAppFile(bundleId: String, at path: String, to localURL: URL, size: Int64, progress: @escaping (Double, String) -> Void) async throws {
+        try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+            sandboxQueue.async {
+                let context = iOSProgressContext(progress: progress, totalSize: Double(size))
+                let contextPtr = Unmanaged.passRetained(context).toOpaque()
+                
+                let ret = ios_app_download_file(bundleId, path, localURL.path, iOSDeviceService.downloadProgress, contextPtr)
+                
+                Unmanaged<iOSProgressContext>.fromOpaque(contextPtr).release()
+                
+                if ret == 0 {
+                    continuation.resume()
+                } else {
+                    continuation.resume(throwing: NSError(domain: "iOSDeviceService", code: Int(ret), userInfo: nil))
+                }
+            }
+        }
+    }
+    
+    func uploadAppFile(bundleId: String, from localURL: URL, to path: String, progress: @escaping (Double, String) -> Void) async throws {
+        let destinationPath = path + (path.hasSuffix("/") ? "" : "/") + localURL.lastPathComponent
+        let fileSize = (try? FileManager.default.attributesOfItem(atPath: localURL.path)[.size] as? UInt64) ?? 0
+        
+        try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+            sandboxQueue.async {
+                let context = iOSProgressContext(progress: progress, totalSize: Double(fileSize))
+                let contextPtr = Unmanaged.passRetained(context).toOpaque()
+                
+                let ret = ios_app_upload_file(bundleId, localURL.path, destinationPath, iOSDeviceService.uploadProgress, contextPtr)
+                
+                Unmanaged<iOSProgressContext>.fromOpaque(contextPtr).release()
+                
+                if ret == 0 {
+                    continuation.resume()
+                } else {
+                    continuation.resume(throwing: NSError(domain: "iOSDeviceService", code: Int(ret), userInfo: nil))
+                }
+            }
+        }
+    }
+    
+    func deleteAppItem(bundleId: String, at path: String) async throws {
+        try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+            sandboxQueue.async {
+                let ret = ios_app_delete_file(bundleId, path)
+                if ret == 0 {
+                    continuation.resume()
+                } else {
+                    continuation.resume(throwing: NSError(domain: "iOSDeviceService", code: Int(ret), userInfo: nil))
+                }
+            }
+        }
+    }
+    
+    private static let downloadProgress: iOSProgressCallback = { sent, total, ctx in
+        reportProgress(sent, total, ctx, verb: "Downloading")
+    }
+    
+    private static let uploadProgress: iOSProgressCallback = { sent, total, ctx in
+        reportProgress(sent, total, ctx, verb: "Uploading")
+    }
+    
+    private static func reportProgress(_ sent: UInt64, _ total: UInt64, _ ctx: UnsafeRawPointer?, verb: String) {
+        guard let ctx = ctx else { return }
+        let context = Unmanaged<iOSProgressContext>.fromOpaque(ctx).takeUnretainedValue()
+        
+        let percentage = Double(sent) / context.totalSize
+        let status = "\(verb) \(ByteCountFormatter.string(fromByteCount: Int64(sent), countStyle: .file)) / \(ByteCountFormatter.string(fromByteCount: Int64(total), countStyle: .file))"
+        
+        DispatchQueue.main.async {
+            context.progress(percentage, status)
+        }
+    }
+    
     func getAppContainers() async throws -> [String] {
         // For now, we'll return a placeholder - in a real implementation,
         // we would query the device for installed apps
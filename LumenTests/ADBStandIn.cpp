@@ -0,0 +1,307 @@
+#include "ADBStandIn.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0      // Darwin: SO_NOSIGPIPE is set on each socket instead
+#endif
+
+static std::mutex root_lock;
+static std::string root;
+static std::atomic<bool> advertise_v2{true};
+static std::atomic<int> round_trip_us{0};
+static std::atomic<long> sync_reads{0};
+static uint16_t listening_port = 0;
+
+static std::string device_root() {
+    std::lock_guard<std::mutex> guard(root_lock);
+    return root;
+}
+
+struct Conn {
+    int fd;
+    bool counted = false;       // Reads on sync connections are counted
+    char buf[64 * 1024];
+    size_t pos = 0, len = 0;
+
+    bool read(void* out, size_t n) {
+        char* p = (char*)out;
+        while (n > 0) {
+            if (pos == len) {
+                int delay = round_trip_us;
+                if (delay > 0) std::this_thread::sleep_for(std::chrono::microseconds(delay));
+                ssize_t r = recv(fd, buf, sizeof(buf), 0);
+                if (r <= 0) return false;
+                if (counted) sync_reads++;
+                pos = 0;
+                len = (size_t)r;
+            }
+            size_t take = std::min(n, len - pos);
+            memcpy(p, buf + pos, take);
+            pos += take;
+            p += take;
+            n -= take;
+        }
+        return true;
+    }
+    bool u32(uint32_t& v) {
+        unsigned char b[4];
+        if (!read(b, 4)) return false;
+        v = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+        return true;
+    }
+    void write(const void* p, size_t n) { send(fd, p, n, MSG_NOSIGNAL); }
+    void w32(std::string& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back((char)(v >> (8 * i)));
+    }
+    void w64(std::string& out, uint64_t v) {
+        for (int i = 0; i < 8; i++) out.push_back((char)(v >> (8 * i)));
+    }
+    void okay_hex(const std::string& s) {
+        char length[5];
+        snprintf(length, sizeof(length), "%04x", (unsigned)s.size());
+        std::string out = std::string("OKAY") + length + s;
+        write(out.data(), out.size());
+    }
+    bool host_request(std::string& req) {
+        char length[5] = {0};
+        if (!read(length, 4)) return false;
+        req.resize(strtoul(length, NULL, 16));
+        return req.empty() || read(&req[0], req.size());
+    }
+};
+
+static void stat_reply(Conn& c, const std::string& id, const std::string& path) {
+    struct stat st;
+    bool ok = lstat((device_root() + path).c_str(), &st) == 0;
+    std::string out = id;
+    if (id == "STAT") {
+        c.w32(out, ok ? st.st_mode : 0);
+        c.w32(out, ok ? (uint32_t)st.st_size : 0);
+        c.w32(out, ok ? (uint32_t)st.st_mtime : 0);
+    } else {
+        c.w32(out, ok ? 0 : ENOENT);
+        c.w64(out, 0); c.w64(out, 0);
+        c.w32(out, ok ? st.st_mode : 0);
+        c.w32(out, 1); c.w32(out, 0); c.w32(out, 0);
+        c.w64(out, ok ? st.st_size : 0);
+        c.w64(out, 0);
+        c.w64(out, ok ? st.st_mtime : 0);
+        c.w64(out, 0);
+    }
+    c.write(out.data(), out.size());
+}
+
+static void list_reply(Conn& c, bool v2, const std::string& path) {
+    std::string folder = device_root() + path;
+    std::string out;
+    DIR* dir = opendir(folder.c_str());
+    while (dir) {
+        struct dirent* e = readdir(dir);
+        if (!e) break;
+        struct stat st;
+        std::string name = e->d_name;
+        if (lstat((folder + "/" + name).c_str(), &st) != 0) continue;
+        if (v2) {
+            out += "DNT2";
+            c.w32(out, 0); c.w64(out, 0); c.w64(out, 0);
+            c.w32(out, st.st_mode); c.w32(out, 1); c.w32(out, 0); c.w32(out, 0);
+            c.w64(out, st.st_size); c.w64(out, 0); c.w64(out, st.st_mtime); c.w64(out, 0);
+        } else {
+            out += "DENT";
+            c.w32(out, st.st_mode); c.w32(out, (uint32_t)st.st_size); c.w32(out, (uint32_t)st.st_mtime);
+        }
+        c.w32(out, (uint32_t)name.size());
+        out += name;
+    }
+    if (dir) closedir(dir);
+    out += "DONE";
+    out.append(v2 ? 72 : 16, '\0');
+    c.write(out.data(), out.size());
+}
+
+static void fail_reply(Conn& c, const std::string& message) {
+    std::string out = "FAIL";
+    c.w32(out, (uint32_t)message.size());
+    out += message;
+    c.write(out.data(), out.size());
+}
+
+static void sync_loop(Conn& c) {
+    c.counted = true;
+    while (true) {
+        char id[5] = {0};
+        uint32_t length;
+        if (!c.read(id, 4) || !c.u32(length)) return;
+        std::string payload(length, '\0');
+        if (length && !c.read(&payload[0], length)) return;
+        std::string sid = id;
+
+        if (sid == "STAT" || sid == "STA2" || sid == "LST2") {
+            stat_reply(c, sid, payload);
+        } else if (sid == "LIST" || sid == "LIS2") {
+            list_reply(c, sid == "LIS2", payload);
+        } else if (sid == "RECV") {
+            int fd = open((device_root() + payload).c_str(), O_RDONLY);
+            if (fd < 0) {
+                fail_reply(c, "No such file or directory");
+                continue;
+            }
+            std::string out;
+            char buf[64 * 1024];
+            ssize_t n;
+            while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+                out += "DATA";
+                c.w32(out, (uint32_t)n);
+                out.append(buf, (size_t)n);
+            }
+            close(fd);
+            out += "DONE";
+            c.w32(out, 0);
+            c.write(out.data(), out.size());
+        } else if (sid == "SEND") {
+            std::string path = payload.substr(0, payload.rfind(','));
+            FILE* f = fopen((device_root() + path).c_str(), "wb");
+            while (true) {
+                char did[5] = {0};
+                uint32_t dlen;
+                if (!c.read(did, 4) || !c.u32(dlen)) {
+                    if (f) fclose(f);
+                    return;
+                }
+                if (strcmp(did, "DONE") == 0) break;
+                std::string data(dlen, '\0');
+                if (dlen && !c.read(&data[0], dlen)) {
+                    if (f) fclose(f);
+                    return;
+                }
+                if (f) fwrite(data.data(), 1, dlen, f);
+            }
+            if (!f) {
+                fail_reply(c, "Permission denied");
+                continue;
+            }
+            fclose(f);
+            std::string out = "OKAY";
+            c.w32(out, 0);
+            c.write(out.data(), out.size());
+        } else {
+            return; // QUIT or unknown
+        }
+    }
+}
+
+static void serve(int fd) {
+    Conn c;
+    c.fd = fd;
+    std::string req;
+    while (c.host_request(req)) {
+        if (req == "host:devices") {
+            c.okay_hex("STANDIN01\tdevice\n");
+            break;
+        } else if (req.find(":features") != std::string::npos) {
+            c.okay_hex(advertise_v2 ? "shell_v2,cmd,stat_v2,ls_v2" : "shell_v2,cmd");
+            break;
+        } else if (req.rfind("host:transport", 0) == 0) {
+            c.write("OKAY", 4);
+        } else if (req == "sync:") {
+            c.write("OKAY", 4);
+            sync_loop(c);
+            break;
+        } else if (req.rfind("shell:", 0) == 0) {
+            c.write("OKAY", 4);
+            // Only understands what adb_delete_file sends: rm -r -- '<path>' ...
+            size_t a = req.find('\''), b = req.find('\'', a + 1);
+            std::string path = req.substr(a + 1, b - a - 1);
+            std::string cmd = "rm -r -- '" + device_root() + path + "' 2>/dev/null";
+            std::string out = "rc=" + std::to_string(system(cmd.c_str()) == 0 ? 0 : 1) + "\n";
+            c.write(out.data(), out.size());
+            break;
+        } else {
+            std::string message = "unknown request";
+            char length[5];
+            snprintf(length, sizeof(length), "%04x", (unsigned)message.size());
+            std::string out = std::string("FAIL") + length + message;
+            c.write(out.data(), out.size());
+            break;
+        }
+    }
+    close(fd);
+}
+
+static void configure(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+extern "C" {
+
+uint16_t adb_standin_start(const char* directory) {
+    {
+        std::lock_guard<std::mutex> guard(root_lock);
+        root = directory ? directory : "";
+        // One server per process; later calls just point it at the new root
+        if (listening_port != 0) return listening_port;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return 0;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &length) != 0) {
+        close(fd);
+        return 0;
+    }
+    std::thread([fd]() {
+        while (true) {
+            int c = accept(fd, NULL, NULL);
+            if (c < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            configure(c);
+            std::thread(serve, c).detach();
+        }
+    }).detach();
+
+    std::lock_guard<std::mutex> guard(root_lock);
+    listening_port = ntohs(addr.sin_port);
+    return listening_port;
+}
+
+void adb_standin_set_v2(bool v2) {
+    advertise_v2 = v2;
+}
+
+void adb_standin_set_round_trip_us(int microseconds) {
+    round_trip_us = microseconds;
+}
+
+long adb_standin_sync_reads(void) {
+    return sync_reads;
+}
+
+} // extern "C"
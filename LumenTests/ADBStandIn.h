@@ -0,0 +1,31 @@
+#ifndef ADBStandIn_h
+#define ADBStandIn_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A stand-in adb server for the ADBBridge tests and bench.
+//
+// Speaks enough of the host and sync protocols (host:devices, host:features,
+// host:transport, sync: LIST/LIS2/STAT/STA2/RECV/SEND/QUIT, shell:rm) to
+// serve a local directory as the device file system, as device STANDIN01.
+// Each read it does off a socket can be delayed to model a USB round trip.
+
+// Listens on 127.0.0.1 and returns the port, or 0 on failure. Serves until the process exits.
+uint16_t adb_standin_start(const char* root);
+// Whether host:features advertises stat_v2 and ls_v2. Default true.
+void adb_standin_set_v2(bool v2);
+// Delay before each socket read. Default 0.
+void adb_standin_set_round_trip_us(int microseconds);
+// Socket reads made on sync connections so far
+long adb_standin_sync_reads(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADBStandIn_h */
@@ -0,0 +1,154 @@
+//
+//  ADBSyncTests.swift
+//  LumenTests
+//
+
+import XCTest
+@testable import Lumen
+
+// Runs the native ADB client against the stand-in server (ADBStandIn.h),
+// which serves a temporary directory as the device file system
+class ADBSyncTests: XCTestCase {
+
+    private let fileCount = 300
+    private var directory: URL!
+    private var root: URL!
+
+    override func setUpWithError() throws {
+        try super.setUpWithError()
+        directory = try makeTemporaryDirectory("ADBSyncTests")
+        root = directory.appendingPathComponent("device")
+        let dcim = root.appendingPathComponent("sdcard/DCIM")
+        try FileManager.default.createDirectory(at: dcim, withIntermediateDirectories: true)
+        let contents = Data("0123456789abcdef".utf8)
+        for i in 0..<fileCount {
+            try contents.prefix(10 + i % 7).write(to: root.appendingPathComponent("sdcard/file_\(i).txt"))
+        }
+
+        adb_standin_set_v2(true)
+        adb_standin_set_round_trip_us(0)
+        let port = adb_standin_start(root.path)
+        XCTAssertNotEqual(port, 0)
+        adb_set_server("127.0.0.1", port)
+    }
+
+    override func tearDownWithError() throws {
+        adb_disconnect()
+        try FileManager.default.removeItem(at: directory)
+        try super.tearDownWithError()
+    }
+
+    private func connect(v2: Bool) {
+        adb_disconnect()
+        adb_standin_set_v2(v2)
+        XCTAssertTrue(adb_connect(nil))
+    }
+
+    private var paths: [String] {
+        return (0..<fileCount).map { "/sdcard/file_\($0).txt" }
+    }
+
+    private func stat(_ path: String) -> ADBFileInfo? {
+        var info = ADBFileInfo()
+        return adb_stat(path, &info) == 0 ? info : nil
+    }
+
+    private func statMany(_ paths: [String]) -> [ADBFileInfo]? {
+        let cPaths = paths.map { UnsafePointer(strdup($0)) }
+        defer { cPaths.forEach { free(UnsafeMutablePointer(mutating: $0)) } }
+        var infos = [ADBFileInfo](repeating: ADBFileInfo(), count: paths.count)
+        return adb_stat_many(cPaths, Int32(paths.count), &infos) == 0 ? infos : nil
+    }
+
+    func testListsTheStandInDevice() {
+        var devices = [ADBDeviceInfo](repeating: ADBDeviceInfo(), count: 4)
+        XCTAssertEqual(adb_list_devices(&devices, 4), 1)
+        XCTAssertEqual(cString(devices[0].serial), "STANDIN01")
+        XCTAssertEqual(cString(devices[0].state), "device")
+    }
+
+    private func checkListingAndStat(v2: Bool) {
+        connect(v2: v2)
+
+        var count: Int32 = 0
+        let list = adb_list_files("/sdcard", &count)
+        defer { adb_free_files(list) }
+        XCTAssertEqual(Int(count), fileCount + 1)
+        let entries = UnsafeBufferPointer(start: list, count: Int(count))
+        XCTAssertEqual(entries.first { cString($0.name) == "DCIM" }?.is_directory, true)
+        XCTAssertEqual(entries.first { cString($0.name) == "file_3.txt" }?.size, 13)
+
+        let info = stat("/sdcard/file_5.txt")
+        XCTAssertEqual(info?.exists, true)
+        XCTAssertEqual(info?.is_directory, false)
+        XCTAssertEqual(info?.size, 15)
+        XCTAssertEqual(stat("/sdcard/DCIM")?.is_directory, true)
+        XCTAssertEqual(stat("/sdcard/nope")?.exists, false, "A missing path is a reply, not an error")
+
+        guard let infos = statMany(paths + ["/sdcard/nope"]) else {
+            XCTFail("adb_stat_many failed")
+            return
+        }
+        for i in 0..<fileCount {
+            XCTAssertTrue(infos[i].exists)
+            XCTAssertEqual(infos[i].size, UInt64(10 + i % 7))
+        }
+        XCTAssertFalse(infos[fileCount].exists)
+    }
+
+    func testEmptyAndFailedListingsDiffer() {
+        connect(v2: true)
+        var count: Int32 = -1
+        XCTAssertNil(adb_list_files("/sdcard/DCIM", &count))
+        XCTAssertEqual(count, 0)
+
+        // Nothing listening there
+        adb_set_server("127.0.0.1", 1)
+        XCTAssertNil(adb_list_files("/sdcard", &count))
+        XCTAssertLessThan(count, 0)
+    }
+
+    func testListingAndStatWithV2Replies() {
+        checkListingAndStat(v2: true)
+    }
+
+    func testListingAndStatWithV1Replies() {
+        checkListingAndStat(v2: false)
+    }
+
+    func testStatManyPipelinesRequests() {
+        connect(v2: true)
+        // The server sleeps before each read, so requests that are all sent
+        // up front arrive together in a few reads
+        adb_standin_set_round_trip_us(200)
+
+        var reads = adb_standin_sync_reads()
+        for path in paths.prefix(50) {
+            XCTAssertEqual(stat(path)?.exists, true)
+        }
+        XCTAssertGreaterThanOrEqual(adb_standin_sync_reads() - reads, 50, "One request, one reply, one read")
+
+        reads = adb_standin_sync_reads()
+        XCTAssertNotNil(statMany(paths))
+        XCTAssertLessThan(adb_standin_sync_reads() - reads, fileCount / 10)
+    }
+
+    func testSendReceiveAndDelete() throws {
+        connect(v2: true)
+        let local = directory.appendingPathComponent("upload.bin")
+        let back = directory.appendingPathComponent("download.bin")
+        let data = Data((0..<(5 * 1024 * 1024)).map { UInt8(truncatingIfNeeded: $0 &* 31) })
+        try data.write(to: local)
+
+        XCTAssertEqual(adb_upload_file(local.path, "/sdcard/DCIM/upload.bin", nil, nil), 0)
+        XCTAssertEqual(adb_download_file("/sdcard/DCIM/upload.bin", back.path, nil, nil), 0)
+        XCTAssertEqual(try Data(contentsOf: back), data)
+
+        XCTAssertEqual(adb_download_file("/sdcard/missing.bin", back.path, nil, nil), -4)
+        // The connection is still usable after a FAIL
+        XCTAssertEqual(stat("/sdcard/DCIM/upload.bin")?.size, UInt64(data.count))
+
+        XCTAssertEqual(adb_delete_file("/sdcard/DCIM/upload.bin"), 0)
+        XCTAssertEqual(stat("/sdcard/DCIM/upload.bin")?.exists, false)
+    }
+}
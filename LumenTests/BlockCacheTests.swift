@@ -0,0 +1,164 @@
+//
+//  BlockCacheTests.swift
+//  LumenTests
+//
+
+import XCTest
+@testable import Lumen
+
+// A remote object whose bytes are a function of their offset
+private final class FakeObject {
+    let size: UInt64
+    var requests = 0
+    var failAt: UInt64?         // Fetches starting here return an I/O error
+
+    init(size: UInt64) {
+        self.size = size
+    }
+
+    static func byte(at offset: UInt64) -> UInt8 {
+        return UInt8(truncatingIfNeeded: (offset &* 0x9E37_79B9_7F4A_7C15) >> 56)
+    }
+
+    func fetch(offset: UInt64, length: UInt32, into out: UnsafeMutablePointer<UInt8>) -> Int64 {
+        requests += 1
+        if offset == failAt { return -5 }
+        if offset >= size { return 0 }
+        let count = Int(min(UInt64(length), size - offset))
+        for i in 0..<count {
+            out[i] = FakeObject.byte(at: offset + UInt64(i))
+        }
+        return Int64(count)
+    }
+}
+
+class BlockCacheTests: XCTestCase {
+
+    // Small blocks keep the objects small; readahead counts in blocks either way
+    private let blockSize: UInt32 = 64 * 1024
+    private var caches: [OpaquePointer] = []
+    private var objects: [FakeObject] = []
+
+    override func tearDown() {
+        caches.forEach { block_cache_free($0) }
+        caches = []
+        objects = []
+        super.tearDown()
+    }
+
+    private func makeCache(_ object: FakeObject, maxReadahead: UInt32 = 16) -> OpaquePointer {
+        objects.append(object)
+        let fetch: BlockCacheFetchCallback = { offset, length, out, context in
+            guard let out = out, let context = context else { return -1 }
+            let object = Unmanaged<FakeObject>.fromOpaque(context).takeUnretainedValue()
+            return object.fetch(offset: offset, length: length, into: out)
+        }
+        let cache = block_cache_create(object.size, fetch, Unmanaged.passUnretained(object).toOpaque(),
+                                       blockSize, 32, maxReadahead)!
+        caches.append(cache)
+        return cache
+    }
+
+    private func read(_ cache: OpaquePointer, at offset: UInt64, length: Int) -> [UInt8]? {
+        var buffer = [UInt8](repeating: 0, count: length)
+        let n = block_cache_read(cache, offset, &buffer, UInt32(length))
+        return n < 0 ? nil : Array(buffer.prefix(Int(n)))
+    }
+
+    private func isIntact(_ data: [UInt8], at offset: UInt64) -> Bool {
+        for (i, byte) in data.enumerated() where byte != FakeObject.byte(at: offset + UInt64(i)) {
+            return false
+        }
+        return true
+    }
+
+    // Sequential 16 KB reads, the way AVFoundation pulls media
+    private func play(_ cache: OpaquePointer, from start: UInt64, bytes: UInt64) -> Bool {
+        var offset = start
+        while offset < start + bytes {
+            guard let chunk = read(cache, at: offset, length: 16 * 1024), !chunk.isEmpty, isIntact(chunk, at: offset) else {
+                return false
+            }
+            offset += UInt64(chunk.count)
+        }
+        return true
+    }
+
+    func testSequentialReadsFetchAhead() {
+        let size: UInt64 = 16 * 1024 * 1024 + 123
+        let blocks = Int((size + UInt64(blockSize) - 1) / UInt64(blockSize))
+
+        let oneAtATime = FakeObject(size: size)
+        XCTAssertTrue(play(makeCache(oneAtATime, maxReadahead: 1), from: 0, bytes: size))
+        XCTAssertEqual(oneAtATime.requests, blocks)
+
+        let readahead = FakeObject(size: size)
+        XCTAssertTrue(play(makeCache(readahead), from: 0, bytes: size))
+        // Fetches double up to 16 blocks
+        XCTAssertLessThan(readahead.requests, blocks * 2 / 16 + 8)
+    }
+
+    func testRandomReadsFetchOnlyWhatTheyTouch() {
+        let object = FakeObject(size: 16 * 1024 * 1024)
+        let cache = makeCache(object)
+
+        // First page of a document
+        let page = read(cache, at: 0, length: 40_000)
+        XCTAssertEqual(page?.count, 40_000)
+        XCTAssertTrue(isIntact(page ?? [], at: 0))
+        XCTAssertEqual(object.requests, 1)
+        XCTAssertEqual(block_cache_stats(cache).bytes_fetched, UInt64(blockSize))
+
+        // A seek elsewhere is one more fetch, not a download of everything in between
+        let far = UInt64(blockSize) * 100 + 777
+        XCTAssertTrue(isIntact(read(cache, at: far, length: 1000) ?? [], at: far))
+        XCTAssertEqual(object.requests, 2)
+    }
+
+    func testScrubbingBackIsServedFromTheCache() {
+        let object = FakeObject(size: 16 * 1024 * 1024)
+        let cache = makeCache(object)
+        XCTAssertTrue(play(cache, from: 4 * 1024 * 1024, bytes: 1024 * 1024))
+        let requests = object.requests
+
+        XCTAssertTrue(play(cache, from: 4 * 1024 * 1024, bytes: 1024 * 1024))
+        XCTAssertEqual(object.requests, requests)
+        XCTAssertGreaterThan(block_cache_stats(cache).block_hits, 0)
+    }
+
+    func testReadsAtTheEdges() {
+        let size: UInt64 = 16 * 1024 * 1024 + 123
+        let cache = makeCache(FakeObject(size: size))
+
+        let tail = read(cache, at: size - 100, length: 4096)
+        XCTAssertEqual(tail?.count, 100)
+        XCTAssertTrue(isIntact(tail ?? [], at: size - 100))
+        XCTAssertEqual(read(cache, at: size, length: 4096)?.count, 0)
+        XCTAssertEqual(read(cache, at: size + 10, length: 4096)?.count, 0)
+
+        // Unaligned and longer than a block
+        let odd = UInt64(blockSize) * 5 + 777
+        let span = read(cache, at: odd, length: Int(blockSize) * 3)
+        XCTAssertEqual(span?.count, Int(blockSize) * 3)
+        XCTAssertTrue(isIntact(span ?? [], at: odd))
+
+        // Smaller than one block
+        let tiny = FakeObject(size: 1000)
+        let whole = read(makeCache(tiny), at: 0, length: 2000)
+        XCTAssertEqual(whole?.count, 1000)
+        XCTAssertTrue(isIntact(whole ?? [], at: 0))
+        XCTAssertEqual(tiny.requests, 1)
+    }
+
+    func testFetchErrorsAreReturnedAndNotCached() {
+        let object = FakeObject(size: 1024 * 1024)
+        object.failAt = 0
+        let cache = makeCache(object)
+        var buffer = [UInt8](repeating: 0, count: 100)
+        XCTAssertEqual(block_cache_read(cache, 10, &buffer, 100), -5)
+
+        object.failAt = nil
+        XCTAssertEqual(block_cache_read(cache, 10, &buffer, 100), 100)
+        XCTAssertTrue(isIntact(buffer, at: 10))
+    }
+}
@@ -0,0 +1,183 @@
+//
+//  DeviceCatalogTests.swift
+//  LumenTests
+//
+
+import XCTest
+@testable import Lumen
+
+class DeviceCatalogTests: XCTestCase {
+
+    private var directory: URL!
+    private var catalog: OpaquePointer!
+
+    override func setUpWithError() throws {
+        try super.setUpWithError()
+        directory = try makeTemporaryDirectory("DeviceCatalogTests")
+        catalog = device_catalog_create()
+    }
+
+    override func tearDownWithError() throws {
+        device_catalog_free(catalog)
+        catalog = nil
+        try FileManager.default.removeItem(at: directory)
+        try super.tearDownWithError()
+    }
+
+    private var catalogPath: String {
+        return directory.appendingPathComponent("mtp-SERIAL123.catalog").path
+    }
+
+    private func key(_ folder: Int) -> String {
+        return "65537/\(1000 + folder)"
+    }
+
+    private func listing(_ folder: Int, files: Int) -> [DeviceCatalogItem] {
+        return (0..<files).map { i in
+            var item = DeviceCatalogItem()
+            item.id = UInt64(folder * 100_000 + i)
+            setCString(&item.name, "IMG_\(folder)_\(i).jpg")
+            item.size = UInt64(1000 + i * 37)
+            item.modification_date = UInt64(1_700_000_000 + i)
+            item.storage_id = 65537
+            item.parent_id = UInt32(1000 + folder)
+            item.is_directory = i % 10 == 0
+            return item
+        }
+    }
+
+    private func put(_ key: String, _ items: [DeviceCatalogItem], listedAt: Int64 = 1_800_000_000, into handle: OpaquePointer? = nil) {
+        device_catalog_put(handle ?? catalog, key, items, Int32(items.count), listedAt)
+    }
+
+    // nil when the folder is unknown
+    private func read(_ key: String, from handle: OpaquePointer? = nil) -> [DeviceCatalogItem]? {
+        let count = device_catalog_get(handle ?? catalog, key, nil, 0, nil)
+        if count < 0 { return nil }
+        var items = [DeviceCatalogItem](repeating: DeviceCatalogItem(), count: Int(count))
+        XCTAssertEqual(device_catalog_get(handle ?? catalog, key, &items, count, nil), count)
+        return items
+    }
+
+    private func assertSame(_ actual: [DeviceCatalogItem]?, _ expected: [DeviceCatalogItem], file: StaticString = #filePath, line: UInt = #line) {
+        guard let actual = actual else {
+            XCTFail("Folder missing", file: file, line: line)
+            return
+        }
+        XCTAssertEqual(actual.count, expected.count, file: file, line: line)
+        for (a, b) in zip(actual, expected) {
+            XCTAssertEqual(cString(a.name), cString(b.name), file: file, line: line)
+            XCTAssertEqual(a.id, b.id, file: file, line: line)
+            XCTAssertEqual(a.size, b.size, file: file, line: line)
+            XCTAssertEqual(a.modification_date, b.modification_date, file: file, line: line)
+            XCTAssertEqual(a.storage_id, b.storage_id, file: file, line: line)
+            XCTAssertEqual(a.parent_id, b.parent_id, file: file, line: line)
+            XCTAssertEqual(a.is_directory, b.is_directory, file: file, line: line)
+        }
+    }
+
+    // Saves 200 folders, then reads them back from the file the way a reconnect does
+    private func recordAndReopen() -> OpaquePointer {
+        XCTAssertTrue(device_catalog_open(catalog, directory.path, "mtp", "SERIAL123"))
+        XCTAssertEqual(device_catalog_folder_count(catalog), 0)
+        // In reverse, so the file has to end up sorted
+        for folder in stride(from: 199, through: 0, by: -1) {
+            put(key(folder), listing(folder, files: folder == 7 ? 0 : 20), listedAt: Int64(1_700_000_000 + folder))
+        }
+        XCTAssertTrue(device_catalog_save(catalog))
+
+        let reopened = device_catalog_create()!
+        XCTAssertTrue(device_catalog_open(reopened, directory.path, "mtp", "SERIAL123"))
+        return reopened
+    }
+
+    func testListingsSurviveSaveAndReopen() {
+        let reopened = recordAndReopen()
+        defer { device_catalog_free(reopened) }
+
+        XCTAssertEqual(device_catalog_folder_count(reopened), 200)
+        for folder in 0..<200 {
+            assertSame(read(key(folder), from: reopened), listing(folder, files: folder == 7 ? 0 : 20))
+        }
+        var listedAt: Int64 = 0
+        XCTAssertEqual(device_catalog_get(reopened, key(42), nil, 0, &listedAt), 20)
+        XCTAssertEqual(listedAt, 1_700_000_042)
+        XCTAssertNil(read("65537/1", from: reopened))
+        XCTAssertEqual(read(key(7), from: reopened)?.count, 0, "An empty folder is known, not missing")
+    }
+
+    func testUpdatesMergeIntoTheSavedFile() {
+        let reopened = recordAndReopen()
+        defer { device_catalog_free(reopened) }
+
+        var renamed = listing(3, files: 5)
+        setCString(&renamed[0].name, "renamed.jpg")
+        put(key(3), renamed, into: reopened)
+        device_catalog_invalidate(reopened, key(4))
+        put(key(500), listing(500, files: 2), into: reopened)
+        assertSame(read(key(3), from: reopened), renamed)
+        XCTAssertNil(read(key(4), from: reopened))
+
+        XCTAssertTrue(device_catalog_save(reopened))
+        XCTAssertEqual(device_catalog_folder_count(reopened), 200)
+
+        let again = device_catalog_create()!
+        defer { device_catalog_free(again) }
+        XCTAssertTrue(device_catalog_open(again, directory.path, "mtp", "SERIAL123"))
+        XCTAssertEqual(device_catalog_folder_count(again), 200)
+        assertSame(read(key(3), from: again), renamed)
+        XCTAssertNil(read(key(4), from: again))
+        assertSame(read(key(500), from: again), listing(500, files: 2))
+        assertSame(read(key(5), from: again), listing(5, files: 20))
+    }
+
+    func testInvalidatingAFolderDropsItsSubtreeOnly() {
+        XCTAssertTrue(device_catalog_open(catalog, directory.path, "ios", "UDID"))
+        let items = listing(0, files: 3)
+        for path in ["/DCIM", "/DCIM/100APPLE", "/DCIM/100APPLE/Edits", "/DCIM-old", "/DCIMX"] {
+            put(path, items)
+        }
+        XCTAssertTrue(device_catalog_save(catalog))
+        // One saved and one still pending below the folder
+        put("/DCIM/101APPLE", items)
+
+        device_catalog_invalidate_tree(catalog, "/DCIM")
+        XCTAssertNil(read("/DCIM"))
+        XCTAssertNil(read("/DCIM/100APPLE"))
+        XCTAssertNil(read("/DCIM/100APPLE/Edits"))
+        XCTAssertNil(read("/DCIM/101APPLE"))
+        XCTAssertEqual(read("/DCIM-old")?.count, 3)
+        XCTAssertEqual(read("/DCIMX")?.count, 3)
+        XCTAssertTrue(device_catalog_save(catalog))
+        XCTAssertEqual(device_catalog_folder_count(catalog), 2)
+    }
+
+    func testOtherDevicesNeverSeeTheFile() throws {
+        device_catalog_free(recordAndReopen())
+        device_catalog_close(catalog)
+
+        let other = device_catalog_create()!
+        defer { device_catalog_free(other) }
+        XCTAssertTrue(device_catalog_open(other, directory.path, "mtp", "SERIAL/123"))
+        XCTAssertEqual(device_catalog_folder_count(other), 0)
+        device_catalog_close(other)
+
+        // Even when its key sanitizes to the same file name
+        let colliding = directory.appendingPathComponent("mtp-SERIAL_123.catalog").path
+        try FileManager.default.linkItem(atPath: catalogPath, toPath: colliding)
+        XCTAssertTrue(device_catalog_open(other, directory.path, "mtp", "SERIAL/123"))
+        XCTAssertEqual(device_catalog_folder_count(other), 0)
+    }
+
+    func testTornFileIsIgnored() {
+        device_catalog_free(recordAndReopen())
+        device_catalog_close(catalog)
+
+        XCTAssertEqual(truncate(catalogPath, 4096), 0)
+        let damaged = device_catalog_create()!
+        defer { device_catalog_free(damaged) }
+        XCTAssertTrue(device_catalog_open(damaged, directory.path, "mtp", "SERIAL123"))
+        XCTAssertEqual(device_catalog_folder_count(damaged), 0)
+        XCTAssertNil(read(key(5), from: damaged))
+    }
+}
@@ -0,0 +1,6 @@
+//
+//  Native APIs for the tests: everything the app bridges, plus the stand-ins.
+//
+
+#import "../Lumen/Lumen-Bridging-Header.h"
+#import "ADBStandIn.h"
@@ -0,0 +1,28 @@
+//
+//  NativeTestSupport.swift
+//  LumenTests
+//
+
+import Foundation
+
+// Fixed-size C char arrays, as the bridge structs carry names
+func cString<T>(_ field: T) -> String {
+    return withUnsafeBytes(of: field) { raw in
+        String(decoding: raw.prefix { $0 != 0 }, as: UTF8.self)
+    }
+}
+
+func setCString<T>(_ field: inout T, _ value: String) {
+    withUnsafeMutableBytes(of: &field) { raw in
+        let bytes = Array(value.utf8.prefix(raw.count - 1))
+        raw.copyBytes(from: bytes)
+        raw[bytes.count] = 0
+    }
+}
+
+// A fresh directory under the temp folder, removed by the caller
+func makeTemporaryDirectory(_ prefix: String) throws -> URL {
+    let url = FileManager.default.temporaryDirectory.appendingPathComponent("\(prefix)-\(UUID().uuidString)")
+    try FileManager.default.createDirectory(at: url, withIntermediateDirectories: true)
+    return url
+}
@@ -0,0 +1,163 @@
+//
+//  SearchIndexTests.swift
+//  LumenTests
+//
+
+import XCTest
+@testable import Lumen
+
+class SearchIndexTests: XCTestCase {
+
+    private struct File {
+        let source: SearchSource
+        let directory: String
+        let name: String
+        let size: UInt64
+        let date: Int64
+        let type: SearchFileType
+
+        var path: String { return directory + "/" + name }
+    }
+
+    private static let words = [
+        "invoice", "receipt", "report", "vacation", "holiday", "resume", "budget", "contract",
+        "meeting", "notes", "project", "draft", "final", "summary", "tax", "letter", "family",
+        "wedding", "birthday", "lecture", "slides", "manual", "passport", "insurance", "lease"
+    ]
+    private static let artists = ["Radiohead", "Daft Punk", "Nina Simone", "Bonobo", "Khruangbin", "Portishead"]
+
+    // Camera rolls, screenshots, music and documents over a hundred folders
+    private static let files: [File] = (0..<4000).map { i -> File in
+        let folder = i % 97
+        let date = Int64(1_600_000_000 + (i * 7919) % 150_000_000)
+        let size = UInt64(1000 + (i * 104_729) % 20_000_000)
+        switch i % 10 {
+        case 0..<5:
+            let video = i % 10 == 4
+            return File(source: SEARCH_SOURCE_MTP, directory: "mtp://65537/\(folder)",
+                        name: "\(video ? "VID" : "IMG")_\(20_200_000 + i % 500)_\(i).\(video ? "mp4" : "jpg")",
+                        size: size, date: date, type: video ? SEARCH_TYPE_VIDEO : SEARCH_TYPE_IMAGE)
+        case 5:
+            return File(source: SEARCH_SOURCE_IOS, directory: "/DCIM/\(100 + folder % 20)APPLE",
+                        name: "Screenshot \(2020 + (i / 10) % 5)-\(1 + i % 12) \(i).png",
+                        size: size, date: date, type: SEARCH_TYPE_IMAGE)
+        case 6:
+            let artist = SearchIndexTests.artists[folder % 6]
+            return File(source: SEARCH_SOURCE_LOCAL, directory: "/Users/me/Music/\(artist)",
+                        name: "\(artist) - Track \(i).mp3", size: size, date: date, type: SEARCH_TYPE_AUDIO)
+        default:
+            return File(source: SEARCH_SOURCE_LOCAL, directory: "/Users/me/Documents/\(folder)",
+                        name: "\(SearchIndexTests.words[i % 25])_\(SearchIndexTests.words[(i / 25) % 25])_\(i).\(i % 10 == 9 ? "docx" : "pdf")",
+                        size: size, date: date, type: SEARCH_TYPE_DOCUMENT)
+        }
+    }
+
+    private var index: OpaquePointer!
+
+    override func setUp() {
+        super.setUp()
+        index = search_index_create()
+        SearchIndexTests.files.forEach(add)
+    }
+
+    override func tearDown() {
+        search_index_free(index)
+        index = nil
+        super.tearDown()
+    }
+
+    private func add(_ file: File) {
+        search_index_add(index, file.source, file.directory, file.path, file.name, file.size, file.date, file.type)
+    }
+
+    private var count: Int {
+        return Int(search_index_count(index, SEARCH_ALL, SEARCH_ALL))
+    }
+
+    private func search(_ text: String, fuzzy: Bool = true, limit: Int = 50,
+                        _ configure: (inout SearchQuery) -> Void = { _ in }) -> (results: [SearchResult], total: Int) {
+        var query = search_default_query()
+        query.fuzzy = fuzzy
+        configure(&query)
+        var results = [SearchResult](repeating: SearchResult(), count: limit)
+        var total: Int32 = 0
+        let n = text.withCString { cText -> Int32 in
+            query.text = cText
+            return search_index_query(index, &query, &results, Int32(limit), &total)
+        }
+        return (Array(results.prefix(Int(n))), Int(total))
+    }
+
+    func testSubstringQueriesMatchALinearScan() {
+        XCTAssertEqual(count, SearchIndexTests.files.count)
+        for text in ["invoice", "tax receipt", "IMG_2020", "screenshot 2023", "portishead", "ax"] {
+            let terms = text.lowercased().split(separator: " ").map(String.init)
+            let expected = SearchIndexTests.files.filter { file in
+                let name = file.name.lowercased()
+                return terms.allSatisfy { name.contains($0) }
+            }.count
+            XCTAssertGreaterThan(expected, 0, text)
+            XCTAssertEqual(search(text, fuzzy: false).total, expected, text)
+        }
+    }
+
+    func testTyposStillFindTheWord() {
+        XCTAssertTrue(search("vacaton").results.first.map { cString($0.name).contains("vacation") } ?? false)
+        XCTAssertTrue(search("vacaton", fuzzy: false).results.isEmpty)
+        XCTAssertTrue(search("reciept").results.first.map { cString($0.name).contains("receipt") } ?? false)
+    }
+
+    func testFacetsFilterAndSortByDate() {
+        let (results, total) = search("") { query in
+            query.source_mask = 1 << SEARCH_SOURCE_MTP.rawValue
+            query.type_mask = 1 << SEARCH_TYPE_VIDEO.rawValue
+            query.min_size = 10_000_000
+            query.modified_after = 1_610_000_000
+        }
+        let expected = SearchIndexTests.files.filter {
+            $0.source == SEARCH_SOURCE_MTP && $0.type == SEARCH_TYPE_VIDEO && $0.size >= 10_000_000 && $0.date >= 1_610_000_000
+        }
+        XCTAssertEqual(total, expected.count)
+        XCTAssertEqual(results.count, 50)
+        for result in results {
+            XCTAssertEqual(UInt32(result.type), SEARCH_TYPE_VIDEO.rawValue)
+            XCTAssertGreaterThanOrEqual(result.size, 10_000_000)
+            XCTAssertGreaterThanOrEqual(result.modification_date, 1_610_000_000)
+        }
+        XCTAssertEqual(results.map { $0.modification_date }, results.map { $0.modification_date }.sorted(by: >))
+    }
+
+    func testPathsComeBackAsTheyWentIn() {
+        let file = SearchIndexTests.files[1234]
+        let (results, _) = search(file.name, limit: 1)
+        XCTAssertEqual(results.count, 1)
+        XCTAssertEqual(results.first.map { cString($0.path) }, file.path)
+    }
+
+    func testRelistingAFolderReplacesItsContents() {
+        let sample = SearchIndexTests.files[7]
+        let siblings = SearchIndexTests.files.filter { $0.source == sample.source && $0.directory == sample.directory }
+        for _ in 0..<3 {
+            search_index_begin_directory(index, sample.source, sample.directory)
+            siblings.forEach(add)
+        }
+        XCTAssertEqual(count, SearchIndexTests.files.count)
+
+        XCTAssertTrue(search_index_remove(index, sample.source, sample.directory, sample.path))
+        XCTAssertFalse(search_index_remove(index, sample.source, sample.directory, sample.path))
+        XCTAssertEqual(count, SearchIndexTests.files.count - 1)
+    }
+
+    func testClearingASourceKeepsTheOthers() {
+        let phone = Int(search_index_count(index, 1 << SEARCH_SOURCE_MTP.rawValue, SEARCH_ALL))
+        search_index_clear_source(index, SEARCH_SOURCE_MTP)
+        // Storage roots use object ids, not directory/name paths
+        search_index_add(index, SEARCH_SOURCE_MTP, "mtp://", "mtp://65537/99", "Internal storage", 0, 0, SEARCH_TYPE_FOLDER)
+        XCTAssertEqual(count, SearchIndexTests.files.count - phone + 1)
+
+        let (storage, _) = search("internal")
+        XCTAssertEqual(storage.map { cString($0.path) }, ["mtp://65537/99"])
+        XCTAssertTrue(search("IMG_", fuzzy: false).results.isEmpty)
+        XCTAssertFalse(search("portishead").results.isEmpty)
+    }
+}
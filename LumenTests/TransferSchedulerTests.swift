@@ -0,0 +1,182 @@
+//
+//  TransferSchedulerTests.swift
+//  LumenTests
+//
+
+import XCTest
+@testable import Lumen
+
+class TransferSchedulerTests: XCTestCase {
+
+    private let MB: UInt64 = 1024 * 1024
+    private var scheduler: OpaquePointer!
+
+    // A wireless peer with two slots, for the checks that need more than one
+    private let peer = "wireless:peer"
+
+    override func setUp() {
+        super.setUp()
+        scheduler = transfer_scheduler_create()
+    }
+
+    override func tearDown() {
+        transfer_scheduler_free(scheduler)
+        scheduler = nil
+        super.tearDown()
+    }
+
+    // USB MTP: one slot, ~30 MB/s plus 30 ms per file
+    private func configureUSB() {
+        transfer_scheduler_set_link_limit(scheduler, "mtp", 1)
+        transfer_scheduler_set_link_estimate(scheduler, "mtp", 30.0 * Double(MB), 0.03)
+    }
+
+    private func seconds(_ size: UInt64) -> Double {
+        return 0.03 + Double(size) / (30.0 * Double(MB))
+    }
+
+    private func linkState(_ link: String) -> TransferLinkState? {
+        var states = [TransferLinkState](repeating: TransferLinkState(), count: 8)
+        let count = Int(transfer_scheduler_links(scheduler, &states, Int32(states.count)))
+        return states.prefix(count).first { cString($0.link) == link }
+    }
+
+    func testPhotosAreNotStuckBehindVideos() {
+        configureUSB()
+        let video1 = transfer_scheduler_submit(scheduler, "mtp", "a.mp4", 2048 * MB)
+        let video2 = transfer_scheduler_submit(scheduler, "mtp", "b.mp4", 1536 * MB)
+        for _ in 0..<400 {
+            _ = transfer_scheduler_submit(scheduler, "mtp", "photo.jpg", 3 * MB)
+        }
+
+        // Run the link in simulated time, one job at a time
+        var now = 0.0
+        var photosDone = 0.0
+        var taken = 0
+        while true {
+            let job = transfer_scheduler_take(scheduler, "mtp")
+            if job == 0 { break }
+            XCTAssertEqual(transfer_scheduler_take(scheduler, "mtp"), 0, "One slot on this link")
+            let size = job == video1 ? 2048 * MB : (job == video2 ? 1536 * MB : 3 * MB)
+            now += seconds(size)
+            if size == 3 * MB { photosDone = now }
+            transfer_scheduler_finish(scheduler, job, 0)
+            taken += 1
+        }
+
+        // In submission order the photos would wait for both videos
+        let inOrder = seconds(2048 * MB) + seconds(1536 * MB) + 400 * seconds(3 * MB)
+        XCTAssertEqual(taken, 402)
+        XCTAssertLessThan(photosDone, inOrder / 2)
+        // Reordering costs nothing overall
+        XCTAssertEqual(now, inOrder, accuracy: 0.001)
+        XCTAssertTrue(transfer_scheduler_idle(scheduler))
+    }
+
+    func testVideoGetsItsShareWhilePhotosKeepArriving() {
+        configureUSB()
+        let video = transfer_scheduler_submit(scheduler, "mtp", "a.mp4", 1024 * MB)
+
+        // A photo every 50 ms for 150 s, more than the link can keep up with
+        var submitted = 0
+        var now = 0.0
+        var videoStart = -1.0
+        while true {
+            while submitted < 3000 && Double(submitted) * 0.05 <= now {
+                _ = transfer_scheduler_submit(scheduler, "mtp", "photo.jpg", 2 * MB)
+                submitted += 1
+            }
+            let job = transfer_scheduler_take(scheduler, "mtp")
+            if job == 0 {
+                if submitted < 3000 {
+                    now = Double(submitted) * 0.05
+                    continue
+                }
+                break
+            }
+            if job == video { videoStart = now }
+            now += seconds(job == video ? 1024 * MB : 2 * MB)
+            transfer_scheduler_finish(scheduler, job, 0)
+        }
+
+        // Equal shares: the photos get about as much link time before it
+        XCTAssertGreaterThan(videoStart, 0)
+        XCTAssertLessThan(videoStart, seconds(1024 * MB) + 3)
+    }
+
+    func testLinksRunIndependentlyWithinTheirLimits() {
+        transfer_scheduler_set_link_limit(scheduler, "mtp", 1)
+        transfer_scheduler_set_link_limit(scheduler, peer, 2)
+        for link in ["mtp", peer] {
+            for _ in 0..<3 {
+                _ = transfer_scheduler_submit(scheduler, link, "photo.jpg", 2 * MB)
+            }
+        }
+
+        let mtpJob = transfer_scheduler_take(scheduler, "mtp")
+        XCTAssertNotEqual(mtpJob, 0)
+        XCTAssertEqual(transfer_scheduler_take(scheduler, "mtp"), 0)
+        // A busy USB link does not hold up the peer
+        XCTAssertNotEqual(transfer_scheduler_take(scheduler, peer), 0)
+        XCTAssertNotEqual(transfer_scheduler_take(scheduler, peer), 0)
+        XCTAssertEqual(transfer_scheduler_take(scheduler, peer), 0)
+
+        transfer_scheduler_finish(scheduler, mtpJob, 0)
+        XCTAssertEqual(transfer_scheduler_take(scheduler, peer), 0, "Finishing on one link frees nothing on another")
+        XCTAssertNotEqual(transfer_scheduler_take(scheduler, "mtp"), 0)
+
+        XCTAssertEqual(linkState("mtp")?.running, 1)
+        XCTAssertEqual(linkState("mtp")?.done, 1)
+        XCTAssertEqual(linkState(peer)?.running, 2)
+        XCTAssertEqual(linkState(peer)?.queued_small, 1)
+    }
+
+    func testQueueStateCancellationAndFailures() {
+        transfer_scheduler_set_link_limit(scheduler, peer, 2)
+        let big1 = transfer_scheduler_submit(scheduler, peer, "a.mov", 900 * MB)
+        let big2 = transfer_scheduler_submit(scheduler, peer, "b.mov", 900 * MB)
+        XCTAssertEqual(transfer_scheduler_take(scheduler, peer), big1)
+        XCTAssertEqual(transfer_scheduler_take(scheduler, peer), 0, "The last slot stays with the small lane")
+        let small1 = transfer_scheduler_submit(scheduler, peer, "a.jpg", 3 * MB)
+        let small2 = transfer_scheduler_submit(scheduler, peer, "b.jpg", 3 * MB)
+        XCTAssertEqual(transfer_scheduler_take(scheduler, peer), small1)
+        XCTAssertEqual(transfer_scheduler_take(scheduler, peer), 0)
+
+        transfer_scheduler_progress(scheduler, big1, 100 * MB)
+        XCTAssertTrue(transfer_scheduler_cancel(scheduler, big2))
+        XCTAssertFalse(transfer_scheduler_cancel(scheduler, big2))
+
+        var link = TransferLinkState()
+        XCTAssertEqual(transfer_scheduler_links(scheduler, &link, 1), 1)
+        XCTAssertEqual(link.running, 2)
+        XCTAssertEqual(link.queued_small, 1)
+        XCTAssertEqual(link.queued_large, 0)
+        XCTAssertEqual(link.cancelled, 1)
+        XCTAssertEqual(link.running_bytes, 903 * MB)
+        XCTAssertEqual(link.running_bytes_done, 100 * MB)
+
+        var jobs = [TransferJobInfo](repeating: TransferJobInfo(), count: 8)
+        var total: Int32 = 0
+        XCTAssertEqual(transfer_scheduler_jobs(scheduler, &jobs, 8, &total), 4)
+        XCTAssertEqual(total, 4)
+        XCTAssertEqual(jobs.prefix(4).map { $0.id }, [big1, small1, small2, big2])
+        XCTAssertEqual(jobs[1].state, UInt8(TRANSFER_JOB_RUNNING.rawValue))
+        XCTAssertEqual(jobs[2].state, UInt8(TRANSFER_JOB_QUEUED.rawValue))
+        XCTAssertEqual(jobs[3].state, UInt8(TRANSFER_JOB_CANCELLED.rawValue))
+
+        transfer_scheduler_finish(scheduler, small1, -5)
+        XCTAssertEqual(transfer_scheduler_take(scheduler, peer), small2)
+        XCTAssertTrue(transfer_scheduler_cancel(scheduler, big1))
+        transfer_scheduler_finish(scheduler, big1, 0)
+        transfer_scheduler_finish(scheduler, small2, 0)
+        transfer_scheduler_links(scheduler, &link, 1)
+        XCTAssertEqual(link.done, 1)
+        XCTAssertEqual(link.failed, 1)
+        XCTAssertEqual(link.cancelled, 2)
+        XCTAssertTrue(transfer_scheduler_idle(scheduler))
+
+        transfer_scheduler_clear_finished(scheduler)
+        transfer_scheduler_jobs(scheduler, &jobs, 8, &total)
+        XCTAssertEqual(total, 0)
+    }
+}
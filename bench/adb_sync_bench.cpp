@@ -0,0 +1,109 @@
+// Times pipelined vs. one-at-a-time STAT requests through the native ADB
+// client, against the stand-in adb server from LumenTests (ADBStandIn.h),
+// with each socket read on the server delayed to model a USB round trip.
+// The protocol checks live in LumenTests/ADBSyncTests.swift.
+//
+// Build and run from the repository root:
+//   mkdir -p build
+//   c++ -std=c++17 -O2 -pthread -I Lumen/ADBBridge/include -I LumenTests Lumen/ADBBridge/src/ADBBridge.cpp LumenTests/ADBStandIn.cpp bench/adb_sync_bench.cpp -o build/adb_sync_bench
+//   ./build/adb_sync_bench [file_count] [round_trip_us]
+
+#include "ADBBridge.h"
+#include "ADBStandIn.h"
+
+#include <sys/stat.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+static std::string dir;
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run(int files, bool v2) {
+    adb_standin_set_v2(v2);
+    adb_disconnect();
+    if (!adb_connect(NULL)) {
+        fprintf(stderr, "could not connect to the stand-in\n");
+        return;
+    }
+    printf("%s replies:\n", v2 ? "v2" : "v1");
+
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    ADBFileInfo* list = adb_list_files("/sdcard", &count);
+    printf("  LIST %d entries: %.2f ms\n", count, ms_since(start));
+    adb_free_files(list);
+
+    std::vector<std::string> paths;
+    for (int i = 0; i < files; i++) paths.push_back("/sdcard/file_" + std::to_string(i) + ".txt");
+    std::vector<const char*> cpaths;
+    for (auto& p : paths) cpaths.push_back(p.c_str());
+    std::vector<ADBFileInfo> infos(files);
+
+    long reads = adb_standin_sync_reads();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < files; i++) adb_stat(cpaths[i], &infos[i]);
+    double sequential = ms_since(start);
+    long sequential_reads = adb_standin_sync_reads() - reads;
+
+    reads = adb_standin_sync_reads();
+    start = std::chrono::steady_clock::now();
+    adb_stat_many(cpaths.data(), files, infos.data());
+    double pipelined = ms_since(start);
+    long pipelined_reads = adb_standin_sync_reads() - reads;
+
+    printf("  STAT x%d: sequential %.2f ms (%ld reads), pipelined %.2f ms (%ld reads)\n",
+           files, sequential, sequential_reads, pipelined, pipelined_reads);
+
+    // Round trip a 5 MB file through SEND and RECV
+    std::string local = dir + "/upload.bin";
+    std::string back = dir + "/download.bin";
+    FILE* f = fopen(local.c_str(), "wb");
+    for (int i = 0; i < 5 * 1024 * 1024; i++) fputc((i * 31) & 0xFF, f);
+    fclose(f);
+
+    start = std::chrono::steady_clock::now();
+    adb_upload_file(local.c_str(), "/sdcard/DCIM/upload.bin", NULL, NULL);
+    adb_download_file("/sdcard/DCIM/upload.bin", back.c_str(), NULL, NULL);
+    printf("  SEND + RECV 5 MB: %.2f ms\n", ms_since(start));
+
+    adb_delete_file("/sdcard/DCIM/upload.bin");
+    unlink(local.c_str());
+    unlink(back.c_str());
+}
+
+int main(int argc, char** argv) {
+    signal(SIGPIPE, SIG_IGN);
+    int files = argc > 1 ? atoi(argv[1]) : 2000;
+    int round_trip_us = argc > 2 ? atoi(argv[2]) : 200;
+
+    char tmp[] = "/tmp/adb_standin_XXXXXX";
+    if (!mkdtemp(tmp)) return 1;
+    dir = tmp;
+    std::string root = dir + "/device";
+    mkdir(root.c_str(), 0755);
+    mkdir((root + "/sdcard").c_str(), 0755);
+    mkdir((root + "/sdcard/DCIM").c_str(), 0755);
+    for (int i = 0; i < files; i++) {
+        FILE* f = fopen((root + "/sdcard/file_" + std::to_string(i) + ".txt").c_str(), "wb");
+        fwrite("0123456789abcdef", 1, 10 + i % 7, f);
+        fclose(f);
+    }
+
+    adb_standin_set_round_trip_us(round_trip_us);
+    adb_set_server("127.0.0.1", adb_standin_start(root.c_str()));
+
+    run(files, true);
+    run(files, false);
+    adb_disconnect();
+
+    system(("rm -rf " + dir).c_str());
+    return 0;
+}
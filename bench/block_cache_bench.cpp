@@ -0,0 +1,95 @@
+// Estimates what previews cost over USB with the range-read block cache.
+//
+// The "device" is a synthetic object whose bytes are a function of their
+// offset, with a cost model per fetch (fixed round trip plus transfer time),
+// so results don't depend on having a phone attached. Compares pulling the
+// whole object, as previews did before, with reading only the touched ranges.
+// The readahead and edge-case checks live in LumenTests/BlockCacheTests.swift.
+//
+// Build and run from the repository root:
+//   mkdir -p build
+//   c++ -std=c++17 -O2 -I Lumen/BlockCache/include Lumen/BlockCache/src/BlockCache.cpp bench/block_cache_bench.cpp -o build/block_cache_bench
+//   ./build/block_cache_bench [object_mb]
+
+#include "BlockCache.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+// Roughly a USB 2 MTP session: a few ms per request, ~35 MB/s of payload
+static const double ROUND_TRIP_MS = 4.0;
+static const double BYTES_PER_MS = 35.0 * 1024 * 1024 / 1000;
+
+static uint8_t byte_at(uint64_t offset) {
+    uint64_t x = offset * 0x9E3779B97F4A7C15ull;
+    return (uint8_t)(x >> 56);
+}
+
+struct Device {
+    uint64_t size;
+    double busy_ms = 0;
+    uint64_t requests = 0;
+
+    int64_t fetch(uint64_t offset, uint32_t length, uint8_t* out) {
+        requests++;
+        if (offset >= size) return 0;
+        uint32_t n = (uint32_t)std::min<uint64_t>(length, size - offset);
+        for (uint32_t i = 0; i < n; i++) out[i] = byte_at(offset + i);
+        busy_ms += ROUND_TRIP_MS + n / BYTES_PER_MS;
+        return n;
+    }
+};
+
+static BlockCache make_cache(Device& device, uint32_t max_readahead = BlockCache::DEFAULT_MAX_READAHEAD) {
+    return BlockCache(device.size, [&device](uint64_t offset, uint32_t length, uint8_t* out) {
+        return device.fetch(offset, length, out);
+    }, BlockCache::DEFAULT_BLOCK_SIZE, BlockCache::DEFAULT_CAPACITY, max_readahead);
+}
+
+// Sequential playback in 64 KB reads, the way AVFoundation pulls media
+static void playback(BlockCache& cache, uint64_t start, uint64_t bytes) {
+    std::vector<uint8_t> chunk(64 * 1024);
+    for (uint64_t offset = start; offset < start + bytes; offset += chunk.size()) {
+        if (cache.read(offset, chunk.data(), (uint32_t)chunk.size()) <= 0) break;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t size = (argc > 1 ? strtoull(argv[1], NULL, 10) : 3072) * 1024 * 1024 + 12345;
+    double full_ms = ROUND_TRIP_MS * ((size + (1 << 20) - 1) >> 20) + size / BYTES_PER_MS;
+    printf("object %.0f MB; whole download before previewing: %.1f s\n", size / 1048576.0, full_ms / 1000);
+
+    // First page of a document
+    {
+        Device device{ size };
+        BlockCache cache = make_cache(device);
+        std::vector<uint8_t> page(200 * 1024);
+        cache.read(0, page.data(), (uint32_t)page.size());
+        printf("  first 200 KB:            %4llu requests, %7.1f ms\n", (unsigned long long)device.requests, device.busy_ms);
+    }
+
+    // Scrubbing: jump around, play a couple of seconds at each spot
+    {
+        Device device{ size };
+        BlockCache cache = make_cache(device);
+        std::mt19937_64 rng(7);
+        for (int i = 0; i < 20; i++) {
+            playback(cache, rng() % (size - 4 * 1024 * 1024), 2 * 1024 * 1024);
+        }
+        printf("  20 seeks x 2 MB:         %4llu requests, %7.1f ms\n", (unsigned long long)device.requests, device.busy_ms);
+    }
+
+    // Sequential playback with and without readahead
+    for (uint32_t max_readahead : { 1u, BlockCache::DEFAULT_MAX_READAHEAD }) {
+        Device device{ size };
+        BlockCache cache = make_cache(device, max_readahead);
+        playback(cache, 0, 256 * 1024 * 1024);
+        printf("  play 256 MB, readahead %2u: %4llu requests, %7.1f ms, %.1f MB/s\n", max_readahead,
+               (unsigned long long)device.requests, device.busy_ms, 256.0 / (device.busy_ms / 1000));
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Times saving and reopening a large device catalog snapshot.
+//
+// Records a phone-sized tree, saves it, then reopens the file the way a
+// reconnect does and reads every folder back. The round-trip, merge and
+// damaged-file checks live in LumenTests/DeviceCatalogTests.swift.
+//
+// Build and run from the repository root:
+//   mkdir -p build
+//   c++ -std=c++17 -O2 -pthread -I Lumen/DeviceCatalog/include Lumen/DeviceCatalog/src/DeviceCatalog.cpp bench/device_catalog_bench.cpp -o build/device_catalog_bench
+//   ./build/device_catalog_bench [folders] [files_per_folder]
+
+#include "DeviceCatalog.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string folder_key(int folder) {
+    return "65537/" + std::to_string(1000 + folder);
+}
+
+static void make_listing(int folder, int files, std::vector<DeviceCatalogEntry>& entries, std::vector<std::string>& names) {
+    entries.assign(files, DeviceCatalogEntry());
+    names.resize(files);
+    for (int i = 0; i < files; i++) {
+        DeviceCatalogEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.id = (uint64_t)folder * 100000 + i;
+        entry.size = 1000 + i * 37;
+        entry.modification_date = 1700000000 + i;
+        entry.storage_id = 65537;
+        entry.parent_id = 1000 + folder;
+        entry.is_directory = i % 10 == 0;
+        names[i] = "IMG_" + std::to_string(folder) + "_" + std::to_string(i) + ".jpg";
+    }
+}
+
+// Reads a folder the way the bridges do: copy records and names out
+static int read_folder(DeviceCatalog& catalog, const std::string& key, std::vector<DeviceCatalogEntry>& out,
+                       std::vector<std::string>& names) {
+    int count = -1;
+    catalog.with_folder(key, [&](const DeviceCatalogFolder& folder) {
+        out.assign(folder.entries, folder.entries + folder.count);
+        names.resize(folder.count);
+        char name[256];
+        for (uint32_t i = 0; i < folder.count; i++) {
+            names[i] = device_catalog_copy_name(folder, folder.entries[i], name, sizeof(name)) ? name : "";
+        }
+        count = (int)folder.count;
+    });
+    return count;
+}
+
+int main(int argc, char** argv) {
+    int folders = argc > 1 ? atoi(argv[1]) : 2000;
+    int files = argc > 2 ? atoi(argv[2]) : 50;
+
+    char dir[] = "/tmp/device_catalog_XXXXXX";
+    if (!mkdtemp(dir)) return 1;
+    std::string path = std::string(dir) + "/mtp-SERIAL123.catalog";
+
+    std::vector<DeviceCatalogEntry> entries;
+    std::vector<std::string> names;
+
+    {
+        DeviceCatalog catalog;
+        catalog.open(dir, "mtp", "SERIAL123");
+
+        // In reverse, so the save has to sort
+        for (int f = folders - 1; f >= 0; f--) {
+            make_listing(f, f == 7 ? 0 : files, entries, names);
+            catalog.put(folder_key(f), entries, names, 1700000000 + f);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        catalog.save();
+        struct stat st;
+        stat(path.c_str(), &st);
+        printf("%d folders x %d files: save %.2f ms, %.1f MB on disk (%.0f bytes per file)\n",
+               folders, files, ms_since(start), st.st_size / 1048576.0, (double)st.st_size / ((double)folders * files));
+    }
+
+    // Reconnect: one mmap and a validation pass over the folder table
+    DeviceCatalog catalog;
+    auto start = std::chrono::steady_clock::now();
+    catalog.open(dir, "mtp", "SERIAL123");
+    double open_ms = ms_since(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t read = 0;
+    for (int f = 0; f < folders; f++) {
+        if (read_folder(catalog, folder_key(f), entries, names) > 0) read += names.size();
+    }
+    double read_ms = ms_since(start);
+    printf("reopen %.3f ms, read back %zu files in all folders %.2f ms\n", open_ms, read, read_ms);
+    catalog.close();
+
+    // Time to first folder, which is what the file browser waits for
+    start = std::chrono::steady_clock::now();
+    {
+        DeviceCatalog again;
+        again.open(dir, "mtp", "SERIAL123");
+        read_folder(again, folder_key(folders / 2), entries, names);
+    }
+    printf("open + first folder %.3f ms\n", ms_since(start));
+
+    if (system(("rm -rf " + std::string(dir)).c_str()) != 0) fprintf(stderr, "could not remove %s\n", dir);
+    return 0;
+}
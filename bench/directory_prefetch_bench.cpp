@@ -0,0 +1,211 @@
+// Checks the directory prefetcher against a simulated USB device and times
+// drill-downs with and without it.
+//
+// Each listing holds the simulated bus for a fixed latency. A scripted user
+// opens a folder, looks at it for a moment, hovers over a subfolder and
+// usually opens that one. Checks that prefetching never overlaps real work,
+// stays off the bus during a long transfer and delays real work by at most
+// one listing.
+//
+// Build and run from the repository root:
+//   mkdir -p build
+//   c++ -std=c++17 -O2 -pthread -I Lumen/DirectoryPrefetcher/include Lumen/DirectoryPrefetcher/src/DirectoryPrefetcher.cpp bench/directory_prefetch_bench.cpp -o build/directory_prefetch_bench
+//   ./build/directory_prefetch_bench [listing_ms] [drill_downs]
+
+#include "DirectoryPrefetcher.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { fprintf(stderr, "FAILED: %s (line %d)\n", #cond, __LINE__); failures++; } } while (0)
+
+using Clock = std::chrono::steady_clock;
+
+static double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void sleep_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// One device: a single bus, and the listings the bridge has recorded
+struct SimulatedDevice {
+    int listing_ms;
+    std::atomic<int> on_bus{0};
+    std::atomic<int> overlaps{0};
+    std::atomic<int> listings{0};
+    std::mutex lock;
+    std::map<std::string, Clock::time_point> listed;
+
+    explicit SimulatedDevice(int listing_ms) : listing_ms(listing_ms) {}
+
+    void use_bus(int ms) {
+        if (on_bus++ > 0) overlaps++;
+        sleep_ms(ms);
+        on_bus--;
+    }
+
+    void list(const std::string& key) {
+        use_bus(listing_ms);
+        listings++;
+        std::lock_guard<std::mutex> guard(lock);
+        listed[key] = Clock::now();
+    }
+
+    bool fresh(const std::string& key) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = listed.find(key);
+        return found != listed.end() && Clock::now() - found->second < std::chrono::seconds(30);
+    }
+};
+
+static std::vector<std::string> children(const std::string& key) {
+    std::vector<std::string> keys;
+    for (int i = 0; i < 8; i++) keys.push_back(key + "/" + std::to_string(i));
+    return keys;
+}
+
+struct SessionResult {
+    int hits = 0;
+    double total_wait_ms = 0;
+    double worst_wait_ms = 0;
+};
+
+// Opens drill_downs folders the way the browser does: serve a fresh listing
+// if there is one, otherwise list in the foreground
+static SessionResult browse(SimulatedDevice& device, DirectoryPrefetcher* prefetcher, int drill_downs) {
+    SessionResult result;
+    std::string current = "/0";
+    unsigned seed = 7;
+    for (int step = 0; step < drill_downs; step++) {
+        auto start = Clock::now();
+        if (device.fresh(current)) {
+            result.hits++;
+        } else if (prefetcher) {
+            DirectoryPrefetcher::Foreground work(*prefetcher);
+            device.list(current);
+        } else {
+            device.list(current);
+        }
+        double wait = ms_since(start);
+        result.total_wait_ms += wait;
+        if (wait > result.worst_wait_ms) result.worst_wait_ms = wait;
+
+        std::vector<std::string> next = children(current);
+        if (prefetcher) prefetcher->schedule(next);
+
+        // Look around, hover, then usually open the hovered folder
+        seed = seed * 1103515245 + 12345;
+        int hovered = (seed >> 16) % next.size();
+        sleep_ms(300);
+        if (prefetcher) prefetcher->hint(next[hovered]);
+        sleep_ms(500);
+        seed = seed * 1103515245 + 12345;
+        int pick = (seed >> 16) % 10 < 7 ? hovered : (int)((seed >> 8) % next.size());
+        current = next[pick];
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int listing_ms = argc > 1 ? atoi(argv[1]) : 60;
+    int drill_downs = argc > 2 ? atoi(argv[2]) : 12;
+
+    // Baseline: every drill-down waits for the device
+    {
+        SimulatedDevice device(listing_ms);
+        SessionResult result = browse(device, nullptr, drill_downs);
+        printf("no prefetch:   %2d/%d served without the device, %.0f ms waited in total (worst %.0f ms)\n",
+               result.hits, drill_downs, result.total_wait_ms, result.worst_wait_ms);
+    }
+
+    {
+        SimulatedDevice device(listing_ms);
+        DirectoryPrefetcher prefetcher([&](const std::string& key) {
+            if (!device.fresh(key)) device.list(key);
+        });
+        SessionResult result = browse(device, &prefetcher, drill_downs);
+        printf("with prefetch: %2d/%d served without the device, %.0f ms waited in total (worst %.0f ms), %d listings\n",
+               result.hits, drill_downs, result.total_wait_ms, result.worst_wait_ms, device.listings.load());
+        CHECK(device.overlaps == 0);
+        CHECK(result.hits >= drill_downs / 2);
+        // Real work waits for at most the one folder in flight
+        CHECK(result.worst_wait_ms < 2.5 * listing_ms + 20);
+    }
+
+    // A long transfer keeps the prefetcher off the bus entirely
+    {
+        SimulatedDevice device(listing_ms);
+        DirectoryPrefetcher prefetcher([&](const std::string& key) { device.list(key); },
+                                       std::chrono::milliseconds(100));
+        prefetcher.schedule(children("/0"));
+        sleep_ms(listing_ms / 2);   // Let the first folder start
+
+        auto start = Clock::now();
+        int before = 0;
+        {
+            DirectoryPrefetcher::Foreground first(prefetcher);
+            double waited = ms_since(start);
+            printf("transfer start waited %.0f ms for the folder in flight\n", waited);
+            CHECK(waited < listing_ms + 20);
+            before = device.listings;
+        }
+        // Chunks back to back with short gaps, well inside the idle delay
+        for (int chunk = 0; chunk < 20; chunk++) {
+            DirectoryPrefetcher::Foreground work(prefetcher);
+            device.use_bus(20);
+            sleep_ms(0);
+        }
+        int during = device.listings - before;
+        printf("prefetch listings during a 400 ms transfer: %d\n", during);
+        CHECK(during == 0);
+        CHECK(device.overlaps == 0);
+
+        // Once idle again it carries on
+        auto idle = Clock::now();
+        while (prefetcher.pending() > 0 && ms_since(idle) < 10000) sleep_ms(10);
+        sleep_ms(listing_ms + 20);
+        CHECK(prefetcher.pending() == 0);
+        CHECK(device.listings == 8);
+        CHECK(device.overlaps == 0);
+    }
+
+    // A hint jumps the queue, and cancel drops the rest
+    {
+        SimulatedDevice device(listing_ms);
+        std::mutex order_lock;
+        std::vector<std::string> order;
+        DirectoryPrefetcher prefetcher([&](const std::string& key) {
+            {
+                std::lock_guard<std::mutex> guard(order_lock);
+                order.push_back(key);
+            }
+            device.list(key);
+        }, std::chrono::milliseconds(50));
+        {
+            DirectoryPrefetcher::Foreground work(prefetcher);
+            prefetcher.schedule(children("/h"));
+            prefetcher.hint("/h/5");
+        }
+        sleep_ms(50 + listing_ms * 2 + 30);
+        prefetcher.cancel();
+        sleep_ms(listing_ms + 20);
+        std::lock_guard<std::mutex> guard(order_lock);
+        CHECK(!order.empty() && order[0] == "/h/5");
+        CHECK(order.size() >= 2 && order[1] == "/h/0");
+        CHECK(order.size() < 8);
+        CHECK(prefetcher.pending() == 0);
+    }
+
+    printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+// Counts heap allocations the bridges make while listing a large folder.
+//
+// Links the real MTPBridge.cpp and iOSBridge.cpp against the stub device in
+// bench/stub_device, which hands them a simulated phone. Every operator new
+// in the process is counted; the stubs allocate with malloc, as libmtp and
+// libimobiledevice do, so what is counted is the bridges' own work per
+// listing: converting to the records Swift reads, building paths, recording
+// the folder in the device catalog and freeing the result. Checks that
+// repeated listings allocate nothing once the listing pool is warm, and that
+// the catalog still gets every name.
+//
+// Build and run from the repository root:
+//   mkdir -p build
+//   c++ -std=c++17 -O2 -pthread -I bench/stub_device -I Lumen -I Lumen/iOSBridge/include -I Lumen/ListingPool/include -I Lumen/DeviceCatalog/include -I Lumen/BlockCache/include -I Lumen/DirectoryPrefetcher/include Lumen/MTPBridge.cpp Lumen/iOSBridge/src/iOSBridge.cpp Lumen/ListingPool/src/ListingPool.cpp Lumen/DeviceCatalog/src/DeviceCatalog.cpp Lumen/BlockCache/src/BlockCache.cpp Lumen/DirectoryPrefetcher/src/DirectoryPrefetcher.cpp bench/stub_device/stub_device.cpp bench/listing_pool_bench.cpp -o build/listing_pool_bench
+//   ./build/listing_pool_bench [entries] [listings]
+
+#include "MTPBridge.hpp"
+#include "iOSBridge.h"
+#include "stub_device.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { fprintf(stderr, "FAILED: %s (line %d)\n", #cond, __LINE__); failures++; } } while (0)
+
+static std::atomic<long> allocations{0};
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocations++;
+    return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// iOSBridge's ids: djb2 over the full device path
+static uint64_t simple_hash(const std::string& str) {
+    uint64_t hash = 5381;
+    for (char c : str) hash = ((hash << 5) + hash) + c;
+    return hash;
+}
+
+struct Measure {
+    long first = 0;             // Allocations in the first listing
+    long steady_max = 0;        // Most in any later listing
+    double steady_ms = 0;       // Average time of the later listings
+};
+
+template <typename Fn>
+static Measure measure(int listings, Fn list_and_free) {
+    Measure m;
+    double total_ms = 0;
+    for (int n = 0; n < listings; n++) {
+        long before = allocations;
+        auto start = std::chrono::steady_clock::now();
+        list_and_free();
+        double ms = ms_since(start);
+        long made = allocations - before;
+        if (n == 0) {
+            m.first = made;
+        } else {
+            if (made > m.steady_max) m.steady_max = made;
+            total_ms += ms;
+        }
+    }
+    m.steady_ms = listings > 1 ? total_ms / (listings - 1) : 0;
+    return m;
+}
+
+template <typename Info>
+static bool same_names(const Info* files, int count, const std::vector<std::string>& expected, int expected_count) {
+    if (count != expected_count || (count > 0 && !files)) return false;
+    for (int i = 0; i < count; i++) {
+        if (expected[i] != files[i].name) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int entries = argc > 1 ? atoi(argv[1]) : 10000;
+    int listings = argc > 2 ? atoi(argv[2]) : 20;
+    if (entries < 2) entries = 2;
+
+    char dir[] = "/tmp/listing_pool_XXXXXX";
+    if (!mkdtemp(dir)) return 1;
+
+    std::vector<std::string> names(entries);
+    for (int i = 0; i < entries; i++) {
+        char name[64];
+        stub_device_file_name(i, name, sizeof(name));
+        names[i] = name;
+    }
+    stub_device_set_folder_size(entries);
+
+    printf("%d-entry folder, %d listings each\n", entries, listings);
+
+    mtp_set_catalog_directory(dir);
+    CHECK(mtp_connect());
+    ios_set_catalog_directory(dir);
+    CHECK(ios_connect());
+
+    {
+        MTPFileInfo* check = nullptr;
+        Measure m = measure(listings, [&] {
+            int count = 0;
+            MTPFileInfo* files = mtp_list_files(65537, 42, &count);
+            CHECK(count == entries);
+            if (!check) check = files;
+            CHECK(files == check);     // Same block every time
+            CHECK(files && strcmp(files[entries - 1].name, names[entries - 1].c_str()) == 0);
+            mtp_free_files(files);
+        });
+
+        int count = 0;
+        MTPFileInfo* cached = mtp_list_cached_files(65537, 42, &count, NULL);
+        CHECK(same_names(cached, count, names, entries));
+        mtp_free_files(cached);
+
+        printf("mtp listing: %6ld allocations first, %6ld steady, %.2f ms\n", m.first, m.steady_max, m.steady_ms);
+        // The first listing grows the scratch strings by doubling
+        CHECK(m.first < 64);
+        CHECK(m.steady_max == 0);
+    }
+
+    {
+        const char* path = "/DCIM/100APPLE";
+        uint64_t last_id = 0;
+        Measure m = measure(listings, [&] {
+            int count = 0;
+            iOSFileInfo* files = ios_list_files("DCIM/100APPLE", &count);
+            CHECK(count == entries);
+            if (files) last_id = files[entries - 1].id;
+            ios_free_files(files);
+        });
+
+        int count = 0;
+        iOSFileInfo* cached = ios_list_cached_files(path, &count, NULL);
+        CHECK(same_names(cached, count, names, entries));
+        ios_free_files(cached);
+        // Ids still hash the full path
+        CHECK(last_id == simple_hash(std::string(path) + "/" + names[entries - 1]));
+
+        printf("ios listing: %6ld allocations first, %6ld steady, %.2f ms\n", m.first, m.steady_max, m.steady_ms);
+        CHECK(m.first < 64);
+        CHECK(m.steady_max == 0);
+    }
+
+    // Browsing around folders of different sizes settles too
+    {
+        int sizes[] = { 12, entries, 300, entries / 2, 1 };
+        long steady = 0;
+        for (int round = 0; round < 3; round++) {
+            long before = allocations;
+            for (int size : sizes) {
+                stub_device_set_folder_size(size);
+                int count = 0;
+                MTPFileInfo* files = mtp_list_files(65537, 100 + size, &count);
+                CHECK(count == size);
+                mtp_free_files(files);
+            }
+            if (round > 0) steady += allocations - before;
+        }
+        printf("browsing 5 folders of mixed sizes: %ld allocations after the first pass\n", steady);
+        CHECK(steady == 0);
+    }
+
+    // Two listings at once, as the iOS bridge allows, each get their own buffers
+    {
+        const int folder = entries < 500 ? entries : 500;
+        stub_device_set_folder_size(folder);
+        std::atomic<int> wrong{0};
+        auto browse = [&](const char* path) {
+            for (int n = 0; n < 50; n++) {
+                int count = 0;
+                iOSFileInfo* files = ios_list_files(path, &count);
+                if (!same_names(files, count, names, folder)) wrong++;
+                ios_free_files(files);
+            }
+        };
+        std::thread a(browse, "/DCIM/100APPLE");
+        std::thread b(browse, "/DCIM/101APPLE");
+        a.join();
+        b.join();
+        CHECK(wrong == 0);
+    }
+
+    mtp_disconnect();
+    ios_disconnect();
+
+    std::string cleanup = std::string("rm -rf ") + dir;
+    if (system(cleanup.c_str()) != 0) fprintf(stderr, "could not remove %s\n", dir);
+
+    printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+// Builds a synthetic catalog and times filename queries against the native
+// search index and against a linear scan of the same names.
+//
+// Names mimic what a phone and a Mac hold: camera rolls, screenshots,
+// downloads, music and documents, spread over a few thousand folders. The
+// query, facet and re-listing checks live in LumenTests/SearchIndexTests.swift.
+//
+// Build and run from the repository root:
+//   mkdir -p build
+//   c++ -std=c++17 -O2 -pthread -I Lumen/SearchIndex/include Lumen/SearchIndex/src/SearchIndex.cpp bench/search_index_bench.cpp -o build/search_index_bench
+//   ./build/search_index_bench [file_count]
+
+#include "SearchIndex.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct File {
+    SearchSource source;
+    std::string directory;
+    std::string name;
+    uint64_t size;
+    int64_t date;
+    SearchFileType type;
+};
+
+static const char* WORDS[] = {
+    "invoice", "receipt", "report", "vacation", "holiday", "resume", "budget", "contract",
+    "meeting", "notes", "project", "draft", "final", "summary", "tax", "letter", "family",
+    "wedding", "birthday", "lecture", "slides", "manual", "passport", "insurance", "lease"
+};
+static const char* ARTISTS[] = { "Radiohead", "Daft Punk", "Nina Simone", "Bonobo", "Khruangbin", "Portishead" };
+
+static std::vector<File> make_catalog(int count) {
+    std::mt19937 rng(42);
+    std::vector<File> files;
+    files.reserve(count);
+    const int64_t base = 1600000000;
+    for (int i = 0; i < count; i++) {
+        File f;
+        int kind = (int)(rng() % 10);
+        int folder = (int)(rng() % 4000);
+        f.date = base + (int64_t)(rng() % 150000000);
+        f.size = 1000 + rng() % 20000000;
+        char name[200];
+        if (kind < 5) {
+            f.source = SEARCH_SOURCE_MTP;
+            f.directory = "mtp://65537/" + std::to_string(folder);
+            snprintf(name, sizeof(name), "%s_%08d_%06d.%s", kind < 4 ? "IMG" : "VID", 20200000 + i % 50000, i,
+                     kind < 4 ? "jpg" : "mp4");
+            f.type = kind < 4 ? SEARCH_TYPE_IMAGE : SEARCH_TYPE_VIDEO;
+        } else if (kind < 6) {
+            f.source = SEARCH_SOURCE_IOS;
+            f.directory = "/DCIM/" + std::to_string(100 + folder % 20) + "APPLE";
+            snprintf(name, sizeof(name), "Screenshot %d-%02d-%02d at %d.%02d.png", 2020 + i % 5, 1 + i % 12,
+                     1 + i % 28, i % 24, i % 60);
+            f.type = SEARCH_TYPE_IMAGE;
+        } else if (kind < 7) {
+            f.source = SEARCH_SOURCE_LOCAL;
+            f.directory = "/Users/me/Music/" + std::string(ARTISTS[folder % 6]);
+            snprintf(name, sizeof(name), "%s - Track %d.mp3", ARTISTS[folder % 6], i);
+            f.type = SEARCH_TYPE_AUDIO;
+        } else {
+            f.source = SEARCH_SOURCE_LOCAL;
+            f.directory = "/Users/me/Documents/" + std::to_string(folder);
+            const char* a = WORDS[rng() % 25];
+            const char* b = WORDS[rng() % 25];
+            snprintf(name, sizeof(name), "%s_%s_%d.%s", a, b, i, kind == 9 ? "docx" : "pdf");
+            f.type = SEARCH_TYPE_DOCUMENT;
+        }
+        f.name = name;
+        files.push_back(std::move(f));
+    }
+    return files;
+}
+
+static void add_file(SearchIndex* index, const File& f) {
+    std::string path = f.directory + "/" + f.name;
+    search_index_add(index, f.source, f.directory.c_str(), path.c_str(), f.name.c_str(), f.size, f.date, f.type);
+}
+
+// Reference: every term must be a case-insensitive substring of the name
+static int linear_count(const std::vector<File>& files, const std::vector<std::string>& terms) {
+    int matches = 0;
+    std::string folded;
+    for (const File& f : files) {
+        folded = f.name;
+        for (char& c : folded) c = (char)tolower((unsigned char)c);
+        bool all = true;
+        for (const std::string& t : terms) {
+            if (folded.find(t) == std::string::npos) { all = false; break; }
+        }
+        if (all) matches++;
+    }
+    return matches;
+}
+
+static void time_query(SearchIndex* index, const std::vector<File>& files, const char* text,
+                       std::vector<std::string> terms, bool fuzzy) {
+    SearchQuery query = search_default_query();
+    query.text = text;
+    query.fuzzy = fuzzy;
+    SearchResult results[50];
+    int total = 0;
+
+    const int rounds = 20;
+    auto start = std::chrono::steady_clock::now();
+    int n = 0;
+    for (int i = 0; i < rounds; i++) n = search_index_query(index, &query, results, 50, &total);
+    double indexed = ms_since(start) / rounds;
+
+    start = std::chrono::steady_clock::now();
+    linear_count(files, terms);
+    double linear = ms_since(start);
+
+    printf("  %-22s %7d hits  index %7.3f ms  linear scan %7.2f ms  top: %s\n",
+           text, total, indexed, linear, n > 0 ? results[0].name : "-");
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 500000;
+    std::vector<File> files = make_catalog(count);
+
+    size_t raw_bytes = 0;
+    for (const File& f : files) raw_bytes += f.name.size() + f.directory.size() + 1;
+
+    SearchIndex* index = search_index_create();
+    auto start = std::chrono::steady_clock::now();
+    for (const File& f : files) add_file(index, f);
+    double build = ms_since(start);
+
+    printf("%d files, %.1f MB of paths\n", count, raw_bytes / 1048576.0);
+    printf("  build %.0f ms, index %.1f MB\n", build, search_index_memory_usage(index) / 1048576.0);
+
+    printf("queries (mean of 20 runs):\n");
+    time_query(index, files, "invoice", { "invoice" }, false);
+    time_query(index, files, "tax receipt", { "tax", "receipt" }, false);
+    time_query(index, files, "IMG_2020", { "img_2020" }, false);
+    time_query(index, files, "screenshot 2023", { "screenshot", "2023" }, false);
+    time_query(index, files, "portishead", { "portishead" }, false);
+    time_query(index, files, "vacaton", { "vacaton" }, true);
+    time_query(index, files, "reciept", { "reciept" }, true);
+    time_query(index, files, "ax", { "ax" }, false);
+
+    // Facets: recent large videos from the phone, newest first
+    SearchQuery query = search_default_query();
+    SearchResult results[50];
+    int total = 0;
+    query.source_mask = SEARCH_SOURCE_BIT(SEARCH_SOURCE_MTP);
+    query.type_mask = SEARCH_TYPE_BIT(SEARCH_TYPE_VIDEO);
+    query.min_size = 10000000;
+    query.modified_after = 1700000000;
+    start = std::chrono::steady_clock::now();
+    search_index_query(index, &query, results, 50, &total);
+    printf("  %-22s %7d hits  index %7.3f ms\n", "(facets only)", total, ms_since(start));
+
+    // Dropping a disconnected phone compacts the index
+    int phone = search_index_count(index, SEARCH_SOURCE_BIT(SEARCH_SOURCE_MTP), SEARCH_ALL);
+    start = std::chrono::steady_clock::now();
+    search_index_clear_source(index, SEARCH_SOURCE_MTP);
+    printf("  clear %d phone entries + compact: %.0f ms, index %.1f MB\n", phone, ms_since(start),
+           search_index_memory_usage(index) / 1048576.0);
+
+    search_index_free(index);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef AFC_STUB_H
+#define AFC_STUB_H
+
+#include "libimobiledevice.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct afc_client_private* afc_client_t;
+typedef enum {
+    AFC_E_SUCCESS = 0,
+    AFC_E_INVALID_ARG = 7,
+    AFC_E_OBJECT_NOT_FOUND = 8,
+    AFC_E_PERM_DENIED = 10,
+    AFC_E_OBJECT_EXISTS = 16,
+    AFC_E_NO_RESOURCES = 13,
+    AFC_E_IO_ERROR = 14
+} afc_error_t;
+typedef enum { AFC_FOPEN_RDONLY = 1, AFC_FOPEN_WRONLY = 4 } afc_file_mode_t;
+
+afc_error_t afc_client_start_service(idevice_t device, afc_client_t* client, const char* label);
+afc_error_t afc_client_free(afc_client_t client);
+afc_error_t afc_read_directory(afc_client_t client, const char* path, char*** directory_information);
+afc_error_t afc_get_file_info(afc_client_t client, const char* path, char*** file_information);
+afc_error_t afc_dictionary_free(char** dictionary);
+afc_error_t afc_file_open(afc_client_t client, const char* filename, afc_file_mode_t file_mode, uint64_t* handle);
+afc_error_t afc_file_close(afc_client_t client, uint64_t handle);
+afc_error_t afc_file_read(afc_client_t client, uint64_t handle, char* data, uint32_t length, uint32_t* bytes_read);
+afc_error_t afc_file_write(afc_client_t client, uint64_t handle, const char* data, uint32_t length, uint32_t* bytes_written);
+afc_error_t afc_file_seek(afc_client_t client, uint64_t handle, int64_t offset, int whence);
+afc_error_t afc_remove_path(afc_client_t client, const char* path);
+afc_error_t afc_remove_path_and_contents(afc_client_t client, const char* path);
+afc_error_t afc_make_directory(afc_client_t client, const char* path);
+afc_error_t afc_rename_path(afc_client_t client, const char* from, const char* to);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AFC_STUB_H */
@@ -0,0 +1,23 @@
+#ifndef HOUSE_ARREST_STUB_H
+#define HOUSE_ARREST_STUB_H
+
+#include "libimobiledevice.h"
+#include "afc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct house_arrest_client_private* house_arrest_client_t;
+typedef enum { HOUSE_ARREST_E_SUCCESS = 0, HOUSE_ARREST_E_INVALID_ARG = -1 } house_arrest_error_t;
+
+house_arrest_error_t house_arrest_client_start_service(idevice_t device, house_arrest_client_t* client, const char* label);
+house_arrest_error_t house_arrest_client_free(house_arrest_client_t client);
+house_arrest_error_t house_arrest_send_command(house_arrest_client_t client, const char* command, const char* appid);
+afc_error_t afc_client_new_from_house_arrest_client(house_arrest_client_t client, afc_client_t* afc_client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOUSE_ARREST_STUB_H */
@@ -0,0 +1,30 @@
+// The part of libimobiledevice's API that iOSBridge.cpp uses, declared as
+// libimobiledevice declares it. Implemented by stub_device.cpp.
+#ifndef IMOBILEDEVICE_STUB_H
+#define IMOBILEDEVICE_STUB_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// From libplist, which the real header pulls in
+typedef void* plist_t;
+typedef enum { PLIST_BOOLEAN, PLIST_UINT, PLIST_REAL, PLIST_STRING, PLIST_ARRAY, PLIST_DICT } plist_type;
+plist_type plist_get_node_type(plist_t node);
+void plist_get_string_val(plist_t node, char** val);
+void plist_free(plist_t plist);
+
+typedef struct idevice_private* idevice_t;
+typedef enum { IDEVICE_E_SUCCESS = 0, IDEVICE_E_NO_DEVICE = -3 } idevice_error_t;
+
+idevice_error_t idevice_new(idevice_t* device, const char* udid);
+idevice_error_t idevice_free(idevice_t device);
+idevice_error_t idevice_get_udid(idevice_t device, char** udid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMOBILEDEVICE_STUB_H */
@@ -0,0 +1,26 @@
+#ifndef LOCKDOWN_STUB_H
+#define LOCKDOWN_STUB_H
+
+#include "libimobiledevice.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct lockdownd_client_private* lockdownd_client_t;
+typedef enum {
+    LOCKDOWN_E_SUCCESS = 0,
+    LOCKDOWN_E_PASSWORD_PROTECTED = -17,
+    LOCKDOWN_E_INVALID_HOST_ID = -21
+} lockdownd_error_t;
+
+lockdownd_error_t lockdownd_client_new_with_handshake(idevice_t device, lockdownd_client_t* client, const char* label);
+lockdownd_error_t lockdownd_client_free(lockdownd_client_t client);
+lockdownd_error_t lockdownd_get_device_name(lockdownd_client_t client, char** device_name);
+lockdownd_error_t lockdownd_get_value(lockdownd_client_t client, const char* domain, const char* key, plist_t* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOCKDOWN_STUB_H */
@@ -0,0 +1,88 @@
+// The part of libmtp's API that MTPBridge.cpp uses, declared as libmtp
+// declares it. Implemented by stub_device.cpp so benches can run the real
+// bridge against a simulated phone.
+#ifndef LIBMTP_STUB_H
+#define LIBMTP_STUB_H
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct LIBMTP_devicestorage_struct {
+    uint32_t id;
+    struct LIBMTP_devicestorage_struct* next;
+} LIBMTP_devicestorage_t;
+
+typedef struct LIBMTP_error_struct {
+    int errornumber;
+    char* error_text;
+    struct LIBMTP_error_struct* next;
+} LIBMTP_error_t;
+
+typedef struct {
+    LIBMTP_devicestorage_t* storage;
+} LIBMTP_mtpdevice_t;
+
+typedef struct {
+    int devnum;
+} LIBMTP_raw_device_t;
+
+typedef enum { LIBMTP_ERROR_NONE = 0, LIBMTP_ERROR_NO_DEVICE_ATTACHED = 5 } LIBMTP_error_number_t;
+typedef enum { LIBMTP_FILETYPE_FOLDER, LIBMTP_FILETYPE_UNKNOWN = 44 } LIBMTP_filetype_t;
+typedef enum {
+    LIBMTP_DEVICECAP_GetPartialObject,
+    LIBMTP_DEVICECAP_SendPartialObject,
+    LIBMTP_DEVICECAP_EditObjects,
+    LIBMTP_DEVICECAP_MoveObject,
+    LIBMTP_DEVICECAP_CopyObject
+} LIBMTP_devicecap_t;
+
+typedef struct LIBMTP_file_struct {
+    uint32_t item_id;
+    uint32_t parent_id;
+    uint32_t storage_id;
+    char* filename;
+    uint64_t filesize;
+    time_t modificationdate;
+    LIBMTP_filetype_t filetype;
+    struct LIBMTP_file_struct* next;
+} LIBMTP_file_t;
+
+typedef int (*LIBMTP_progressfunc_t)(uint64_t const sent, uint64_t const total, void const* const data);
+
+#define LIBMTP_STORAGE_SORTBY_NOTSORTED 0
+
+void LIBMTP_Init(void);
+LIBMTP_error_number_t LIBMTP_Detect_Raw_Devices(LIBMTP_raw_device_t** devices, int* numdevs);
+LIBMTP_mtpdevice_t* LIBMTP_Open_Raw_Device_Uncached(LIBMTP_raw_device_t* rawdevice);
+void LIBMTP_Release_Device(LIBMTP_mtpdevice_t* device);
+int LIBMTP_Get_Storage(LIBMTP_mtpdevice_t* device, int const sortby);
+char* LIBMTP_Get_Modelname(LIBMTP_mtpdevice_t* device);
+char* LIBMTP_Get_Serialnumber(LIBMTP_mtpdevice_t* device);
+int LIBMTP_Check_Capability(LIBMTP_mtpdevice_t* device, LIBMTP_devicecap_t cap);
+LIBMTP_error_t* LIBMTP_Get_Errorstack(LIBMTP_mtpdevice_t* device);
+void LIBMTP_Clear_Errorstack(LIBMTP_mtpdevice_t* device);
+
+LIBMTP_file_t* LIBMTP_new_file_t(void);
+void LIBMTP_destroy_file_t(LIBMTP_file_t* file);
+LIBMTP_file_t* LIBMTP_Get_Files_And_Folders(LIBMTP_mtpdevice_t* device, uint32_t const storage, uint32_t const parent);
+LIBMTP_file_t* LIBMTP_Get_Filemetadata(LIBMTP_mtpdevice_t* device, uint32_t const fileid);
+int LIBMTP_Get_File_To_File(LIBMTP_mtpdevice_t* device, uint32_t const id, char const* const path,
+                            LIBMTP_progressfunc_t const callback, void const* const data);
+int LIBMTP_Send_File_From_File(LIBMTP_mtpdevice_t* device, char const* const path, LIBMTP_file_t* const filedata,
+                               LIBMTP_progressfunc_t const callback, void const* const data);
+int LIBMTP_GetPartialObject(LIBMTP_mtpdevice_t* device, uint32_t const id, uint64_t const offset,
+                            uint32_t const maxbytes, unsigned char** data, unsigned int* size);
+int LIBMTP_Delete_Object(LIBMTP_mtpdevice_t* device, uint32_t object_id);
+int LIBMTP_Move_Object(LIBMTP_mtpdevice_t* device, uint32_t object_id, uint32_t storage_id, uint32_t parent_id);
+int LIBMTP_Copy_Object(LIBMTP_mtpdevice_t* device, uint32_t object_id, uint32_t storage_id, uint32_t parent_id);
+int LIBMTP_Set_File_Name(LIBMTP_mtpdevice_t* device, LIBMTP_file_t* file, const char* newname);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBMTP_STUB_H */
@@ -0,0 +1,225 @@
+#include "stub_device.hpp"
+
+#include <libmtp.h>
+#include <libimobiledevice/libimobiledevice.h>
+#include <libimobiledevice/lockdown.h>
+#include <libimobiledevice/afc.h>
+#include <libimobiledevice/house_arrest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+static std::atomic<int> folder_size{0};
+
+static const uint32_t stub_storage_id = 65537;
+static const uint32_t first_item_id = 5000;
+
+void stub_device_set_folder_size(int entries) {
+    folder_size = entries < 0 ? 0 : entries;
+}
+
+int stub_device_folder_size() {
+    return folder_size;
+}
+
+void stub_device_file_name(int index, char* name, size_t size) {
+    snprintf(name, size, "IMG_20240615_%06d_HDR.jpg", index);
+}
+
+static char* file_name(int index) {
+    char name[64];
+    stub_device_file_name(index, name, sizeof(name));
+    return strdup(name);
+}
+
+// Opaque handles only need to be distinct and non-NULL
+static char handle_storage;
+#define STUB_HANDLE(type) ((type)(void*)&handle_storage)
+
+// MARK: - libmtp
+
+extern "C" {
+
+void LIBMTP_Init(void) {}
+
+LIBMTP_error_number_t LIBMTP_Detect_Raw_Devices(LIBMTP_raw_device_t** devices, int* numdevs) {
+    *devices = (LIBMTP_raw_device_t*)calloc(1, sizeof(LIBMTP_raw_device_t));
+    *numdevs = 1;
+    return LIBMTP_ERROR_NONE;
+}
+
+LIBMTP_mtpdevice_t* LIBMTP_Open_Raw_Device_Uncached(LIBMTP_raw_device_t*) {
+    LIBMTP_mtpdevice_t* device = (LIBMTP_mtpdevice_t*)calloc(1, sizeof(LIBMTP_mtpdevice_t));
+    device->storage = (LIBMTP_devicestorage_t*)calloc(1, sizeof(LIBMTP_devicestorage_t));
+    device->storage->id = stub_storage_id;
+    return device;
+}
+
+void LIBMTP_Release_Device(LIBMTP_mtpdevice_t* device) {
+    if (!device) return;
+    free(device->storage);
+    free(device);
+}
+
+int LIBMTP_Get_Storage(LIBMTP_mtpdevice_t*, int const) { return 0; }
+char* LIBMTP_Get_Modelname(LIBMTP_mtpdevice_t*) { return strdup("Stub Phone"); }
+char* LIBMTP_Get_Serialnumber(LIBMTP_mtpdevice_t*) { return strdup("STUB0001"); }
+int LIBMTP_Check_Capability(LIBMTP_mtpdevice_t*, LIBMTP_devicecap_t) { return 0; }
+LIBMTP_error_t* LIBMTP_Get_Errorstack(LIBMTP_mtpdevice_t*) { return NULL; }
+void LIBMTP_Clear_Errorstack(LIBMTP_mtpdevice_t*) {}
+
+LIBMTP_file_t* LIBMTP_new_file_t(void) {
+    return (LIBMTP_file_t*)calloc(1, sizeof(LIBMTP_file_t));
+}
+
+void LIBMTP_destroy_file_t(LIBMTP_file_t* file) {
+    if (!file) return;
+    free(file->filename);
+    free(file);
+}
+
+// One allocation per file plus its name, as libmtp does
+LIBMTP_file_t* LIBMTP_Get_Files_And_Folders(LIBMTP_mtpdevice_t*, uint32_t const storage, uint32_t const parent) {
+    LIBMTP_file_t* head = NULL;
+    LIBMTP_file_t** tail = &head;
+    int entries = folder_size;
+    for (int i = 0; i < entries; i++) {
+        LIBMTP_file_t* file = LIBMTP_new_file_t();
+        file->item_id = first_item_id + i;
+        file->parent_id = parent;
+        file->storage_id = storage;
+        file->filename = file_name(i);
+        file->filesize = 2000000 + i;
+        file->modificationdate = 1700000000 + i;
+        file->filetype = LIBMTP_FILETYPE_UNKNOWN;
+        *tail = file;
+        tail = &file->next;
+    }
+    return head;
+}
+
+LIBMTP_file_t* LIBMTP_Get_Filemetadata(LIBMTP_mtpdevice_t*, uint32_t const) { return NULL; }
+
+int LIBMTP_Get_File_To_File(LIBMTP_mtpdevice_t*, uint32_t const, char const* const, LIBMTP_progressfunc_t const, void const* const) {
+    return -1;
+}
+
+int LIBMTP_Send_File_From_File(LIBMTP_mtpdevice_t*, char const* const, LIBMTP_file_t* const, LIBMTP_progressfunc_t const, void const* const) {
+    return -1;
+}
+
+int LIBMTP_GetPartialObject(LIBMTP_mtpdevice_t*, uint32_t const, uint64_t const, uint32_t const, unsigned char**, unsigned int*) {
+    return -1;
+}
+
+int LIBMTP_Delete_Object(LIBMTP_mtpdevice_t*, uint32_t) { return -1; }
+int LIBMTP_Move_Object(LIBMTP_mtpdevice_t*, uint32_t, uint32_t, uint32_t) { return -1; }
+int LIBMTP_Copy_Object(LIBMTP_mtpdevice_t*, uint32_t, uint32_t, uint32_t) { return -1; }
+int LIBMTP_Set_File_Name(LIBMTP_mtpdevice_t*, LIBMTP_file_t*, const char*) { return -1; }
+
+// MARK: - libimobiledevice
+
+plist_type plist_get_node_type(plist_t) { return PLIST_DICT; }
+void plist_get_string_val(plist_t, char** val) { *val = NULL; }
+void plist_free(plist_t) {}
+
+idevice_error_t idevice_new(idevice_t* device, const char*) {
+    *device = STUB_HANDLE(idevice_t);
+    return IDEVICE_E_SUCCESS;
+}
+
+idevice_error_t idevice_free(idevice_t) { return IDEVICE_E_SUCCESS; }
+
+idevice_error_t idevice_get_udid(idevice_t, char** udid) {
+    *udid = strdup("00008030-STUB0001");
+    return IDEVICE_E_SUCCESS;
+}
+
+lockdownd_error_t lockdownd_client_new_with_handshake(idevice_t, lockdownd_client_t* client, const char*) {
+    *client = STUB_HANDLE(lockdownd_client_t);
+    return LOCKDOWN_E_SUCCESS;
+}
+
+lockdownd_error_t lockdownd_client_free(lockdownd_client_t) { return LOCKDOWN_E_SUCCESS; }
+
+lockdownd_error_t lockdownd_get_device_name(lockdownd_client_t, char** device_name) {
+    *device_name = strdup("Stub iPhone");
+    return LOCKDOWN_E_SUCCESS;
+}
+
+lockdownd_error_t lockdownd_get_value(lockdownd_client_t, const char*, const char*, plist_t* value) {
+    *value = NULL;
+    return LOCKDOWN_E_SUCCESS;
+}
+
+afc_error_t afc_client_start_service(idevice_t, afc_client_t* client, const char*) {
+    *client = STUB_HANDLE(afc_client_t);
+    return AFC_E_SUCCESS;
+}
+
+afc_error_t afc_client_free(afc_client_t) { return AFC_E_SUCCESS; }
+
+// A NULL-terminated array of names, each malloc'd, as AFC returns them
+afc_error_t afc_read_directory(afc_client_t, const char*, char*** directory_information) {
+    int entries = folder_size;
+    char** list = (char**)malloc(sizeof(char*) * (entries + 1));
+    for (int i = 0; i < entries; i++) list[i] = file_name(i);
+    list[entries] = NULL;
+    *directory_information = list;
+    return AFC_E_SUCCESS;
+}
+
+// Key/value pairs for the file the path ends in
+afc_error_t afc_get_file_info(afc_client_t, const char* path, char*** file_information) {
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    int index = 0;
+    if (sscanf(name, "IMG_20240615_%d_HDR.jpg", &index) != 1) return AFC_E_OBJECT_NOT_FOUND;
+
+    char value[32];
+    char** info = (char**)malloc(sizeof(char*) * 7);
+    info[0] = strdup("st_size");
+    snprintf(value, sizeof(value), "%d", 2000000 + index);
+    info[1] = strdup(value);
+    info[2] = strdup("st_ifmt");
+    info[3] = strdup("S_IFREG");
+    info[4] = strdup("st_mtime");
+    snprintf(value, sizeof(value), "%d", 1700000000 + index);
+    info[5] = strdup(value);
+    info[6] = NULL;
+    *file_information = info;
+    return AFC_E_SUCCESS;
+}
+
+afc_error_t afc_dictionary_free(char** dictionary) {
+    if (!dictionary) return AFC_E_SUCCESS;
+    for (int i = 0; dictionary[i]; i++) free(dictionary[i]);
+    free(dictionary);
+    return AFC_E_SUCCESS;
+}
+
+afc_error_t afc_file_open(afc_client_t, const char*, afc_file_mode_t, uint64_t*) { return AFC_E_IO_ERROR; }
+afc_error_t afc_file_close(afc_client_t, uint64_t) { return AFC_E_SUCCESS; }
+afc_error_t afc_file_read(afc_client_t, uint64_t, char*, uint32_t, uint32_t*) { return AFC_E_IO_ERROR; }
+afc_error_t afc_file_write(afc_client_t, uint64_t, const char*, uint32_t, uint32_t*) { return AFC_E_IO_ERROR; }
+afc_error_t afc_file_seek(afc_client_t, uint64_t, int64_t, int) { return AFC_E_IO_ERROR; }
+afc_error_t afc_remove_path(afc_client_t, const char*) { return AFC_E_IO_ERROR; }
+afc_error_t afc_remove_path_and_contents(afc_client_t, const char*) { return AFC_E_IO_ERROR; }
+afc_error_t afc_make_directory(afc_client_t, const char*) { return AFC_E_IO_ERROR; }
+afc_error_t afc_rename_path(afc_client_t, const char*, const char*) { return AFC_E_IO_ERROR; }
+
+house_arrest_error_t house_arrest_client_start_service(idevice_t, house_arrest_client_t*, const char*) {
+    return HOUSE_ARREST_E_INVALID_ARG;
+}
+
+house_arrest_error_t house_arrest_client_free(house_arrest_client_t) { return HOUSE_ARREST_E_SUCCESS; }
+
+house_arrest_error_t house_arrest_send_command(house_arrest_client_t, const char*, const char*) {
+    return HOUSE_ARREST_E_INVALID_ARG;
+}
+
+afc_error_t afc_client_new_from_house_arrest_client(house_arrest_client_t, afc_client_t*) { return AFC_E_IO_ERROR; }
+
+} // extern "C"
@@ -0,0 +1,18 @@
+#ifndef stub_device_hpp
+#define stub_device_hpp
+
+#include <stddef.h>
+
+// A simulated phone behind the libmtp and libimobiledevice stubs. One MTP
+// device and one iOS device are always attached, and every folder on either
+// holds the same files: stub_device_folder_size() of them, named by
+// stub_device_file_name(). The stubs allocate with malloc, as the real
+// libraries do, so operator new in a bench only sees the bridges.
+// Everything else the bridges call fails with an I/O error.
+
+void stub_device_set_folder_size(int entries);
+int stub_device_folder_size();
+// Camera-roll names, long enough to defeat the small-string optimization
+void stub_device_file_name(int index, char* name, size_t size);
+
+#endif /* stub_device_hpp */
@@ -0,0 +1,204 @@
+// Simulates transfer queues on several links and compares the scheduler's
+// ordering with running jobs one after another in submission order.
+//
+// Time is simulated: each link moves bytes at a fixed rate with a fixed cost
+// per file, and the scheduler's cost model is seeded with the same numbers.
+// The ordering and queue-state checks live in
+// LumenTests/TransferSchedulerTests.swift.
+//
+// Build and run from the repository root:
+//   mkdir -p build
+//   c++ -std=c++17 -O2 -I Lumen/TransferScheduler/include Lumen/TransferScheduler/src/TransferScheduler.cpp bench/transfer_scheduler_bench.cpp -o build/transfer_scheduler_bench
+//   ./build/transfer_scheduler_bench
+
+#include "TransferScheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+static const uint64_t MB = 1024 * 1024;
+
+struct LinkModel {
+    const char* name;
+    int slots;
+    double bytes_per_second;    // Per slot
+    double seconds_per_file;
+};
+
+struct File {
+    double submit_at;
+    const char* link;
+    uint64_t size;
+};
+
+struct Outcome {
+    double finished_at;
+    double started_at;
+};
+
+struct Run {
+    std::map<uint64_t, Outcome> outcomes;
+    std::map<uint64_t, const File*> files;
+    double makespan = 0;
+};
+
+static double duration(const LinkModel& model, uint64_t size) {
+    return model.seconds_per_file + (double)size / model.bytes_per_second;
+}
+
+// Event loop over simulated time: submit arrivals, start whatever the
+// scheduler hands out, finish the earliest running job, repeat
+static Run simulate(TransferScheduler* scheduler, const std::vector<LinkModel>& models, const std::vector<File>& files) {
+    Run run;
+    struct Running { uint64_t id; const LinkModel* model; double ends_at; };
+    std::vector<Running> running;
+    size_t next_file = 0;
+    double now = 0;
+
+    for (;;) {
+        while (next_file < files.size() && files[next_file].submit_at <= now) {
+            const File& file = files[next_file++];
+            uint64_t id = transfer_scheduler_submit(scheduler, file.link, "file", file.size);
+            run.files[id] = &file;
+        }
+        for (const LinkModel& model : models) {
+            while (uint64_t id = transfer_scheduler_take(scheduler, model.name)) {
+                running.push_back({ id, &model, now + duration(model, run.files[id]->size) });
+                run.outcomes[id].started_at = now;
+            }
+        }
+
+        double next_arrival = next_file < files.size() ? files[next_file].submit_at : 1e300;
+        auto first = std::min_element(running.begin(), running.end(),
+                                      [](const Running& a, const Running& b) { return a.ends_at < b.ends_at; });
+        if (first == running.end() && next_file >= files.size()) break;
+        if (first == running.end() || next_arrival < first->ends_at) {
+            now = next_arrival;
+            continue;
+        }
+        now = first->ends_at;
+        transfer_scheduler_finish(scheduler, first->id, 0);
+        run.outcomes[first->id].finished_at = now;
+        running.erase(first);
+    }
+    run.makespan = now;
+    return run;
+}
+
+static TransferScheduler* make_scheduler(const std::vector<LinkModel>& models) {
+    TransferScheduler* scheduler = transfer_scheduler_create();
+    for (const LinkModel& model : models) {
+        transfer_scheduler_set_link_limit(scheduler, model.name, model.slots);
+        transfer_scheduler_set_link_estimate(scheduler, model.name, model.bytes_per_second, model.seconds_per_file);
+    }
+    return scheduler;
+}
+
+// Submission order on one slot, what TransferManager did before
+static Run simulate_fifo(const LinkModel& model, const std::vector<File>& files) {
+    Run run;
+    double now = 0;
+    uint64_t id = 1;
+    for (const File& file : files) {
+        now = std::max(now, file.submit_at);
+        run.outcomes[id].started_at = now;
+        now += duration(model, file.size);
+        run.outcomes[id].finished_at = now;
+        run.files[id++] = &file;
+    }
+    run.makespan = now;
+    return run;
+}
+
+static int finished_by(const Run& run, double t) {
+    int n = 0;
+    for (const auto& entry : run.outcomes) if (entry.second.finished_at <= t) n++;
+    return n;
+}
+
+static double last_small_done(const Run& run, uint64_t threshold) {
+    double t = 0;
+    for (const auto& entry : run.outcomes) {
+        if (run.files.at(entry.first)->size < threshold) t = std::max(t, entry.second.finished_at);
+    }
+    return t;
+}
+
+int main() {
+    std::mt19937 random(42);
+    const LinkModel usb = { "mtp", 1, 30.0 * MB, 0.03 };
+
+    // Two phone videos queued ahead of 400 photos, all at once
+    {
+        std::vector<File> files;
+        files.push_back({ 0, "mtp", 2048 * MB });
+        files.push_back({ 0, "mtp", 1536 * MB });
+        std::uniform_int_distribution<uint64_t> photo(1 * MB, 5 * MB);
+        for (int i = 0; i < 400; i++) files.push_back({ 0, "mtp", photo(random) });
+
+        Run fifo = simulate_fifo(usb, files);
+        TransferScheduler* scheduler = make_scheduler({ usb });
+        Run scheduled = simulate(scheduler, { usb }, files);
+
+        printf("2 videos + 400 photos on one USB link\n");
+        printf("  in order:  photos done at %6.1f s, %3d files after 60 s, all done at %.1f s\n",
+               last_small_done(fifo, 8 * MB), finished_by(fifo, 60), fifo.makespan);
+        printf("  scheduled: photos done at %6.1f s, %3d files after 60 s, all done at %.1f s\n",
+               last_small_done(scheduled, 8 * MB), finished_by(scheduled, 60), scheduled.makespan);
+        transfer_scheduler_free(scheduler);
+    }
+
+    // A video waits its fair share, not forever, while photos keep arriving
+    {
+        std::vector<File> files;
+        files.push_back({ 0, "mtp", 1024 * MB });
+        for (int i = 0; i < 3000; i++) files.push_back({ i * 0.05, "mtp", 2 * MB });
+
+        TransferScheduler* scheduler = make_scheduler({ usb });
+        Run scheduled = simulate(scheduler, { usb }, files);
+        double video_start = scheduled.outcomes[1].started_at;
+        double video_seconds = duration(usb, 1024 * MB);
+        printf("1 video while photos arrive for 150 s: video starts at %.1f s (it takes %.1f s)\n",
+               video_start, video_seconds);
+        transfer_scheduler_free(scheduler);
+    }
+
+    // Three links at once, each on its own schedule
+    {
+        std::vector<LinkModel> models = {
+            usb,
+            { "ios", 1, 25.0 * MB, 0.02 },
+            { "wireless:peer", 2, 6.0 * MB, 0.05 },
+        };
+        std::vector<File> files;
+        std::uniform_int_distribution<uint64_t> photo(1 * MB, 5 * MB);
+        for (const LinkModel& model : models) {
+            files.push_back({ 0, model.name, 600 * MB });
+            for (int i = 0; i < 150; i++) files.push_back({ 0, model.name, photo(random) });
+        }
+
+        TransferScheduler* scheduler = make_scheduler(models);
+        Run scheduled = simulate(scheduler, models, files);
+        // Each link on its own, one job at a time, and all of them in turn
+        double serial = 0, slowest_link = 0;
+        for (const LinkModel& model : models) {
+            double on_link = 0;
+            for (const File& file : files) {
+                if (!strcmp(model.name, file.link)) on_link += duration(model, file.size);
+            }
+            serial += on_link;
+            slowest_link = std::max(slowest_link, on_link);
+        }
+        printf("3 links: all done at %.1f s (slowest link alone %.1f s, one job at a time %.1f s)\n",
+               scheduled.makespan, slowest_link, serial);
+        transfer_scheduler_free(scheduler);
+    }
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Loopback throughput benchmark for the native wireless engine.
+//
+// Build and run from the repository root (Linux or macOS):
+//   mkdir -p build
+//   c++ -std=c++17 -O2 -pthread -I Lumen/WirelessBridge/include Lumen/WirelessBridge/src/*.cpp bench/wireless_loopback_bench.cpp -o build/wireless_loopback_bench
+//   (add -DWIRELESS_WITH_ZSTD=1 -DWIRELESS_WITH_LZ4=1 -I/opt/homebrew/include -L/opt/homebrew/lib -llz4 -lzstd
+//    to exercise compression)
+//   ./build/wireless_loopback_bench [size_mb] [max_streams]
+
+#include "WirelessBridge.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct BenchState {
+    std::mutex lock;
+    std::condition_variable done;
+    bool finished = false;
+    int result = 0;
+    std::string savedPath;
+};
+
+static bool accept_all(const char*, uint64_t, const void*) {
+    return true;
+}
+
+static void on_complete(const char*, const char* saved_path, int result, const void* context) {
+    BenchState* state = (BenchState*)context;
+    std::lock_guard<std::mutex> guard(state->lock);
+    state->finished = true;
+    state->result = result;
+    state->savedPath = saved_path ? saved_path : "";
+    state->done.notify_all();
+}
+
+static uint64_t checksum(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return 0;
+    std::vector<unsigned char> buf(1 << 20);
+    uint64_t h = 1469598103934665603ULL;
+    ssize_t n;
+    while ((n = read(fd, buf.data(), buf.size())) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            h = (h ^ buf[i]) * 1099511628211ULL;
+        }
+    }
+    close(fd);
+    return h;
+}
+
+static bool run(const std::string& source, uint64_t size, int streams, const std::string& destDir) {
+    WirelessConfig config = wireless_default_config();
+    config.max_streams = streams;
+    config.stripe_threshold = 1;
+
+    BenchState state;
+    WirelessReceiver* receiver = wireless_receiver_start(0, destDir.c_str(), &config, accept_all, NULL, on_complete, NULL, &state);
+    if (!receiver) {
+        fprintf(stderr, "receiver failed to start\n");
+        return false;
+    }
+
+    WirelessTransfer* transfer = wireless_transfer_create("127.0.0.1", wireless_receiver_port(receiver), &config);
+    auto start = std::chrono::steady_clock::now();
+    int ret = wireless_transfer_send_file(transfer, source.c_str(), "bench.bin", NULL, NULL);
+    {
+        std::unique_lock<std::mutex> guard(state.lock);
+        state.done.wait(guard, [&]() { return state.finished; });
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    wireless_transfer_free(transfer);
+    wireless_receiver_stop(receiver);
+
+    bool ok = ret == WIRELESS_OK && state.result == WIRELESS_OK && checksum(source) == checksum(state.savedPath);
+    printf("streams=%d  %.1f MB in %.3fs  %.1f MB/s  %s\n", streams, size / 1048576.0, seconds,
+           size / 1048576.0 / seconds, ok ? "ok" : "FAILED");
+    if (!state.savedPath.empty()) unlink(state.savedPath.c_str());
+    return ok;
+}
+
+// Media-like data: incompressible, goes out through sendfile
+static bool write_random(const std::string& path, uint64_t size) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    std::vector<uint64_t> chunk((1 << 20) / sizeof(uint64_t));
+    uint64_t x = 88172645463325252ULL;
+    for (uint64_t written = 0; written < size; written += chunk.size() * sizeof(uint64_t)) {
+        for (auto& v : chunk) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            v = x;
+        }
+        if (write(fd, chunk.data(), chunk.size() * sizeof(uint64_t)) < 0) break;
+    }
+    close(fd);
+    return true;
+}
+
+// Log-like data: compresses well, goes out as frames when a codec is available
+static bool write_text(const std::string& path, uint64_t size) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    uint64_t written = 0;
+    for (uint64_t line = 0; written < size; line++) {
+        char buf[160];
+        int n = snprintf(buf, sizeof(buf), "2025-11-27 10:%02llu:%02llu.%03llu INFO transfer[%llu] chunk ok bytes=%llu\n",
+                         (unsigned long long)(line / 60000 % 60), (unsigned long long)(line / 1000 % 60),
+                         (unsigned long long)(line % 1000), (unsigned long long)(line % 97),
+                         (unsigned long long)(line * 4096));
+        uint64_t take = (uint64_t)n < size - written ? (uint64_t)n : size - written;
+        fwrite(buf, 1, (size_t)take, f);
+        written += take;
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    // Linux sendfile has no MSG_NOSIGNAL equivalent
+    signal(SIGPIPE, SIG_IGN);
+
+    uint64_t sizeMB = argc > 1 ? strtoull(argv[1], NULL, 10) : 512;
+    int maxStreams = argc > 2 ? atoi(argv[2]) : 4;
+    uint64_t size = sizeMB * 1024 * 1024;
+
+    char dir[] = "/tmp/wireless_bench_XXXXXX";
+    if (!mkdtemp(dir)) return 1;
+    std::string destDir = std::string(dir) + "/received";
+    mkdir(destDir.c_str(), 0755);
+
+    struct { const char* label; bool (*make)(const std::string&, uint64_t); } inputs[] = {
+        { "random", write_random },
+        { "text", write_text },
+    };
+
+    bool ok = true;
+    for (auto& input : inputs) {
+        std::string source = std::string(dir) + "/" + input.label + ".bin";
+        if (!input.make(source, size)) return 1;
+        printf("%s:\n", input.label);
+        for (int streams = 1; streams <= maxStreams; streams *= 2) {
+            ok = run(source, size, streams, destDir) && ok;
+        }
+        unlink(source.c_str());
+    }
+
+    rmdir(destDir.c_str());
+    rmdir(dir);
+    return ok ? 0 : 1;
+}
@@ -5,19 +5,97 @@ rm -rf build
 rm -rf Lumen.app
 mkdir -p build
 
+# Optional codecs for wireless compression. Each one is compiled in and linked
+# only when Homebrew has both its header and its library; without them the
+# wireless engine simply sends uncompressed.
+CODEC_DEFINES=""
+CODEC_LIBS=""
+has_codec() {
+  for prefix in /opt/homebrew /usr/local; do
+    if [ -f "$prefix/include/$1.h" ] && ls "$prefix/lib/lib$1."* >/dev/null 2>&1; then
+      return 0
+    fi
+  done
+  return 1
+}
+if has_codec zstd; then
+  CODEC_DEFINES="$CODEC_DEFINES -DWIRELESS_WITH_ZSTD=1"
+  CODEC_LIBS="$CODEC_LIBS -lzstd"
+fi
+if has_codec lz4; then
+  CODEC_DEFINES="$CODEC_DEFINES -DWIRELESS_WITH_LZ4=1"
+  CODEC_LIBS="$CODEC_LIBS -llz4"
+fi
+
 # Compile C++ Bridges
 # MTP Bridge
 clang++ -c Lumen/MTPBridge.cpp -o build/MTPBridge.o \
   -std=c++17 \
   -I/opt/homebrew/include \
-  -I/usr/local/include
+  -I/usr/local/include \
+  -I Lumen/DeviceCatalog/include \
+  -I Lumen/BlockCache/include \
+  -I Lumen/DirectoryPrefetcher/include \
+  -I Lumen/ListingPool/include
 
 # iOS Bridge
 clang++ -c Lumen/iOSBridge/src/iOSBridge.cpp -o build/iOSBridge.o \
   -std=c++17 \
   -I/opt/homebrew/include \
   -I/usr/local/include \
-  -I Lumen/iOSBridge/include
+  -I Lumen/iOSBridge/include \
+  -I Lumen/DeviceCatalog/include \
+  -I Lumen/BlockCache/include \
+  -I Lumen/DirectoryPrefetcher/include \
+  -I Lumen/ListingPool/include
+
+# Wireless Bridge
+clang++ -c Lumen/WirelessBridge/src/WirelessBridge.cpp -o build/WirelessBridge.o \
+  -std=c++17 \
+  -I/opt/homebrew/include \
+  -I/usr/local/include \
+  -I Lumen/WirelessBridge/include
+
+clang++ -c Lumen/WirelessBridge/src/WirelessCompression.cpp -o build/WirelessCompression.o \
+  -std=c++17 \
+  $CODEC_DEFINES \
+  -I/opt/homebrew/include \
+  -I/usr/local/include
+
+# ADB Bridge
+clang++ -c Lumen/ADBBridge/src/ADBBridge.cpp -o build/ADBBridge.o \
+  -std=c++17 \
+  -I Lumen/ADBBridge/include
+
+# Search Index
+clang++ -c Lumen/SearchIndex/src/SearchIndex.cpp -o build/SearchIndex.o \
+  -std=c++17 \
+  -I Lumen/SearchIndex/include
+
+# Device Catalog
+clang++ -c Lumen/DeviceCatalog/src/DeviceCatalog.cpp -o build/DeviceCatalog.o \
+  -std=c++17 \
+  -I Lumen/DeviceCatalog/include
+
+# Block Cache
+clang++ -c Lumen/BlockCache/src/BlockCache.cpp -o build/BlockCache.o \
+  -std=c++17 \
+  -I Lumen/BlockCache/include
+
+# Directory Prefetcher
+clang++ -c Lumen/DirectoryPrefetcher/src/DirectoryPrefetcher.cpp -o build/DirectoryPrefetcher.o \
+  -std=c++17 \
+  -I Lumen/DirectoryPrefetcher/include
+
+# Transfer Scheduler
+clang++ -c Lumen/TransferScheduler/src/TransferScheduler.cpp -o build/TransferScheduler.o \
+  -std=c++17 \
+  -I Lumen/TransferScheduler/include
+
+# Listing Pool
+clang++ -c Lumen/ListingPool/src/ListingPool.cpp -o build/ListingPool.o \
+  -std=c++17 \
+  -I Lumen/ListingPool/include
 
 # Compile all Swift files and link
 swiftc -v -sdk $(xcrun --sdk macosx --show-sdk-path) \
@@ -30,12 +108,15 @@ swiftc -v -sdk $(xcrun --sdk macosx --show-sdk-path) \
   -L/usr/local/lib \
   -lmtp \
   -limobiledevice \
+  $CODEC_LIBS \
   -lc++ \
   -framework Foundation \
   -framework AppKit \
   -framework SwiftUI \
   -framework UniformTypeIdentifiers \
-  Lumen/*.swift build/MTPBridge.o build/iOSBridge.o \
+  -framework AVFoundation \
+  -framework AVKit \
+  Lumen/*.swift build/MTPBridge.o build/iOSBridge.o build/WirelessBridge.o build/WirelessCompression.o build/ADBBridge.o build/SearchIndex.o build/DeviceCatalog.o build/BlockCache.o build/DirectoryPrefetcher.o build/TransferScheduler.o build/ListingPool.o \
   -o Lumen.app
 
 echo "Build completed!"
\ No newline at end of file
@@ -15,14 +15,17 @@ fi
 
 # Install required dependencies if not present
 echo "Installing dependencies..."
-brew install libmtp libimobiledevice
+brew install libmtp libimobiledevice lz4 zstd
 
 # Create build directory if it doesn't exist
 mkdir -p build
 
 # Build the project using xcodebuild
 echo "Building project..."
-xcodebuild -project Lumen.xcodeproj -scheme Lumen -configuration Release -derivedDataPath build
+# lz4 and zstd were installed above, so build the wireless codecs in
+xcodebuild -project Lumen.xcodeproj -scheme Lumen -configuration Release -derivedDataPath build \
+  WIRELESS_CODEC_DEFINES="WIRELESS_WITH_ZSTD=1 WIRELESS_WITH_LZ4=1" \
+  WIRELESS_CODEC_LDFLAGS="-lzstd -llz4"
 
 # Check if build was successful
 if [ $? -eq 0 ]; then